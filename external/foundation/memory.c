@@ -603,18 +603,41 @@ memory_tracker_finalize(void) {
 	memory_tracker_cleanup();
 }
 
+#define MEMORY_TAG_DUMP_BATCH_SIZE 32
+
 static void
 memory_tracker_dump_impl(memory_tracker_handler_fn handler) {
 	if (!memory_tracker_initialized || !memory_tag_map)
 		return;
+	// Tags are copied while the bucket is locked, since other threads can track and untrack
+	// allocations concurrently, and the handler is called once unlocked, since it can allocate memory.
+	memory_tag_t tags[MEMORY_TAG_DUMP_BATCH_SIZE];
 	for (uint ibucket = 0; ibucket < MEMORY_TAG_MAP_SIZE; ++ibucket) {
 		memory_tag_bucket_t* bucket = memory_tag_map + ibucket;
-		memory_tag_t* tag = bucket->tags;
-		for (size_t itag = 0; tag && (itag < bucket->size); ++itag, ++tag) {
-			void* addr = tag->address;
-			if (addr) {
-				if (handler(tag->context, addr, tag->size, tag->trace, sizeof(tag->trace) / sizeof(tag->trace[0])))
-					break;
+		size_t itag = 0;
+		bool done = false;
+		while (!done) {
+			while (!atomic_cas32(&bucket->lock, 1, 0, memory_order_acquire, memory_order_acquire))
+				thread_yield();
+			size_t count = 0;
+			if (bucket->tags && (itag < bucket->size)) {
+				count = bucket->size - itag;
+				if (count > MEMORY_TAG_DUMP_BATCH_SIZE)
+					count = MEMORY_TAG_DUMP_BATCH_SIZE;
+				memcpy(tags, bucket->tags + itag, sizeof(memory_tag_t) * count);
+			}
+			atomic_store32(&bucket->lock, 0, memory_order_release);
+
+			itag += count;
+			done = (count < MEMORY_TAG_DUMP_BATCH_SIZE);
+			for (size_t icopy = 0; icopy < count; ++icopy) {
+				const memory_tag_t* tag = tags + icopy;
+				if (tag->address) {
+					if (handler(tag->context, tag->address, tag->size, tag->trace, sizeof(tag->trace) / sizeof(tag->trace[0]))) {
+						done = true;
+						break;
+					}
+				}
 			}
 		}
 	}
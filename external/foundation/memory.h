@@ -116,7 +116,8 @@ tracker will be set once the library is initialized.
 FOUNDATION_API void
 memory_set_tracker(memory_tracker_t tracker);
 
-/*! Dump all tracked allocations
+/*! Dump all tracked allocations. Allocations tracked or untracked by other threads while
+dumping can be missed or reported twice, but the handler is never called with the tracker locked.
 \param handler Function receiving allocation data */
 FOUNDATION_API void
 memory_tracker_dump(memory_tracker_handler_fn handler);
@@ -110,7 +110,7 @@ extern int main_initialize()
     memset(&application, 0, sizeof application);
 
     #if BUILD_ENABLE_MEMORY_TRACKER
-        memory_set_tracker(memory_tracker_local());
+        memory_set_tracker(profiler_memory_tracker());
     #endif
     
     #if BUILD_ENABLE_STATIC_HASH_DEBUG
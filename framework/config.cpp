@@ -9,8 +9,11 @@
 #include <framework/scoped_string.h>
 #include <framework/string_table.h>
 #include <framework/string.h>
+#include <framework/array.h>
+#include <framework/shared_mutex.h>
 
 #include <foundation/fs.h>
+#include <foundation/hash.h>
 #include <foundation/array.h>
 #include <foundation/stream.h>
 #include <foundation/path.h>
@@ -18,7 +21,23 @@
 #include <stdexcept>
 #include <algorithm>
 
+#if FOUNDATION_ARCH_SSE2
+#include <emmintrin.h>
+#elif FOUNDATION_ARCH_NEON
+#include <arm_neon.h>
+#endif
+
+#if FOUNDATION_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+#define HASH_CONFIG static_hash_string("config", 6, 0x336f91cbb8948a62ULL)
+
+/*! Number of fields an object must have before its fields get indexed by name. */
+#define CONFIG_FIELD_INDEX_MIN_COUNT (24)
+
 struct config_value_t;
+struct config_field_index_t;
 
 static config_handle_t NIL { nullptr, (config_index_t)(-1) };
 
@@ -27,6 +46,12 @@ struct config_t
     config_option_flags_t options;
     config_value_t* values;
     string_table_t* st;
+
+    /*! Field indexes of large objects sorted by object value index, built when fields are searched. */
+    config_field_index_t* field_indexes;
+
+    /*! Field indexes are built while searching const config values, which can happen from many threads. */
+    shared_mutex field_index_lock;
 };
 
 struct config_value_t
@@ -139,6 +164,160 @@ time_t config_handle_t::as_time(time_t default_value /*= 0*/) const
     return default_value;
 }
 
+struct config_field_slot_t
+{
+    string_table_symbol_t name;
+    config_index_t field;
+};
+
+/*! Open addressing hash index of the fields of an object.
+ *
+ *  The index remembers the object first child and child count when it was last updated
+ *  so that an object which fields were reset gets indexed again.
+ */
+struct config_field_index_t
+{
+    config_index_t object;
+    config_index_t child;
+    uint32_t child_count;
+
+    uint32_t capacity;
+    uint32_t count;
+    config_field_slot_t* slots;
+};
+
+FOUNDATION_FORCEINLINE bool operator<(const config_field_index_t& index, const config_index_t& object) { return index.object < object; }
+FOUNDATION_FORCEINLINE bool operator>(const config_field_index_t& index, const config_index_t& object) { return index.object > object; }
+
+FOUNDATION_FORCEINLINE uint32_t config_field_index_hash(string_table_symbol_t name)
+{
+    return (uint32_t)name * 2654435761U;
+}
+
+FOUNDATION_STATIC config_field_slot_t* config_field_index_slot(const config_field_index_t& index, string_table_symbol_t name)
+{
+    const uint32_t mask = index.capacity - 1;
+    for (uint32_t i = config_field_index_hash(name) & mask;; i = (i + 1) & mask)
+    {
+        config_field_slot_t* slot = index.slots + i;
+        if (slot->name == name || slot->name == STRING_TABLE_NULL_SYMBOL)
+            return slot;
+    }
+}
+
+/*! Adds a field to the index, #replace is true when the field comes first in the object sibling chain. */
+FOUNDATION_STATIC void config_field_index_insert(config_field_index_t& index, string_table_symbol_t name, config_index_t field, bool replace)
+{
+    if ((index.count + 1) * 2 > index.capacity)
+    {
+        config_field_slot_t* slots = index.slots;
+        const uint32_t capacity = index.capacity;
+
+        index.capacity = max(capacity * 2, 64U);
+        index.slots = (config_field_slot_t*)memory_allocate(HASH_CONFIG, sizeof(config_field_slot_t) * index.capacity, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+        for (uint32_t i = 0; i < capacity; ++i)
+        {
+            if (slots[i].name != STRING_TABLE_NULL_SYMBOL)
+                *config_field_index_slot(index, slots[i].name) = slots[i];
+        }
+        memory_deallocate(slots);
+    }
+
+    config_field_slot_t* slot = config_field_index_slot(index, name);
+    if (slot->name == STRING_TABLE_NULL_SYMBOL)
+    {
+        slot->name = name;
+        slot->field = field;
+        index.count++;
+    }
+    else if (replace)
+    {
+        slot->field = field;
+    }
+}
+
+FOUNDATION_STATIC void config_field_index_invalidate(config_t* config, config_index_t object)
+{
+    if (config->field_indexes == nullptr)
+        return;
+
+    SHARED_WRITE_LOCK(config->field_index_lock);
+
+    const int idx = array_binary_search(config->field_indexes, array_size(config->field_indexes), object);
+    if (idx < 0)
+        return;
+
+    memory_deallocate(config->field_indexes[idx].slots);
+    array_erase_ordered_safe(config->field_indexes, idx);
+}
+
+FOUNDATION_STATIC void config_field_indexes_deallocate(config_t* config)
+{
+    foreach(index, config->field_indexes)
+        memory_deallocate(index->slots);
+    array_deallocate(config->field_indexes);
+}
+
+/*! Returns the field index of a large object, building it if it is missing or outdated. 
+ *  @remark The field index lock must be locked exclusively.
+ */
+FOUNDATION_STATIC const config_field_index_t* config_field_index(config_t* config, const config_value_t* obj)
+{
+    int idx = array_binary_search(config->field_indexes, array_size(config->field_indexes), obj->index);
+    if (idx >= 0)
+    {
+        config_field_index_t& index = config->field_indexes[idx];
+        if (index.child == obj->child && index.child_count == obj->child_count)
+            return &index;
+
+        memory_deallocate(index.slots);
+        array_erase_ordered_safe(config->field_indexes, idx);
+        idx = array_binary_search(config->field_indexes, array_size(config->field_indexes), obj->index);
+    }
+
+    config_field_index_t index{};
+    index.object = obj->index;
+    index.child = obj->child;
+    index.child_count = obj->child_count;
+
+    // Keep the first field of the sibling chain for duplicated names like a linear search would.
+    const config_value_t* values = config->values;
+    for (config_index_t i = obj->child; i != 0; i = values[i].sibling)
+        config_field_index_insert(index, values[i].name, i, false);
+
+    array_insert(config->field_indexes, ~idx, index);
+    return &config->field_indexes[~idx];
+}
+
+/*! Looks for a field of a large object using its field index.
+ * 
+ *  @return True if the object fields are indexed, #out_field is then set to the field index or 0 if not found.
+ */
+FOUNDATION_STATIC bool config_field_index_find(config_t* config, const config_value_t* obj, string_table_symbol_t name, config_index_t& out_field)
+{
+    if (obj->type != CONFIG_VALUE_OBJECT || obj->child == 0 || obj->child_count < CONFIG_FIELD_INDEX_MIN_COUNT)
+        return false;
+
+    {
+        SHARED_READ_LOCK(config->field_index_lock);
+        const int idx = array_binary_search(config->field_indexes, array_size(config->field_indexes), obj->index);
+        if (idx >= 0)
+        {
+            const config_field_index_t& index = config->field_indexes[idx];
+            if (index.child == obj->child && index.child_count == obj->child_count)
+            {
+                out_field = config_field_index_slot(index, name)->field;
+                return true;
+            }
+        }
+    }
+
+    SHARED_WRITE_LOCK(config->field_index_lock);
+    const config_field_index_t* index = config_field_index(config, obj);
+    out_field = config_field_index_slot(*index, name)->field;
+    return true;
+}
+
 FOUNDATION_STATIC string_table_symbol_t config_add_symbol(config_t* root, const char* s, size_t length)
 {
     if (root == nullptr || s == nullptr || length == 0)
@@ -168,10 +347,11 @@ config_handle_t config_null()
 
 config_handle_t config_allocate(config_value_type_t type /*= CONFIG_VALUE_OBJECT*/, config_option_flags_t options /*= CONFIG_OPTION_NONE*/)
 {
-    config_t* config = (config_t*)memory_allocate(0, sizeof(config_t), 0, (options & CONFIG_OPTION_ALLOCATE_TEMPORARY) ? MEMORY_PERSISTENT : MEMORY_TEMPORARY);
+    config_t* config = new (memory_allocate(HASH_CONFIG, sizeof(config_t), 0, (options & CONFIG_OPTION_ALLOCATE_TEMPORARY) ? MEMORY_PERSISTENT : MEMORY_TEMPORARY)) config_t;
     config->options = options;
     config->st = string_table_allocate(256, 10);
     config->values = nullptr;
+    config->field_indexes = nullptr;
     array_resize(config->values, 1);
 
     //config->guard = mutex_allocate(STRING_CONST("CV"));
@@ -187,13 +367,35 @@ void config_deallocate(config_handle_t& root)
         return;
     config_t* config = root.config;
     string_table_deallocate(config->st);
+    config_field_indexes_deallocate(config);
     array_deallocate(config->values);
+    config->~config_t();
     memory_deallocate(config);
 
     root.config = nullptr;
     root.index = 0;
 }
 
+config_handle_t config_snapshot(const config_handle_t& h)
+{
+    const config_t* source = h.config;
+    if (source == nullptr)
+        return NIL;
+
+    config_t* config = new (memory_allocate(HASH_CONFIG, sizeof(config_t), 0, (source->options & CONFIG_OPTION_ALLOCATE_TEMPORARY) ? MEMORY_PERSISTENT : MEMORY_TEMPORARY)) config_t;
+    config->options = source->options;
+    config->field_indexes = nullptr;
+    config->values = nullptr;
+    array_copy(config->values, source->values);
+
+    // The string table is a single block, free slots are only needed to add new strings.
+    config->st = (string_table_t*)memory_allocate(0, source->st->allocated_bytes, alignof(string_table_t), MEMORY_PERSISTENT);
+    memcpy(config->st, source->st, source->st->allocated_bytes);
+    config->st->free_slots = nullptr;
+
+    return config_handle_t{ config, h.index };
+}
+
 config_tag_t config_tag(const config_handle_t& h, const char* tag, size_t tag_length)
 {
     return config_tag_t { config_add_symbol(h.config, tag, tag_length) };
@@ -243,6 +445,10 @@ FOUNDATION_STATIC config_handle_t config_find(const config_handle_t& obj, string
     if (v == nullptr || symbol <= 0)
         return NIL;
     
+    config_index_t field = 0;
+    if (config_field_index_find(obj.config, v, symbol, field))
+        return field != 0 ? config_handle_t{ obj.config, field } : NIL;
+    
     const config_value_t* values = obj.config->values;
     const config_value_t* p = &values[v->child];
     while (p && p->name != symbol)
@@ -446,6 +652,10 @@ FOUNDATION_STATIC config_handle_t config_add(const config_handle_t& obj_handle,
     config_value_initialize(obj_handle.config, new_field_value, CONFIG_VALUE_UNDEFINED, new_field_index, symbol);
 
     obj = obj_handle;
+
+    const config_index_t previous_child = obj->child;
+    const uint32_t previous_child_count = obj->child_count;
+
     obj->child_count++;
 
     if (obj->child == 0)
@@ -466,6 +676,29 @@ FOUNDATION_STATIC config_handle_t config_add(const config_handle_t& obj_handle,
         new_field_value.sibling = obj->child;
         obj->child = new_field_index;
     }
+
+    // Update the object field index if it was still valid before the new field was added.
+    config_t* config = obj_handle.config;
+    if (config->field_indexes)
+    {
+        SHARED_WRITE_LOCK(config->field_index_lock);
+        const int idx = array_binary_search(config->field_indexes, array_size(config->field_indexes), obj->index);
+        if (idx >= 0)
+        {
+            config_field_index_t& index = config->field_indexes[idx];
+            if (index.child == previous_child && index.child_count == previous_child_count)
+            {
+                config_field_index_insert(index, symbol, new_field_index, obj->child == new_field_index);
+                index.child = obj->child;
+                index.child_count = obj->child_count;
+            }
+            else
+            {
+                memory_deallocate(index.slots);
+                array_erase_ordered_safe(config->field_indexes, idx);
+            }
+        }
+    }
     
     return config_handle_t{ obj_handle.config, new_field_index };
 }
@@ -485,6 +718,8 @@ bool config_remove(const config_handle_t& h, const config_handle_t& to_remove_ha
     if (to_remove_handle.config == nullptr)
         return false;
 
+    config_field_index_invalidate(h.config, cv->index);
+
     config_value_t* values = h.config->values;
     if (cv->child == to_remove_handle.index)
     {
@@ -909,6 +1144,8 @@ void config_array_sort(const config_handle_t& array_handle, const function<bool(
     if (arr == nullptr || arr->child == 0 || !sort_fn)
         return; // Nothing to sort.
 
+    config_field_index_invalidate(array_handle.config, arr->index);
+
     // Get all element indexes into an array
     config_index_t* indexes = nullptr;
     array_reserve(indexes, arr->child_count);
@@ -1414,6 +1651,101 @@ FOUNDATION_STATIC char config_parse_next(string_const_t json, int index)
     return json.str[index];
 }
 
+FOUNDATION_FORCEINLINE bool config_parse_is_whitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',';
+}
+
+FOUNDATION_FORCEINLINE unsigned config_parse_first_bit(uint32_t mask)
+{
+    #if FOUNDATION_COMPILER_MSVC
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (unsigned)bit;
+    #else
+    return (unsigned)__builtin_ctz(mask);
+    #endif
+}
+
+/*! Returns the index of the first quote or backslash at or after #index, or the data length if none is found. 
+ * 
+ *  Strings are scanned 16 bytes at a time when SIMD instructions are available.
+ */
+FOUNDATION_STATIC int config_parse_scan_string(string_const_t json, int index)
+{
+    const char* s = json.str;
+    const int length = (int)json.length;
+
+    #if FOUNDATION_ARCH_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; index + 16 <= length; index += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(s + index));
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0)
+            return index + config_parse_first_bit(mask);
+    }
+    #elif FOUNDATION_ARCH_NEON
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    for (; index + 16 <= length; index += 16)
+    {
+        const uint8x16_t chunk = vld1q_u8((const uint8_t*)(s + index));
+        if (vmaxvq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash))) != 0)
+            break;
+    }
+    #endif
+
+    for (; index < length; ++index)
+    {
+        if (s[index] == '"' || s[index] == '\\')
+            return index;
+    }
+
+    return length;
+}
+
+/*! Returns the index of the first character at or after #index that is not a whitespace or a comma. */
+FOUNDATION_STATIC int config_parse_scan_whitespace(string_const_t json, int index)
+{
+    const char* s = json.str;
+    const int length = (int)json.length;
+
+    // Short runs between tokens are faster to skip one character at a time.
+    for (int end = min(index + 4, length); index < end; ++index)
+    {
+        if (!config_parse_is_whitespace(s[index]))
+            return index;
+    }
+
+    #if FOUNDATION_ARCH_SSE2
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i comma = _mm_set1_epi8(',');
+    for (; index + 16 <= length; index += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(s + index));
+        const __m128i ws = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)), _mm_cmpeq_epi8(chunk, comma)));
+        const uint32_t mask = ~(uint32_t)_mm_movemask_epi8(ws) & 0xFFFF;
+        if (mask != 0)
+            return index + config_parse_first_bit(mask);
+    }
+    #endif
+
+    for (; index < length; ++index)
+    {
+        if (!config_parse_is_whitespace(s[index]))
+            return index;
+    }
+
+    return length;
+}
+
 void config_parse_skip_comment(string_const_t json, int& index)
 {
     if (!config_parse_at_end(json, index + 1) && config_parse_next(json, index + 1) == '/')
@@ -1436,11 +1768,9 @@ void config_parse_skip_whitespace(string_const_t json, int& index)
 {
     while (!config_parse_at_end(json, index))
     {
-        char c = config_parse_next(json, index);
-        if (c == '/')
+        index = config_parse_scan_whitespace(json, index);
+        if (!config_parse_at_end(json, index) && json.str[index] == '/')
             config_parse_skip_comment(json, index);
-        else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',')
-            ++index;
         else
             break;
     }
@@ -1490,97 +1820,103 @@ string_t config_parse_string(string_const_t json, int& index, config_option_flag
     config_parse_consume(json, index, STRING_CONST("\""));
     while (true)
     {
+        // Copy all characters up to the next quote or escape sequence at once.
+        const int end = config_parse_scan_string(json, index);
+        if (end > index)
+        {
+            const unsigned size = array_size(s);
+            array_resize(s, size + (end - index));
+            memcpy(s + size, json.str + index, end - index);
+            index = end;
+        }
+
         char c = config_parse_next(json, index);
         ++index;
         if (c == '"')
             break;
-        if (c != '\\')
+
+        // Otherwise the scan stopped on an escape sequence.
+        FOUNDATION_ASSERT(c == '\\');
+        char q = config_parse_next(json, index);
+        ++index;
+        if (q == '"' || q == '\\' || q == '/')
         {
-            s = array_push(s, c);
+            s = array_push(s, q);
         }
-        else
+        else if (q == 'b') { s = array_push(s, '\b'); }
+        else if (q == 'f') { s = array_push(s, '\f'); }
+        else if (q == 'n') { s = array_push(s, '\n'); }
+        else if (q == 'r') { s = array_push(s, '\r'); }
+        else if (q == 't') { s = array_push(s, '\t'); }
+        else if (q == 'u')
         {
-            char q = config_parse_next(json, index);
-            ++index;
-            if (q == '"' || q == '\\' || q == '/')
+            if (options & CONFIG_OPTION_PARSE_UNICODE_UTF8)
             {
-                s = array_push(s, q);
+                scoped_string_t utf8 = string_utf8_unescape(json.str + index - 2, 6);
+                if (utf8.value.str == nullptr)
+                    throw config_parse_exception(json, index, "Invalid Unicode character or sequence");
+
+                const char* utf8c = utf8.value.str;
+                for (int i = 0; i < utf8.value.length && *utf8c; ++i, ++utf8c)
+                    s = array_push(s, *utf8c);
+                index += 4;
             }
-            else if (q == 'b') { s = array_push(s, '\b'); }
-            else if (q == 'f') { s = array_push(s, '\f'); }
-            else if (q == 'n') { s = array_push(s, '\n'); }
-            else if (q == 'r') { s = array_push(s, '\r'); }
-            else if (q == 't') { s = array_push(s, '\t'); }
-            else if (q == 'u')
+            else
             {
-                if (options & CONFIG_OPTION_PARSE_UNICODE_UTF8)
-                {
-                    scoped_string_t utf8 = string_utf8_unescape(json.str + index - 2, 6);
-                    if (utf8.value.str == nullptr)
-                        throw config_parse_exception(json, index, "Invalid Unicode character or sequence");
-
-                    const char* utf8c = utf8.value.str;
-                    for (int i = 0; i < utf8.value.length && *utf8c; ++i, ++utf8c)
-                        s = array_push(s, *utf8c);
-                    index += 4;
-                }
-                else
-                {
-                    s = array_push(s, '\\');
-                    s = array_push(s, 'u');
-                }
+                s = array_push(s, '\\');
+                s = array_push(s, 'u');
             }
-            else if (q == 'x')
+        }
+        else if (q == 'x')
+        {
+            // Parse UTF-8 char
+            if (options & CONFIG_OPTION_PARSE_UNICODE_UTF8)
             {
-                // Parse UTF-8 char
-                if (options & CONFIG_OPTION_PARSE_UNICODE_UTF8)
+                char b1 = config_parse_next(json, index);
+                char b2 = config_parse_next(json, index + 1);
+                if (b1 == '0' && b2 == '0')
                 {
-                    char b1 = config_parse_next(json, index);
-                    char b2 = config_parse_next(json, index + 1);
-                    if (b1 == '0' && b2 == '0')
-                    {
-                        s = array_push(s, '\0');
-                    }
-                    else
-                    {
-                        // Convert b1 and b2 to uint8_t
-                        uint8_t b1v = 0;
-                        uint8_t b2v = 0;
-                        if (b1 >= '0' && b1 <= '9')
-                            b1v = b1 - '0';
-                        else if (b1 >= 'a' && b1 <= 'f')
-                            b1v = b1 - 'a' + 10;
-                        else if (b1 >= 'A' && b1 <= 'F')
-                            b1v = b1 - 'A' + 10;
-                        else
-                            throw config_parse_exception(json, index, "Invalid hex character");
-
-                        if (b2 >= '0' && b2 <= '9')
-                            b2v = b2 - '0';
-                        else if (b2 >= 'a' && b2 <= 'f')
-                            b2v = b2 - 'a' + 10;
-                        else if (b2 >= 'A' && b2 <= 'F')
-                            b2v = b2 - 'A' + 10;
-                        else
-                            throw config_parse_exception(json, index, "Invalid hex character");
-
-                        // Convert to UTF-8
-                        uint8_t b = (b1v << 4) | b2v;
-
-                        s = array_push(s, (char)b);
-                    }
+                    s = array_push(s, '\0');
                 }
                 else
                 {
-                    s = array_push(s, '\\');
-                    s = array_push(s, 'x');
-                }
+                    // Convert b1 and b2 to uint8_t
+                    uint8_t b1v = 0;
+                    uint8_t b2v = 0;
+                    if (b1 >= '0' && b1 <= '9')
+                        b1v = b1 - '0';
+                    else if (b1 >= 'a' && b1 <= 'f')
+                        b1v = b1 - 'a' + 10;
+                    else if (b1 >= 'A' && b1 <= 'F')
+                        b1v = b1 - 'A' + 10;
+                    else
+                        throw config_parse_exception(json, index, "Invalid hex character");
+
+                    if (b2 >= '0' && b2 <= '9')
+                        b2v = b2 - '0';
+                    else if (b2 >= 'a' && b2 <= 'f')
+                        b2v = b2 - 'a' + 10;
+                    else if (b2 >= 'A' && b2 <= 'F')
+                        b2v = b2 - 'A' + 10;
+                    else
+                        throw config_parse_exception(json, index, "Invalid hex character");
+
+                    // Convert to UTF-8
+                    uint8_t b = (b1v << 4) | b2v;
 
-                index += 2;
+                    s = array_push(s, (char)b);
+                }
             }
             else
-                throw config_parse_exception(json, index, "Unknown escape code");
+            {
+                s = array_push(s, '\\');
+                s = array_push(s, 'x');
+            }
+
+            index += 2;
         }
+        else
+            throw config_parse_exception(json, index, "Unknown escape code");
     }
 
     string_t res = string_clone(s, array_size(s));
@@ -1588,8 +1924,34 @@ string_t config_parse_string(string_const_t json, int& index, config_option_flag
     return res;
 }
 
+/*! Returns the content of a quoted string without escape sequences directly from the parsed data.
+ * 
+ *  @return Null string if the string must be unescaped or is a literal string.
+ */
+FOUNDATION_STATIC string_const_t config_parse_plain_string(string_const_t json, int& index)
+{
+    if (config_parse_at_end(json, index) || json.str[index] != '"')
+        return string_null();
+
+    if (!config_parse_at_end(json, index + 2) && json.str[index + 1] == '"' && json.str[index + 2] == '"')
+        return string_null();
+
+    const int end = config_parse_scan_string(json, index + 1);
+    if (config_parse_at_end(json, end) || json.str[end] != '"')
+        return string_null();
+
+    string_const_t str = string_const(json.str + index + 1, end - index - 1);
+    index = end + 1;
+    return str;
+}
+
 FOUNDATION_STATIC config_handle_t config_parse_string(string_const_t json, int& index, config_handle_t str_handle)
 {
+    // Most strings have no escape sequences and are stored without being copied first.
+    string_const_t plain = config_parse_plain_string(json, index);
+    if (plain.str)
+        return config_set(str_handle, STRING_ARGS(plain));
+
     string_t s = config_parse_string(json, index, str_handle.config->options);
     config_set(str_handle, STRING_ARGS(s));
     string_deallocate(s.str);
@@ -1603,28 +1965,31 @@ FOUNDATION_STATIC string_t config_parse_identifier(string_const_t json, int& ind
     if (config_parse_next(json, index) == '"')
         return config_parse_string(json, index, CONFIG_OPTION_NONE);
 
-    char* s = nullptr;
-    array_reserve(s, 32);
-
+    const int start = index;
     while (index < json.length)
     {
-        char c = config_parse_next(json, index);
+        const char c = json.str[index];
         if (c == ' ' || c == '\t' || c == '\n' || c == '=' || c == ':')
             break;
-        array_push(s, c);
         ++index;
     }
 
-    string_t res = string_clone(s, array_size(s));
-    array_deallocate(s);
-    return res;
+    return string_clone(json.str + start, index - start);
 }
 
 config_handle_t config_parse_value(string_const_t json, int& index, config_handle_t value);
 
 config_handle_t config_parse_object_field(string_const_t json, int& index, config_handle_t ht)
 {
-    string_t key = config_parse_identifier(json, index);
+    config_parse_skip_whitespace(json, index);
+
+    string_t key_buffer{};
+    string_const_t key = config_parse_plain_string(json, index);
+    if (key.str == nullptr)
+    {
+        key_buffer = config_parse_identifier(json, index);
+        key = string_to_const(key_buffer);
+    }
     config_parse_skip_whitespace(json, index);
     if (config_parse_next(json, index) == ':')
         config_parse_consume(json, index, STRING_CONST(":"));
@@ -1633,8 +1998,9 @@ config_handle_t config_parse_object_field(string_const_t json, int& index, confi
 
     config_handle_t value = config_add(ht, key.str, key.length);
 
+    string_deallocate(key_buffer.str);
+
     value = config_parse_value(json, index, value);
-    string_deallocate(key.str);
     config_parse_skip_whitespace(json, index);
     return value;
 }
@@ -1682,10 +2048,15 @@ config_handle_t config_parse_array(string_const_t json, int& index, config_handl
     return array_handle;
 }
 
+FOUNDATION_FORCEINLINE bool config_parse_is_number_char(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || c == '+' || c == '-' || c == '.' || c == 'E';
+}
+
 config_handle_t config_parse_number(string_const_t json, int& index, config_handle_t value)
 {
     int end = index;	
-    while (!config_parse_at_end(json, end) && string_find_first_of(json.str + end, 1, STRING_CONST("0123456789abcdef+-.eE"), 0) != STRING_NPOS)
+    while (!config_parse_at_end(json, end) && config_parse_is_number_char(json.str[end]))
         ++end;
     int length = end - index;
     config_handle_t res;
@@ -1797,6 +2168,174 @@ config_handle_t config_parse(const char* json, size_t json_length, config_option
     return root;
 }
 
+/*! Binary config files start with a header, followed by the config values and the strings they use.
+ *
+ *  Fields are written one by one in little-endian byte order, so files do not depend on the
+ *  platform endianness or on how the compiler lays out and pads config structures.
+ *
+ *  Header: magic u32, version u16, value size u16, root u32, value count u32, string bytes u32, reserved u32
+ *  Value:  name u32, type u32, child u32, sibling u32, number, string or child count u64
+ *
+ *  Strings are null terminated and value names and strings are byte offsets in them.
+ */
+#define CONFIG_BINARY_HEADER_SIZE (24)
+#define CONFIG_BINARY_VALUE_SIZE (24)
+
+FOUNDATION_FORCEINLINE void config_binary_write_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+FOUNDATION_FORCEINLINE void config_binary_write_u32(uint8_t* p, uint32_t v)
+{
+    for (unsigned i = 0; i < 4; ++i)
+        p[i] = (uint8_t)(v >> (i * 8));
+}
+
+FOUNDATION_FORCEINLINE void config_binary_write_u64(uint8_t* p, uint64_t v)
+{
+    for (unsigned i = 0; i < 8; ++i)
+        p[i] = (uint8_t)(v >> (i * 8));
+}
+
+FOUNDATION_FORCEINLINE uint16_t config_binary_read_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+FOUNDATION_FORCEINLINE uint32_t config_binary_read_u32(const uint8_t* p)
+{
+    uint32_t v = 0;
+    for (unsigned i = 0; i < 4; ++i)
+        v |= (uint32_t)p[i] << (i * 8);
+    return v;
+}
+
+FOUNDATION_FORCEINLINE uint64_t config_binary_read_u64(const uint8_t* p)
+{
+    uint64_t v = 0;
+    for (unsigned i = 0; i < 8; ++i)
+        v |= (uint64_t)p[i] << (i * 8);
+    return v;
+}
+
+FOUNDATION_STATIC bool config_is_binary_file_path(string_const_t file_path)
+{
+    string_const_t extension = path_file_extension(STRING_ARGS(file_path));
+    return string_equal_nocase(STRING_ARGS(extension), STRING_CONST(CONFIG_BINARY_FILE_EXTENSION));
+}
+
+bool config_is_binary(const void* data, size_t size)
+{
+    if (data == nullptr || size < CONFIG_BINARY_HEADER_SIZE)
+        return false;
+
+    return config_binary_read_u32((const uint8_t*)data) == CONFIG_BINARY_MAGIC;
+}
+
+config_handle_t config_parse_binary(const void* data, size_t size, config_option_flags_t options /*= CONFIG_OPTION_NONE*/)
+{
+    if (!config_is_binary(data, size))
+        return NIL;
+
+    const uint8_t* header = (const uint8_t*)data;
+    const uint16_t version = config_binary_read_u16(header + 4);
+    const uint16_t value_size = config_binary_read_u16(header + 6);
+    if (version != CONFIG_BINARY_VERSION || value_size != CONFIG_BINARY_VALUE_SIZE)
+    {
+        log_warnf(0, WARNING_UNSUPPORTED, STRING_CONST("Unsupported binary config version %u (value size %u)"), version, value_size);
+        return NIL;
+    }
+
+    const uint32_t root = config_binary_read_u32(header + 8);
+    const config_index_t value_count = config_binary_read_u32(header + 12);
+    const uint32_t string_bytes = config_binary_read_u32(header + 16);
+    const size_t values_size = (size_t)value_count * CONFIG_BINARY_VALUE_SIZE;
+    if (value_count == 0 || root != 0 || string_bytes == 0 ||
+        CONFIG_BINARY_HEADER_SIZE + values_size + string_bytes > size)
+    {
+        log_warnf(0, WARNING_INVALID_VALUE, STRING_CONST("Invalid binary config data"));
+        return NIL;
+    }
+
+    const uint8_t* values = header + CONFIG_BINARY_HEADER_SIZE;
+    const char* strings = (const char*)values + values_size;
+    if (strings[string_bytes - 1] != '\0')
+    {
+        log_warnf(0, WARNING_INVALID_VALUE, STRING_CONST("Invalid binary config strings"));
+        return NIL;
+    }
+
+    config_t* config = new (memory_allocate(HASH_CONFIG, sizeof(config_t), 0, (options & CONFIG_OPTION_ALLOCATE_TEMPORARY) ? MEMORY_PERSISTENT : MEMORY_TEMPORARY)) config_t;
+    config->options = options;
+    config->field_indexes = nullptr;
+    config->values = nullptr;
+    config->st = string_table_allocate((int)max(256U, string_bytes * 2U), 10);
+    array_resize(config->values, value_count);
+
+    // Strings are added to the string table once, the first time a value uses them.
+    string_table_symbol_t* symbols = (string_table_symbol_t*)memory_allocate(HASH_CONFIG, sizeof(string_table_symbol_t) * string_bytes, 0, MEMORY_TEMPORARY);
+    memset(symbols, 0xFF, sizeof(string_table_symbol_t) * string_bytes);
+    auto config_binary_symbol = [config, strings, string_bytes, symbols](uint64_t offset, string_table_symbol_t& symbol)
+    {
+        if (offset >= string_bytes)
+            return false;
+
+        if (symbols[offset] == STRING_TABLE_FULL)
+        {
+            const char* str = strings + offset;
+            symbols[offset] = config_add_symbol(config, str, string_length(str));
+        }
+
+        symbol = symbols[offset];
+        return true;
+    };
+
+    // Make sure corrupted data cannot index outside of the loaded values and strings.
+    bool valid = true;
+    for (config_index_t i = 0; valid && i < value_count; ++i)
+    {
+        const uint8_t* p = values + (size_t)i * CONFIG_BINARY_VALUE_SIZE;
+        const uint32_t type = config_binary_read_u32(p + 4);
+        const uint64_t payload = config_binary_read_u64(p + 16);
+
+        config_value_t& v = config->values[i];
+        v.index = i;
+        v.type = (config_value_type_t)type;
+        v.child = config_binary_read_u32(p + 8);
+        v.sibling = config_binary_read_u32(p + 12);
+        v.data = nullptr;
+
+        valid = config_binary_symbol(config_binary_read_u32(p), v.name);
+        if (type == CONFIG_VALUE_NUMBER)
+            memcpy(&v.number, &payload, sizeof(v.number));
+        else if (type == CONFIG_VALUE_STRING)
+            valid &= config_binary_symbol(payload, v.str);
+        else if (type == CONFIG_VALUE_ARRAY || type == CONFIG_VALUE_OBJECT)
+            v.child_count = (uint32_t)payload;
+        else if (type > CONFIG_VALUE_OBJECT && type != CONFIG_VALUE_UNDEFINED)
+            valid = false;
+
+        // Children and siblings are written after the value referencing them, 
+        // so any reference back to a previous value would be a cycle.
+        valid &= v.child == 0 || (v.child > i && v.child < value_count);
+        valid &= v.sibling == 0 || (v.sibling > i && v.sibling < value_count);
+        if (!valid)
+            log_warnf(0, WARNING_INVALID_VALUE, STRING_CONST("Invalid binary config value %u"), i);
+    }
+    memory_deallocate(symbols);
+
+    if (!valid)
+    {
+        config_handle_t invalid{ config, 0 };
+        config_deallocate(invalid);
+        return NIL;
+    }
+
+    return config_handle_t{ config, 0 };
+}
+
 config_handle_t config_parse_file(const char* file_path, size_t file_path_length, config_option_flags_t options /*= CONFIG_OPTION_NONE*/)
 {
     if (!fs_is_file(file_path, file_path_length))
@@ -1809,15 +2348,183 @@ config_handle_t config_parse_file(const char* file_path, size_t file_path_length
     const size_t json_buffer_size = stream_size(json_file_stream);
 
     string_t json_buffer = string_allocate(json_buffer_size + 1, json_buffer_size + 2);
-    scoped_string_t json_string = stream_read_string_buffer(json_file_stream, json_buffer.str, json_buffer.length);
-
-    auto json_root_handle = config_parse(STRING_ARGS(json_string.value), options);
+    const size_t read_size = stream_read(json_file_stream, json_buffer.str, json_buffer_size);
+    json_buffer.str[read_size] = '\0';
     stream_deallocate(json_file_stream);
-    return json_root_handle;
+
+    // Binary config files are recognized by their header whatever their extension.
+    config_handle_t root_handle;
+    if (config_is_binary(json_buffer.str, read_size))
+        root_handle = config_parse_binary(json_buffer.str, read_size, options);
+    else
+        root_handle = config_parse(json_buffer.str, read_size, options);
+
+    string_deallocate(json_buffer.str);
+    return root_handle;
+}
+
+uint8_t* config_binary(const config_handle_t& data)
+{
+    const config_t* config = data.config;
+    const config_value_t* values = config->values;
+    const config_index_t value_count = array_size(values);
+    string_table_t* st = config->st;
+
+    // Only the values reachable from the root value are written, in depth-first order, so 
+    // children and siblings are always stored after the value referencing them.
+    config_index_t* remap = (config_index_t*)memory_allocate(HASH_CONFIG, sizeof(config_index_t) * value_count, 0, MEMORY_TEMPORARY);
+    memset(remap, 0xFF, sizeof(config_index_t) * value_count);
+
+    config_index_t* order = nullptr;
+    config_index_t* stack = nullptr;
+    array_push(stack, data.index);
+    while (array_size(stack) > 0)
+    {
+        const config_index_t index = *array_last(stack);
+        array_pop(stack);
+        if (index >= value_count || remap[index] != (config_index_t)-1)
+            continue;
+
+        remap[index] = array_size(order);
+        array_push(order, index);
+
+        // The siblings of the root value are not part of the serialized value.
+        const config_value_t& v = values[index];
+        if (v.sibling != 0 && index != data.index)
+            array_push(stack, v.sibling);
+        if (v.child != 0 && (v.type == CONFIG_VALUE_OBJECT || v.type == CONFIG_VALUE_ARRAY))
+            array_push(stack, v.child);
+    }
+    array_deallocate(stack);
+
+    // Only the strings used by the written values are kept, the first byte is the empty string.
+    char* strings = nullptr;
+    array_push(strings, '\0');
+    const size_t st_string_bytes = (size_t)st->string_bytes;
+    uint32_t* string_offsets = (uint32_t*)memory_allocate(HASH_CONFIG, sizeof(uint32_t) * st_string_bytes, 0, MEMORY_TEMPORARY | MEMORY_ZERO_INITIALIZED);
+    auto config_binary_string_offset = [st, st_string_bytes, string_offsets, &strings](string_table_symbol_t symbol)->uint32_t
+    {
+        if (symbol <= STRING_TABLE_NULL_SYMBOL || (size_t)symbol >= st_string_bytes)
+            return 0;
+
+        if (string_offsets[symbol] == 0)
+        {
+            string_const_t str = string_table_to_string_const(st, symbol);
+            if (str.length == 0)
+                return 0;
+            const uint32_t offset = array_size(strings);
+            array_grow(strings, str.length + 1);
+            memcpy(strings + offset, str.str, str.length);
+            strings[offset + str.length] = '\0';
+            string_offsets[symbol] = offset;
+        }
+
+        return string_offsets[symbol];
+    };
+
+    const config_index_t written_count = array_size(order);
+    const size_t values_size = (size_t)written_count * CONFIG_BINARY_VALUE_SIZE;
+
+    uint8_t* buffer = nullptr;
+    array_resize(buffer, CONFIG_BINARY_HEADER_SIZE + values_size);
+    memset(buffer, 0, CONFIG_BINARY_HEADER_SIZE + values_size);
+
+    for (config_index_t i = 0; i < written_count; ++i)
+    {
+        const config_value_t& v = values[order[i]];
+        const config_index_t child = v.child != 0 && v.child < value_count && remap[v.child] != (config_index_t)-1 ? remap[v.child] : 0;
+        const config_index_t sibling = i != 0 && v.sibling != 0 && v.sibling < value_count ? remap[v.sibling] : 0;
+
+        // Raw pointers are only valid in the process that created them.
+        config_value_type_t type = v.type == CONFIG_VALUE_RAW_DATA ? CONFIG_VALUE_NIL : v.type;
+
+        uint64_t payload = 0;
+        if (type == CONFIG_VALUE_NUMBER)
+            memcpy(&payload, &v.number, sizeof(payload));
+        else if (type == CONFIG_VALUE_STRING)
+            payload = config_binary_string_offset(v.str);
+        else if (type == CONFIG_VALUE_ARRAY || type == CONFIG_VALUE_OBJECT)
+            payload = v.child_count;
+
+        uint8_t* p = buffer + CONFIG_BINARY_HEADER_SIZE + (size_t)i * CONFIG_BINARY_VALUE_SIZE;
+        config_binary_write_u32(p, config_binary_string_offset(v.name));
+        config_binary_write_u32(p + 4, (uint32_t)type);
+        config_binary_write_u32(p + 8, child);
+        config_binary_write_u32(p + 12, sibling);
+        config_binary_write_u64(p + 16, payload);
+    }
+    memory_deallocate(string_offsets);
+    array_deallocate(order);
+    memory_deallocate(remap);
+
+    const uint32_t string_bytes = array_size(strings);
+    config_binary_write_u32(buffer, CONFIG_BINARY_MAGIC);
+    config_binary_write_u16(buffer + 4, CONFIG_BINARY_VERSION);
+    config_binary_write_u16(buffer + 6, CONFIG_BINARY_VALUE_SIZE);
+    config_binary_write_u32(buffer + 8, 0);
+    config_binary_write_u32(buffer + 12, written_count);
+    config_binary_write_u32(buffer + 16, string_bytes);
+
+    const size_t strings_offset = array_size(buffer);
+    array_grow(buffer, string_bytes);
+    memcpy(buffer + strings_offset, strings, string_bytes);
+    array_deallocate(strings);
+    return buffer;
+}
+
+FOUNDATION_STATIC bool config_write_binary_file(string_const_t file_path, const config_handle_t& data, config_option_flags_t write_flags)
+{
+    if (data.config == nullptr)
+    {
+        log_warnf(0, WARNING_INVALID_VALUE, STRING_CONST("No data to write to config file %.*s"), STRING_FORMAT(file_path));
+        return false;
+    }
+
+    bool success = true;
+    uint8_t* buffer = config_binary(data);
+    const size_t buffer_size = array_size(buffer);
+
+    bool data_equal = false;
+    if (write_flags & CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL)
+    {
+        stream_t* current_stream = fs_open_file(STRING_ARGS(file_path), STREAM_IN | STREAM_BINARY);
+        if (current_stream)
+        {
+            if (stream_size(current_stream) == buffer_size)
+            {
+                uint8_t* current = (uint8_t*)memory_allocate(0, buffer_size, 0, MEMORY_TEMPORARY);
+                data_equal = stream_read(current_stream, current, buffer_size) == buffer_size && memcmp(current, buffer, buffer_size) == 0;
+                memory_deallocate(current);
+            }
+            stream_deallocate(current_stream);
+        }
+    }
+
+    if (!data_equal)
+    {
+        stream_t* binary_stream = fs_open_file(STRING_ARGS(file_path), STREAM_CREATE | STREAM_OUT | STREAM_BINARY | STREAM_TRUNCATE);
+        if (binary_stream)
+        {
+            log_debugf(0, STRING_CONST("Writing binary config file %.*s"), STRING_FORMAT(file_path));
+            success = stream_write(binary_stream, buffer, buffer_size) == buffer_size;
+            stream_deallocate(binary_stream);
+        }
+        else
+        {
+            log_errorf(0, ERROR_ACCESS_DENIED, STRING_CONST("Failed to create binary config stream for %.*s"), STRING_FORMAT(file_path));
+            success = false;
+        }
+    }
+
+    array_deallocate(buffer);
+    return success;
 }
 
 bool config_write_file(string_const_t _file_path, config_handle_t data, config_option_flags_t write_json_flags /*= CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS | CONFIG_OPTION_WRITE_SKIP_NULL*/)
 {
+    if (config_is_binary_file_path(_file_path))
+        return config_write_binary_file(_file_path, data, write_json_flags);
+
     bool success = true;
     char local_copy_file_path_buffer[BUILD_MAX_PATHLEN];
     string_t file_path = string_copy(STRING_BUFFER(local_copy_file_path_buffer), STRING_ARGS(_file_path));
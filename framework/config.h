@@ -21,6 +21,13 @@
 #include <foundation/math.h>
 #include <foundation/string.h>
 
+/*! File extension of binary config files written by #config_write_file. */
+#define CONFIG_BINARY_FILE_EXTENSION "wcfg"
+
+/*! Binary config files header magic and version. */
+#define CONFIG_BINARY_MAGIC (0x47464357U) // WCFG
+#define CONFIG_BINARY_VERSION (3)
+
 struct config_t;
 struct config_value_t;
 
@@ -66,6 +73,7 @@ typedef uint32_t config_option_flags_t;
 /*! Config field tag structure 
  *
  *  Using tags on a config value can speed up the linear field search of objects.
+ *  Objects with many fields are also indexed by field name once they get searched.
  */
 struct config_tag_t
 {
@@ -216,6 +224,17 @@ config_handle_t config_allocate(config_value_type_t type = CONFIG_VALUE_OBJECT,
  */
 void config_deallocate(config_handle_t& root);
 
+/*! Copies all the values and strings of a config so the copy can be read from another 
+ *  thread while the source config keeps being modified.
+ *
+ *  @remark The snapshot needs to be deallocated with #config_deallocate by the caller.
+ *
+ *  @param value Config value handle, the returned handle refers to the same value in the snapshot.
+ *
+ *  @return Config value handle in the snapshot.
+ */
+config_handle_t config_snapshot(const config_handle_t& value);
+
 /*! Preload the config value field tag for quicker subsequent accesses. 
  *
  *  @param root Config value handle.
@@ -954,6 +973,9 @@ bool config_is_null(const config_handle_t& v, const char* key = nullptr, size_t
 bool config_is_undefined(const config_handle_t& v, const char* key = nullptr, size_t key_length = 0);
 
 /*! Writes the config content to a file. The file will be overwritten if it already exists.
+ *
+ *  Files with the #CONFIG_BINARY_FILE_EXTENSION extension are written in the binary config format,
+ *  all other files are written as SJSON or JSON text.
  *
  *  @param file_path        File path.
  *  @param data             Config value handle.
@@ -1021,6 +1043,43 @@ config_handle_t config_parse_file(const char* file_path, size_t file_path_length
  */
 config_handle_t config_parse(const char* json, size_t json_length, config_option_flags_t options = CONFIG_OPTION_NONE);
 
+/*! Checks if the data starts with a binary config header.
+ *
+ *  @param data Data to check.
+ *  @param size Data size in bytes.
+ *
+ *  @return True if the data is a binary config.
+ */
+bool config_is_binary(const void* data, size_t size);
+
+/*! Loads a config written in the binary config format.
+ * 
+ *  The binary config format is a version header followed by fixed size config values 
+ *  and the strings they use, all written in little-endian byte order.
+ *
+ *  @remark The config value needs to be deallocated with #config_deallocate by the caller.
+ *  @remark Raw data pointers are not preserved and are loaded as null values.
+ *
+ *  @param data    Binary config data.
+ *  @param size    Binary config data size in bytes.
+ *  @param options Config options.
+ *
+ *  @return Config value handle, or a null handle if the data is invalid.
+ */
+config_handle_t config_parse_binary(const void* data, size_t size, config_option_flags_t options = CONFIG_OPTION_NONE);
+
+/*! Serializes a config in the binary config format, as written for #CONFIG_BINARY_FILE_EXTENSION files.
+ *
+ *  @remark Only the value and its children are written, the value becomes the root of the loaded config.
+ *  @remark Only the strings used by the written values are written.
+ *  @remark The returned buffer is an array that must be deallocated with #array_deallocate by the caller.
+ *
+ *  @param data Config value handle to use as the root value.
+ *
+ *  @return Binary config content.
+ */
+uint8_t* config_binary(const config_handle_t& data);
+
 /*! Returns the JSON or SJSON string content of a config value.
  *
  *  @remark The string content must be deallocated with #config_sjson_deallocate by the caller.
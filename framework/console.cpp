@@ -21,9 +21,33 @@
 #include <foundation/error.h>
 #include <foundation/hashstrings.h>
 #include <foundation/stream.h>
+#include <foundation/atomic.h>
+#include <foundation/thread.h>
 
 #define HASH_CONSOLE static_hash_string("console", 7, 0xf4408b2738af51e7ULL)
 
+/*! Number of log records that can be waiting to be drained, must be a power of two. */
+constexpr uint32_t CONSOLE_LOG_RING_CAPACITY = 4096;
+
+/*! Size of the text stored inline in a log record, longer messages are copied on the heap. */
+constexpr size_t CONSOLE_LOG_RECORD_TEXT_SIZE = 232;
+
+/*! Size after which the log file is moved to prev_log.txt and started over. */
+constexpr size_t CONSOLE_LOG_FILE_MAX_SIZE = 16 * 1024 * 1024;
+
+/*! Preformatted log message waiting in the ring buffer to be drained. */
+struct console_log_record_t
+{
+    atomic32_t sequence;
+    hash_t context;
+    error_level_t severity;
+    bool prefix;
+    bool console;
+    size_t length;
+    char* overflow;
+    char text[CONSOLE_LOG_RECORD_TEXT_SIZE];
+};
+
 struct log_message_t
 {
     size_t id{ 0 };
@@ -51,6 +75,7 @@ static struct CONSOLE_MODULE
     bool concat_messages = false;
     char expression_buffer[4096]{ "" };
     bool expression_explicitly_set = false;
+    bool profile_expression = false;
     log_message_t* messages{ nullptr };
     size_t max_context_name_length = 0;
     string_t* secret_keys{ nullptr };
@@ -58,9 +83,21 @@ static struct CONSOLE_MODULE
     generics::fixed_loop < string_t, 20, [](string_t& s) { string_deallocate(s.str); } > saved_expressions;
 
     stream_t* log_stream = nullptr;
+    size_t log_stream_size = 0;
+
+    // Bounded MPSC ring buffer, any thread can push log records and the main thread drains them.
+    console_log_record_t* records{ nullptr };
+    atomic32_t records_tail;
+    uint32_t records_head{ 0 };
+    atomic32_t draining;
+    atomic32_t dropped_messages;
+    size_t dropped_message_count{ 0 };
 
 } *_console_module;
 
+/*! Set while the thread drains the log records, so its own log messages do not wait for the drain. */
+static thread_local bool _console_log_draining = false;
+
 FOUNDATION_STATIC string_table_symbol_t console_string_encode(const char* s, size_t length /* = 0*/)
 {
     if (length == 0)
@@ -90,27 +127,13 @@ FOUNDATION_STATIC string_table_symbol_t console_string_encode(const char* s, siz
     return symbol;
 }
 
-FOUNDATION_STATIC void logger(hash_t context, error_level_t severity, const char* msg, size_t length)
+FOUNDATION_STATIC void console_add_message(hash_t context, error_level_t severity, bool prefix, const char* msg, size_t length)
 {
-    if (_console_module->log_stream)
-    {
-        stream_write_string(_console_module->log_stream, msg, length);
-        stream_write_endl(_console_module->log_stream);
-    }
-
-	#if BUILD_DEBUG
-    if (error() == ERROR_ASSERT)
-        return;
-
-    if (system_debugger_attached() && severity <= ERRORLEVEL_DEBUG)
-        return;
-	#endif
-
     memory_context_push(HASH_CONSOLE);
+    scoped_mutex_t lock(_console_module->lock);
 
     if (_console_module->concat_messages)
     {
-        scoped_mutex_t lock(_console_module->lock);
         log_message_t* last_message = array_last(_console_module->messages);
         if (last_message)
         {
@@ -118,6 +141,7 @@ FOUNDATION_STATIC void logger(hash_t context, error_level_t severity, const char
             string_t new_msg = string_allocate_concat(STRING_ARGS(prev), msg, length);
             last_message->msg_symbol = console_string_encode(new_msg.str, new_msg.length);
             string_deallocate(new_msg.str);
+            memory_context_pop();
             return;
         }
     }
@@ -125,7 +149,7 @@ FOUNDATION_STATIC void logger(hash_t context, error_level_t severity, const char
     {
         log_message_t m{ _console_module->next_log_message_id++, string_hash(msg, length), severity };
         m.context = context;
-        m.prefix = log_is_prefix_enabled();
+        m.prefix = prefix;
 
         #if BUILD_ENABLE_STATIC_HASH_DEBUG
         context = context ? context : HASH_DEFAULT;
@@ -133,7 +157,6 @@ FOUNDATION_STATIC void logger(hash_t context, error_level_t severity, const char
         const size_t hash_code_start = string_find(msg, length, '<', 12);
         const size_t hash_code_end = string_find(msg, length, '>', hash_code_start);
 
-        scoped_mutex_t lock(_console_module->lock);
         if (context_name.length != 0 && hash_code_start != STRING_NPOS && hash_code_end != STRING_NPOS)
         {
             _console_module->max_context_name_length = max(_console_module->max_context_name_length, context_name.length);
@@ -162,6 +185,180 @@ FOUNDATION_STATIC void logger(hash_t context, error_level_t severity, const char
     memory_context_pop();
 }
 
+FOUNDATION_STATIC void console_log_open_stream()
+{
+    string_const_t log_path = session_get_user_file_path(STRING_CONST("log.txt"));
+    if (fs_is_file(STRING_ARGS(log_path)))
+    {
+        // Move log file to prev_log.txt
+        string_const_t prev_log_path = session_get_user_file_path(STRING_CONST("prev_log.txt"));
+        fs_remove_file(STRING_ARGS(prev_log_path));
+        fs_move_file(STRING_ARGS(log_path), STRING_ARGS(prev_log_path));
+    }
+
+    _console_module->log_stream = stream_open(STRING_ARGS(log_path), STREAM_OUT | STREAM_CREATE | STREAM_TRUNCATE | STREAM_SYNC);
+    _console_module->log_stream_size = 0;
+}
+
+FOUNDATION_STATIC void console_log_write_file(const char* msg, size_t length)
+{
+    if (_console_module->log_stream == nullptr)
+        return;
+
+    stream_write_string(_console_module->log_stream, msg, length);
+    stream_write_endl(_console_module->log_stream);
+    _console_module->log_stream_size += length + 1;
+}
+
+/*! Writes the log records pushed so far to the log file and the console messages.
+ *
+ *  @return Number of log records written, or zero if another thread is already draining them.
+ */
+FOUNDATION_STATIC unsigned console_log_drain()
+{
+    // Only one thread can consume the records at a time.
+    if (!atomic_cas32(&_console_module->draining, 1, 0, memory_order_acquire, memory_order_relaxed))
+        return 0;
+
+    _console_log_draining = true;
+
+    unsigned record_count = 0;
+    bool written = false;
+    for (;;)
+    {
+        const uint32_t head = _console_module->records_head;
+        console_log_record_t& record = _console_module->records[head & (CONSOLE_LOG_RING_CAPACITY - 1)];
+        if (atomic_load32(&record.sequence, memory_order_acquire) != (int32_t)(head + 1))
+            break;
+
+        const char* msg = record.overflow ? record.overflow : record.text;
+        console_log_write_file(msg, record.length);
+        if (record.console)
+            console_add_message(record.context, record.severity, record.prefix, msg, record.length);
+
+        if (record.overflow)
+        {
+            memory_deallocate(record.overflow);
+            record.overflow = nullptr;
+        }
+
+        // Release the record for the producer that will wrap around to it.
+        atomic_store32(&record.sequence, (int32_t)(head + CONSOLE_LOG_RING_CAPACITY), memory_order_release);
+        _console_module->records_head = head + 1;
+        record_count++;
+        written = true;
+    }
+
+    const int32_t dropped_messages = atomic_load32(&_console_module->dropped_messages, memory_order_relaxed);
+    if (dropped_messages > 0)
+    {
+        atomic_add32(&_console_module->dropped_messages, -dropped_messages, memory_order_relaxed);
+        _console_module->dropped_message_count += dropped_messages;
+
+        string_const_t msg = string_format_static(STRING_CONST("%d log messages dropped (%" PRIsize " total)"), 
+            dropped_messages, _console_module->dropped_message_count);
+        console_log_write_file(STRING_ARGS(msg));
+        console_add_message(HASH_CONSOLE, ERRORLEVEL_WARNING, false, STRING_ARGS(msg));
+        written = true;
+    }
+
+    if (written && _console_module->log_stream)
+    {
+        stream_flush(_console_module->log_stream);
+        if (_console_module->log_stream_size >= CONSOLE_LOG_FILE_MAX_SIZE)
+        {
+            stream_deallocate(_console_module->log_stream);
+            console_log_open_stream();
+        }
+    }
+
+    _console_log_draining = false;
+    atomic_store32(&_console_module->draining, 0, memory_order_release);
+    return record_count;
+}
+
+FOUNDATION_STATIC void logger(hash_t context, error_level_t severity, const char* msg, size_t length)
+{
+    // Messages are always written to the log file, but some are not shown in the console.
+    bool console = true;
+	#if BUILD_DEBUG
+    if (error() == ERROR_ASSERT)
+        console = false;
+
+    if (system_debugger_attached() && severity <= ERRORLEVEL_DEBUG)
+        console = false;
+	#endif
+
+    // Claim the next record, or drop the message if the consumer is too far behind.
+    // Errors are never dropped, the records get drained to make room for them.
+    console_log_record_t* record = nullptr;
+    uint32_t tail = (uint32_t)atomic_load32(&_console_module->records_tail, memory_order_relaxed);
+    for (;;)
+    {
+        record = &_console_module->records[tail & (CONSOLE_LOG_RING_CAPACITY - 1)];
+        const int32_t diff = (int32_t)((uint32_t)atomic_load32(&record->sequence, memory_order_acquire) - tail);
+        if (diff == 0)
+        {
+            if (atomic_cas32(&_console_module->records_tail, (int32_t)(tail + 1), (int32_t)tail, memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0 && severity < ERRORLEVEL_ERROR)
+        {
+            atomic_incr32(&_console_module->dropped_messages, memory_order_relaxed);
+            return;
+        }
+        else if (diff < 0 && _console_log_draining)
+        {
+            // This thread is the one draining the records, so it owns the log file.
+            console_log_write_file(msg, length);
+            return;
+        }
+        else if (diff < 0 && console_log_drain() == 0)
+        {
+            thread_yield();
+        }
+
+        tail = (uint32_t)atomic_load32(&_console_module->records_tail, memory_order_relaxed);
+    }
+
+    record->context = context;
+    record->severity = severity;
+    record->prefix = log_is_prefix_enabled();
+    record->console = console;
+    record->length = length;
+    if (length < sizeof(record->text))
+    {
+        memcpy(record->text, msg, length);
+        record->text[length] = '\0';
+        record->overflow = nullptr;
+    }
+    else
+    {
+        record->overflow = (char*)memory_allocate(HASH_CONSOLE, length + 1, 0, MEMORY_PERSISTENT);
+        memcpy(record->overflow, msg, length);
+        record->overflow[length] = '\0';
+    }
+
+    // Publish the record to the consumer.
+    atomic_store32(&record->sequence, (int32_t)(tail + 1), memory_order_release);
+
+    // Errors, including failed asserts, and panics are written to the log file before returning, 
+    // in case the application does not survive long enough for the main thread to drain them.
+    if (severity >= ERRORLEVEL_ERROR && !_console_log_draining)
+    {
+        while (atomic_load32(&record->sequence, memory_order_acquire) == (int32_t)(tail + 1))
+        {
+            if (console_log_drain() == 0)
+                thread_yield();
+        }
+    }
+}
+
+FOUNDATION_STATIC void console_update()
+{
+    console_log_drain();
+}
+
 FOUNDATION_STATIC string_const_t console_get_log_trimmed_text(const log_message_t& log)
 {
     // Find the first : character and truncate the text length
@@ -393,8 +590,13 @@ FOUNDATION_STATIC void console_render_evaluator()
     }
 
     ImGui::SameLine();
-    if (ImGui::Button(tr("Eval"), ImVec2(-1, -1)))
+    ImGui::BeginGroup();
+    if (ImGui::Button(tr("Eval"), ImVec2(-1, -ImGui::GetFrameHeightWithSpacing())))
         evaluate = true;
+    ImGui::Checkbox(tr("Profile"), &_console_module->profile_expression);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("%s", tr("Log the time spent in each expression function"));
+    ImGui::EndGroup();
 
     if (evaluate)
     {
@@ -464,6 +666,13 @@ FOUNDATION_STATIC void console_render_evaluator()
             }
         }
 
+        const bool profiling_enabled = expr_profile_enabled();
+        if (_console_module->profile_expression)
+        {
+            expr_profile_reset();
+            expr_profile_enable(true);
+        }
+
         expr_result_t result = eval(string_to_const(expression_string));
         if (EXPR_ERROR_CODE == 0)
         {
@@ -475,6 +684,12 @@ FOUNDATION_STATIC void console_render_evaluator()
                 EXPR_ERROR_CODE, STRING_FORMAT(expression_string), (int)string_length(EXPR_ERROR_MSG), EXPR_ERROR_MSG);
         }
 
+        if (_console_module->profile_expression)
+        {
+            expr_profile_enable(profiling_enabled);
+            expr_profile_log(HASH_EXPR);
+        }
+
         focus_text_field = true;
 
         string_deallocate(expression_string.str);
@@ -525,16 +740,13 @@ FOUNDATION_STATIC void console_module_ensure_initialized()
     {
         _console_module = MEM_NEW(HASH_CONSOLE, CONSOLE_MODULE);
         _console_module->lock = mutex_allocate(STRING_CONST("console_lock"));
+
+        _console_module->records = (console_log_record_t*)memory_allocate(HASH_CONSOLE, 
+            sizeof(console_log_record_t) * CONSOLE_LOG_RING_CAPACITY, alignof(console_log_record_t), MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+        for (uint32_t i = 0; i < CONSOLE_LOG_RING_CAPACITY; ++i)
+            atomic_store32(&_console_module->records[i].sequence, (int32_t)i, memory_order_relaxed);
         
-        string_const_t log_path = session_get_user_file_path(STRING_CONST("log.txt"));
-        if (fs_is_file(STRING_ARGS(log_path)))
-        {
-            // Move log file to prev_log.txt
-            string_const_t prev_log_path = session_get_user_file_path(STRING_CONST("prev_log.txt"));
-            fs_move_file(STRING_ARGS(log_path), STRING_ARGS(prev_log_path));
-        }
-        
-        _console_module->log_stream = stream_open(STRING_ARGS(log_path), STREAM_OUT | STREAM_CREATE | STREAM_TRUNCATE | STREAM_SYNC);
+        console_log_open_stream();
     }
 }
 
@@ -564,6 +776,20 @@ void console_set_expression(const char* expression, size_t expression_length)
     console_show();
 }
 
+void console_log(hash_t context, error_level_t severity, const char* msg, size_t length)
+{
+    console_module_ensure_initialized();
+    logger(context, severity, msg, length);
+}
+
+unsigned console_log_flush()
+{
+    if (_console_module == nullptr)
+        return 0;
+
+    return console_log_drain();
+}
+
 void console_add_secret_key_token(const char* key, size_t key_length)
 {
     console_module_ensure_initialized();
@@ -585,7 +811,9 @@ FOUNDATION_STATIC void console_initialize()
     if (BUILD_APPLICATION && !main_is_running_tests())
     {
         log_set_handler(logger);
+        module_register_update(HASH_CONSOLE, console_update);
         _console_module->opened = environment_argument("console") || session_get_bool("show_console", _console_module->opened);
+        _console_module->profile_expression = session_get_bool("console_profile_expression", false);
         module_register_menu(HASH_CONSOLE, console_menu);
 
         app_register_menu(HASH_CONSOLE,  STRING_CONST("Windows/" ICON_MD_LOGO_DEV " Console"), STRING_CONST("F10"), AppMenu::Append, [](void*)
@@ -614,9 +842,13 @@ FOUNDATION_STATIC void console_shutdown()
         log_set_handler(nullptr);
     }
 
+    // Write the last messages to the log file before it gets closed.
+    console_log_drain();
+
     console_clear_all();
     mutex_deallocate(_console_module->lock);
     session_set_bool("show_console", _console_module->opened);
+    session_set_bool("console_profile_expression", _console_module->profile_expression);
     string_deallocate(_console_module->selected_msg.str);
 
     if (_console_module->saved_expressions.size() > 0)
@@ -635,6 +867,7 @@ FOUNDATION_STATIC void console_shutdown()
         _console_module->log_stream = nullptr;
     }
 
+    memory_deallocate(_console_module->records);
     MEM_DELETE(_console_module);
 }
 
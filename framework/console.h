@@ -8,6 +8,7 @@
 #pragma once
 
 #include <foundation/platform.h>
+#include <foundation/types.h>
 
 /*! Clear the console logs. */
 void console_clear();
@@ -32,3 +33,20 @@ void console_set_expression(const char* expression, size_t expression_length);
  */
 void console_add_secret_key_token(const char* key, size_t key_length);
 
+/*! Reports a log message to the console and the log file, this is the log handler used by the application.
+ * 
+ *  Messages are queued and written by the main thread, but errors, failed asserts 
+ *  and panics are written to the log file before this returns.
+ * 
+ *  @param context  Log context.
+ *  @param severity Log severity.
+ *  @param msg      Log message.
+ *  @param length   Log message length.
+ */
+void console_log(hash_t context, error_level_t severity, const char* msg, size_t length);
+
+/*! Writes the queued log messages to the log file and the console on the calling thread.
+ * 
+ *  @return Number of log messages written, or zero if another thread is already writing them.
+ */
+unsigned console_log_flush();
@@ -18,6 +18,7 @@
 #include <framework/plot_expr.h>
 #include <framework/table_expr.h>
 #include <framework/array.h>
+#include <framework/scoped_mutex.h>
 
 #include <foundation/random.h>
 #include <foundation/system.h>
@@ -35,6 +36,50 @@ static expr_func_t* _expr_user_funcs = nullptr;
 static string_t* _expr_user_funcs_names = nullptr;
 static thread_local expr_result_t* _empty_list = nullptr;
 
+/*! Default size of the evaluation arena memory blocks. */
+#define EXPR_ARENA_BLOCK_SIZE (64 * 1024)
+
+/*! Arena blocks larger than this are released instead of being recycled. */
+#define EXPR_ARENA_MAX_RETAINED_SIZE (8 * 1024 * 1024)
+
+/*! Foundation array watermark ('FARR'), used to create arena sets compatible with array_size. */
+#define EXPR_ARENA_ARRAY_WATERMARK (0x52524145U)
+
+/*! Evaluation arena memory block header. The block memory follows the header. */
+typedef struct expr_arena_block_t
+{
+    expr_arena_block_t* prev;
+    size_t              capacity;
+    size_t              used;
+} expr_arena_block_t;
+
+/*! Per thread bump allocator used for evaluation temporaries (result sets, nodes and strings). */
+typedef struct expr_arena_t
+{
+    /*! Current block, previous blocks are chained through #expr_arena_block_t::prev */
+    expr_arena_block_t* block{ nullptr };
+
+    /*! Last allocation, which can be grown in place. */
+    void*               last{ nullptr };
+
+    /*! Top level #eval nesting depth, the arena is only reset at depth 0. */
+    unsigned            depth{ 0 };
+
+    /*! Set while an evaluation expression tree is being parsed in the arena. */
+    bool                parsing{ false };
+
+    /*! Running count of arena allocations, used by the expression profiler. */
+    uint64_t            allocations{ 0 };
+
+    /*! Nesting depth of #expr_eval calls, each root call starts a new evaluation. */
+    unsigned            eval_depth{ 0 };
+
+    /*! Running count of top level evaluations, see #expr_evaluation_id. */
+    uint64_t            evaluations{ 0 };
+} expr_arena_t;
+
+static thread_local expr_arena_t _expr_arena;
+
 typedef struct {
     string_argument_type_t type; 
     union {
@@ -120,12 +165,191 @@ FOUNDATION_FORCEINLINE bool isvarchr(char c)
 #define vec_nth(v, i)		(v)->buf[i]
 #define vec_peek(v)			(v)->buf[(v)->len - 1]
 #define vec_pop(v)			(v)->buf[--(v)->len]
-#define vec_free(v)			(memory_deallocate((v)->buf), (v)->buf = NULL, (v)->len = (v)->cap = 0)
+#define vec_free(v)			(expr_vec_free((v)->buf), (v)->buf = NULL, (v)->len = (v)->cap = 0)
 #define vec_foreach(v, var, iter)                                              \
   if ((v)->len > 0)                                                            \
     for ((iter) = 0; (iter) < (v)->len && (((var) = (v)->buf[(iter)]), 1);     \
          ++(iter))
 
+/*
+ * Evaluation arena
+ */
+
+FOUNDATION_STATIC expr_arena_block_t* expr_arena_new_block(size_t min_capacity)
+{
+    const size_t capacity = max(min_capacity, (size_t)EXPR_ARENA_BLOCK_SIZE);
+    expr_arena_block_t* block = (expr_arena_block_t*)memory_allocate(
+        HASH_EXPR, sizeof(expr_arena_block_t) + capacity, 16, MEMORY_PERSISTENT);
+    block->prev = _expr_arena.block;
+    block->capacity = capacity;
+    block->used = 0;
+    _expr_arena.block = block;
+    return block;
+}
+
+FOUNDATION_FORCEINLINE uint8_t* expr_arena_block_data(const expr_arena_block_t* block)
+{
+    return (uint8_t*)(block + 1);
+}
+
+FOUNDATION_STATIC void* expr_arena_block_allocate(expr_arena_block_t* block, size_t size, size_t alignment)
+{
+    if (block == nullptr)
+        return nullptr;
+
+    uint8_t* data = expr_arena_block_data(block);
+    const uintptr_t start = (uintptr_t)(data + block->used);
+    const uintptr_t aligned = (start + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+    if (aligned + size > (uintptr_t)(data + block->capacity))
+        return nullptr;
+
+    block->used = (size_t)(aligned + size - (uintptr_t)data);
+    return (void*)aligned;
+}
+
+void* expr_arena_allocate(size_t size, size_t alignment /*= 8*/)
+{
+    FOUNDATION_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    void* ptr = expr_arena_block_allocate(_expr_arena.block, size, alignment);
+    if (ptr == nullptr)
+        ptr = expr_arena_block_allocate(expr_arena_new_block(size + alignment), size, alignment);
+
+    _expr_arena.last = ptr;
+    _expr_arena.allocations++;
+    return ptr;
+}
+
+/*! Grows an arena allocation. The last allocation is extended in place if the current block has room,
+ *  otherwise a new allocation is made and the old content is copied over, the old space being
+ *  reclaimed when the arena is reset.
+ */
+FOUNDATION_STATIC void* expr_arena_reallocate(void* ptr, size_t old_size, size_t new_size, size_t alignment)
+{
+    expr_arena_block_t* block = _expr_arena.block;
+    if (ptr && ptr == _expr_arena.last && block)
+    {
+        uint8_t* data = expr_arena_block_data(block);
+        if ((uint8_t*)ptr + new_size <= data + block->capacity)
+        {
+            block->used = (size_t)((uint8_t*)ptr + new_size - data);
+            return ptr;
+        }
+    }
+
+    void* new_ptr = expr_arena_allocate(new_size, alignment);
+    if (ptr && old_size)
+        memcpy(new_ptr, ptr, min(old_size, new_size));
+    return new_ptr;
+}
+
+bool expr_arena_owns(const void* ptr)
+{
+    if (ptr == nullptr)
+        return false;
+
+    for (const expr_arena_block_t* block = _expr_arena.block; block; block = block->prev)
+    {
+        const uint8_t* data = expr_arena_block_data(block);
+        if ((const uint8_t*)ptr >= data && (const uint8_t*)ptr < data + block->capacity)
+            return true;
+    }
+
+    return false;
+}
+
+/*! Releases all the arena allocations at once. If the last evaluation needed many blocks,
+ *  they get coalesced into a single block so the next evaluation doesn't need to chain them.
+ */
+FOUNDATION_STATIC void expr_arena_reset()
+{
+    expr_arena_block_t* block = _expr_arena.block;
+    _expr_arena.last = nullptr;
+
+    if (block == nullptr)
+        return;
+
+    if (block->prev == nullptr && block->capacity <= EXPR_ARENA_MAX_RETAINED_SIZE)
+    {
+        block->used = 0;
+        return;
+    }
+
+    size_t total_capacity = 0;
+    while (block)
+    {
+        expr_arena_block_t* prev = block->prev;
+        total_capacity += block->capacity;
+        memory_deallocate(block);
+        block = prev;
+    }
+
+    _expr_arena.block = nullptr;
+    if (total_capacity <= EXPR_ARENA_MAX_RETAINED_SIZE)
+        expr_arena_new_block(total_capacity);
+}
+
+FOUNDATION_STATIC void expr_arena_shutdown()
+{
+    for (expr_arena_block_t* block = _expr_arena.block; block;)
+    {
+        expr_arena_block_t* prev = block->prev;
+        memory_deallocate(block);
+        block = prev;
+    }
+    _expr_arena = {};
+}
+
+string_const_t expr_arena_string_clone(const char* str, size_t length)
+{
+    char* buffer = (char*)expr_arena_allocate(length + 1, 1);
+    if (length)
+        memcpy(buffer, str, length);
+    buffer[length] = 0;
+    return string_const(buffer, length);
+}
+
+FOUNDATION_STATIC expr_result_t* expr_arena_list_grow(expr_result_t* list, uint32_t capacity)
+{
+    const size_t header_size = sizeof(uint32_t) * _array_header_size;
+    uint32_t* raw = list ? _array_raw(list) : nullptr;
+    const uint32_t size = raw ? raw[1] : 0;
+    if (raw && raw[0] >= capacity)
+        return list;
+
+    raw = (uint32_t*)expr_arena_reallocate(raw, header_size + sizeof(expr_result_t) * size, header_size + sizeof(expr_result_t) * capacity, 16);
+    raw[0] = capacity;
+    raw[1] = size;
+    raw[2] = EXPR_ARENA_ARRAY_WATERMARK;
+    raw[3] = (uint32_t)sizeof(expr_result_t);
+    return (expr_result_t*)(raw + _array_header_size);
+}
+
+expr_result_t* expr_eval_list_reserve(uint32_t capacity)
+{
+    return expr_arena_list_grow(nullptr, max(capacity, 1U));
+}
+
+expr_result_t* expr_eval_list_push(expr_result_t*& list, const expr_result_t& value)
+{
+    FOUNDATION_ASSERT_MSG(list == nullptr || expr_arena_owns(list), "Result set must be allocated in the evaluation arena");
+
+    if (list == nullptr)
+        list = expr_arena_list_grow(nullptr, 8);
+    else if (_array_rawsize(list) >= _array_rawcapacity(list))
+        list = expr_arena_list_grow(list, _array_rawcapacity(list) * 2);
+
+    list[_array_rawsize(list)++] = value;
+    return list;
+}
+
+FOUNDATION_STATIC void expr_vec_free(void* buf)
+{
+    // Expression nodes parsed in the evaluation arena are released when the arena gets reset.
+    if (buf && !expr_arena_owns(buf))
+        memory_deallocate(buf);
+}
+
 /*
  * Simple expandable vector implementation
  */
@@ -137,7 +361,10 @@ FOUNDATION_STATIC int expr_vec_expand(char** buf, int* length, int* cap, int mem
     {
         void* ptr;
         int n = (*cap == 0) ? 1 : *cap << 1;
-        ptr = memory_reallocate(*buf, n * memsz, 8, *cap * memsz/*memory_size(*buf)*/, MEMORY_PERSISTENT);
+        if (_expr_arena.parsing)
+            ptr = expr_arena_reallocate(*buf, *cap * memsz, n * memsz, 8);
+        else
+            ptr = memory_reallocate(*buf, n * memsz, 8, *cap * memsz/*memory_size(*buf)*/, MEMORY_PERSISTENT);
         if (ptr == NULL)
         {
             log_errorf(HASH_EXPR, ERROR_OUT_OF_MEMORY, STRING_CONST("Failed to allocate memory to expand vector"));
@@ -253,18 +480,22 @@ const expr_result_t* expr_eval_list(const expr_result_t* list)
     if (list == nullptr)
         return expr_eval_empty_list();
 
+    // Sets allocated in the evaluation arena are released all at once on the next evaluation.
+    if (expr_arena_owns(list))
+        return list;
+
     array_push(_expr_lists, list);
     return list;
 }
 
 FOUNDATION_STATIC expr_result_t expr_eval_set(expr_t* e)
 {
-    expr_result_t* resolved_values = nullptr;
+    expr_result_t* resolved_values = e->args.len > 0 ? expr_eval_list_reserve(e->args.len) : nullptr;
 
     for (int i = 0; i < e->args.len; ++i)
     {
         expr_result_t r = expr_eval(&e->args.buf[i]);
-        array_push(resolved_values, r);
+        expr_eval_list_push(resolved_values, r);
     }
 
     return expr_eval_list(resolved_values);
@@ -278,41 +509,34 @@ expr_result_t expr_eval_merge(const expr_result_t& key, const expr_result_t& val
         for (auto e : key)
         {
             if (keep_nulls || !e.is_null())
-                array_push(kvp, e);
+                expr_eval_list_push(kvp, e);
         }
     }
     else if (keep_nulls || !key.is_null())
-        array_push(kvp, key);
+        expr_eval_list_push(kvp, key);
 
     if (value.type == EXPR_RESULT_ARRAY)
     {
         for (auto e : value)
         {
             if (keep_nulls || !e.is_null())
-                array_push(kvp, e);
+                expr_eval_list_push(kvp, e);
         }
     }
     else if (keep_nulls || !value.is_null())
-        array_push(kvp, value);
+        expr_eval_list_push(kvp, value);
 
     if (array_size(kvp) == 1)
-    {
-        expr_result_t single_value = kvp[0];
-        array_deallocate(kvp);
-        return single_value;
-    }
+        return kvp[0];
 
     return expr_eval_list(kvp);
 }
 
 expr_result_t expr_eval_pair(const expr_result_t& key, const expr_result_t& value)
 {
-    expr_result_t* kvp = nullptr;
-    array_push(kvp, key);
-    array_push(kvp, value);
-    if (kvp) {
-        array_push(_expr_lists, kvp);
-    }
+    expr_result_t* kvp = expr_eval_list_reserve(2);
+    expr_eval_list_push(kvp, key);
+    expr_eval_list_push(kvp, value);
     return expr_result_t(kvp, 1ULL);
 }
 
@@ -329,8 +553,8 @@ expr_result_t expr_eval_get_set_arg(const vec_expr_t* args, size_t idx, const ch
         throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "Set cannot be null: %s", STRING_FORMAT(args->buf[idx].token), message);
 
     // If we have a single value, wrap it in a set
-    expr_result_t* single_value_set = nullptr;
-    array_push(single_value_set, value);
+    expr_result_t* single_value_set = expr_eval_list_reserve(1);
+    expr_eval_list_push(single_value_set, value);
     return expr_eval_list(single_value_set);
 }
 
@@ -348,9 +572,7 @@ string_const_t expr_eval_get_string_arg(const vec_expr_t* args, size_t idx, cons
 FOUNDATION_STATIC string_const_t expr_eval_get_string_copy_arg(const vec_expr_t* args, size_t idx, const char* message)
 {
     const auto& arg_string = expr_eval_get_string_arg(args, idx, message);
-
-    string_t arg_buffer = string_static_buffer(arg_string.length + 1);
-    return string_to_const(string_copy(STRING_ARGS(arg_buffer), STRING_ARGS(arg_string)));
+    return expr_arena_string_clone(STRING_ARGS(arg_string));
 }
 
 FOUNDATION_STATIC expr_result_t expr_eval_date_to_string(const expr_func_t* f, vec_expr_t* args, void* c)
@@ -690,13 +912,13 @@ FOUNDATION_STATIC const expr_result_t* expr_eval_expand_args(vec_expr_t* args)
         expr_result_t fexpr = expr_eval(&args->buf[arg_index++]);
         if (fexpr.type == EXPR_RESULT_ARRAY)
             return fexpr.list;
-        array_push(list, fexpr);
+        expr_eval_list_push(list, fexpr);
     }
 
     for (; arg_index < args->len; ++arg_index)
     {
         const expr_result_t& e = expr_eval(&vec_nth(args, arg_index));
-        array_push(list, e);
+        expr_eval_list_push(list, e);
     }
 
     return expr_eval_list(list);
@@ -782,7 +1004,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_math_count(const expr_func_t* f, vec_e
     for (int arg_index = 0; arg_index < args->len; ++arg_index)
     {
         const expr_result_t& e = expr_eval(args->get(arg_index));
-        array_push(counts, (double)e.element_count());
+        expr_eval_list_push(counts, (double)e.element_count());
     }
 
     return expr_eval_list(counts);
@@ -834,7 +1056,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_last(const expr_func_t* f, vec_expr_t*
     {
         if (count == 1)
             return set.element_at(i);
-        array_push(results, set.element_at(i));
+        expr_eval_list_push(results, set.element_at(i));
     }
 
     return expr_eval_list(results);
@@ -858,7 +1080,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_reverse(const expr_func_t* f, vec_expr
 
     expr_result_t* results = nullptr;
     for (uint32_t i = element_count; i > 0; --i)
-        array_push(results, set.element_at(i - 1));
+        expr_eval_list_push(results, set.element_at(i - 1));
 
     return expr_eval_list(results);
 }
@@ -911,7 +1133,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_range(const expr_func_t* f, vec_expr_t
 
     expr_result_t* results = nullptr;
     for (uint32_t i = start; i <= end; ++i)
-        array_push(results, set.element_at(i));
+        expr_eval_list_push(results, set.element_at(i));
 
     return expr_eval_list(results);
 }
@@ -942,7 +1164,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_first(const expr_func_t* f, vec_expr_t
     {
         if (count == 1)
             return set.element_at(i);
-        array_push(results, set.element_at(i));
+        expr_eval_list_push(results, set.element_at(i));
     }
 
     return expr_eval_list(results);
@@ -992,7 +1214,8 @@ FOUNDATION_STATIC expr_result_t expr_eval_string_lpad(const expr_func_t* f, vec_
         return value;
 
     const size_t capacity = length + 1;
-    string_t buffer = string_allocate(0, capacity);
+    string_t buffer = { (char*)expr_arena_allocate(capacity, 1), 0 };
+    buffer.str[0] = 0;
 
     // Repeat append the padding string until we've reached the desired length
     while (buffer.length < length - value.length)
@@ -1010,10 +1233,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_string_lpad(const expr_func_t* f, vec_
 
     buffer = string_append(STRING_ARGS(buffer), capacity, value.str, value.length);
 
-    expr_result_t padded = expr_result_t(string_to_const(buffer));
-    string_deallocate(buffer.str);
-
-    return padded;
+    return expr_result_t(string_to_const(buffer));
 }
 
 FOUNDATION_STATIC expr_result_t expr_eval_string_rpad(const expr_func_t* f, vec_expr_t* args, void* c)
@@ -1035,7 +1255,8 @@ FOUNDATION_STATIC expr_result_t expr_eval_string_rpad(const expr_func_t* f, vec_
         return expr_result_t(value);
 
     const size_t capacity = length + 1;
-    string_t buffer = string_allocate(0, capacity);
+    string_t buffer = { (char*)expr_arena_allocate(capacity, 1), 0 };
+    buffer.str[0] = 0;
 
     buffer = string_append(STRING_ARGS(buffer), capacity, value.str, value.length);
 
@@ -1045,10 +1266,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_string_rpad(const expr_func_t* f, vec_
         buffer = string_append(STRING_ARGS(buffer), capacity, padding.str, padding.length);
     }
 
-    expr_result_t padded = expr_result_t(string_to_const(buffer));
-    string_deallocate(buffer.str);
-
-    return padded;
+    return expr_result_t(string_to_const(buffer));
 }
 
 FOUNDATION_STATIC expr_result_t expr_eval_string_ends_with(const expr_func_t* f, vec_expr_t* args, void* c)
@@ -1101,7 +1319,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_string_format(const expr_func_t* f, ve
             {
                 string_const_t s = e.as_string();
                 expr_format_supported_value_t v{StringArgumentType::CSTRING};
-                v.s = string_clone(STRING_ARGS(s)).str;
+                v.s = (char*)expr_arena_string_clone(STRING_ARGS(s)).str;
                 array_push(results, v);
             }
         }
@@ -1167,11 +1385,6 @@ FOUNDATION_STATIC expr_result_t expr_eval_string_format(const expr_func_t* f, ve
                 results[8].type, results[8].u);
         }
 
-        for (unsigned i = 0, end = array_size(results); i < end; ++i)
-        {
-            if (results[i].type == StringArgumentType::CSTRING)
-                string_deallocate(results[i].s);
-        }
         array_deallocate(results);
     }
     
@@ -1308,7 +1521,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_distinct(const expr_func_t* f, vec_exp
             }
         }
         if (!found)
-            array_push(uniqs, e);
+            expr_eval_list_push(uniqs, e);
     }
 
     return expr_eval_list(uniqs);
@@ -1330,11 +1543,11 @@ FOUNDATION_STATIC expr_result_t expr_eval_concat(const expr_func_t* f, vec_expr_
         if (arg.is_set())
         {
             for (unsigned j = 0, end = arg.element_count(); j < end; ++j)
-                array_push(elements, arg.element_at(j));
+                expr_eval_list_push(elements, arg.element_at(j));
         }
         else if (arg.type != EXPR_RESULT_NULL)
         {
-            array_push(elements, arg);
+            expr_eval_list_push(elements, arg);
         }
     }
 
@@ -1467,7 +1680,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_repeat(const expr_func_t* f, vec_expr_
         vi->value = expr_result_t((double)i);
 
         expr_result_t r = expr_eval(&args->buf[0]);
-        array_push_memcpy(results, &r);
+        expr_eval_list_push(results, r);
     }
 
     return expr_eval_list(results);
@@ -1520,7 +1733,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_inline(const expr_func_t* f, vec_expr_
                 expr_result_t arg_value = expr_eval(args->get(i));
                 expr_set_global_var(STRING_ARGS(arg_name), arg_value);
 
-                array_push_memcpy(elements, &arg_value);
+                expr_eval_list_push(elements, arg_value);
             }
 
             expr_set_global_var(STRING_CONST("@ARGS"), expr_eval_list(elements));
@@ -1540,7 +1753,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_inline(const expr_func_t* f, vec_expr_
     for (int i = 0; i < args->len; ++i)
     {
         const auto& r = expr_eval(&args->buf[i]);
-        array_push_memcpy(results, &r);
+        expr_eval_list_push(results, r);
     }
     return expr_eval_list(results);
 }
@@ -1563,16 +1776,17 @@ FOUNDATION_STATIC expr_result_t expr_eval_filter(const expr_func_t* f, vec_expr_
     if (!elements.is_set())
         throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "First argument must be a result set");
 
-    expr_result_t* results = nullptr;
+    expr_result_t* results = expr_eval_list_reserve(elements.element_count());
+    expr_result_t* var_stack = expr_eval_list_reserve(4);
     for (auto e : elements)
     {
         // Set _ to the current element
         expr_set_or_create_global_var(STRING_CONST("_"), e);
 
-        expr_result_t* var_stack = nullptr;
+        array_clear(var_stack);
         if (!e.is_set())
         {
-            array_push(var_stack, expr_get_global_var_value("$1"));
+            expr_eval_list_push(var_stack, expr_get_global_var_value("$1"));
             expr_set_or_create_global_var(STRING_CONST("$1"), e);
         }
         else
@@ -1582,7 +1796,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_filter(const expr_func_t* f, vec_expr_
             for (auto m : e)
             {
                 string_t macro = string_format(STRING_BUFFER(varname), STRING_CONST("$%d"), i);
-                array_push(var_stack, expr_get_global_var_value(STRING_ARGS(macro)));
+                expr_eval_list_push(var_stack, expr_get_global_var_value(STRING_ARGS(macro)));
                 expr_set_or_create_global_var(STRING_ARGS(macro), m);
                 i++;
             }
@@ -1590,7 +1804,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_filter(const expr_func_t* f, vec_expr_
 
         expr_result_t r = expr_eval(&args->buf[1]);
         if (r.type != EXPR_RESULT_FALSE && (r.type == EXPR_RESULT_TRUE || r.as_number() != 0))
-            array_push_memcpy(results, &e);
+            expr_eval_list_push(results, e);
 
         // Restore global variables
         for (unsigned i = 0, end = array_size(var_stack); i < end; ++i)
@@ -1599,7 +1813,6 @@ FOUNDATION_STATIC expr_result_t expr_eval_filter(const expr_func_t* f, vec_expr_
             string_t macro = string_format(STRING_BUFFER(varname), STRING_CONST("$%d"), i+1);
             expr_set_or_create_global_var(STRING_ARGS(macro), var_stack[i]);
         }
-        array_deallocate(var_stack);
     }
 
     return expr_eval_list(results);
@@ -1623,17 +1836,18 @@ FOUNDATION_STATIC expr_result_t expr_eval_map(const expr_func_t* f, vec_expr_t*
     if (!elements.is_set())
         throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "First argument must be a result set");
 
-    expr_result_t* results = nullptr;
+    expr_result_t* results = expr_eval_list_reserve(elements.element_count());
+    expr_result_t* var_stack = expr_eval_list_reserve(4);
 
     for (auto e : elements)
     {
         // Set _ to the current element
         expr_set_or_create_global_var(STRING_CONST("_"), e);
 
-        expr_result_t* var_stack = nullptr;
+        array_clear(var_stack);
         if (!e.is_set())
         {
-            array_push(var_stack, expr_get_global_var_value("$1"));
+            expr_eval_list_push(var_stack, expr_get_global_var_value("$1"));
             expr_set_or_create_global_var(STRING_CONST("$1"), e);
         }
         else
@@ -1643,33 +1857,23 @@ FOUNDATION_STATIC expr_result_t expr_eval_map(const expr_func_t* f, vec_expr_t*
             for (auto m : e)
             {
                 string_t macro = string_format(STRING_BUFFER(varname), STRING_CONST("$%d"), i);
-                array_push(var_stack, expr_get_global_var_value(STRING_ARGS(macro)));
+                expr_eval_list_push(var_stack, expr_get_global_var_value(STRING_ARGS(macro)));
                 expr_set_or_create_global_var(STRING_ARGS(macro), m);
                 i++;
             }
         }
 
-        try
-        {
-            expr_result_t r = expr_eval(&args->buf[1]);
-            if (r.is_set() && r.index == NO_INDEX)
-                r.index = r.element_count() - 1;
-            array_push_memcpy(results, &r);
-
-            // Restore global variables
-            for (unsigned i = 0, end = array_size(var_stack); i < end; ++i)
-            {
-                char varname[4];
-                string_t macro = string_format(STRING_BUFFER(varname), STRING_CONST("$%d"), i+1);
-                expr_set_or_create_global_var(STRING_ARGS(macro), var_stack[i]);
-            }
+        expr_result_t r = expr_eval(&args->buf[1]);
+        if (r.is_set() && r.index == NO_INDEX)
+            r.index = r.element_count() - 1;
+        expr_eval_list_push(results, r);
 
-            array_deallocate(var_stack);
-        }
-        catch (ExprError& e)
+        // Restore global variables
+        for (unsigned i = 0, end = array_size(var_stack); i < end; ++i)
         {
-            array_deallocate(var_stack);
-            throw e;
+            char varname[4];
+            string_t macro = string_format(STRING_BUFFER(varname), STRING_CONST("$%d"), i+1);
+            expr_set_or_create_global_var(STRING_ARGS(macro), var_stack[i]);
         }
     }
 
@@ -1900,12 +2104,130 @@ FOUNDATION_STATIC expr_var_t* expr_var(expr_var_list_t* vars, const char* s, siz
     return v;
 }
 
+/*! Profiled function evaluation frame, used to compute exclusive and wait times of nested calls. */
+typedef struct expr_profile_frame_t
+{
+    expr_profile_frame_t*   parent;
+    tick_t                  start;
+    tick_t                  children;
+    tick_t                  wait_start;
+    tick_t                  wait;
+    uint64_t                allocations;
+} expr_profile_frame_t;
+
+static bool _expr_profile_enabled = false;
+static mutex_t* _expr_profile_lock = nullptr;
+static expr_profile_entry_t* _expr_profile_entries = nullptr;
+static thread_local expr_profile_frame_t* _expr_profile_frame = nullptr;
+
+FOUNDATION_STATIC uint64_t expr_profile_allocation_count()
+{
+    // Heap statistics are process wide, so allocations made concurrently by 
+    // other threads can be accounted to the function being profiled.
+    #if BUILD_ENABLE_MEMORY_STATISTICS
+    return memory_statistics().allocations_total + _expr_arena.allocations;
+    #else
+    return _expr_arena.allocations;
+    #endif
+}
+
+FOUNDATION_STATIC void expr_profile_record(string_const_t name, tick_t inclusive, tick_t exclusive, tick_t wait, uint64_t allocations)
+{
+    const hash_t key = string_hash(STRING_ARGS(name));
+
+    scoped_mutex_t lock(_expr_profile_lock);
+    int index = array_binary_search_compare(_expr_profile_entries, key, [](const expr_profile_entry_t& e, hash_t key)
+    {
+        return e.key < key ? -1 : (e.key > key ? 1 : 0);
+    });
+
+    if (index < 0)
+    {
+        expr_profile_entry_t entry{ key };
+        string_copy(STRING_BUFFER(entry.name), STRING_ARGS(name));
+
+        index = ~index;
+        array_insert_memcpy(_expr_profile_entries, index, &entry);
+    }
+
+    expr_profile_entry_t& entry = _expr_profile_entries[index];
+    entry.calls++;
+    entry.inclusive += inclusive;
+    entry.exclusive += exclusive;
+    entry.wait += wait;
+    entry.allocations += allocations;
+}
+
+/*! Records the statistics of a function node evaluation when the profiler is enabled. */
+struct ExprProfileFunctionScope
+{
+    const expr_func_t* func;
+    expr_profile_frame_t frame;
+
+    FOUNDATION_FORCEINLINE ExprProfileFunctionScope(const expr_func_t* f)
+        : func(f)
+    {
+        frame.parent = _expr_profile_frame;
+        frame.children = 0;
+        frame.wait_start = 0;
+        frame.wait = 0;
+        frame.allocations = expr_profile_allocation_count();
+        _expr_profile_frame = &frame;
+
+        #if BUILD_ENABLE_PROFILE
+        profile_begin_block(STRING_ARGS(func->name));
+        #endif
+
+        frame.start = time_current();
+    }
+
+    FOUNDATION_FORCEINLINE ~ExprProfileFunctionScope()
+    {
+        const tick_t now = time_current();
+        const tick_t inclusive = time_diff(frame.start, now);
+
+        #if BUILD_ENABLE_PROFILE
+        profile_end_block();
+        #endif
+
+        // Close any wait left opened by an exception
+        if (frame.wait_start != 0)
+            frame.wait += time_diff(frame.wait_start, now);
+
+        _expr_profile_frame = frame.parent;
+        if (frame.parent)
+            frame.parent->children += inclusive;
+
+        const tick_t exclusive = inclusive > frame.children ? inclusive - frame.children : 0;
+        expr_profile_record(func->name, inclusive, exclusive, frame.wait, expr_profile_allocation_count() - frame.allocations);
+    }
+};
+
 expr_result_t expr_eval_var(expr_t* e)
 {
     return *e->param.var.value;
 }
 
-expr_result_t expr_eval(expr_t* e)
+FOUNDATION_STATIC expr_result_t expr_eval_function(expr_t* e)
+{
+    try
+    {
+        expr_result_t fn_result = e->param.func.f->handler(e->param.func.f, &e->args, e->param.func.context);
+        expr_var_t* v = expr_get_or_create_global_var(STRING_CONST("$0"));
+        v->value = fn_result;
+        return fn_result;
+    }
+    catch (ExprError err)
+    {
+        if (err.outer == EXPR_ERROR_EVAL_FUNCTION)
+            throw err;
+
+        throw ExprError(err.code, EXPR_ERROR_EVAL_FUNCTION, "Failed to evaluate function %.*s: %.*s", 
+            STRING_FORMAT(e->token), (int)err.message_length, err.message);
+    }
+}
+
+FOUNDATION_STATIC expr_result_t expr_eval_node(expr_t* e)
 {
     expr_result_t n;
     switch (e->type)
@@ -2018,22 +2340,13 @@ expr_result_t expr_eval(expr_t* e)
 
     case OP_FUNC:
     {
-        try
+        if (_expr_profile_enabled)
         {
-            expr_result_t fn_result = e->param.func.f->handler(e->param.func.f, &e->args, e->param.func.context);
-            expr_var_t* v = expr_get_or_create_global_var(STRING_CONST("$0"));
-            v->value = fn_result;
-            return fn_result;
-        }
-        catch (ExprError err)
-        {
-            if (err.outer == EXPR_ERROR_EVAL_FUNCTION)
-                throw err;
-
-            throw ExprError(err.code, EXPR_ERROR_EVAL_FUNCTION, "Failed to evaluate function %.*s: %.*s", 
-                STRING_FORMAT(e->token), (int)err.message_length, err.message);
+            ExprProfileFunctionScope profile_scope(e->param.func.f);
+            return expr_eval_function(e);
         }
         
+        return expr_eval_function(e);
     }
 
     case OP_SET:
@@ -2047,6 +2360,27 @@ expr_result_t expr_eval(expr_t* e)
     return NAN;
 }
 
+/*! Scope an #expr_eval call, the root call of an expression tree starts a new evaluation, see #expr_evaluation_id. */
+struct ExprEvalNodeScope
+{
+    FOUNDATION_FORCEINLINE ExprEvalNodeScope()
+    {
+        if (_expr_arena.eval_depth++ == 0)
+            _expr_arena.evaluations++;
+    }
+
+    FOUNDATION_FORCEINLINE ~ExprEvalNodeScope()
+    {
+        _expr_arena.eval_depth--;
+    }
+};
+
+expr_result_t expr_eval(expr_t* e)
+{
+    ExprEvalNodeScope scope;
+    return expr_eval_node(e);
+}
+
 FOUNDATION_STATIC int expr_next_token(const char* s, size_t len, int& flags)
 {
     unsigned int i = 0;
@@ -2597,7 +2931,10 @@ expr_t* expr_create(const char* s, size_t len, expr_var_list_t* vars, expr_func_
         }
     }
 
-    result = (expr_t*)memory_allocate(HASH_EXPR, sizeof(expr_t), 8, MEMORY_PERSISTENT);
+    if (_expr_arena.parsing)
+        result = (expr_t*)expr_arena_allocate(sizeof(expr_t), 8);
+    else
+        result = (expr_t*)memory_allocate(HASH_EXPR, sizeof(expr_t), 8, MEMORY_PERSISTENT);
     if (result != NULL) {
         if (vec_len(&es) == 0) {
             result->type = OP_CONST;
@@ -2634,12 +2971,13 @@ cleanup:
     return result;
 }
 
-void expr_destroy(expr_t* e, expr_var_list_t* vars)
+void expr_destroy(expr_t* e, expr_var_list_t* vars /*= nullptr*/)
 {
     if (e != NULL)
     {
         expr_destroy_args(e);
-        memory_deallocate(e);
+        if (!expr_arena_owns(e))
+            memory_deallocate(e);
     }
     if (vars != NULL)
     {
@@ -2652,6 +2990,16 @@ void expr_destroy(expr_t* e, expr_var_list_t* vars)
     }
 }
 
+expr_t* expr_parse(const char* expression, size_t expression_length)
+{
+    // Parsed trees outlive the current evaluation, so make sure they are not allocated in the arena.
+    const bool was_parsing = _expr_arena.parsing;
+    _expr_arena.parsing = false;
+    expr_t* e = expr_create(expression, expression_length, &_global_vars, _expr_user_funcs);
+    _expr_arena.parsing = was_parsing;
+    return e;
+}
+
 expr_result_t eval(const char* expression, size_t expression_length /*= -1*/)
 {
     return eval(string_const(expression, expression_length != -1 ? expression_length : string_length(expression)));
@@ -2659,7 +3007,11 @@ expr_result_t eval(const char* expression, size_t expression_length /*= -1*/)
 
 expr_result_t eval_inline(const char* expression, size_t expression_length)
 {
+    // The expression tree only lives for this evaluation, so parse it in the evaluation arena.
+    const bool was_parsing = _expr_arena.parsing;
+    _expr_arena.parsing = true;
     expr_t* e = expr_create(expression, expression_length, &_global_vars, _expr_user_funcs);
+    _expr_arena.parsing = was_parsing;
     if (e == NULL)
         return NIL;
 
@@ -2682,13 +3034,41 @@ expr_result_t eval_inline(const char* expression, size_t expression_length)
     return result;
 }
 
-expr_result_t eval(string_const_t expression)
+/*! Scope a top level evaluation. Temporaries of the previous evaluation are released
+ *  when entering the first level, nested evaluations keep their parent temporaries alive.
+ */
+struct ExprEvaluationScope
 {
-    memory_context_push(HASH_EXPR);
+    FOUNDATION_FORCEINLINE ExprEvaluationScope()
+    {
+        memory_context_push(HASH_EXPR);
 
-    for (unsigned i = 0, end = array_size(_expr_lists); i < end; ++i)
-        array_deallocate(_expr_lists[i]);
-    array_clear(_expr_lists);
+        if (_expr_arena.depth++ > 0)
+            return;
+
+        for (unsigned i = 0, end = array_size(_expr_lists); i < end; ++i)
+            array_deallocate(_expr_lists[i]);
+        array_clear(_expr_lists);
+
+        expr_arena_reset();
+        _expr_arena.evaluations++;
+    }
+
+    FOUNDATION_FORCEINLINE ~ExprEvaluationScope()
+    {
+        _expr_arena.depth--;
+        memory_context_pop();
+    }
+};
+
+uint64_t expr_evaluation_id()
+{
+    return _expr_arena.evaluations;
+}
+
+expr_result_t eval(string_const_t expression)
+{
+    ExprEvaluationScope scope;
 
     // Check if the expression is @FILE_PATH
     if (expression.length > 0 && expression.str[0] == '@')
@@ -2704,11 +3084,7 @@ expr_result_t eval(string_const_t expression)
         }
     }
 
-    expr_result_t result = eval_inline(STRING_ARGS(expression));
-    
-    memory_context_pop();
-
-    return result;
+    return eval_inline(STRING_ARGS(expression));
 }
 
 void expr_register_function(const char* name, exprfn_t fn, exprfn_cleanup_t cleanup /*= nullptr*/, size_t context_size /*= 0*/)
@@ -2879,6 +3255,86 @@ void expr_log_evaluation_result(string_const_t expression_string, const expr_res
     }
 }
 
+void expr_profile_enable(bool enable)
+{
+    _expr_profile_enabled = enable;
+}
+
+bool expr_profile_enabled()
+{
+    return _expr_profile_enabled;
+}
+
+void expr_profile_reset()
+{
+    scoped_mutex_t lock(_expr_profile_lock);
+    array_clear(_expr_profile_entries);
+}
+
+expr_profile_entry_t* expr_profile_entries()
+{
+    expr_profile_entry_t* entries = nullptr;
+
+    {
+        scoped_mutex_t lock(_expr_profile_lock);
+        const unsigned entry_count = array_size(_expr_profile_entries);
+        if (entry_count == 0)
+            return nullptr;
+        array_resize(entries, entry_count);
+        memcpy(entries, _expr_profile_entries, sizeof(expr_profile_entry_t) * entry_count);
+    }
+
+    return array_sort(entries, [](const expr_profile_entry_t& a, const expr_profile_entry_t& b)
+    {
+        if (a.exclusive == b.exclusive)
+            return 0;
+        return a.exclusive > b.exclusive ? -1 : 1;
+    });
+}
+
+void expr_profile_log(hash_t context, uint32_t max_entries /*= 10*/)
+{
+    expr_profile_entry_t* entries = expr_profile_entries();
+    if (entries == nullptr)
+    {
+        log_infof(context, STRING_CONST("No expression functions were profiled"));
+        return;
+    }
+
+    log_infof(context, STRING_CONST("Expression profile (%u functions)"), array_size(entries));
+    LOG_PREFIX(false);
+    log_infof(context, STRING_CONST("\t%-24s %8s %12s %12s %12s %10s"), "Function", "Calls", "Inclusive", "Exclusive", "Wait", "Allocs");
+    for (unsigned i = 0, end = min(array_size(entries), max_entries); i < end; ++i)
+    {
+        const expr_profile_entry_t& e = entries[i];
+        log_infof(context, STRING_CONST("\t%-24s %8" PRIu64 " %9.3lf ms %9.3lf ms %9.3lf ms %10" PRIu64),
+            e.name, e.calls, 
+            time_ticks_to_milliseconds(e.inclusive), 
+            time_ticks_to_milliseconds(e.exclusive), 
+            time_ticks_to_milliseconds(e.wait), 
+            e.allocations);
+    }
+
+    array_deallocate(entries);
+}
+
+void expr_profile_wait_begin()
+{
+    expr_profile_frame_t* frame = _expr_profile_frame;
+    if (frame && frame->wait_start == 0)
+        frame->wait_start = time_current();
+}
+
+void expr_profile_wait_end()
+{
+    expr_profile_frame_t* frame = _expr_profile_frame;
+    if (frame && frame->wait_start != 0)
+    {
+        frame->wait += time_diff(frame->wait_start, time_current());
+        frame->wait_start = 0;
+    }
+}
+
 ExprError::ExprError(expr_error_code_t code, expr_error_code_t outer, const char* msg, ...)
 {
     this->code = code;
@@ -2936,6 +3392,9 @@ ExprError::ExprError(expr_error_code_t code, const expr_func_t* f, vec_expr_t* a
 
 FOUNDATION_STATIC void expr_initialize()
 {
+    _expr_profile_lock = mutex_allocate(STRING_CONST("ExprProfile"));
+    _expr_profile_enabled = environment_argument("expr-profile");
+
     // Set functions
     array_push(_expr_user_funcs, (expr_func_t{ STRING_CONST("MIN"), expr_eval_math_min, NULL, 0 })); // MIN([-1, 0, 1])
     array_push(_expr_user_funcs, (expr_func_t{ STRING_CONST("MAX"), expr_eval_math_max, NULL, 0 })); // MAX([1, 2, 3]) + MAX(4, 5, 6) = 9
@@ -3062,6 +3521,13 @@ FOUNDATION_STATIC void expr_shutdown()
         array_deallocate(_expr_lists[i]);
     array_deallocate(_expr_lists);
     array_deallocate(_empty_list);
+    expr_arena_shutdown();
+
+    if (_expr_profile_enabled)
+        expr_profile_log(HASH_EXPR, UINT32_MAX);
+    array_deallocate(_expr_profile_entries);
+    mutex_deallocate(_expr_profile_lock);
+    _expr_profile_lock = nullptr;
 
     array_deallocate(_expr_user_funcs);
     string_array_deallocate(_expr_user_funcs_names);
@@ -206,6 +206,65 @@ typedef enum ExprResultType {
  */
 const expr_result_t* expr_eval_list(const expr_result_t* list);
 
+/*! Allocates memory from the thread local expression evaluation arena.
+ *
+ *  @remark The memory is released all at once when the next top level #eval starts,
+ *          it must never be deallocated with #memory_deallocate.
+ *
+ *  @param size      Number of bytes to allocate.
+ *  @param alignment Memory alignment of the allocation.
+ *
+ *  @return Pointer to the allocated memory.
+ */
+void* expr_arena_allocate(size_t size, size_t alignment = 8);
+
+/*! Checks if a pointer was allocated from the thread local evaluation arena.
+ *
+ *  @param ptr Pointer to check.
+ *
+ *  @return True if the pointer is owned by the evaluation arena.
+ */
+bool expr_arena_owns(const void* ptr);
+
+/*! Clones a string in the evaluation arena. The string is null terminated.
+ *
+ *  @param str    String to clone.
+ *  @param length Length of the string to clone.
+ *
+ *  @return Temporary string valid until the next evaluation starts.
+ */
+string_const_t expr_arena_string_clone(const char* str, size_t length);
+
+/*! Returns the identifier of the current top level evaluation on the calling thread.
+ *
+ *  @remark Function handlers can use it to cache data that must only live for one evaluation,
+ *          i.e. data allocated in the evaluation arena.
+ *
+ *  @return Identifier that changes each time a new top level #eval or a root #expr_eval call starts.
+ */
+uint64_t expr_evaluation_id();
+
+/*! Push a value in an evaluation result set allocated in the evaluation arena.
+ *
+ *  @remark The set is compatible with the foundation array accessors (i.e. array_size),
+ *          but it must never be modified with array_push or array_deallocate.
+ *          If the set is null, a new one is allocated.
+ *
+ *  @param list  Result set to push the value to.
+ *  @param value Value to push.
+ *
+ *  @return The (possibly moved) result set.
+ */
+expr_result_t* expr_eval_list_push(expr_result_t*& list, const expr_result_t& value);
+
+/*! Allocates an empty evaluation result set in the evaluation arena.
+ *
+ *  @param capacity Number of elements to reserve.
+ *
+ *  @return Empty result set that can be filled using #expr_eval_list_push.
+ */
+expr_result_t* expr_eval_list_reserve(uint32_t capacity);
+
 /*! Expression result. 
  * 
  *  @note The @list member is used to store the result of an expression that
@@ -640,7 +699,7 @@ struct expr_result_t
         {
             expr_result_t* elements = nullptr;
             for (unsigned i = 0, end = element_count(); i < end; ++i)
-                array_push(elements, -element_at(i));
+                expr_eval_list_push(elements, -element_at(i));
             return expr_result_t(expr_eval_list(elements));
         }
 
@@ -667,7 +726,7 @@ struct expr_result_t
         {
             expr_result_t* elements = nullptr;
             for (unsigned i = 0, end = rhs.element_count(); i < end; ++i)
-                array_push(elements, *this * rhs.element_at(i));
+                expr_eval_list_push(elements, *this * rhs.element_at(i));
             return expr_result_t(expr_eval_list(elements));
         }
 
@@ -681,7 +740,7 @@ struct expr_result_t
         {
             expr_result_t* elements = nullptr;
             for (unsigned i = 0, end = element_count(); i < end; ++i)
-                array_push(elements, element_at(i) * rhs);
+                expr_eval_list_push(elements, element_at(i) * rhs);
             return expr_result_t(expr_eval_list(elements));
         }
 
@@ -691,7 +750,7 @@ struct expr_result_t
             for (unsigned i = 0, end = min(element_count(), rhs.element_count()); i < end; ++i)
             {
                 expr_result_t result = element_at(i) * rhs.element_at(i);
-                array_push(elements, result);
+                expr_eval_list_push(elements, result);
             }
             return expr_result_t(expr_eval_list(elements));
         }
@@ -715,7 +774,7 @@ struct expr_result_t
             for (unsigned i = 0, end = element_count(); i < end; ++i)
             {
                 expr_result_t div = element_at(i) / rhs;
-                array_push_memcpy(elements, &div);
+                expr_eval_list_push(elements, div);
             }
             return expr_result_t(expr_eval_list(elements));
         }
@@ -743,12 +802,10 @@ struct expr_result_t
             string_const_t s2 = rhs.as_string();
 
             const size_t capacity = s1.length + s2.length + 1;
-            string_t sc = string_allocate(0, capacity);
-            sc = string_concat(sc.str, capacity, STRING_ARGS(s1), STRING_ARGS(s2));
+            char* buffer = (char*)expr_arena_allocate(capacity, 1);
+            string_t sc = string_concat(buffer, capacity, STRING_ARGS(s1), STRING_ARGS(s2));
 
-            expr_result_t r(string_to_const(sc));
-            string_deallocate(sc.str);
-            return r;
+            return expr_result_t(string_to_const(sc));
         }
 
         // If both value are arrays, merge them into a new array.
@@ -756,9 +813,9 @@ struct expr_result_t
         {
             expr_result_t* elements = nullptr;
             for (unsigned i = 0, end = element_count(); i < end; ++i)
-                array_push(elements, element_at(i));
+                expr_eval_list_push(elements, element_at(i));
             for (unsigned i = 0, end = rhs.element_count(); i < end; ++i)
-                array_push(elements, rhs.element_at(i));
+                expr_eval_list_push(elements, rhs.element_at(i));
             return expr_eval_list(elements);
         }
 
@@ -1278,6 +1335,25 @@ expr_result_t eval_inline(const char* expression, size_t expression_length);
  */
 expr_result_t eval(const char* expression, size_t expression_length = -1);
 
+/*! Parse an expression without evaluating it, i.e. to inspect the functions and variables it references.
+ *
+ *  @remark Variables referenced by the expression are bound to the calling thread global variables,
+ *          so the expression tree should only be evaluated on the thread that parsed it.
+ *
+ *  @param expression        Expression to parse.
+ *  @param expression_length Length of the expression string.
+ *
+ *  @return Expression tree that must be released with #expr_destroy, or nullptr if the expression is invalid.
+ */
+expr_t* expr_parse(const char* expression, size_t expression_length);
+
+/*! Release an expression tree created with #expr_parse.
+ *
+ *  @param e    Expression tree to release.
+ *  @param vars Variable list to release as well, or nullptr.
+ */
+void expr_destroy(expr_t* e, expr_var_list_t* vars = nullptr);
+
 /*! Set a global expression variable to point to an application pointer.
  * 
  *  @remark Nothing special is done to manage the ptr lifespan. It is up to the application to ensure
@@ -1411,3 +1487,78 @@ expr_result_t expr_eval_get_set_arg(const vec_expr_t* args, size_t idx, const ch
  *  @param result              The result of the expression
  */
 void expr_log_evaluation_result(string_const_t expression_string, const expr_result_t& result);
+
+/*! Expression function profiling statistics, see #expr_profile_enable. */
+struct expr_profile_entry_t
+{
+    /*! Function name hash used to identify the entry. */
+    hash_t key;
+
+    /*! Function name (truncated). */
+    char name[32];
+
+    /*! Number of times the function was evaluated. */
+    uint64_t calls;
+
+    /*! Time spent in the function, including nested function calls. */
+    tick_t inclusive;
+
+    /*! Time spent in the function itself, excluding nested function calls. */
+    tick_t exclusive;
+
+    /*! Time spent blocked waiting for external data, see #ExprProfileWaitScope. */
+    tick_t wait;
+
+    /*! Number of memory allocations (heap and evaluation arena) made during the function calls. */
+    uint64_t allocations;
+};
+
+/*! Enable or disable the expression function profiler.
+ * 
+ *  When enabled, each function node evaluation records its call count, inclusive and
+ *  exclusive time, allocations and blocking waits. Function calls are also reported 
+ *  as profile blocks, which feeds the profiler tracker table when the application
+ *  is launched with --profile.
+ * 
+ *  @param enable True to start recording statistics, false to stop.
+ */
+void expr_profile_enable(bool enable);
+
+/*! Returns true if the expression function profiler is recording. */
+bool expr_profile_enabled();
+
+/*! Clears all the recorded expression function statistics. */
+void expr_profile_reset();
+
+/*! Returns a copy of the recorded expression function statistics sorted by exclusive time.
+ * 
+ *  @return Array of profile entries that must be deallocated with #array_deallocate.
+ */
+expr_profile_entry_t* expr_profile_entries();
+
+/*! Log the expression functions that took the most time.
+ * 
+ *  @param context      Log context to use.
+ *  @param max_entries  Maximum number of entries to log.
+ */
+void expr_profile_log(hash_t context, uint32_t max_entries = 10);
+
+/*! Marks the beginning of a blocking wait in the function being evaluated. */
+void expr_profile_wait_begin();
+
+/*! Marks the end of a blocking wait in the function being evaluated. */
+void expr_profile_wait_end();
+
+/*! Scope used to record time spent waiting on external data while evaluating a function. */
+struct ExprProfileWaitScope
+{
+    FOUNDATION_FORCEINLINE ExprProfileWaitScope()
+    {
+        expr_profile_wait_begin();
+    }
+
+    FOUNDATION_FORCEINLINE ~ExprProfileWaitScope()
+    {
+        expr_profile_wait_end();
+    }
+};
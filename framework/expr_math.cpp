@@ -257,7 +257,7 @@ FOUNDATION_STATIC expr_result_t expr_eval_simple_moving_average(const expr_func_
     if (set.element_count() <= 0)
         return set;
 
-    expr_result_t* sma = nullptr;
+    expr_result_t* sma = expr_eval_list_reserve(set.element_count());
     expr_result_t edistance = expr_eval(args->get(1));
     const int distance = to_int(edistance.as_number(2.0));
     for (int i = 0, end = to_int(set.element_count()); i < end; ++i)
@@ -278,11 +278,11 @@ FOUNDATION_STATIC expr_result_t expr_eval_simple_moving_average(const expr_func_
 
         if (count <= 1)
         {
-            array_push(sma, set.element_at(i));
+            expr_eval_list_push(sma, set.element_at(i));
         }
         else
         {
-            array_push(sma, expr_result_t(sum / count));
+            expr_eval_list_push(sma, expr_result_t(sum / count));
         }
     }
 
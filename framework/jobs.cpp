@@ -8,17 +8,57 @@
 #include "common.h"
 #include "concurrent_queue.h"
 #include "dispatcher.h"
+#include "profiler.h"
 
 #include <foundation/thread.h>
 #include <foundation/semaphore.h>
+#include <foundation/atomic.h>
 
 #ifndef MAX_JOB_THREADS
 #define MAX_JOB_THREADS 8
 #endif
 
+/*! Marks a job #job_t::waiter once the job completed. */
+#define JOB_WAITER_COMPLETED ((void*)(uintptr_t)1)
+
 static concurrent_queue<job_t*> _scheduled_jobs{};
 static thread_t* _job_threads[MAX_JOB_THREADS]{ nullptr };
 
+/*! Shared state of a parallel loop, released by the last thread using it. */
+struct job_parallel_for_t
+{
+    atomic32_t refs;
+    atomic32_t next_chunk;
+    atomic32_t completed_chunks;
+
+    size_t count{ 0 };
+    unsigned chunk_count{ 0 };
+    const job_parallel_handler_t* handler{ nullptr };
+};
+
+/*! Flags the job as completed, or deallocates it, and wakes up the thread waiting for it. */
+FOUNDATION_STATIC void job_complete(job_t* job)
+{
+    if (job->flags & JOB_DEALLOCATE_AFTER_EXECUTION)
+    {
+        job->completed = true;
+        job_deallocate(job);
+        return;
+    }
+
+    // Take the waiter before flagging the job as completed, since the owner can deallocate it right after.
+    void* waiter = atomic_load_ptr(&job->waiter, memory_order_acquire);
+    while (!atomic_cas_ptr(&job->waiter, JOB_WAITER_COMPLETED, waiter, memory_order_acq_rel, memory_order_acquire))
+        waiter = atomic_load_ptr(&job->waiter, memory_order_acquire);
+
+    // Flagging the job is the last access to it, the job status must be visible before.
+    atomic_thread_fence_release();
+    job->completed = true;
+
+    if (waiter)
+        semaphore_post((semaphore_t*)waiter);
+}
+
 static void* job_thread_fn(void* arg)
 {
     job_t* job = nullptr;
@@ -27,11 +67,13 @@ static void* job_thread_fn(void* arg)
     {
         if (_scheduled_jobs.try_pop(job, 16))
         {
-            job->status = job->handler((payload_t*)job->payload);
-            job->completed = true;
+            PERFORMANCE_TRACKER("job");
+            if (job->cancelled)
+                job->status = -1;
+            else
+                job->status = job->handler((payload_t*)job->payload);
 
-            if (job->flags & JOB_DEALLOCATE_AFTER_EXECUTION)
-                job_deallocate(job);
+            job_complete(job);
             signal_thread();
         }
     }
@@ -39,8 +81,8 @@ static void* job_thread_fn(void* arg)
     // Empty jobs before exiting thread (prevent memory leaks)
     while (_scheduled_jobs.try_pop(job))
     {
-        if (job->flags & JOB_DEALLOCATE_AFTER_EXECUTION)
-            job_deallocate(job);
+        job->status = -1;
+        job_complete(job);
     }
 
     return 0;
@@ -133,6 +175,67 @@ job_t* job_execute(const job_handler_t& handler, void* payload, size_t payload_s
     return new_job;
 }
 
+FOUNDATION_STATIC void job_parallel_for_run(job_parallel_for_t* loop)
+{
+    for (;;)
+    {
+        const int32_t chunk = atomic_incr32(&loop->next_chunk, memory_order_acq_rel) - 1;
+        if (chunk >= (int32_t)loop->chunk_count)
+            break;
+
+        // The handler is only accessed while some chunks are still being processed, so it is still alive.
+        const size_t begin = loop->count * chunk / loop->chunk_count;
+        const size_t end = loop->count * (chunk + 1) / loop->chunk_count;
+        (*loop->handler)(begin, end, (unsigned)chunk);
+
+        atomic_incr32(&loop->completed_chunks, memory_order_release);
+    }
+}
+
+FOUNDATION_STATIC void job_parallel_for_release(job_parallel_for_t* loop)
+{
+    if (atomic_decr32(&loop->refs, memory_order_acq_rel) == 0)
+        MEM_DELETE(loop);
+}
+
+void job_parallel_for(size_t count, unsigned chunk_count, const job_parallel_handler_t& handler)
+{
+    if (count == 0 || chunk_count == 0)
+        return;
+
+    job_parallel_for_t* loop = MEM_NEW(0, job_parallel_for_t);
+    loop->count = count;
+    loop->chunk_count = chunk_count;
+    loop->handler = &handler;
+
+    const unsigned job_count = min(chunk_count - 1, (unsigned)ARRAY_COUNT(_job_threads));
+    atomic_store32(&loop->refs, (int32_t)job_count + 1, memory_order_release);
+    atomic_store32(&loop->next_chunk, 0, memory_order_release);
+    atomic_store32(&loop->completed_chunks, 0, memory_order_release);
+
+    for (unsigned i = 0; i < job_count; ++i)
+    {
+        job_execute([](payload_t* payload)
+        {
+            job_parallel_for_t* loop = (job_parallel_for_t*)payload;
+            job_parallel_for_run(loop);
+            job_parallel_for_release(loop);
+            return 0;
+        }, loop, JOB_DEALLOCATE_AFTER_EXECUTION);
+    }
+
+    job_parallel_for_run(loop);
+    while (atomic_load32(&loop->completed_chunks, memory_order_acquire) < (int32_t)chunk_count)
+        thread_yield();
+
+    job_parallel_for_release(loop);
+}
+
+unsigned job_parallel_thread_count()
+{
+    return ARRAY_COUNT(_job_threads) + 1;
+}
+
 bool job_completed(job_t* job)
 {
     if (job == nullptr)
@@ -144,3 +247,37 @@ bool job_completed(job_t* job)
     _scheduled_jobs.signal();
     return false;
 }
+
+void job_cancel(job_t* job)
+{
+    if (job == nullptr)
+        return;
+
+    job->cancelled = true;
+    _scheduled_jobs.signal();
+}
+
+void job_wait(job_t* job)
+{
+    if (job == nullptr || job->completed || !job->scheduled)
+        return;
+
+    FOUNDATION_ASSERT((job->flags & JOB_DEALLOCATE_AFTER_EXECUTION) == 0);
+
+    semaphore_t completed;
+    semaphore_initialize(&completed, 0);
+    if (atomic_cas_ptr(&job->waiter, &completed, nullptr, memory_order_acq_rel, memory_order_acquire))
+    {
+        _scheduled_jobs.signal();
+        semaphore_wait(&completed);
+    }
+    else
+    {
+        // The job thread took the waiter slot but did not flag the job yet,
+        // returning now would let the caller deallocate the job under it.
+        while (!job->completed)
+            thread_yield();
+    }
+    semaphore_finalize(&completed);
+    atomic_thread_fence_acquire();
+}
@@ -28,6 +28,10 @@ struct job_t
     int status { 0 };
     volatile bool scheduled { false };
     volatile bool completed { false };
+    volatile bool cancelled { false };
+
+    /*! Semaphore of the thread waiting for the job to complete, see #job_wait. */
+    atomicptr_t waiter;
 };
 
 void jobs_initialize();
@@ -43,3 +47,37 @@ job_t* job_execute(const job_handler_t& handler, void* payload = nullptr, job_fl
 job_t* job_execute(const job_handler_t& handler, void* payload, size_t payload_size, job_flags_t flags = JOB_FLAGS_NONE);
 
 bool job_completed(job_t* job);
+
+/*! Cancels a job, the handler is not invoked if the job did not start yet.
+ *
+ *  @remark A job already running completes normally, its handler can check #job_t::cancelled 
+ *          through its payload to return early.
+ *
+ *  @param job Job to cancel.
+ */
+void job_cancel(job_t* job);
+
+/*! Blocks the calling thread until the job completes.
+ *
+ *  @remark The job must not be flagged with #JOB_DEALLOCATE_AFTER_EXECUTION.
+ *
+ *  @param job Job to wait for.
+ */
+void job_wait(job_t* job);
+
+/*! Handler invoked to process the items [begin, end) of a parallel loop chunk. */
+typedef function<void(size_t begin, size_t end, unsigned chunk)> job_parallel_handler_t;
+
+/*! Splits the range [0, count) in chunks processed in parallel by the job threads and the calling thread.
+ *
+ *  @remark Chunks are claimed atomically, so the calling thread processes any chunk no job thread picked up
+ *          and never waits on a job that has not started. It is thus safe to use from a job.
+ *
+ *  @param count        Number of items to process.
+ *  @param chunk_count  Number of chunks, i.e. to index per chunk partial results that are merged once the call returns.
+ *  @param handler      Handler invoked for each chunk, possibly concurrently.
+ */
+void job_parallel_for(size_t count, unsigned chunk_count, const job_parallel_handler_t& handler);
+
+/*! Returns the number of threads that can process jobs in parallel, including the calling thread. */
+unsigned job_parallel_thread_count();
@@ -14,9 +14,11 @@
 #include <framework/profiler.h>
 #include <framework/dispatcher.h>
 #include <framework/system.h>
+#include <framework/persistence.h>
 
 #include <foundation/path.h>
 #include <foundation/environment.h>
+#include <foundation/stream.h>
 
 #if FOUNDATION_PLATFORM_WINDOWS
 #include <framework/resource.h>
@@ -25,6 +27,11 @@
 
 #define HASH_LOCALIZATION static_hash_string("localization", 12, 0xf40f9a08f45a6556ULL)
 
+#define LOCALIZATION_COMPILED_MAGIC (0x434f4c57U) // WLOC
+#define LOCALIZATION_COMPILED_VERSION (1)
+#define LOCALIZATION_COMPILED_BUCKET_SIZE (4)
+#define LOCALIZATION_COMPILED_MAX_SEED (1U << 20)
+
 struct localization_language_t
 {
     string_const_t lang;
@@ -66,6 +73,30 @@ struct string_locale_t
     config_handle_t         cv;
 };
 
+/*! Header of a language dictionary compiled from the locales.sjson file.
+ * 
+ *  The header is followed by the perfect hash displacement of each bucket, the translated
+ *  entries indexed by the perfect hash of their key and the null terminated UTF-8 strings.
+ */
+struct localization_compiled_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    char lang[8];
+    hash_t source_hash;
+    uint32_t entry_count;
+    uint32_t bucket_count;
+    uint32_t string_bytes;
+    uint32_t size;
+};
+
+struct localization_compiled_entry_t
+{
+    hash_t key;
+    uint32_t offset;
+    uint32_t length;
+};
+
 struct localization_dictionary_t
 {
     char lang[8]{ "en" };
@@ -73,6 +104,9 @@ struct localization_dictionary_t
     string_table_t* strings{ nullptr };
     string_locale_t* locales{ nullptr };
 
+    // When loaded, all the lookups go through the compiled dictionary.
+    localization_compiled_header_t* compiled{ nullptr };
+
     bool is_default_language{ false };
 
     bool config_updated{ false };
@@ -117,10 +151,65 @@ FOUNDATION_FORCEINLINE string_const_t localization_locale_to_string_const(const
     return string_table_to_string_const(dict->strings, lc->symbol);
 }
 
+FOUNDATION_FORCEINLINE uint32_t localization_compiled_bucket(hash_t key, uint32_t bucket_count)
+{
+    return (uint32_t)((key >> 32) % bucket_count);
+}
+
+FOUNDATION_FORCEINLINE uint32_t localization_compiled_slot(hash_t key, uint32_t seed, uint32_t entry_count)
+{
+    hash_t h = key ^ (seed * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (uint32_t)(h % entry_count);
+}
+
+FOUNDATION_FORCEINLINE const uint32_t* localization_compiled_displacements(const localization_compiled_header_t* compiled)
+{
+    return (const uint32_t*)(compiled + 1);
+}
+
+FOUNDATION_FORCEINLINE const localization_compiled_entry_t* localization_compiled_entries(const localization_compiled_header_t* compiled)
+{
+    // Buckets are padded to an even count to keep the entries 8 bytes aligned.
+    return (const localization_compiled_entry_t*)(localization_compiled_displacements(compiled) + ((compiled->bucket_count + 1) & ~1U));
+}
+
+FOUNDATION_FORCEINLINE const char* localization_compiled_strings(const localization_compiled_header_t* compiled)
+{
+    return (const char*)(localization_compiled_entries(compiled) + compiled->entry_count);
+}
+
+FOUNDATION_FORCEINLINE size_t localization_compiled_size(uint32_t entry_count, uint32_t bucket_count, uint32_t string_bytes)
+{
+    return sizeof(localization_compiled_header_t) + 
+        sizeof(uint32_t) * ((bucket_count + 1) & ~1U) + 
+        sizeof(localization_compiled_entry_t) * entry_count + string_bytes;
+}
+
+FOUNDATION_STATIC const localization_compiled_entry_t* localization_compiled_find(const localization_compiled_header_t* compiled, hash_t key)
+{
+    if (compiled->entry_count == 0)
+        return nullptr;
+
+    const uint32_t seed = localization_compiled_displacements(compiled)[localization_compiled_bucket(key, compiled->bucket_count)];
+    const localization_compiled_entry_t* entry = localization_compiled_entries(compiled) + localization_compiled_slot(key, seed, compiled->entry_count);
+    return entry->key == key ? entry : nullptr;
+}
+
 FOUNDATION_STATIC string_const_t localization_get_locale(const localization_dictionary_t* dict, const char* str, size_t length, bool literal)
 {
     FOUNDATION_ASSERT(dict);
 
+    if (dict->compiled)
+    {
+        const localization_compiled_entry_t* entry = localization_compiled_find(dict->compiled, string_hash(str, length));
+        if (entry == nullptr)
+            return string_const(str, length);
+        return string_const(localization_compiled_strings(dict->compiled) + entry->offset, entry->length);
+    }
+
     string_locale_t* string_locale = localization_find_string_locale(dict, str, length, literal);
     if (string_locale == nullptr)
         return string_const(str, length);
@@ -241,6 +330,256 @@ FOUNDATION_STATIC bool localization_save_system_locales(config_handle_t config,
     return config_write_file(path, path_length, config, CONFIG_OPTION_PRESERVE_INSERTION_ORDER | CONFIG_OPTION_WRITE_ESCAPE_UTF8);
 }
 
+FOUNDATION_STATIC hash_t localization_file_hash(string_const_t file_path)
+{
+    stream_t* stream = fs_open_file(STRING_ARGS(file_path), STREAM_IN | STREAM_BINARY);
+    if (stream == nullptr)
+        return 0;
+
+    hash_t file_hash = 0;
+    const size_t size = stream_size(stream);
+    void* content = memory_allocate(HASH_LOCALIZATION, size, 0, MEMORY_TEMPORARY);
+    if (stream_read(stream, content, size) == size)
+        file_hash = hash(content, size);
+    memory_deallocate(content);
+    stream_deallocate(stream);
+    return file_hash;
+}
+
+FOUNDATION_STATIC string_t localization_compiled_file_path(char* buffer, size_t capacity, const char* lang)
+{
+    char name_buffer[32];
+    string_t name = string_format(STRING_BUFFER(name_buffer), STRING_CONST("locales_%s"), lang);
+    return session_get_user_file_path(buffer, capacity, STRING_ARGS(name), STRING_CONST("cache"), STRING_CONST("dict"), true);
+}
+
+/*! Assigns a slot to each key with a CHD style minimal perfect hash.
+ *  Keys are grouped in buckets and each bucket gets the first seed that moves all its keys to free slots.
+ *
+ *  @return False if a bucket could not be placed, i.e. when the keys are not unique.
+ */
+FOUNDATION_STATIC bool localization_compile_perfect_hash(const hash_t* keys, uint32_t count, uint32_t bucket_count, uint32_t* displacements, uint32_t* slots)
+{
+    // Group key indexes by bucket, larger buckets are placed first while most slots are free.
+    uint32_t* buckets = nullptr;
+    array_resize(buckets, bucket_count + 1);
+    memset(buckets, 0, sizeof(uint32_t) * (bucket_count + 1));
+    for (uint32_t i = 0; i < count; ++i)
+        buckets[localization_compiled_bucket(keys[i], bucket_count) + 1]++;
+    for (uint32_t b = 0; b < bucket_count; ++b)
+        buckets[b + 1] += buckets[b];
+
+    uint32_t* bucket_keys = nullptr;
+    uint32_t* bucket_fill = nullptr;
+    array_resize(bucket_keys, count);
+    array_copy(bucket_fill, buckets);
+    for (uint32_t i = 0; i < count; ++i)
+        bucket_keys[bucket_fill[localization_compiled_bucket(keys[i], bucket_count)]++] = i;
+
+    uint32_t* order = nullptr;
+    array_resize(order, bucket_count);
+    for (uint32_t b = 0; b < bucket_count; ++b)
+        order[b] = b;
+    array_sort(order, [buckets](const uint32_t& a, const uint32_t& b)
+    {
+        return (int)(buckets[b + 1] - buckets[b]) - (int)(buckets[a + 1] - buckets[a]);
+    });
+
+    bool* used = nullptr;
+    uint32_t* bucket_slots = nullptr;
+    array_resize(used, count);
+    memset(used, 0, sizeof(bool) * count);
+    array_resize(bucket_slots, LOCALIZATION_COMPILED_BUCKET_SIZE * 8);
+
+    bool success = true;
+    for (uint32_t o = 0; o < bucket_count && success; ++o)
+    {
+        const uint32_t b = order[o];
+        const uint32_t begin = buckets[b], end = buckets[b + 1];
+        displacements[b] = 0;
+        if (begin == end)
+            continue;
+
+        if (end - begin > array_size(bucket_slots))
+            array_resize(bucket_slots, end - begin);
+
+        uint32_t seed = 0;
+        for (; seed < LOCALIZATION_COMPILED_MAX_SEED; ++seed)
+        {
+            uint32_t placed = 0;
+            for (; placed < end - begin; ++placed)
+            {
+                const uint32_t slot = localization_compiled_slot(keys[bucket_keys[begin + placed]], seed, count);
+                if (used[slot])
+                    break;
+                used[slot] = true;
+                bucket_slots[placed] = slot;
+            }
+
+            if (placed == end - begin)
+                break;
+
+            // Release the slots taken by this seed before trying the next one.
+            for (uint32_t i = 0; i < placed; ++i)
+                used[bucket_slots[i]] = false;
+        }
+
+        if (seed == LOCALIZATION_COMPILED_MAX_SEED)
+        {
+            success = false;
+            break;
+        }
+
+        displacements[b] = seed;
+        for (uint32_t i = begin; i < end; ++i)
+            slots[bucket_keys[i]] = bucket_slots[i - begin];
+    }
+
+    array_deallocate(bucket_slots);
+    array_deallocate(used);
+    array_deallocate(order);
+    array_deallocate(bucket_fill);
+    array_deallocate(bucket_keys);
+    array_deallocate(buckets);
+    return success;
+}
+
+/*! Compiles the translated strings of a loaded dictionary.
+ *
+ *  @remark Only translated strings are compiled, other strings are returned as is by #tr.
+ *
+ *  @return The compiled dictionary allocated as a single memory block, or null if it could not be compiled.
+ */
+FOUNDATION_STATIC localization_compiled_header_t* localization_compile_locales(const localization_dictionary_t* dict, hash_t source_hash)
+{
+    // Locales are sorted by key, so duplicated keys are consecutive.
+    hash_t* keys = nullptr;
+    string_table_symbol_t* symbols = nullptr;
+    foreach(lc, dict->locales)
+    {
+        if (lc->symbol == 0 || test(lc->type, LocaleType::Default) || test(lc->type, LocaleType::Missing))
+            continue;
+        if (array_size(keys) > 0 && *array_last(keys) == lc->key)
+            continue;
+        array_push(keys, lc->key);
+        array_push(symbols, lc->symbol);
+    }
+
+    const uint32_t entry_count = array_size(keys);
+    const uint32_t bucket_count = max(1U, (entry_count + LOCALIZATION_COMPILED_BUCKET_SIZE - 1) / LOCALIZATION_COMPILED_BUCKET_SIZE);
+
+    uint32_t* displacements = nullptr;
+    uint32_t* slots = nullptr;
+    array_resize(displacements, bucket_count);
+    array_resize(slots, entry_count);
+
+    localization_compiled_header_t* compiled = nullptr;
+    if (localization_compile_perfect_hash(keys, entry_count, bucket_count, displacements, slots))
+    {
+        // Strings are interned by the dictionary string table, so each symbol is only written once.
+        uint32_t string_bytes = 0;
+        uint32_t* symbol_offsets = nullptr;
+        string_table_symbol_t* written_symbols = nullptr;
+        for (uint32_t i = 0; i < entry_count; ++i)
+        {
+            const int idx = array_binary_search(written_symbols, array_size(written_symbols), symbols[i]);
+            if (idx >= 0)
+                continue;
+            array_insert(written_symbols, ~idx, symbols[i]);
+            array_insert(symbol_offsets, ~idx, string_bytes);
+            string_bytes += (uint32_t)string_table_to_string_const(dict->strings, symbols[i]).length + 1;
+        }
+
+        const size_t size = localization_compiled_size(entry_count, bucket_count, string_bytes);
+        compiled = (localization_compiled_header_t*)memory_allocate(HASH_LOCALIZATION, size, 8, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+        compiled->magic = LOCALIZATION_COMPILED_MAGIC;
+        compiled->version = LOCALIZATION_COMPILED_VERSION;
+        string_copy(STRING_BUFFER(compiled->lang), dict->lang, string_length(dict->lang));
+        compiled->source_hash = source_hash;
+        compiled->entry_count = entry_count;
+        compiled->bucket_count = bucket_count;
+        compiled->string_bytes = string_bytes;
+        compiled->size = (uint32_t)size;
+
+        memcpy((void*)localization_compiled_displacements(compiled), displacements, sizeof(uint32_t) * bucket_count);
+
+        char* strings = (char*)localization_compiled_strings(compiled);
+        localization_compiled_entry_t* entries = (localization_compiled_entry_t*)localization_compiled_entries(compiled);
+        for (uint32_t i = 0; i < entry_count; ++i)
+        {
+            const int idx = array_binary_search(written_symbols, array_size(written_symbols), symbols[i]);
+            string_const_t value = string_table_to_string_const(dict->strings, symbols[i]);
+
+            localization_compiled_entry_t& entry = entries[slots[i]];
+            entry.key = keys[i];
+            entry.offset = symbol_offsets[idx];
+            entry.length = (uint32_t)value.length;
+            memcpy(strings + entry.offset, value.str, value.length);
+        }
+
+        array_deallocate(written_symbols);
+        array_deallocate(symbol_offsets);
+    }
+    else
+    {
+        log_warnf(HASH_LOCALIZATION, WARNING_INVALID_VALUE, STRING_CONST("Failed to compile %s locales"), dict->lang);
+    }
+
+    array_deallocate(slots);
+    array_deallocate(displacements);
+    array_deallocate(symbols);
+    array_deallocate(keys);
+    return compiled;
+}
+
+/*! Loads the compiled dictionary of the language if it was compiled from the same locales. */
+FOUNDATION_STATIC localization_compiled_header_t* localization_load_compiled_locales(const char* lang, hash_t source_hash)
+{
+    char compiled_file_path_buffer[BUILD_MAX_PATHLEN];
+    string_t compiled_file_path = localization_compiled_file_path(STRING_BUFFER(compiled_file_path_buffer), lang);
+    stream_t* stream = fs_open_file(STRING_ARGS(compiled_file_path), STREAM_IN | STREAM_BINARY);
+    if (stream == nullptr)
+        return nullptr;
+
+    localization_compiled_header_t header;
+    const size_t size = stream_size(stream);
+    if (stream_read(stream, &header, sizeof(header)) != sizeof(header) ||
+        header.magic != LOCALIZATION_COMPILED_MAGIC || header.version != LOCALIZATION_COMPILED_VERSION ||
+        header.source_hash != source_hash || !string_equal(header.lang, string_length(header.lang), lang, string_length(lang)) ||
+        header.size != size || header.bucket_count == 0 ||
+        localization_compiled_size(header.entry_count, header.bucket_count, header.string_bytes) != size)
+    {
+        stream_deallocate(stream);
+        return nullptr;
+    }
+
+    // The whole dictionary is read in one block and used in place.
+    localization_compiled_header_t* compiled = (localization_compiled_header_t*)memory_allocate(HASH_LOCALIZATION, size, 8, MEMORY_PERSISTENT);
+    memcpy(compiled, &header, sizeof(header));
+    const size_t content_size = size - sizeof(header);
+    const bool loaded = stream_read(stream, compiled + 1, content_size) == content_size;
+    stream_deallocate(stream);
+
+    if (!loaded)
+    {
+        memory_deallocate(compiled);
+        return nullptr;
+    }
+
+    // Make sure the entries cannot index outside of the strings.
+    const localization_compiled_entry_t* entries = localization_compiled_entries(compiled);
+    for (uint32_t i = 0; i < compiled->entry_count; ++i)
+    {
+        if ((uint64_t)entries[i].offset + entries[i].length >= compiled->string_bytes)
+        {
+            memory_deallocate(compiled);
+            return nullptr;
+        }
+    }
+
+    return compiled;
+}
+
 FOUNDATION_STATIC localization_dictionary_t* localization_load_system_locales(string_const_t user_lang = {})
 {
     string_const_t locales_json_path = localization_system_locales_path();
@@ -248,15 +587,7 @@ FOUNDATION_STATIC localization_dictionary_t* localization_load_system_locales(st
 
     const bool has_config_locales = fs_is_file(STRING_ARGS(locales_json_path));
 
-    config_handle_t cv = has_config_locales ? 
-        config_parse_file(STRING_ARGS(locales_json_path), CONFIG_OPTION_PRESERVE_INSERTION_ORDER | CONFIG_OPTION_PARSE_UNICODE_UTF8) :
-        localization_locales_new_config();
-    FOUNDATION_ASSERT(cv);
-
     localization_dictionary_t* dict = MEM_NEW(HASH_LOCALIZATION, localization_dictionary_t);
-    
-    dict->config = cv;
-    dict->strings = string_table_allocate(64 * 1024, 32);
 
     // Check if language is specified through the command line
     if (string_is_null(user_lang))
@@ -279,6 +610,24 @@ FOUNDATION_STATIC localization_dictionary_t* localization_load_system_locales(st
 
     dict->is_default_language = string_equal_nocase(STRING_ARGS(user_lang), STRING_CONST("en"));
 
+    // Use the compiled dictionary of the language unless we are building the locales.
+    const bool compile_locales = has_config_locales && !_localization_module->build_locales;
+    const hash_t source_hash = compile_locales ? localization_file_hash(locales_json_path) : 0;
+    if (compile_locales)
+    {
+        dict->compiled = localization_load_compiled_locales(dict->lang, source_hash);
+        if (dict->compiled)
+            return dict;
+    }
+
+    config_handle_t cv = has_config_locales ? 
+        config_parse_file(STRING_ARGS(locales_json_path), CONFIG_OPTION_PRESERVE_INSERTION_ORDER | CONFIG_OPTION_PARSE_UNICODE_UTF8) :
+        localization_locales_new_config();
+    FOUNDATION_ASSERT(cv);
+
+    dict->config = cv;
+    dict->strings = string_table_allocate(64 * 1024, 32);
+
     // Load locale string
     auto strings = cv["strings"];
     for (auto str : strings)
@@ -324,6 +673,23 @@ FOUNDATION_STATIC localization_dictionary_t* localization_load_system_locales(st
 
     dict->locales = localization_sort_locales(dict->locales);
 
+    // Compile the dictionary for the next time and use it right away.
+    if (compile_locales)
+    {
+        dict->compiled = localization_compile_locales(dict, source_hash);
+        if (dict->compiled)
+        {
+            char compiled_file_path_buffer[BUILD_MAX_PATHLEN];
+            string_t compiled_file_path = localization_compiled_file_path(STRING_BUFFER(compiled_file_path_buffer), dict->lang);
+            persistence_write_file(string_to_const(compiled_file_path), dict->compiled, dict->compiled->size);
+
+            array_deallocate(dict->locales);
+            config_deallocate(dict->config);
+            string_table_deallocate(dict->strings);
+            dict->strings = nullptr;
+        }
+    }
+
     return dict;
 }
 
@@ -331,7 +697,9 @@ FOUNDATION_STATIC void localization_dictionary_deallocate(localization_dictionar
 {
     array_deallocate(dict->locales);
     config_deallocate(dict->config);
-    string_table_deallocate(dict->strings);
+    if (dict->strings)
+        string_table_deallocate(dict->strings);
+    memory_deallocate(dict->compiled);
     MEM_DELETE(dict);
 }
 
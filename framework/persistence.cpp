@@ -0,0 +1,380 @@
+/*
+ * Copyright 2022-2023 - All rights reserved.
+ * License: https://wiimag.com/LICENSE
+ */
+
+#include "persistence.h"
+
+#include <framework/jobs.h>
+#include <framework/module.h>
+#include <framework/dispatcher.h>
+#include <framework/scoped_mutex.h>
+#include <framework/array.h>
+
+#include <foundation/fs.h>
+#include <foundation/path.h>
+#include <foundation/hash.h>
+#include <foundation/mutex.h>
+#include <foundation/stream.h>
+
+#if FOUNDATION_PLATFORM_WINDOWS
+    #include <foundation/windows.h>
+#endif
+
+#define HASH_PERSISTENCE static_hash_string("persistence", 11, 0xca9489cf93c2fcc5ULL)
+
+struct persistence_entry_t
+{
+    hash_t key{ 0 };
+    string_t path{};
+    char path_buffer[BUILD_MAX_PATHLEN];
+
+    // Latest snapshot waiting to be written, guarded by the module lock.
+    config_handle_t pending{};
+    config_option_flags_t flags{ CONFIG_OPTION_NONE };
+    tick_t write_at{ 0 };
+    bool dispatched{ false };
+
+    // Serializes the writes of the file, the content hash is only accessed while locked.
+    mutex_t* write_lock{ nullptr };
+    hash_t content_hash{ 0 };
+    bool content_hash_loaded{ false };
+};
+
+static struct PERSISTENCE_MODULE {
+
+    mutex_t* lock{ nullptr };
+    persistence_entry_t** entries{ nullptr };
+
+} *_persistence_module = nullptr;
+
+//
+// # PRIVATE
+//
+
+FOUNDATION_STATIC bool persistence_is_binary_file_path(string_const_t file_path)
+{
+    string_const_t extension = path_file_extension(STRING_ARGS(file_path));
+    return string_equal_nocase(STRING_ARGS(extension), STRING_CONST(CONFIG_BINARY_FILE_EXTENSION));
+}
+
+FOUNDATION_STATIC hash_t persistence_file_hash(string_const_t file_path)
+{
+    stream_t* stream = fs_open_file(STRING_ARGS(file_path), STREAM_IN | STREAM_BINARY);
+    if (stream == nullptr)
+        return 0;
+
+    hash_t content_hash = 0;
+    const size_t size = stream_size(stream);
+    if (size > 0)
+    {
+        void* content = memory_allocate(HASH_PERSISTENCE, size, 0, MEMORY_TEMPORARY);
+        if (stream_read(stream, content, size) == size)
+            content_hash = hash(content, size);
+        memory_deallocate(content);
+    }
+
+    stream_deallocate(stream);
+    return content_hash;
+}
+
+FOUNDATION_STATIC bool persistence_replace_file(string_const_t temp_file_path, string_const_t file_path)
+{
+    #if FOUNDATION_PLATFORM_WINDOWS
+        // MoveFile fails when the destination exists, so ask explicitly to replace it.
+        wchar_t* wsource = wstring_allocate_from_string(STRING_ARGS(temp_file_path));
+        wchar_t* wdest = wstring_allocate_from_string(STRING_ARGS(file_path));
+        const bool replaced = MoveFileExW(wsource, wdest, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+        wstring_deallocate(wsource);
+        wstring_deallocate(wdest);
+        return replaced;
+    #else
+        return fs_move_file(STRING_ARGS(temp_file_path), STRING_ARGS(file_path));
+    #endif
+}
+
+/*! Serializes the config and writes it unless its hash matches @content_hash, which gets updated once written. */
+FOUNDATION_STATIC bool persistence_write_config(
+    string_const_t file_path, const config_handle_t& data, config_option_flags_t flags,
+    hash_t& content_hash, bool* out_written = nullptr)
+{
+    uint8_t* binary = nullptr;
+    config_sjson_const_t sjson = nullptr;
+    const void* content = nullptr;
+    size_t content_size = 0;
+
+    if (persistence_is_binary_file_path(file_path))
+    {
+        binary = config_binary(data);
+        content = binary;
+        content_size = array_size(binary);
+    }
+    else
+    {
+        sjson = config_sjson(data, flags);
+        content = sjson;
+        content_size = array_size(sjson) > 0 ? array_size(sjson) - 1 : 0;
+    }
+
+    bool success = true;
+    if (content_size == 0)
+    {
+        log_warnf(HASH_PERSISTENCE, WARNING_INVALID_VALUE, STRING_CONST("No data to write to config file %.*s"), STRING_FORMAT(file_path));
+        success = false;
+    }
+    else
+    {
+        const hash_t new_content_hash = hash(content, content_size);
+        if (new_content_hash != content_hash)
+        {
+            success = persistence_write_file(file_path, content, content_size);
+            if (success)
+            {
+                content_hash = new_content_hash;
+                if (out_written)
+                    *out_written = true;
+            }
+        }
+    }
+
+    array_deallocate(binary);
+    config_sjson_deallocate(sjson);
+    return success;
+}
+
+FOUNDATION_STATIC persistence_entry_t* persistence_find_entry(hash_t key)
+{
+    foreach(e, _persistence_module->entries)
+    {
+        if ((*e)->key == key)
+            return *e;
+    }
+
+    return nullptr;
+}
+
+/*! Writes the latest pending snapshot of a file, from a job or from the thread flushing saves. */
+FOUNDATION_STATIC bool persistence_entry_write(persistence_entry_t* entry, bool* out_written = nullptr)
+{
+    scoped_mutex_t write_lock(entry->write_lock);
+
+    // Take the snapshot once we own the file, so the last writer always writes the latest content.
+    config_handle_t data;
+    config_option_flags_t flags;
+    {
+        scoped_mutex_t lock(_persistence_module->lock);
+        data = entry->pending;
+        flags = entry->flags;
+        entry->pending = config_null();
+    }
+
+    if (data.config == nullptr)
+        return true;
+
+    if (!entry->content_hash_loaded)
+    {
+        if (flags & CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL)
+            entry->content_hash = persistence_file_hash(string_to_const(entry->path));
+        entry->content_hash_loaded = true;
+    }
+    else if ((flags & CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL) == 0)
+    {
+        entry->content_hash = 0;
+    }
+
+    const bool success = persistence_write_config(string_to_const(entry->path), data, flags, entry->content_hash, out_written);
+    config_deallocate(data);
+    return success;
+}
+
+FOUNDATION_STATIC void persistence_dispatch_write(hash_t key)
+{
+    if (_persistence_module == nullptr)
+        return;
+
+    persistence_entry_t* entry = nullptr;
+    {
+        scoped_mutex_t lock(_persistence_module->lock);
+        entry = persistence_find_entry(key);
+        if (entry == nullptr)
+            return;
+
+        // Wait again if other saves were requested since the write was dispatched.
+        const tick_t now = time_current();
+        if (entry->pending.config && now < entry->write_at)
+        {
+            const uint32_t remaining_ms = (uint32_t)(time_ticks_to_milliseconds(entry->write_at - now)) + 1;
+            if (dispatch([key]() { persistence_dispatch_write(key); }, remaining_ms))
+                return;
+        }
+
+        entry->dispatched = false;
+        if (entry->pending.config == nullptr)
+            return;
+    }
+
+    job_execute([entry](payload_t*)
+    {
+        return persistence_entry_write(entry) ? 0 : -1;
+    }, nullptr, JOB_DEALLOCATE_AFTER_EXECUTION);
+}
+
+//
+// # PUBLIC API
+//
+
+bool persistence_write_file(string_const_t file_path, const void* data, size_t size)
+{
+    char temp_file_path_buffer[BUILD_MAX_PATHLEN];
+    string_t temp_file_path = string_format(STRING_BUFFER(temp_file_path_buffer), STRING_CONST("%.*s.tmp"), STRING_FORMAT(file_path));
+
+    stream_t* stream = fs_open_file(STRING_ARGS(temp_file_path), STREAM_CREATE | STREAM_OUT | STREAM_BINARY | STREAM_TRUNCATE);
+    if (stream == nullptr)
+    {
+        log_errorf(HASH_PERSISTENCE, ERROR_ACCESS_DENIED, STRING_CONST("Failed to create %.*s"), STRING_FORMAT(temp_file_path));
+        return false;
+    }
+
+    const bool written = stream_write(stream, data, size) == size;
+    stream_deallocate(stream);
+
+    if (!written || !persistence_replace_file(string_to_const(temp_file_path), file_path))
+    {
+        log_errorf(HASH_PERSISTENCE, ERROR_SYSTEM_CALL_FAIL, STRING_CONST("Failed to write %.*s"), STRING_FORMAT(file_path));
+        fs_remove_file(STRING_ARGS(temp_file_path));
+        return false;
+    }
+
+    log_debugf(HASH_PERSISTENCE, STRING_CONST("Writing config file %.*s"), STRING_FORMAT(file_path));
+    return true;
+}
+
+bool persistence_save(string_const_t file_path, const config_handle_t& data,
+    config_option_flags_t write_json_flags /*= CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS | CONFIG_OPTION_WRITE_SKIP_NULL*/,
+    uint32_t delay_ms /*= PERSISTENCE_SAVE_DELAY_MS*/)
+{
+    if (data.config == nullptr)
+    {
+        log_warnf(HASH_PERSISTENCE, WARNING_INVALID_VALUE, STRING_CONST("No data to write to config file %.*s"), STRING_FORMAT(file_path));
+        return false;
+    }
+
+    if (_persistence_module == nullptr)
+    {
+        hash_t content_hash = 0;
+        if (write_json_flags & CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL)
+            content_hash = persistence_file_hash(file_path);
+        return persistence_write_config(file_path, data, write_json_flags, content_hash);
+    }
+
+    config_handle_t snapshot = config_snapshot(data);
+    const hash_t key = hash(STRING_ARGS(file_path));
+
+    bool dispatch_write = false;
+    {
+        scoped_mutex_t lock(_persistence_module->lock);
+        persistence_entry_t* entry = persistence_find_entry(key);
+        if (entry == nullptr)
+        {
+            entry = MEM_NEW(HASH_PERSISTENCE, persistence_entry_t);
+            entry->key = key;
+            entry->path = string_copy(STRING_BUFFER(entry->path_buffer), STRING_ARGS(file_path));
+            entry->write_lock = mutex_allocate(STRING_CONST("Persistence"));
+            array_push(_persistence_module->entries, entry);
+        }
+
+        // Only the latest content gets written.
+        config_deallocate(entry->pending);
+        entry->pending = snapshot;
+        entry->flags = write_json_flags;
+        entry->write_at = time_current() + (tick_t)(time_ticks_per_second() * delay_ms / 1000);
+
+        if (!entry->dispatched)
+            entry->dispatched = dispatch_write = true;
+    }
+
+    if (dispatch_write && !dispatch([key]() { persistence_dispatch_write(key); }, delay_ms))
+        persistence_dispatch_write(key);
+
+    return true;
+}
+
+bool persistence_cancel(string_const_t file_path)
+{
+    if (_persistence_module == nullptr)
+        return false;
+
+    bool cancelled = false;
+    persistence_entry_t* entry = nullptr;
+    {
+        scoped_mutex_t lock(_persistence_module->lock);
+        entry = persistence_find_entry(hash(STRING_ARGS(file_path)));
+        if (entry == nullptr)
+            return false;
+
+        cancelled = entry->pending.config != nullptr;
+        config_deallocate(entry->pending);
+        entry->pending = config_null();
+    }
+
+    // Wait for any write in progress and forget the content hash of the file being removed.
+    scoped_mutex_t write_lock(entry->write_lock);
+    entry->content_hash = 0;
+    entry->content_hash_loaded = false;
+    return cancelled;
+}
+
+unsigned persistence_flush()
+{
+    if (_persistence_module == nullptr)
+        return 0;
+
+    persistence_entry_t** entries = nullptr;
+    {
+        scoped_mutex_t lock(_persistence_module->lock);
+        array_copy(entries, _persistence_module->entries);
+    }
+
+    unsigned written_count = 0;
+    foreach(e, entries)
+    {
+        bool written = false;
+        persistence_entry_write(*e, &written);
+        if (written)
+            written_count++;
+    }
+
+    array_deallocate(entries);
+    return written_count;
+}
+
+//
+// # SYSTEM
+//
+
+FOUNDATION_STATIC void persistence_initialize()
+{
+    _persistence_module = MEM_NEW(HASH_PERSISTENCE, PERSISTENCE_MODULE);
+    _persistence_module->lock = mutex_allocate(STRING_CONST("Persistence"));
+}
+
+FOUNDATION_STATIC void persistence_shutdown()
+{
+    // Job threads are already stopped at this point, so any save still pending
+    // (including the ones requested by other modules shutting down) is written here.
+    persistence_flush();
+
+    foreach(e, _persistence_module->entries)
+    {
+        persistence_entry_t* entry = *e;
+        config_deallocate(entry->pending);
+        mutex_deallocate(entry->write_lock);
+        MEM_DELETE(entry);
+    }
+    array_deallocate(_persistence_module->entries);
+
+    mutex_deallocate(_persistence_module->lock);
+    MEM_DELETE(_persistence_module);
+}
+
+DEFINE_MODULE(PERSISTENCE, persistence_initialize, persistence_shutdown, MODULE_PRIORITY_SYSTEM);
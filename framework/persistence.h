@@ -0,0 +1,66 @@
+/*
+ * Copyright 2022-2023 - All rights reserved.
+ * License: https://wiimag.com/LICENSE
+ *
+ * Persistence service used to save config files without blocking the main thread.
+ *
+ * Saves are debounced per file, serialized from a snapshot on a job thread, skipped
+ * when the content did not change since the last write, and written to a temporary
+ * file that replaces the previous one so a crash never leaves a partial file behind.
+ */
+
+#pragma once
+
+#include <framework/config.h>
+
+/*! Default delay to wait for other save requests before writing a file. */
+constexpr uint32_t PERSISTENCE_SAVE_DELAY_MS = 500;
+
+/*! Schedules a config to be written to a file.
+ *
+ *  The config is copied right away, so the caller can keep modifying or deallocate it.
+ *  If another save is requested for the same file before the delay expires, only the
+ *  latest content is written.
+ *
+ *  @remark Files with the #CONFIG_BINARY_FILE_EXTENSION extension are written in the binary config format.
+ *  @remark Once the service is shutdown, the file is written synchronously.
+ *
+ *  @param file_path        File path.
+ *  @param data             Config value handle to write.
+ *  @param write_json_flags Flags to control the JSON output.
+ *  @param delay_ms         Delay to wait for other save requests before writing the file.
+ *
+ *  @return True if the save was scheduled or written successfully.
+ */
+bool persistence_save(
+    string_const_t file_path,
+    const config_handle_t& data,
+    config_option_flags_t write_json_flags = CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS | CONFIG_OPTION_WRITE_SKIP_NULL,
+    uint32_t delay_ms = PERSISTENCE_SAVE_DELAY_MS);
+
+/*! Drops the pending save of a file, i.e. before the file gets deleted.
+ *
+ *  If the file is being written, this waits for the write to complete, so the
+ *  file can be safely removed once this returns.
+ *
+ *  @param file_path File path.
+ *
+ *  @return True if a pending save was dropped.
+ */
+bool persistence_cancel(string_const_t file_path);
+
+/*! Writes all pending saves right away on the calling thread.
+ *
+ *  @return Number of files written, files which content did not change are not counted.
+ */
+unsigned persistence_flush();
+
+/*! Writes content to a temporary file next to the file path and then replaces the file with it.
+ *
+ *  @param file_path File path.
+ *  @param data      Content to write.
+ *  @param size      Content size in bytes.
+ *
+ *  @return True if the file was replaced successfully.
+ */
+bool persistence_write_file(string_const_t file_path, const void* data, size_t size);
@@ -9,16 +9,22 @@
 
 #include <framework/imgui.h>
 #include <framework/common.h>
+#include <framework/expr.h>
 #include <framework/module.h>
 #include <framework/session.h>
 #include <framework/shared_mutex.h>
 #include <framework/table.h>
 #include <framework/math.h>
 #include <framework/string.h>
+#include <framework/array.h>
+#include <framework/console.h>
 
 #include <foundation/stream.h>
 #include <foundation/environment.h>
 #include <foundation/time.h>
+#include <foundation/atomic.h>
+#include <foundation/thread.h>
+#include <foundation/hashstrings.h>
 
 #include <bx/sort.h>
 
@@ -29,6 +35,15 @@
 #define PROFILE_ID_ENDFRAME (4)
 #define PROFILE_LAST_BUILTIN_ID (12)
 
+#define PROFILER_TRACE_MAGIC (0x43525457U) // WTRC
+#define PROFILER_TRACE_VERSION (1)
+#define PROFILER_TRACE_NAME_SIZE (31)
+#define PROFILER_TRACE_CHUNK_EVENT_COUNT (1024)
+#define PROFILER_TRACE_FLUSH_INTERVAL (1.0)
+
+#define PROFILER_MEMORY_CONTEXT_CAPACITY (512)
+#define PROFILER_MEMORY_SAMPLE_INTERVAL (2.0)
+
 struct profile_block_data_t {
     int32_t id;
     int32_t parentid;
@@ -55,6 +70,83 @@ struct profile_tracker_t {
     char name[MAX_MESSAGE_LENGTH + 1];
 };
 
+typedef enum profiler_trace_event_type_t : uint8_t
+{
+    PROFILER_TRACE_BEGIN = 'B',
+    PROFILER_TRACE_END = 'E',
+    PROFILER_TRACE_COUNTER = 'C'
+} profiler_trace_event_type_t;
+
+struct profiler_trace_event_t
+{
+    tick_t time;
+    hash_t context;
+    double value;
+    profiler_trace_event_type_t type;
+    char name[PROFILER_TRACE_NAME_SIZE];
+};
+
+/*! Events recorded by a single thread, other threads only read the events published by #count. */
+struct profiler_trace_chunk_t
+{
+    profiler_trace_chunk_t* next;
+    uint32_t written;
+    atomic32_t count;
+    uint64_t thread;
+    char thread_name[32];
+    profiler_trace_event_t events[PROFILER_TRACE_CHUNK_EVENT_COUNT];
+};
+
+struct profiler_trace_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t event_size;
+    uint32_t reserved;
+    uint64_t ticks_per_second;
+    tick_t start;
+};
+
+/*! Header of each block of events of a thread written in the trace file. */
+struct profiler_trace_block_t
+{
+    uint64_t thread;
+    uint32_t event_count;
+    uint32_t reserved;
+    char thread_name[32];
+};
+
+#if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+// Counters updated by every tracked allocation, the slot of a context never changes once claimed.
+struct profiler_memory_counter_t
+{
+    atomic64_t context;
+    atomic64_t allocations;
+    atomic64_t largest;
+};
+
+static memory_tracker_t _memory_tracker_forward;
+static profiler_memory_counter_t _memory_counters[PROFILER_MEMORY_CONTEXT_CAPACITY];
+static uint64_t _memory_dump_bytes[PROFILER_MEMORY_CONTEXT_CAPACITY];
+static uint64_t _memory_dump_allocations[PROFILER_MEMORY_CONTEXT_CAPACITY];
+static uint64_t _memory_snapshot_bytes[PROFILER_MEMORY_CONTEXT_CAPACITY];
+static uint64_t _memory_snapshot_allocations[PROFILER_MEMORY_CONTEXT_CAPACITY];
+static profiler_memory_context_t _memory_contexts[PROFILER_MEMORY_CONTEXT_CAPACITY];
+static profiler_memory_context_t* _memory_entries = nullptr;
+static tick_t _memory_last_sample = 0;
+static tick_t _memory_snapshot_time = 0;
+static table_t* _profiler_memory_table = nullptr;
+#endif
+
+static atomic32_t _trace_session;
+static atomicptr_t _trace_chunks;
+static int32_t _trace_last_session = 0;
+static stream_t* _trace_stream = nullptr;
+static tick_t _trace_last_flush = 0;
+static profiler_trace_chunk_t** _trace_retired_chunks = nullptr;
+static thread_local profiler_trace_chunk_t* _trace_thread_chunk = nullptr;
+static thread_local int32_t _trace_thread_session = 0;
+
 static bool _profiler_initialized = false;
 static stream_t* _profile_stream = nullptr;
 
@@ -63,6 +155,8 @@ static profile_tracker_t* _trackers = nullptr;
 
 static bool _profiler_window_opened = false;
 static table_t* _profiler_table = nullptr;
+static table_t* _profiler_expr_table = nullptr;
+static expr_profile_entry_t* _profiler_expr_entries = nullptr;
 
 static uint8_t* _profile_buffer = nullptr;
 
@@ -156,6 +250,128 @@ FOUNDATION_STATIC void profiler_tracker(void* buffer, size_t size)
         stream_write(_profile_stream, buffer, size);
 }
 
+FOUNDATION_STATIC profiler_trace_chunk_t* profiler_trace_allocate_chunk(int32_t session)
+{
+    profiler_trace_chunk_t* chunk = (profiler_trace_chunk_t*)memory_allocate(HASH_PROFILER, sizeof(profiler_trace_chunk_t), 8, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+    chunk->thread = thread_id();
+    string_const_t name = thread_name(nullptr);
+    if (name.length == 0)
+        name = thread_is_main() ? CTEXT("main") : CTEXT("thread");
+    string_copy(STRING_BUFFER(chunk->thread_name), STRING_ARGS(name));
+
+    // Chunks are pushed on a lock-free list, only the thread flushing events removes them.
+    void* head = nullptr;
+    do
+    {
+        head = atomic_load_ptr(&_trace_chunks, memory_order_relaxed);
+        chunk->next = (profiler_trace_chunk_t*)head;
+    } while (!atomic_cas_ptr(&_trace_chunks, chunk, head, memory_order_release, memory_order_relaxed));
+
+    _trace_thread_chunk = chunk;
+    _trace_thread_session = session;
+    return chunk;
+}
+
+FOUNDATION_STATIC void profiler_trace_record(profiler_trace_event_type_t type, const char* name, size_t name_length, double value)
+{
+    const int32_t session = atomic_load32(&_trace_session, memory_order_relaxed);
+    if (session == 0)
+        return;
+
+    profiler_trace_chunk_t* chunk = _trace_thread_chunk;
+    if (chunk == nullptr || _trace_thread_session != session)
+        chunk = profiler_trace_allocate_chunk(session);
+
+    const int32_t index = atomic_load32(&chunk->count, memory_order_relaxed);
+    profiler_trace_event_t& e = chunk->events[index];
+    e.time = time_current();
+    e.context = memory_context();
+    e.value = value;
+    e.type = type;
+    string_copy(STRING_BUFFER(e.name), name, name_length);
+
+    atomic_store32(&chunk->count, index + 1, memory_order_release);
+
+    // Full chunks can be released as soon as they are written, so never access them again.
+    if (index + 1 == PROFILER_TRACE_CHUNK_EVENT_COUNT)
+        _trace_thread_chunk = nullptr;
+}
+
+FOUNDATION_STATIC void profiler_trace_write_block(profiler_trace_chunk_t* chunk, uint32_t count)
+{
+    profiler_trace_block_t block;
+    block.thread = chunk->thread;
+    block.event_count = count - chunk->written;
+    block.reserved = 0;
+    memcpy(block.thread_name, chunk->thread_name, sizeof(block.thread_name));
+
+    stream_write(_trace_stream, &block, sizeof(block));
+    stream_write(_trace_stream, chunk->events + chunk->written, sizeof(profiler_trace_event_t) * block.event_count);
+    chunk->written = count;
+}
+
+/*! Writes the events published since the last flush. 
+ *  Full chunks are never written again by their thread, so they are released once written. */
+FOUNDATION_STATIC void profiler_trace_flush()
+{
+    if (_trace_stream == nullptr)
+        return;
+
+    profiler_trace_chunk_t* head = (profiler_trace_chunk_t*)atomic_load_ptr(&_trace_chunks, memory_order_acquire);
+    profiler_trace_chunk_t* prev = nullptr;
+    for (profiler_trace_chunk_t* chunk = head; chunk;)
+    {
+        profiler_trace_chunk_t* next = chunk->next;
+        const uint32_t count = (uint32_t)atomic_load32(&chunk->count, memory_order_acquire);
+        if (count > chunk->written)
+            profiler_trace_write_block(chunk, count);
+
+        // The head stays in place since other threads might be pushing new chunks before it.
+        if (chunk != head && count == PROFILER_TRACE_CHUNK_EVENT_COUNT)
+        {
+            prev->next = next;
+            memory_deallocate(chunk);
+        }
+        else
+        {
+            prev = chunk;
+        }
+
+        chunk = next;
+    }
+
+    stream_flush(_trace_stream);
+    _trace_last_flush = time_current();
+}
+
+FOUNDATION_STATIC void profiler_trace_update()
+{
+    if (_trace_stream && time_elapsed(_trace_last_flush) > PROFILER_TRACE_FLUSH_INTERVAL)
+        profiler_trace_flush();
+}
+
+FOUNDATION_STATIC string_const_t profiler_trace_json_name(char* buffer, size_t capacity, const char* name, size_t name_length)
+{
+    string_t json_name = string_copy(buffer, capacity, name, name_length);
+    for (size_t i = 0; i < json_name.length; ++i)
+    {
+        if (json_name.str[i] == '"' || json_name.str[i] == '\\' || (unsigned char)json_name.str[i] < 0x20)
+            json_name.str[i] = '_';
+    }
+    return string_to_const(json_name);
+}
+
+FOUNDATION_STATIC string_const_t profiler_trace_context_name(char* buffer, size_t capacity, hash_t context)
+{
+    #if BUILD_ENABLE_STATIC_HASH_DEBUG
+    string_const_t context_name = hash_to_string(context);
+    if (context_name.length)
+        return profiler_trace_json_name(buffer, capacity, STRING_ARGS(context_name));
+    #endif
+
+    return string_to_const(string_format(buffer, capacity, STRING_CONST("%" PRIhash), context));
+}
+
 FOUNDATION_STATIC void profiler_render_time_ms_column(double time_ms)
 {
     static const ImColor TEXT_TIME_US = ImColor::HSV(140 / 360.0f, 0.20f, 0.65f);
@@ -223,6 +439,309 @@ FOUNDATION_STATIC void profiler_create_table()
         .set_width(imgui_get_font_ui_scale(70.0f));
 }
 
+FOUNDATION_STATIC table_cell_t profiler_expr_table_name(table_element_ptr_t element, const table_column_t* column)
+{
+    expr_profile_entry_t* e = (expr_profile_entry_t*)element;
+    return e->name;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_expr_table_calls(table_element_ptr_t element, const table_column_t* column)
+{
+    expr_profile_entry_t* e = (expr_profile_entry_t*)element;
+    return (double)e->calls;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_expr_table_inclusive(table_element_ptr_t element, const table_column_t* column)
+{
+    expr_profile_entry_t* e = (expr_profile_entry_t*)element;
+    return profiler_table_format_time(time_ticks_to_milliseconds(e->inclusive));
+}
+
+FOUNDATION_STATIC table_cell_t profiler_expr_table_exclusive(table_element_ptr_t element, const table_column_t* column)
+{
+    expr_profile_entry_t* e = (expr_profile_entry_t*)element;
+    return profiler_table_format_time(time_ticks_to_milliseconds(e->exclusive));
+}
+
+FOUNDATION_STATIC table_cell_t profiler_expr_table_wait(table_element_ptr_t element, const table_column_t* column)
+{
+    expr_profile_entry_t* e = (expr_profile_entry_t*)element;
+    return profiler_table_format_time(time_ticks_to_milliseconds(e->wait));
+}
+
+FOUNDATION_STATIC table_cell_t profiler_expr_table_allocations(table_element_ptr_t element, const table_column_t* column)
+{
+    expr_profile_entry_t* e = (expr_profile_entry_t*)element;
+    return (double)e->allocations;
+}
+
+FOUNDATION_STATIC void profiler_create_expr_table()
+{
+    _profiler_expr_table = table_allocate("ProfilerExpr#1");
+    const float value_column_width = imgui_get_font_ui_scale(90.0f);
+    table_add_column(_profiler_expr_table, "Function", profiler_expr_table_name, COLUMN_FORMAT_TEXT, COLUMN_SORTABLE | COLUMN_FREEZE);
+    table_add_column(_profiler_expr_table, ICON_MD_NUMBERS "||Calls", profiler_expr_table_calls, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(imgui_get_font_ui_scale(70.0f));
+    table_add_column(_profiler_expr_table, ICON_MD_TIMER "||Inclusive", profiler_expr_table_inclusive, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE).set_width(value_column_width);
+    table_add_column(_profiler_expr_table, ICON_MD_TIMER "||Exclusive", profiler_expr_table_exclusive, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE).set_width(value_column_width);
+    table_add_column(_profiler_expr_table, ICON_MD_HOURGLASS_EMPTY "||Wait", profiler_expr_table_wait, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE).set_width(value_column_width);
+    table_add_column(_profiler_expr_table, ICON_MD_MEMORY "||Allocs", profiler_expr_table_allocations, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(value_column_width);
+}
+
+FOUNDATION_STATIC void profiler_render_expr_table()
+{
+    bool profiling = expr_profile_enabled();
+    if (ImGui::Checkbox(tr("Record expression functions"), &profiling))
+        expr_profile_enable(profiling);
+
+    ImGui::SameLine();
+    if (ImGui::Button(tr("Reset")))
+        expr_profile_reset();
+
+    if (_profiler_expr_table == nullptr)
+        profiler_create_expr_table();
+
+    array_deallocate(_profiler_expr_entries);
+    _profiler_expr_entries = expr_profile_entries();
+    table_render(_profiler_expr_table, _profiler_expr_entries, array_size(_profiler_expr_entries), sizeof(expr_profile_entry_t), 0.0f, 0.0f);
+}
+
+#if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+
+/*! Returns the counter slot of a memory context, claiming a free one the first time the context is seen.
+ *  This is called for every tracked allocation, so it must never allocate memory itself.
+ */
+FOUNDATION_STATIC int profiler_memory_slot(hash_t context)
+{
+    const int64_t key = (int64_t)(context ? context : HASH_DEFAULT);
+    unsigned index = (unsigned)((hash_t)key % PROFILER_MEMORY_CONTEXT_CAPACITY);
+    for (unsigned probe = 0; probe < PROFILER_MEMORY_CONTEXT_CAPACITY; ++probe, index = (index + 1) % PROFILER_MEMORY_CONTEXT_CAPACITY)
+    {
+        profiler_memory_counter_t* counter = &_memory_counters[index];
+        const int64_t slot_context = atomic_load64(&counter->context, memory_order_acquire);
+        if (slot_context == key)
+            return (int)index;
+
+        if (slot_context == 0)
+        {
+            if (atomic_cas64(&counter->context, key, 0, memory_order_acq_rel, memory_order_acquire) ||
+                atomic_load64(&counter->context, memory_order_acquire) == key)
+                return (int)index;
+        }
+    }
+
+    return -1;
+}
+
+FOUNDATION_STATIC void profiler_memory_track(hash_t context, void* addr, size_t size)
+{
+    _memory_tracker_forward.track(context, addr, size);
+
+    const int slot = profiler_memory_slot(context);
+    if (slot < 0)
+        return;
+
+    profiler_memory_counter_t* counter = &_memory_counters[slot];
+    atomic_incr64(&counter->allocations, memory_order_relaxed);
+
+    int64_t largest = atomic_load64(&counter->largest, memory_order_relaxed);
+    while ((int64_t)size > largest && !atomic_cas64(&counter->largest, (int64_t)size, largest, memory_order_relaxed, memory_order_relaxed))
+        largest = atomic_load64(&counter->largest, memory_order_relaxed);
+}
+
+FOUNDATION_STATIC int profiler_memory_dump_handler(hash_t context, const void* addr, size_t size, void* const* trace, size_t depth)
+{
+    const int slot = profiler_memory_slot(context);
+    if (slot >= 0)
+    {
+        _memory_dump_bytes[slot] += size;
+        _memory_dump_allocations[slot]++;
+    }
+    return 0;
+}
+
+/*! Sums the live allocations of each context from the memory tracker. */
+FOUNDATION_STATIC void profiler_memory_dump()
+{
+    memset(_memory_dump_bytes, 0, sizeof(_memory_dump_bytes));
+    memset(_memory_dump_allocations, 0, sizeof(_memory_dump_allocations));
+    memory_tracker_dump(profiler_memory_dump_handler);
+}
+
+/*! Updates the context entries from the last dump and the allocation counters. */
+FOUNDATION_STATIC void profiler_memory_update_entries()
+{
+    const tick_t now = time_current();
+    const double elapsed_seconds = _memory_last_sample ? time_ticks_to_seconds(time_diff(_memory_last_sample, now)) : 0;
+    _memory_last_sample = now;
+
+    array_clear(_memory_entries);
+    for (unsigned i = 0; i < PROFILER_MEMORY_CONTEXT_CAPACITY; ++i)
+    {
+        const profiler_memory_counter_t* counter = &_memory_counters[i];
+        const hash_t context = (hash_t)atomic_load64(&counter->context, memory_order_acquire);
+        if (context == 0)
+            continue;
+
+        profiler_memory_context_t& c = _memory_contexts[i];
+        if (c.context == 0)
+        {
+            c.context = context;
+            profiler_trace_context_name(STRING_BUFFER(c.name), context);
+        }
+
+        const uint64_t allocations = (uint64_t)atomic_load64(&counter->allocations, memory_order_relaxed);
+        c.allocations_per_second = elapsed_seconds > 0 ? (allocations - c.allocations) / elapsed_seconds : 0;
+        c.allocations = allocations;
+        c.largest = (uint64_t)atomic_load64(&counter->largest, memory_order_relaxed);
+
+        c.live_bytes = _memory_dump_bytes[i];
+        c.live_allocations = _memory_dump_allocations[i];
+        c.sampled_peak_bytes = max(c.sampled_peak_bytes, c.live_bytes);
+
+        c.growth_bytes = (int64_t)c.live_bytes - (int64_t)_memory_snapshot_bytes[i];
+        c.growth_allocations = (int64_t)c.live_allocations - (int64_t)_memory_snapshot_allocations[i];
+
+        array_push(_memory_entries, c);
+    }
+
+    if (_memory_snapshot_time)
+        array_sort(_memory_entries, ARRAY_GREATER_BY(growth_bytes));
+    else
+        array_sort(_memory_entries, ARRAY_GREATER_BY(live_bytes));
+}
+
+FOUNDATION_STATIC void profiler_memory_log()
+{
+    MEMORY_TRACKER(HASH_MEMORY);
+    profiler_memory_sample();
+
+    if (_memory_snapshot_time)
+    {
+        log_infof(HASH_MEMORY, STRING_CONST("Memory per context, growth since snapshot taken %.0lf seconds ago:"),
+            time_elapsed(_memory_snapshot_time));
+    }
+    else
+    {
+        log_info(HASH_MEMORY, STRING_CONST("Memory per context:"));
+    }
+
+    foreach(c, _memory_entries)
+    {
+        if (c->live_bytes == 0 && c->growth_bytes == 0)
+            continue;
+
+        log_infof(HASH_MEMORY, STRING_CONST("%24s : %10.4g kb live (%" PRIu64 "), %10.4g kb sampled peak, %8.0lf allocs/s, %10.4g kb largest, %+10.4g kb (%+" PRId64 ") growth"),
+            c->name, c->live_bytes / 1024.0, c->live_allocations, c->sampled_peak_bytes / 1024.0, c->allocations_per_second,
+            c->largest / 1024.0, c->growth_bytes / 1024.0, c->growth_allocations);
+    }
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_name(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return c->name;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_live(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return (double)c->live_bytes;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_sampled_peak(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return (double)c->sampled_peak_bytes;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_live_allocations(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return (double)c->live_allocations;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_allocations_per_second(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return math_round(c->allocations_per_second);
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_largest(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return (double)c->largest;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_growth(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return (double)c->growth_bytes;
+}
+
+FOUNDATION_STATIC table_cell_t profiler_memory_table_growth_allocations(table_element_ptr_t element, const table_column_t* column)
+{
+    profiler_memory_context_t* c = (profiler_memory_context_t*)element;
+    return (double)c->growth_allocations;
+}
+
+FOUNDATION_STATIC void profiler_create_memory_table()
+{
+    _profiler_memory_table = table_allocate("ProfilerMemory#1");
+    const float value_column_width = imgui_get_font_ui_scale(90.0f);
+    table_add_column(_profiler_memory_table, "Context", profiler_memory_table_name, COLUMN_FORMAT_TEXT, COLUMN_SORTABLE | COLUMN_FREEZE);
+    table_add_column(_profiler_memory_table, ICON_MD_MEMORY "||Live", profiler_memory_table_live, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(value_column_width);
+    table_add_column(_profiler_memory_table, ICON_MD_TRENDING_UP "||Sampled Peak", profiler_memory_table_sampled_peak, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(value_column_width);
+    table_add_column(_profiler_memory_table, ICON_MD_NUMBERS "||Allocs", profiler_memory_table_live_allocations, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(value_column_width);
+    table_add_column(_profiler_memory_table, ICON_MD_SPEED "||Allocs/s", profiler_memory_table_allocations_per_second, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(value_column_width);
+    table_add_column(_profiler_memory_table, ICON_MD_STRAIGHTEN "||Largest", profiler_memory_table_largest, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(value_column_width);
+    table_add_column(_profiler_memory_table, ICON_MD_DIFFERENCE "||Growth", profiler_memory_table_growth, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION)
+        .set_width(value_column_width);
+    table_add_column(_profiler_memory_table, ICON_MD_DIFFERENCE "||Growth Allocs", profiler_memory_table_growth_allocations, COLUMN_FORMAT_NUMBER, COLUMN_SORTABLE | COLUMN_NUMBER_ABBREVIATION | COLUMN_HIDE_DEFAULT)
+        .set_width(value_column_width);
+}
+
+FOUNDATION_STATIC void profiler_render_memory_table()
+{
+    if (_memory_last_sample == 0 || time_elapsed(_memory_last_sample) > PROFILER_MEMORY_SAMPLE_INTERVAL)
+        profiler_memory_sample();
+
+    if (ImGui::Button(tr("Snapshot")))
+        profiler_memory_snapshot();
+
+    ImGui::SameLine();
+    ImGui::BeginDisabled(_memory_snapshot_time == 0);
+    if (ImGui::Button(tr("Clear Snapshot")))
+        profiler_memory_clear_snapshot();
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    if (ImGui::Button(tr("Log")))
+    {
+        console_show();
+        profiler_memory_log();
+    }
+
+    if (_memory_snapshot_time)
+    {
+        ImGui::SameLine();
+        ImGui::TrText("Growth since snapshot taken %.0lf seconds ago", time_elapsed(_memory_snapshot_time));
+    }
+
+    if (_profiler_memory_table == nullptr)
+        profiler_create_memory_table();
+
+    table_render(_profiler_memory_table, _memory_entries, array_size(_memory_entries), sizeof(profiler_memory_context_t), 0.0f, 0.0f);
+}
+
+#endif
+
 FOUNDATION_STATIC void profiler_window_render()
 {
     static bool window_opened_once = false;
@@ -236,14 +755,47 @@ FOUNDATION_STATIC void profiler_window_render()
         ImGui::PushStyleVar(ImGuiStyleVar_ChildBorderSize, 0.0f);
         ImGui::PushStyleVar(ImGuiStyleVar_ItemInnerSpacing, ImVec2(0, 0));
 
-        if (_profiler_table == nullptr)
-            profiler_create_table();
-
-        if (_trackers_lock.shared_lock())
+        if (ImGui::BeginTabBar("Profiler##Tabs"))
         {
-            table_render(_profiler_table, _trackers, array_size(_trackers), sizeof(profile_tracker_t), 0.0f, 0.0f);
+            if (ImGui::BeginTabItem(tr("Blocks")))
+            {
+                bool tracing = profiler_trace_enabled();
+                if (ImGui::Checkbox(tr("Record trace"), &tracing))
+                {
+                    if (tracing && profiler_trace_start())
+                        module_register_update(HASH_PROFILER, profiler_trace_update);
+                    else if (!tracing)
+                        profiler_trace_stop();
+                }
+
+                if (_profiler_table == nullptr)
+                    profiler_create_table();
+
+                if (_trackers_lock.shared_lock())
+                {
+                    table_render(_profiler_table, _trackers, array_size(_trackers), sizeof(profile_tracker_t), 0.0f, 0.0f);
+
+                    _trackers_lock.shared_unlock();
+                }
+
+                ImGui::EndTabItem();
+            }
+
+            if (ImGui::BeginTabItem(tr("Expressions")))
+            {
+                profiler_render_expr_table();
+                ImGui::EndTabItem();
+            }
 
-            _trackers_lock.shared_unlock();
+            #if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+            if (ImGui::BeginTabItem(tr("Memory")))
+            {
+                profiler_render_memory_table();
+                ImGui::EndTabItem();
+            }
+            #endif
+
+            ImGui::EndTabBar();
         }
 
         ImGui::PopStyleVar(2);
@@ -255,6 +807,15 @@ FOUNDATION_STATIC void profiler_window_render()
     {
         table_deallocate(_profiler_table);
         _profiler_table = nullptr;
+
+        table_deallocate(_profiler_expr_table);
+        _profiler_expr_table = nullptr;
+        array_deallocate(_profiler_expr_entries);
+
+        #if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+        table_deallocate(_profiler_memory_table);
+        _profiler_memory_table = nullptr;
+        #endif
     }
 }
 
@@ -316,12 +877,235 @@ void profiler_menu_timer()
     #endif
 }
 
+memory_tracker_t profiler_memory_tracker()
+{
+    memory_tracker_t tracker = memory_tracker_local();
+    #if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+    if (tracker.track)
+    {
+        _memory_tracker_forward = tracker;
+        tracker.track = profiler_memory_track;
+    }
+    #endif
+    return tracker;
+}
+
+#if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+
+const profiler_memory_context_t* profiler_memory_sample()
+{
+    profiler_memory_dump();
+    profiler_memory_update_entries();
+    return _memory_entries;
+}
+
+void profiler_memory_snapshot()
+{
+    profiler_memory_dump();
+    memcpy(_memory_snapshot_bytes, _memory_dump_bytes, sizeof(_memory_snapshot_bytes));
+    memcpy(_memory_snapshot_allocations, _memory_dump_allocations, sizeof(_memory_snapshot_allocations));
+    _memory_snapshot_time = time_current();
+    profiler_memory_update_entries();
+}
+
+void profiler_memory_clear_snapshot()
+{
+    memset(_memory_snapshot_bytes, 0, sizeof(_memory_snapshot_bytes));
+    memset(_memory_snapshot_allocations, 0, sizeof(_memory_snapshot_allocations));
+    _memory_snapshot_time = 0;
+    profiler_memory_sample();
+}
+
+#endif
+
+bool profiler_trace_enabled()
+{
+    return atomic_load32(&_trace_session, memory_order_relaxed) != 0;
+}
+
+void profiler_trace_begin(const char* name, size_t name_length)
+{
+    profiler_trace_record(PROFILER_TRACE_BEGIN, name, name_length, 0);
+}
+
+void profiler_trace_end()
+{
+    profiler_trace_record(PROFILER_TRACE_END, nullptr, 0, 0);
+}
+
+void profiler_trace_counter(const char* name, size_t name_length, double value)
+{
+    profiler_trace_record(PROFILER_TRACE_COUNTER, name, name_length, value);
+}
+
+bool profiler_trace_start(const char* trace_file_path /*= nullptr*/, size_t trace_file_path_length /*= 0*/)
+{
+    if (profiler_trace_enabled())
+        return true;
+
+    string_const_t file_path = string_const(trace_file_path, trace_file_path_length);
+    if (string_is_null(file_path))
+    {
+        string_const_t timestamp = string_from_uint_static(time_current(), false, 0, 0);
+        file_path = session_get_user_file_path(STRING_ARGS(timestamp), STRING_CONST("profiles"), STRING_CONST("wtrace"), true);
+    }
+
+    _trace_stream = fs_open_file(STRING_ARGS(file_path), STREAM_CREATE | STREAM_OUT | STREAM_BINARY | STREAM_TRUNCATE);
+    if (_trace_stream == nullptr)
+    {
+        log_errorf(HASH_PROFILER, ERROR_ACCESS_DENIED, STRING_CONST("Failed to create trace file %.*s"), STRING_FORMAT(file_path));
+        return false;
+    }
+
+    profiler_trace_header_t header;
+    header.magic = PROFILER_TRACE_MAGIC;
+    header.version = PROFILER_TRACE_VERSION;
+    header.event_size = sizeof(profiler_trace_event_t);
+    header.reserved = 0;
+    header.ticks_per_second = time_ticks_per_second();
+    header.start = time_current();
+    stream_write(_trace_stream, &header, sizeof(header));
+
+    _trace_last_flush = header.start;
+    atomic_store32(&_trace_session, ++_trace_last_session, memory_order_release);
+    log_infof(HASH_PROFILER, STRING_CONST("Recording trace to %.*s"), STRING_FORMAT(file_path));
+    return true;
+}
+
+void profiler_trace_stop()
+{
+    if (!profiler_trace_enabled())
+        return;
+
+    atomic_store32(&_trace_session, 0, memory_order_release);
+    profiler_trace_flush();
+
+    // Chunks still in use could be written to by threads that were recording an event
+    // when the trace got stopped, so they are only released when the profiler shuts down.
+    profiler_trace_chunk_t* chunk = (profiler_trace_chunk_t*)atomic_load_ptr(&_trace_chunks, memory_order_acquire);
+    while (!atomic_cas_ptr(&_trace_chunks, nullptr, chunk, memory_order_acq_rel, memory_order_acquire))
+        chunk = (profiler_trace_chunk_t*)atomic_load_ptr(&_trace_chunks, memory_order_acquire);
+    for (; chunk; chunk = chunk->next)
+    {
+        if (chunk->written < (uint32_t)atomic_load32(&chunk->count, memory_order_acquire))
+            profiler_trace_write_block(chunk, (uint32_t)atomic_load32(&chunk->count, memory_order_acquire));
+        array_push(_trace_retired_chunks, chunk);
+    }
+
+    char trace_file_path_buffer[BUILD_MAX_PATHLEN];
+    string_const_t stream_file_path = stream_path(_trace_stream);
+    string_t trace_file_path = string_copy(STRING_BUFFER(trace_file_path_buffer), STRING_ARGS(stream_file_path));
+    stream_deallocate(_trace_stream);
+    _trace_stream = nullptr;
+
+    char json_file_path_buffer[BUILD_MAX_PATHLEN];
+    string_t json_file_path = string_format(STRING_BUFFER(json_file_path_buffer), STRING_CONST("%.*s.json"), STRING_FORMAT(trace_file_path));
+    if (profiler_trace_export_chrome(STRING_ARGS(trace_file_path), STRING_ARGS(json_file_path)))
+        log_infof(HASH_PROFILER, STRING_CONST("Trace exported to %.*s"), STRING_FORMAT(json_file_path));
+}
+
+bool profiler_trace_export_chrome(
+    const char* trace_file_path, size_t trace_file_path_length,
+    const char* json_file_path, size_t json_file_path_length)
+{
+    stream_t* trace_stream = fs_open_file(trace_file_path, trace_file_path_length, STREAM_IN | STREAM_BINARY);
+    if (trace_stream == nullptr)
+        return false;
+
+    profiler_trace_header_t header;
+    if (stream_read(trace_stream, &header, sizeof(header)) != sizeof(header) || header.magic != PROFILER_TRACE_MAGIC ||
+        header.version != PROFILER_TRACE_VERSION || header.event_size != sizeof(profiler_trace_event_t) || header.ticks_per_second == 0)
+    {
+        log_warnf(HASH_PROFILER, WARNING_INVALID_VALUE, STRING_CONST("Invalid trace file %.*s"), (int)trace_file_path_length, trace_file_path);
+        stream_deallocate(trace_stream);
+        return false;
+    }
+
+    stream_t* json_stream = fs_open_file(json_file_path, json_file_path_length, STREAM_CREATE | STREAM_OUT | STREAM_TRUNCATE);
+    if (json_stream == nullptr)
+    {
+        log_errorf(HASH_PROFILER, ERROR_ACCESS_DENIED, STRING_CONST("Failed to create %.*s"), (int)json_file_path_length, json_file_path);
+        stream_deallocate(trace_stream);
+        return false;
+    }
+
+    stream_write_string(json_stream, STRING_CONST("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"));
+
+    const char* separator = "";
+    uint64_t* named_threads = nullptr;
+    profiler_trace_event_t* events = nullptr;
+    const double ticks_to_us = 1000000.0 / (double)header.ticks_per_second;
+
+    profiler_trace_block_t block;
+    while (stream_read(trace_stream, &block, sizeof(block)) == sizeof(block))
+    {
+        array_resize(events, block.event_count);
+        const size_t events_size = sizeof(profiler_trace_event_t) * block.event_count;
+        if (stream_read(trace_stream, events, events_size) != events_size)
+            break;
+
+        char name_buffer[64];
+        if (array_contains(named_threads, block.thread) == false)
+        {
+            string_const_t thread_name = profiler_trace_json_name(STRING_BUFFER(name_buffer), block.thread_name, string_length(block.thread_name));
+            stream_write_format(json_stream, STRING_CONST("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu64 ",\"args\":{\"name\":\"%.*s\"}}"),
+                separator, block.thread, STRING_FORMAT(thread_name));
+            array_push(named_threads, block.thread);
+            separator = ",\n";
+        }
+
+        for (uint32_t i = 0; i < block.event_count; ++i)
+        {
+            const profiler_trace_event_t& e = events[i];
+            const double ts = (double)(e.time - header.start) * ticks_to_us;
+            if (e.type == PROFILER_TRACE_END)
+            {
+                stream_write_format(json_stream, STRING_CONST("%s{\"ph\":\"E\",\"ts\":%.3lf,\"pid\":1,\"tid\":%" PRIu64 "}"),
+                    separator, ts, block.thread);
+                continue;
+            }
+
+            char context_buffer[64];
+            string_const_t name = profiler_trace_json_name(STRING_BUFFER(name_buffer), e.name, string_length(e.name));
+            string_const_t context = profiler_trace_context_name(STRING_BUFFER(context_buffer), e.context);
+            if (e.type == PROFILER_TRACE_COUNTER)
+            {
+                stream_write_format(json_stream, STRING_CONST("%s{\"name\":\"%.*s\",\"cat\":\"%.*s\",\"ph\":\"C\",\"ts\":%.3lf,\"pid\":1,\"tid\":%" PRIu64 ",\"args\":{\"value\":%.17lg}}"),
+                    separator, STRING_FORMAT(name), STRING_FORMAT(context), ts, block.thread, e.value);
+            }
+            else
+            {
+                stream_write_format(json_stream, STRING_CONST("%s{\"name\":\"%.*s\",\"cat\":\"%.*s\",\"ph\":\"B\",\"ts\":%.3lf,\"pid\":1,\"tid\":%" PRIu64 "}"),
+                    separator, STRING_FORMAT(name), STRING_FORMAT(context), ts, block.thread);
+            }
+        }
+    }
+
+    stream_write_string(json_stream, STRING_CONST("\n]}\n"));
+
+    array_deallocate(events);
+    array_deallocate(named_threads);
+    stream_deallocate(json_stream);
+    stream_deallocate(trace_stream);
+    return true;
+}
+
 //
 // # SYSTEM
 //
 
 FOUNDATION_STATIC void profiler_initialize()
 {
+    #if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+    // Report the memory growth of the whole batch run when shutting down.
+    if (main_is_batch_mode())
+        profiler_memory_snapshot();
+    #endif
+
+    string_const_t trace_file_path;
+    if (environment_argument("trace", &trace_file_path) && profiler_trace_start(STRING_ARGS(trace_file_path)))
+        module_register_update(HASH_PROFILER, profiler_trace_update);
+
     if (!environment_argument("profile"))
         return;
         
@@ -352,8 +1136,24 @@ FOUNDATION_STATIC void profiler_initialize()
 
 FOUNDATION_STATIC void profiler_shutdown()
 {
+    #if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+    if (main_is_batch_mode())
+        profiler_memory_log();
+    if (_profiler_memory_table)
+        table_deallocate(_profiler_memory_table);
+    array_deallocate(_memory_entries);
+    #endif
+
+    profiler_trace_stop();
+    foreach(c, _trace_retired_chunks)
+        memory_deallocate(*c);
+    array_deallocate(_trace_retired_chunks);
+
     if (_profiler_table)
         table_deallocate(_profiler_table);
+    if (_profiler_expr_table)
+        table_deallocate(_profiler_expr_table);
+    array_deallocate(_profiler_expr_entries);
 
     if (_profile_stream)
     {
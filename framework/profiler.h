@@ -15,11 +15,102 @@
 #include <foundation/string.h>
 #include <foundation/profile.h>
 
+/*! Returns the memory tracker to install at startup, which also counts the allocations of each memory context.
+ *
+ *  The live memory, sampled peak, allocation rate, largest allocation and growth since a snapshot of each
+ *  context are shown in the profiler Memory tab and logged when the application exits in batch mode.
+ */
+memory_tracker_t profiler_memory_tracker();
+
+#if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+
+/*! Memory usage of a memory context, as shown in the profiler Memory tab. */
+struct profiler_memory_context_t
+{
+    hash_t context{ 0 };
+    char name[32]{ 0 };
+
+    uint64_t live_bytes{ 0 };
+    uint64_t live_allocations{ 0 };
+
+    /*! Highest live bytes seen when sampling, allocations freed between samples are not accounted for. */
+    uint64_t sampled_peak_bytes{ 0 };
+
+    uint64_t largest{ 0 };
+    uint64_t allocations{ 0 };
+    double allocations_per_second{ 0 };
+
+    int64_t growth_bytes{ 0 };
+    int64_t growth_allocations{ 0 };
+};
+
+/*! Sums the live allocations of each memory context from the memory tracker.
+ *
+ *  @return Memory usage of each context, sorted by growth since the snapshot if any, otherwise by live bytes.
+ *          The array is owned by the profiler and is only valid until the next sample.
+ */
+const profiler_memory_context_t* profiler_memory_sample();
+
+/*! Remembers the live memory of each context, so growth is reported relative to this point. */
+void profiler_memory_snapshot();
+
+/*! Forgets the last snapshot, so growth is reported relative to no memory at all. */
+void profiler_memory_clear_snapshot();
+
+#endif
+
+/*! Starts recording trace events of all threads to a binary trace file.
+ *
+ *  @param trace_file_path        Trace file path, or null to write it in the session profiles folder.
+ *  @param trace_file_path_length Trace file path length.
+ *
+ *  @return True if the trace is being recorded.
+ */
+bool profiler_trace_start(const char* trace_file_path = nullptr, size_t trace_file_path_length = 0);
+
+/*! Stops recording trace events, writes the remaining events and exports the trace as Chrome trace JSON. */
+void profiler_trace_stop();
+
+/*! Checks if trace events are being recorded. */
+bool profiler_trace_enabled();
+
+/*! Records the beginning of a block on the calling thread, tagged with the current memory context.
+ *
+ *  @param name        Block name, truncated to 31 characters.
+ *  @param name_length Block name length.
+ */
+void profiler_trace_begin(const char* name, size_t name_length);
+
+/*! Records the end of the last block that began on the calling thread. */
+void profiler_trace_end();
+
+/*! Records a counter value on the calling thread.
+ *
+ *  @param name        Counter name, truncated to 31 characters.
+ *  @param name_length Counter name length.
+ *  @param value       Counter value.
+ */
+void profiler_trace_counter(const char* name, size_t name_length, double value);
+
+/*! Converts a binary trace file to the Chrome trace JSON format, which can also be opened with Perfetto.
+ *
+ *  @param trace_file_path        Binary trace file path.
+ *  @param trace_file_path_length Binary trace file path length.
+ *  @param json_file_path         JSON file path to write.
+ *  @param json_file_path_length  JSON file path length.
+ *
+ *  @return True if the trace was exported.
+ */
+bool profiler_trace_export_chrome(
+    const char* trace_file_path, size_t trace_file_path_length, 
+    const char* json_file_path, size_t json_file_path_length);
+
 struct TrackerScope
 {
     FOUNDATION_FORCEINLINE TrackerScope(const char* name, size_t name_length)
     {
         profile_begin_block(name, name_length);
+        profiler_trace_begin(name, name_length);
     }
 
     template <size_t N> FOUNDATION_FORCEINLINE
@@ -37,10 +128,12 @@ struct TrackerScope
         string_t vname = string_vformat(STRING_BUFFER(vname_buffer), fmt, string_length(fmt), list);
         va_end(list);
         profile_begin_block(STRING_ARGS(vname));
+        profiler_trace_begin(STRING_ARGS(vname));
     }
 
     FOUNDATION_FORCEINLINE ~TrackerScope()
     {
+        profiler_trace_end();
         profile_end_block();
     }
 };
@@ -62,6 +155,15 @@ void profiler_menu_timer();
 
 FOUNDATION_FORCEINLINE void profiler_menu_timer() {}
 
+FOUNDATION_FORCEINLINE memory_tracker_t profiler_memory_tracker() { return memory_tracker_local(); }
+
+FOUNDATION_FORCEINLINE bool profiler_trace_start(const char* trace_file_path = nullptr, size_t trace_file_path_length = 0) { return false; }
+FOUNDATION_FORCEINLINE void profiler_trace_stop() {}
+FOUNDATION_FORCEINLINE bool profiler_trace_enabled() { return false; }
+FOUNDATION_FORCEINLINE void profiler_trace_begin(const char* name, size_t name_length) {}
+FOUNDATION_FORCEINLINE void profiler_trace_end() {}
+FOUNDATION_FORCEINLINE void profiler_trace_counter(const char* name, size_t name_length, double value) {}
+
 #endif
 
 #if BUILD_DEBUG && BUILD_ENABLE_PROFILE
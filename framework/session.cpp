@@ -8,6 +8,7 @@
 #include <framework/imgui.h>
 #include <framework/common.h>
 #include <framework/config.h>
+#include <framework/persistence.h>
 #include <framework/jobs.h>
 #include <framework/string.h>
 #include <framework/array.h>
@@ -183,11 +184,10 @@ void session_save()
     if (main_is_graphical_mode())
         ImGui::SaveIniSettingsToDisk(session_get_user_file_path(STRING_CONST(IMGUI_FILE_NAME)).str);
     
-    config_write_file(session_get_file_path(), _session_config,
+    persistence_save(session_get_file_path(), _session_config,
           CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS |
           CONFIG_OPTION_PRESERVE_INSERTION_ORDER |
           CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL);
-    
 }
 
 string_const_t session_get_user_dir()
@@ -15,6 +15,7 @@
 #include <foundation/hash.h>
 #include <foundation/memory.h>
 #include <foundation/assert.h>
+#include <foundation/atomic.h>
 
 #define HASH_STRING_TABLE static_hash_string("string_table", 12, 0xf026bfe3a9500e3cLL)
 
@@ -26,14 +27,48 @@ struct string_table_free_slot_t
     size_t                length;
 };
 
-/*! Global string table lock mutex. */
-static shared_mutex _string_table_lock;
+/*! Size of the global string table storage chunks, symbols are encoded as chunk index and chunk offset. */
+#define STRING_TABLE_CHUNK_SHIFT (16)
+#define STRING_TABLE_CHUNK_SIZE (1 << STRING_TABLE_CHUNK_SHIFT)
+#define STRING_TABLE_CHUNK_MASK (STRING_TABLE_CHUNK_SIZE - 1)
+#define STRING_TABLE_MAX_CHUNKS (INT32_MAX >> STRING_TABLE_CHUNK_SHIFT)
 
-/// <summary>
-/// Global string table shared by all systems of the application.
-/// Only allocated on demand.
-/// </summary>
-static string_table_t* GLOBAL_STRING_TABLE = nullptr;
+/*! Number of independent hash indexes of the global string table. */
+#define STRING_TABLE_SHARD_COUNT (16)
+
+struct string_table_entry_t
+{
+    hash_t hash;
+    string_table_symbol_t symbol;
+};
+
+/*! Global string table shard, each shard has its own index and storage chunk to add new strings. */
+struct string_table_shard_t
+{
+    shared_mutex lock;
+
+    string_table_entry_t* entries{ nullptr };
+    unsigned capacity{ 0 };
+    unsigned count{ 0 };
+
+    char* chunk{ nullptr };
+    string_table_symbol_t chunk_symbol{ 0 };
+    unsigned chunk_used{ 0 };
+
+    size_t string_bytes{ 0 };
+};
+
+/*! Global string table storage chunks. 
+ * 
+ *  Chunks are never moved nor released before shutdown, so decoded strings stay valid
+ *  and symbols are resolved without locking. Strings larger than a chunk span consecutive chunks.
+ */
+static atomicptr_t _string_table_chunks[STRING_TABLE_MAX_CHUNKS];
+static atomic32_t _string_table_chunk_count = 0;
+static char** _string_table_allocations = nullptr;
+static shared_mutex _string_table_allocations_lock;
+
+static string_table_shard_t _string_table_shards[STRING_TABLE_SHARD_COUNT];
 
 /// <summary>
 /// Contains the hash key of string stored in a string table.
@@ -70,66 +105,233 @@ string_table_symbol_t string_table_encode_unescape(string_const_t value)
     return string_table_encode(STRING_ARGS(value));
 }
 
+/*! Reserves the storage chunks for strings of #length bytes and returns the symbol of the first chunk. */
+FOUNDATION_STATIC string_table_symbol_t string_table_allocate_chunks(size_t length, char** out_chunk, unsigned* out_chunk_count)
+{
+    MEMORY_TRACKER(HASH_STRING_TABLE);
+
+    const unsigned chunk_count = (unsigned)((length + STRING_TABLE_CHUNK_SIZE) >> STRING_TABLE_CHUNK_SHIFT);
+    const int32_t first_chunk = atomic_add32(&_string_table_chunk_count, (int32_t)chunk_count, memory_order_relaxed) - (int32_t)chunk_count;
+    FOUNDATION_ASSERT_MSG(first_chunk + chunk_count <= STRING_TABLE_MAX_CHUNKS, "Global string table is full");
+
+    char* chunk = (char*)memory_allocate(HASH_STRING_TABLE, (size_t)chunk_count * STRING_TABLE_CHUNK_SIZE, 0, MEMORY_PERSISTENT);
+    for (unsigned i = 0; i < chunk_count; ++i)
+        atomic_store_ptr(&_string_table_chunks[first_chunk + i], chunk + (size_t)i * STRING_TABLE_CHUNK_SIZE, memory_order_release);
+
+    {
+        SHARED_WRITE_LOCK(_string_table_allocations_lock);
+        array_push(_string_table_allocations, chunk);
+    }
+
+    *out_chunk = chunk;
+    *out_chunk_count = chunk_count;
+    return (string_table_symbol_t)(first_chunk << STRING_TABLE_CHUNK_SHIFT);
+}
+
+/*! Copies a new string in the shard storage chunk. 
+ *  @remark The shard must be locked exclusively.
+ */
+FOUNDATION_STATIC string_table_symbol_t string_table_shard_store(string_table_shard_t* shard, const char* s, size_t length)
+{
+    char* dest = nullptr;
+    string_table_symbol_t symbol = STRING_TABLE_NULL_SYMBOL;
+    if (shard->chunk && shard->chunk_used + length + 1 <= STRING_TABLE_CHUNK_SIZE)
+    {
+        dest = shard->chunk + shard->chunk_used;
+        symbol = shard->chunk_symbol + shard->chunk_used;
+        shard->chunk_used += (unsigned)length + 1;
+    }
+    else
+    {
+        unsigned chunk_count = 0;
+        symbol = string_table_allocate_chunks(length, &dest, &chunk_count);
+        if (chunk_count == 1)
+        {
+            // Following strings of this shard are added after this one.
+            shard->chunk = dest;
+            shard->chunk_symbol = symbol;
+            shard->chunk_used = (unsigned)length + 1;
+        }
+    }
+
+    memcpy(dest, s, length);
+    dest[length] = '\0';
+    shard->string_bytes += length + 1;
+    return symbol;
+}
+
+FOUNDATION_FORCEINLINE const char* string_table_global_string(string_table_symbol_t symbol)
+{
+    const char* chunk = (const char*)atomic_load_ptr(&_string_table_chunks[symbol >> STRING_TABLE_CHUNK_SHIFT], memory_order_acquire);
+    if (chunk == nullptr)
+        return nullptr;
+    return chunk + (symbol & STRING_TABLE_CHUNK_MASK);
+}
+
+/*! Returns the index entry of a string in the shard or the empty entry where it can be inserted. 
+ *  @remark The shard must be locked.
+ */
+FOUNDATION_STATIC string_table_entry_t* string_table_shard_find(string_table_shard_t* shard, const char* s, size_t length, hash_t h)
+{
+    if (shard->capacity == 0)
+        return nullptr;
+
+    const unsigned mask = shard->capacity - 1;
+    for (unsigned i = (unsigned)(h / STRING_TABLE_SHARD_COUNT) & mask;; i = (i + 1) & mask)
+    {
+        string_table_entry_t* e = shard->entries + i;
+        if (e->symbol == STRING_TABLE_NULL_SYMBOL)
+            return e;
+
+        if (e->hash != h)
+            continue;
+
+        const char* str = string_table_global_string(e->symbol);
+        if (memcmp(str, s, length) == 0 && str[length] == '\0')
+            return e;
+    }
+}
+
+/*! Doubles the shard index capacity, stored strings are not moved.
+ *  @remark The shard must be locked exclusively.
+ */
+FOUNDATION_STATIC void string_table_shard_grow(string_table_shard_t* shard)
+{
+    MEMORY_TRACKER(HASH_STRING_TABLE);
+
+    string_table_entry_t* entries = shard->entries;
+    const unsigned capacity = shard->capacity;
+
+    shard->capacity = max(capacity * 2, 256U);
+    shard->entries = (string_table_entry_t*)memory_allocate(HASH_STRING_TABLE, sizeof(string_table_entry_t) * shard->capacity, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+
+    const unsigned mask = shard->capacity - 1;
+    for (unsigned i = 0; i < capacity; ++i)
+    {
+        const string_table_entry_t& e = entries[i];
+        if (e.symbol == STRING_TABLE_NULL_SYMBOL)
+            continue;
+
+        unsigned k = (unsigned)(e.hash / STRING_TABLE_SHARD_COUNT) & mask;
+        while (shard->entries[k].symbol != STRING_TABLE_NULL_SYMBOL)
+            k = (k + 1) & mask;
+        shard->entries[k] = e;
+    }
+
+    memory_deallocate(entries);
+}
+
 string_table_symbol_t string_table_encode(const char* s, size_t length)
 {
-    if (s == nullptr || length == 0)
+    if (s == nullptr || length == 0 || s[0] == '\0')
         return STRING_TABLE_NULL_SYMBOL;
 
-    SHARED_WRITE_LOCK(_string_table_lock);
+    // Make sure the null symbol is reserved before any string is stored.
+    if (atomic_load32(&_string_table_chunk_count, memory_order_acquire) == 0)
+        string_table_initialize();
 
-    string_table_symbol_t symbol = string_table_to_symbol(GLOBAL_STRING_TABLE, s, length);
-    while (symbol == STRING_TABLE_FULL)
+    const hash_t h = hash(s, length);
+    string_table_shard_t* shard = &_string_table_shards[h % STRING_TABLE_SHARD_COUNT];
+
+    // Most strings are already in the table, so we first look for them without blocking other readers.
     {
-        string_table_grow(&GLOBAL_STRING_TABLE, (int)(GLOBAL_STRING_TABLE->allocated_bytes * HASH_FACTOR));
-        symbol = string_table_to_symbol(GLOBAL_STRING_TABLE, s, length);
+        SHARED_READ_LOCK(shard->lock);
+        const string_table_entry_t* e = string_table_shard_find(shard, s, length, h);
+        if (e && e->symbol != STRING_TABLE_NULL_SYMBOL)
+            return e->symbol;
     }
 
-    return symbol;
+    SHARED_WRITE_LOCK(shard->lock);
+
+    if ((shard->count + 1) * 2 > shard->capacity)
+        string_table_shard_grow(shard);
+
+    string_table_entry_t* e = string_table_shard_find(shard, s, length, h);
+    if (e->symbol != STRING_TABLE_NULL_SYMBOL)
+        return e->symbol;
+
+    e->hash = h;
+    e->symbol = string_table_shard_store(shard, s, length);
+    shard->count++;
+    return e->symbol;
 }
 
 const char* string_table_decode(string_table_symbol_t symbol)
 {
-    SHARED_READ_LOCK(_string_table_lock);
-    return string_table_to_string(GLOBAL_STRING_TABLE, symbol);
+    if (symbol <= STRING_TABLE_NULL_SYMBOL)
+        return nullptr;
+    return string_table_global_string(symbol);
 }
 
 string_t string_table_decode(char* buffer, size_t capacity, string_table_symbol_t symbol)
 {
-    SHARED_READ_LOCK(_string_table_lock);
-    string_const_t str = string_table_to_string_const(GLOBAL_STRING_TABLE, symbol);
+    string_const_t str = string_table_decode_const(symbol);
     return string_copy(buffer, capacity, str.str, str.length);
 }
 
 string_const_t string_table_decode_const(string_table_symbol_t symbol)
 {
-    SHARED_READ_LOCK(_string_table_lock);
-    return string_table_to_string_const(GLOBAL_STRING_TABLE, symbol);
-}
+    if (symbol < STRING_TABLE_NULL_SYMBOL)
+        return {};
 
-void string_table_compress()
-{
-    SHARED_WRITE_LOCK(_string_table_lock);
-    string_table_pack(&GLOBAL_STRING_TABLE);
+    const char* str = string_table_global_string(symbol);
+    if (str == nullptr)
+        return {};
+    return string_const(str, string_length(str));
 }
 
 void string_table_initialize()
 {
-    SHARED_WRITE_LOCK(_string_table_lock);
-    
-    if (GLOBAL_STRING_TABLE == nullptr)
-        GLOBAL_STRING_TABLE = string_table_allocate(32 * 1024, 16);
+    SHARED_WRITE_LOCK(_string_table_shards[0].lock);
+
+    if (atomic_load32(&_string_table_chunk_count, memory_order_acquire) > 0)
+        return;
+
+    // The empty string is stored at the first byte of the first chunk so that it is decoded by the null symbol.
+    string_table_shard_t* shard = &_string_table_shards[0];
+    unsigned chunk_count = 0;
+    shard->chunk_symbol = string_table_allocate_chunks(0, &shard->chunk, &chunk_count);
+    shard->chunk[0] = '\0';
+    shard->chunk_used = 1;
+    shard->string_bytes = 1;
 }
 
 void string_table_shutdown()
 {   
-    if (GLOBAL_STRING_TABLE)
+    const int32_t chunk_count = atomic_load32(&_string_table_chunk_count, memory_order_acquire);
+    if (chunk_count == 0)
+        return;
+
+    size_t string_bytes = 0;
+    unsigned string_count = 0;
+    for (unsigned i = 0; i < STRING_TABLE_SHARD_COUNT; ++i)
     {
-        SHARED_WRITE_LOCK(_string_table_lock);
-        log_debugf(HASH_STRING_TABLE, STRING_CONST("String table size: %.3g kb (average string length: %" PRIsize ")"), 
-            GLOBAL_STRING_TABLE->allocated_bytes / 1024.0, string_table_average_string_length(GLOBAL_STRING_TABLE));
-        string_table_deallocate(GLOBAL_STRING_TABLE);
-        GLOBAL_STRING_TABLE = nullptr;
+        string_table_shard_t* shard = &_string_table_shards[i];
+        SHARED_WRITE_LOCK(shard->lock);
+
+        string_bytes += shard->string_bytes;
+        string_count += shard->count;
+
+        memory_deallocate(shard->entries);
+        shard->entries = nullptr;
+        shard->capacity = shard->count = 0;
+        shard->chunk = nullptr;
+        shard->chunk_symbol = STRING_TABLE_NULL_SYMBOL;
+        shard->chunk_used = 0;
+        shard->string_bytes = 0;
     }
+
+    log_debugf(HASH_STRING_TABLE, STRING_CONST("String table size: %.3g kb in %d chunks (%u strings, %.3g kb of strings)"), 
+        chunk_count * (STRING_TABLE_CHUNK_SIZE / 1024.0), chunk_count, string_count, string_bytes / 1024.0);
+
+    SHARED_WRITE_LOCK(_string_table_allocations_lock);
+    for (int32_t i = 0; i < chunk_count; ++i)
+        atomic_store_ptr(&_string_table_chunks[i], nullptr, memory_order_release);
+    atomic_store32(&_string_table_chunk_count, 0, memory_order_release);
+
+    foreach(c, _string_table_allocations)
+        memory_deallocate(*c);
+    array_deallocate(_string_table_allocations);
 }
 
 string_table_t* string_table_allocate(int bytes, int average_string_size)
@@ -277,7 +277,7 @@ const char* string_table_decode(string_table_symbol_t symbol);
 
 /*! Decode a string symbol from the global string table.
  *
- *  The symbol string content is copied to the buffer while the global string table is locked.
+ *  The symbol string content is copied to the buffer.
  *  This version of the function is thread safe.
  * 
  *  @param buffer   The buffer to decode the string into
@@ -295,9 +295,6 @@ string_t string_table_decode(char* buffer, size_t capacity, string_table_symbol_
  */
 string_const_t string_table_decode_const(string_table_symbol_t symbol);
 
-/*! Compact the global string table. */
-void string_table_compress();
-
 /*! Initialize the shared global string table. */
 void string_table_initialize();
 
@@ -12,17 +12,38 @@
 #include <framework/string.h>
 #include <framework/array.h>
 #include <framework/string_builder.h>
+#include <framework/jobs.h>
+#include <framework/dispatcher.h>
+#include <framework/progress.h>
 
 #include <foundation/assert.h>
 #include <foundation/math.h>
 #include <foundation/time.h>
 #include <foundation/stream.h>
+#include <foundation/fs.h>
+#include <foundation/hashtable.h>
 
 #include <mnyfmt.h>
 #include <sys/timeb.h>
 
 #define ENABLE_ROW_HEIGHT_MIDDLE 1
 
+/*! Number of seconds a cached cell value is used before being fetched again, see #TABLE_CACHE_CELLS. */
+#define TABLE_CELL_CACHE_MAX_AGE (1.0)
+
+/*! Minimum number of elements for a #TABLE_BACKGROUND_SORT table to sort its rows in a job. */
+#define TABLE_ASYNC_MIN_ELEMENT_COUNT (1000)
+
+/*! Number of rows captured and formatted together when exporting a table. */
+#define TABLE_EXPORT_CHUNK_ROW_COUNT (1024)
+
+/*! Maximum number of csv export chunks formatted in parallel before being written, bounds the export memory usage. */
+#define TABLE_EXPORT_MAX_PENDING_CHUNKS (8)
+
+/*! Binary table export signature and version, see #table_export_binary. */
+#define TABLE_EXPORT_BINARY_MAGIC (0x4C425457) // WTBL
+#define TABLE_EXPORT_BINARY_VERSION (1)
+
 static thread_local ImRect _table_last_cell_rect;
 
 struct table_column_header_render_args_t
@@ -258,96 +279,1349 @@ void table_cell_middle_aligned_column_label(const char* label, void* payload)
     table_cell_middle_aligned_label(label, 0);
 }
 
-FOUNDATION_STATIC int table_qsort_cells(void* pcontext, void const* va, void const* vb)
+/*! Sorting key of a row, extracted once per row before sorting. */
+struct table_sort_key_t
+{
+    uint32_t        row;
+    bool            fetched;
+    column_format_t format;
+    double          number;
+    time_t          time;
+    uint32_t        text_offset;
+    uint32_t        text_length;
+    size_t          length;
+};
+
+/*! Radix sorting key of a row, for numeric and date columns. */
+struct table_sort_radix_key_t
+{
+    uint64_t key;
+    uint32_t row;
+};
+
+/*! Maps a number to an unsigned key that sorts the same way. NaN values are sorted last. */
+FOUNDATION_FORCEINLINE uint64_t table_sort_number_radix_key(double value, bool ascending)
+{
+    if (math_real_is_nan(value))
+        return UINT64_MAX;
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = (bits & (1ULL << 63)) ? ~bits : (bits | (1ULL << 63));
+    return ascending ? bits : ~bits;
+}
+
+/*! Maps a date to an unsigned key that sorts the same way. Undefined dates are sorted last. */
+FOUNDATION_FORCEINLINE uint64_t table_sort_time_radix_key(time_t value, bool ascending)
+{
+    if (ascending && value == 0)
+        value = INT64_MAX;
+
+    const uint64_t bits = (uint64_t)value ^ (1ULL << 63);
+    return ascending ? bits : ~bits;
+}
+
+/*! LSD radix sort of the keys, 8 bits at a time. Passes where all keys share the same byte are skipped. */
+FOUNDATION_STATIC table_sort_radix_key_t* table_sort_radix(table_sort_radix_key_t* keys, table_sort_radix_key_t* temp, uint32_t count)
+{
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        uint32_t offsets[256] = { 0 };
+        for (uint32_t i = 0; i < count; ++i)
+            offsets[(keys[i].key >> shift) & 0xFF]++;
+
+        if (offsets[(keys[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t b = 0; b < 256; ++b)
+        {
+            const uint32_t bucket_count = offsets[b];
+            offsets[b] = offset;
+            offset += bucket_count;
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+            temp[offsets[(keys[i].key >> shift) & 0xFF]++] = keys[i];
+
+        std::swap(keys, temp);
+    }
+
+    return keys;
+}
+
+FOUNDATION_STATIC int table_sort_compare_keys(const table_sort_key_t& ka, const table_sort_key_t& kb, const char* texts, bool sort_acsending)
+{
+    // Rows that could not be fetched yet are sorted last.
+    if (!ka.fetched || !kb.fetched)
+        return ka.fetched == kb.fetched ? 0 : (ka.fetched ? -1 : 1);
+
+    if (format_is_numeric(ka.format) && format_is_numeric(kb.format))
+    {
+        double sa = ka.number;
+        double sb = kb.number;
+
+        if (math_real_eq(sa, sb, 3))
+            return 0;
+
+        if (math_real_is_nan(sa)) return 1;
+        if (math_real_is_nan(sb)) return -1;
+
+        if (sa < sb)
+            return sort_acsending ? -1 : 1;
+        return sort_acsending ? 1 : -1;
+    }
+
+    if (ka.format == COLUMN_FORMAT_DATE && kb.format == COLUMN_FORMAT_DATE)
+    {
+        const uint64_t sa = table_sort_time_radix_key(ka.time, sort_acsending);
+        const uint64_t sb = table_sort_time_radix_key(kb.time, sort_acsending);
+        return sa < sb ? -1 : (sa > sb ? 1 : 0);
+    }
+
+    if (ka.length == 0 && kb.length > 0)
+        return 1;
+    else if (ka.length > 0 && kb.length == 0)
+        return -1;
+
+    if (ka.format != COLUMN_FORMAT_TEXT || kb.format != COLUMN_FORMAT_TEXT)
+        return 0;
+
+    return strncmp(texts + ka.text_offset, texts + kb.text_offset, min(ka.text_length, kb.text_length)) * (sort_acsending ? 1 : -1);
+}
+
+/*! Fetches the sorting column value of a row.
+ *
+ *  @param context Sorting context, #table_sorting_context_t::completly_sorted is cleared if the row could not be fetched.
+ *  @param row     Row to extract the key from.
+ *  @param key     Key receiving the sorting value, #table_sort_key_t::fetched is false if the row could not be fetched.
+ *  @param texts   Buffer receiving a copy of the text value, since cell text can be transient.
+ */
+FOUNDATION_STATIC void table_sort_extract_key(table_sorting_context_t& context, table_row_t& row, table_sort_key_t& key, char*& texts)
+{
+    table_t* table = context.table;
+    const table_column_t* sorting_column = context.sorting_column;
+
+    const uint32_t row_index = key.row;
+    memset(&key, 0, sizeof(key));
+    key.row = row_index;
+
+    if ((sorting_column->flags & COLUMN_DYNAMIC_VALUE) && !row.fetched && table->update)
+    {
+        if (!(row.fetched = table->update(row.element)))
+        {
+            context.completly_sorted = false;
+            return;
+        }
+    }
+
+    const table_cell_t& cell = sorting_column->fetch_value(row.element, sorting_column);
+    key.fetched = true;
+    key.format = cell.format;
+    key.length = cell.length;
+    if (cell.format == COLUMN_FORMAT_TEXT)
+    {
+        key.text_offset = array_size(texts);
+        key.text_length = (uint32_t)cell.length;
+        if (cell.length && cell.text)
+        {
+            array_resize(texts, key.text_offset + key.text_length);
+            memcpy(texts + key.text_offset, cell.text, cell.length);
+        }
+        else
+        {
+            key.text_length = 0;
+        }
+    }
+    else if (cell.format == COLUMN_FORMAT_DATE)
+    {
+        key.time = cell.time;
+    }
+    else
+    {
+        key.number = cell.number;
+    }
+}
+
+/*! Fetches the sorting column value of rows once.
+ *
+ *  @param context Sorting context, #table_sorting_context_t::completly_sorted is cleared if some rows could not be fetched.
+ *  @param rows    Rows to extract the keys from.
+ *  @param count   Number of rows to extract the keys from.
+ *  @param texts   Buffer receiving a copy of the text values, since cell text can be transient.
+ *
+ *  @return Sorting keys of the rows, must be deallocated with #array_deallocate.
+ */
+FOUNDATION_STATIC table_sort_key_t* table_sort_extract_keys(table_sorting_context_t& context, table_row_t* rows, uint32_t count, char*& texts)
+{
+    table_sort_key_t* keys = nullptr;
+    array_resize(keys, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        keys[i].row = i;
+        table_sort_extract_key(context, rows[i], keys[i], texts);
+    }
+
+    return keys;
+}
+
+/*! Sorts the keys and writes the sorted #table_sort_key_t::row values in @order.
+ *  This only works on the keys, so it can run in a job.
+ */
+FOUNDATION_STATIC void table_sort_keys(table_sort_key_t* keys, uint32_t count, const char* texts, column_format_t format, bool sort_acsending, uint32_t* order)
+{
+    if (format == COLUMN_FORMAT_BOOLEAN || format_is_numeric(format) || format == COLUMN_FORMAT_DATE)
+    {
+        // Numeric and date columns are sorted with a radix sort on keys mapped to unsigned integers.
+        table_sort_radix_key_t* radix_keys = nullptr;
+        table_sort_radix_key_t* radix_temp = nullptr;
+        array_resize(radix_keys, count);
+        array_resize(radix_temp, count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const table_sort_key_t& k = keys[i];
+            radix_keys[i].row = k.row;
+            if (!k.fetched)
+                radix_keys[i].key = UINT64_MAX;
+            else if (format == COLUMN_FORMAT_DATE)
+                radix_keys[i].key = table_sort_time_radix_key(k.time, sort_acsending);
+            else
+                radix_keys[i].key = table_sort_number_radix_key(k.number, sort_acsending);
+        }
+
+        const table_sort_radix_key_t* sorted_keys = table_sort_radix(radix_keys, radix_temp, count);
+        for (uint32_t i = 0; i < count; ++i)
+            order[i] = sorted_keys[i].row;
+
+        array_deallocate(radix_temp);
+        array_deallocate(radix_keys);
+    }
+    else
+    {
+        array_sort(keys, [texts, sort_acsending](const table_sort_key_t& a, const table_sort_key_t& b)
+        {
+            return table_sort_compare_keys(a, b, texts, sort_acsending);
+        });
+
+        for (uint32_t i = 0; i < count; ++i)
+            order[i] = keys[i].row;
+    }
+}
+
+/*! Permutes the first rows of the table in the given order. */
+FOUNDATION_STATIC void table_sort_permute_rows(table_t* table, const uint32_t* order, uint32_t count)
+{
+    table_row_t* sorted_rows = nullptr;
+    array_resize(sorted_rows, count);
+    for (uint32_t i = 0; i < count; ++i)
+        sorted_rows[i] = table->rows[order[i]];
+    memcpy(table->rows, sorted_rows, sizeof(table_row_t) * count);
+    array_deallocate(sorted_rows);
+}
+
+bool table_default_sorter(table_t* table, table_column_t* sorting_column, int sort_direction)
+{
+    if (table == nullptr || sorting_column == nullptr)
+        return true;
+
+    const uint32_t row_count = (uint32_t)table->rows_visible_count;
+    if (row_count <= 1)
+        return true;
+
+    char* texts = nullptr;
+    table_sorting_context_t sorting_context{ table, sorting_column, sort_direction };
+    sorting_context.search_filter = table->search_filter;
+
+    // Decorate each row with its sorting key so the potentially expensive cells are fetched only once.
+    sorting_column->flags |= COLUMN_SORTING_ELEMENT;
+    table_sort_key_t* keys = table_sort_extract_keys(sorting_context, table->rows, row_count, texts);
+    sorting_column->flags &= ~COLUMN_SORTING_ELEMENT;
+
+    // Undecorate by permuting the visible rows in the sorted order.
+    uint32_t* order = nullptr;
+    array_resize(order, row_count);
+    table_sort_keys(keys, row_count, texts, sorting_column->format, sort_direction == 1, order);
+    table_sort_permute_rows(table, order, row_count);
+
+    array_deallocate(order);
+    array_deallocate(keys);
+    array_deallocate(texts);
+
+    return sorting_context.completly_sorted;
+}
+
+/*! Background sorting job payload, the job works on a copy of the visible rows keys. */
+struct table_async_sort_t
+{
+    uint32_t rows_version{ 0 };
+    table_sort_key_t* keys{ nullptr };
+    const char* texts{ nullptr };
+    column_format_t format{ COLUMN_FORMAT_UNDEFINED };
+    bool ascending{ true };
+    uint32_t* order{ nullptr };
+};
+
+/*! Background sorting state of a table, see #TABLE_BACKGROUND_SORT. */
+struct table_async_t
+{
+    /*! Incremented each time the rows get reordered on the main thread. */
+    uint32_t rows_version{ 0 };
+
+    /*! Sorting keys of each element for #keys_column, indexed like #table_t::elements.
+     *  A key is reused until it is older than #TABLE_CELL_CACHE_MAX_AGE, since cell values can change without the table being invalidated. */
+    const table_column_t* keys_column{ nullptr };
+    uint32_t keys_generation{ 0 };
+    table_element_ptr_const_t keys_elements{ nullptr };
+    int keys_element_count{ -1 };
+    table_sort_key_t* keys{ nullptr };
+    tick_t* key_ticks{ nullptr };
+    char* key_texts{ nullptr };
+
+    job_t* sort_job{ nullptr };
+    table_async_sort_t* sort{ nullptr };
+};
+
+FOUNDATION_FORCEINLINE bool table_async_enabled(const table_t* table)
+{
+    return (table->flags & TABLE_BACKGROUND_SORT) && table->element_count >= TABLE_ASYNC_MIN_ELEMENT_COUNT;
+}
+
+FOUNDATION_FORCEINLINE int table_row_element_index(const table_t* table, const table_row_t& row)
+{
+    return (int)(pointer_diff(row.element, table->elements) / (ptrdiff_t)table->element_size);
+}
+
+/*! Marks the rows as reordered on the main thread, so pending background results get discarded. */
+FOUNDATION_FORCEINLINE void table_rows_reordered(table_t* table)
+{
+    if (table->async)
+        table->async->rows_version++;
+}
+
+/*! Moves the rows of matching elements first, keeping their current order, and updates the visible row count.
+ *  @param matches Match flag of each element, indexed like #table_t::elements.
+ */
+FOUNDATION_STATIC void table_partition_rows(table_t* table, const bool* matches)
+{
+    table_row_t* filtered_rows = nullptr;
+    array_reserve(filtered_rows, table->element_count);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int i = 0; i < table->element_count; ++i)
+        {
+            const table_row_t& row = table->rows[i];
+            if (matches[table_row_element_index(table, row)] == (pass == 0))
+                array_push(filtered_rows, row);
+        }
+
+        if (pass == 0)
+            table->rows_visible_count = array_size(filtered_rows);
+    }
+    memcpy(table->rows, filtered_rows, sizeof(table_row_t) * table->element_count);
+    array_deallocate(filtered_rows);
+}
+
+FOUNDATION_STATIC void table_async_free_sort(table_async_t* async)
+{
+    job_deallocate(async->sort_job);
+    if (async->sort)
+    {
+        array_deallocate(async->sort->keys);
+        array_deallocate(async->sort->order);
+        MEM_DELETE(async->sort);
+    }
+}
+
+FOUNDATION_STATIC void table_async_deallocate(table_t* table)
+{
+    table_async_t* async = table->async;
+    if (async == nullptr)
+        return;
+
+    // The sorting job is using the async state, cancel it and wait for it if it is already running.
+    job_cancel(async->sort_job);
+    job_wait(async->sort_job);
+
+    table_async_free_sort(async);
+    array_deallocate(async->keys);
+    array_deallocate(async->key_ticks);
+    array_deallocate(async->key_texts);
+    MEM_DELETE(table->async);
+}
+
+FOUNDATION_STATIC int table_async_sort_job(payload_t* payload)
+{
+    table_async_sort_t* sort = (table_async_sort_t*)payload;
+    table_sort_keys(sort->keys, array_size(sort->keys), sort->texts, sort->format, sort->ascending, sort->order);
+    return 0;
+}
+
+/*! Applies the last background sorting results if the job completed.
+ *  @return True if a sorting job is still running.
+ */
+FOUNDATION_STATIC bool table_async_poll_sort(table_t* table)
+{
+    table_async_t* async = table->async;
+    if (async == nullptr || async->sort_job == nullptr)
+        return false;
+
+    if (!job_completed(async->sort_job))
+        return true;
+
+    const table_async_sort_t* sort = async->sort;
+    const uint32_t row_count = array_size(sort->order);
+    if (async->sort_job->status == 0 && sort->rows_version == async->rows_version && row_count == (uint32_t)table->rows_visible_count)
+    {
+        table_sort_permute_rows(table, sort->order, row_count);
+        table_rows_reordered(table);
+    }
+    else
+    {
+        // Rows changed while sorting, sort them again.
+        table->needs_sorting = true;
+    }
+
+    table_async_free_sort(async);
+    return false;
+}
+
+FOUNDATION_STATIC bool table_async_sort_rows(table_t* table, table_column_t* sorting_column, int sort_direction)
+{
+    if (table->async == nullptr)
+        table->async = MEM_NEW(0, table_async_t);
+    table_async_t* async = table->async;
+
+    if (async->keys_column != sorting_column || async->keys_generation != table->generation ||
+        async->keys_elements != table->elements || async->keys_element_count != table->element_count)
+    {
+        async->keys_column = sorting_column;
+        async->keys_generation = table->generation;
+        async->keys_elements = table->elements;
+        async->keys_element_count = table->element_count;
+        array_resize(async->keys, table->element_count);
+        array_resize(async->key_ticks, table->element_count);
+        memset(async->key_ticks, 0, sizeof(tick_t) * table->element_count);
+        array_clear(async->key_texts);
+    }
+
+    // Only the keys of visible rows that were never extracted or that are too old get fetched.
+    const tick_t now = time_current();
+    const tick_t max_key_age = (tick_t)(time_ticks_per_second() * TABLE_CELL_CACHE_MAX_AGE);
+    const uint32_t row_count = (uint32_t)table->rows_visible_count;
+    uint32_t stale_count = 0;
+    for (uint32_t i = 0; i < row_count; ++i)
+    {
+        const tick_t key_tick = async->key_ticks[table_row_element_index(table, table->rows[i])];
+        if (key_tick == 0 || now - key_tick > max_key_age)
+            stale_count++;
+    }
+
+    // Drop the previous text values when most keys get fetched again, so the text buffer does not keep growing.
+    if (stale_count * 2 >= row_count)
+    {
+        memset(async->key_ticks, 0, sizeof(tick_t) * table->element_count);
+        array_clear(async->key_texts);
+    }
+
+    table_sorting_context_t sorting_context{ table, sorting_column, sort_direction };
+    sorting_context.search_filter = table->search_filter;
+    if (stale_count > 0)
+    {
+        sorting_column->flags |= COLUMN_SORTING_ELEMENT;
+        for (uint32_t i = 0; i < row_count; ++i)
+        {
+            table_row_t& row = table->rows[i];
+            const int element_index = table_row_element_index(table, row);
+            const tick_t key_tick = async->key_ticks[element_index];
+            if (key_tick != 0 && now - key_tick <= max_key_age)
+                continue;
+
+            table_sort_key_t& key = async->keys[element_index];
+            table_sort_extract_key(sorting_context, row, key, async->key_texts);
+
+            // Keys of rows that could not be fetched yet are extracted again on the next sort.
+            async->key_ticks[element_index] = key.fetched ? now : 0;
+        }
+        sorting_column->flags &= ~COLUMN_SORTING_ELEMENT;
+    }
+
+    table_async_sort_t* sort = MEM_NEW(0, table_async_sort_t);
+    sort->rows_version = async->rows_version;
+    sort->texts = async->key_texts;
+    sort->format = sorting_column->format;
+    sort->ascending = sort_direction == 1;
+    array_resize(sort->keys, row_count);
+    array_resize(sort->order, row_count);
+    for (uint32_t i = 0; i < row_count; ++i)
+    {
+        sort->keys[i] = async->keys[table_row_element_index(table, table->rows[i])];
+        sort->keys[i].row = i;
+    }
+
+    async->sort = sort;
+    async->sort_job = job_execute(table_async_sort_job, sort);
+    return sorting_context.completly_sorted;
+}
+
+/*! Trigram index of the searchable text of each element, built by #table_search_index_build_job. */
+struct table_search_index_data_t
+{
+    uint32_t generation{ 0 };
+    table_element_ptr_const_t elements{ nullptr };
+    int element_count{ -1 };
+
+    /*! Lowercase searchable text of each element, #text_offsets having one more entry than the element count. */
+    char* texts{ nullptr };
+    uint32_t* text_offsets{ nullptr };
+
+    /*! Sorted unique trigrams, the elements containing trigrams[i] are postings[trigram_offsets[i]..trigram_offsets[i+1]]. */
+    uint32_t* trigrams{ nullptr };
+    uint32_t* trigram_offsets{ nullptr };
+    uint32_t* postings{ nullptr };
+};
+
+/*! Search index building job payload, the job works on a copy of the elements. */
+struct table_search_index_build_t
+{
+    table_search_index_data_t* data{ nullptr };
+
+    size_t element_size{ 0 };
+    uint8_t* element_copy{ nullptr };
+    table_search_keywords_handler_t search_keywords;
+
+    /*! Searchable column texts of each element collected on the main thread, nullptr if the table has no searchable columns. */
+    char* column_texts{ nullptr };
+    uint32_t* column_text_offsets{ nullptr };
+
+    volatile bool cancelled{ false };
+};
+
+/*! Search index state of a table, see #TABLE_SEARCH_INDEX. */
+struct table_search_index_t
+{
+    /*! Last built index, nullptr until the first build completes. */
+    table_search_index_data_t* data{ nullptr };
+
+    job_t* build_job{ nullptr };
+    table_search_index_build_t* build{ nullptr };
+
+    bool* matches{ nullptr };
+
+    /*! Lower case search filter, kept to be reused by the next searches. */
+    char* filter{ nullptr };
+};
+
+/*! Unique trigram being indexed, see #table_search_index_build_job. */
+struct table_search_index_trigram_t
+{
+    uint32_t trigram;
+    uint32_t count;
+    uint32_t last_element;
+    uint32_t cursor;
+};
+
+FOUNDATION_FORCEINLINE char table_search_index_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+FOUNDATION_FORCEINLINE uint32_t table_search_index_trigram(const char* s)
+{
+    return ((uint32_t)(uint8_t)s[0] << 16) | ((uint32_t)(uint8_t)s[1] << 8) | (uint32_t)(uint8_t)s[2];
+}
+
+FOUNDATION_STATIC void table_search_index_append_text(table_search_index_data_t* data, const char* str, size_t length)
+{
+    const uint32_t offset = array_size(data->texts);
+    array_resize(data->texts, offset + (uint32_t)length + 1);
+    for (size_t i = 0; i < length; ++i)
+        data->texts[offset + i] = table_search_index_lower(str[i]);
+
+    // Separate values so trigrams do not span over multiple values.
+    data->texts[offset + length] = '\n';
+}
+
+FOUNDATION_STATIC void table_search_index_data_deallocate(table_search_index_data_t*& data)
+{
+    if (data == nullptr)
+        return;
+
+    array_deallocate(data->texts);
+    array_deallocate(data->text_offsets);
+    array_deallocate(data->trigrams);
+    array_deallocate(data->trigram_offsets);
+    array_deallocate(data->postings);
+    MEM_DELETE(data);
+}
+
+FOUNDATION_STATIC void table_search_index_free_build(table_search_index_t* index)
+{
+    job_deallocate(index->build_job);
+    if (index->build)
+    {
+        table_search_index_data_deallocate(index->build->data);
+        memory_deallocate(index->build->element_copy);
+        array_deallocate(index->build->column_texts);
+        array_deallocate(index->build->column_text_offsets);
+        MEM_DELETE(index->build);
+    }
+}
+
+FOUNDATION_STATIC void table_search_index_deallocate(table_t* table)
+{
+    table_search_index_t* index = table->search_index;
+    if (index == nullptr)
+        return;
+
+    // The build job is using the element copy, cancel it and wait for it if it is already running.
+    if (index->build)
+        index->build->cancelled = true;
+    job_cancel(index->build_job);
+    job_wait(index->build_job);
+
+    table_search_index_free_build(index);
+    table_search_index_data_deallocate(index->data);
+    array_deallocate(index->matches);
+    array_deallocate(index->filter);
+    MEM_DELETE(table->search_index);
+}
+
+FOUNDATION_STATIC bool table_search_index_data_is_stale(const table_t* table, const table_search_index_data_t* data)
+{
+    return data == nullptr ||
+        data->generation != table->generation ||
+        data->elements != table->elements ||
+        data->element_count != table->element_count;
+}
+
+FOUNDATION_STATIC bool table_search_index_is_stale(const table_t* table)
+{
+    return table->search_index == nullptr || table_search_index_data_is_stale(table, table->search_index->data);
+}
+
+/*! Returns the slot of a trigram in #trigrams, adding it if needed. 
+ *  The lookup table keys are the trigrams plus one, since zero keys are not supported, and its values are the slots plus one. */
+FOUNDATION_STATIC uint32_t table_search_index_trigram_slot(hashtable32_t*& lookup, table_search_index_trigram_t*& trigrams, uint32_t trigram)
+{
+    const uint32_t slot = hashtable32_get(lookup, trigram + 1);
+    if (slot > 0)
+        return slot - 1;
+
+    // Keep the lookup table half empty so probing stays short.
+    const uint32_t trigram_count = array_size(trigrams);
+    if ((trigram_count + 1) * 2 > (uint32_t)lookup->capacity)
+    {
+        const size_t capacity = lookup->capacity;
+        hashtable32_deallocate(lookup);
+        lookup = hashtable32_allocate(capacity * 2);
+        for (uint32_t i = 0; i < trigram_count; ++i)
+            hashtable32_set(lookup, trigrams[i].trigram + 1, i + 1);
+    }
+
+    hashtable32_set(lookup, trigram + 1, trigram_count + 1);
+    array_push(trigrams, (table_search_index_trigram_t{ trigram, 0, UINT32_MAX, 0 }));
+    return trigram_count;
+}
+
+/*! Collects the searchable text of all elements and indexes all their trigrams. 
+ *
+ *  The postings are built in two passes over the texts, first counting the elements of each unique trigram 
+ *  and then filling them in element order, so no intermediate list of all (trigram, element) pairs is needed.
+ */
+FOUNDATION_STATIC int table_search_index_build_job(payload_t* payload)
+{
+    table_search_index_build_t* build = (table_search_index_build_t*)payload;
+    table_search_index_data_t* data = build->data;
+
+    string_const_t* keywords = nullptr;
+    array_resize(data->text_offsets, data->element_count + 1);
+    for (int e = 0; e < data->element_count && !build->cancelled; ++e)
+    {
+        data->text_offsets[e] = array_size(data->texts);
+
+        if (build->column_texts)
+        {
+            const uint32_t column_text_offset = build->column_text_offsets[e];
+            table_search_index_append_text(data, build->column_texts + column_text_offset, build->column_text_offsets[e + 1] - column_text_offset);
+        }
+
+        if (build->search_keywords)
+        {
+            array_clear(keywords);
+            build->search_keywords(build->element_copy + (size_t)e * build->element_size, keywords);
+            foreach(k, keywords)
+                table_search_index_append_text(data, STRING_ARGS(*k));
+        }
+    }
+    data->text_offsets[data->element_count] = array_size(data->texts);
+    array_deallocate(keywords);
+
+    if (build->cancelled)
+        return -1;
+
+    hashtable32_t* lookup = hashtable32_allocate(4096);
+    table_search_index_trigram_t* trigrams = nullptr;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (uint32_t e = 0; e < (uint32_t)data->element_count && !build->cancelled; ++e)
+        {
+            const char* text = data->texts + data->text_offsets[e];
+            const uint32_t text_length = data->text_offsets[e + 1] - data->text_offsets[e];
+            for (uint32_t i = 0; i + 2 < text_length; ++i)
+            {
+                if (text[i] == '\n' || text[i + 1] == '\n' || text[i + 2] == '\n')
+                    continue;
+
+                const uint32_t slot = table_search_index_trigram_slot(lookup, trigrams, table_search_index_trigram(text + i));
+                table_search_index_trigram_t& t = trigrams[slot];
+                if (t.last_element == e)
+                    continue;
+
+                t.last_element = e;
+                if (pass == 0)
+                    t.count++;
+                else
+                    data->postings[t.cursor++] = e;
+            }
+        }
+
+        if (pass == 0 && !build->cancelled)
+        {
+            // Reserve the postings of each trigram in trigram order.
+            array_sort(trigrams, ARRAY_LESS_BY(trigram));
+
+            uint32_t posting_count = 0;
+            array_resize(data->trigrams, array_size(trigrams));
+            array_resize(data->trigram_offsets, array_size(trigrams) + 1);
+            for (uint32_t i = 0, end = array_size(trigrams); i < end; ++i)
+            {
+                table_search_index_trigram_t& t = trigrams[i];
+                data->trigrams[i] = t.trigram;
+                data->trigram_offsets[i] = posting_count;
+                t.cursor = posting_count;
+                t.last_element = UINT32_MAX;
+                posting_count += t.count;
+
+                hashtable32_set(lookup, t.trigram + 1, i + 1);
+            }
+            data->trigram_offsets[array_size(trigrams)] = posting_count;
+            array_resize(data->postings, posting_count);
+        }
+    }
+
+    hashtable32_deallocate(lookup);
+    array_deallocate(trigrams);
+    return build->cancelled ? -1 : 0;
+}
+
+/*! Starts building the search index of the current elements in a job.
+ *  The searchable column values are fetched right away, since column handlers can only be invoked on the main thread. */
+FOUNDATION_STATIC void table_search_index_start_build(table_t* table, table_search_index_t* index)
+{
+    table_search_index_build_t* build = MEM_NEW(0, table_search_index_build_t);
+    build->data = MEM_NEW(0, table_search_index_data_t);
+    build->data->generation = table->generation;
+    build->data->elements = table->elements;
+    build->data->element_count = table->element_count;
+    build->element_size = table->element_size;
+    build->search_keywords = table->search_keywords;
+    if (table->element_count > 0)
+    {
+        build->element_copy = (uint8_t*)memory_allocate(0, table->element_size * table->element_count, 0, MEMORY_PERSISTENT);
+        memcpy(build->element_copy, table->elements, table->element_size * table->element_count);
+    }
+
+    const int column_count = (int)table_column_count(table);
+    bool has_searchable_columns = false;
+    for (int i = 0, column_slot = 0; i < ARRAY_COUNT(table->columns) && column_slot < column_count; ++i)
+    {
+        const table_column_t& c = table->columns[i];
+        if (!c.used)
+            continue;
+        column_slot++;
+        if (c.flags & COLUMN_SEARCHABLE)
+            has_searchable_columns = true;
+    }
+
+    if (has_searchable_columns)
+    {
+        array_resize(build->column_text_offsets, table->element_count + 1);
+        for (int e = 0; e < table->element_count; ++e)
+        {
+            table_element_ptr_t element = (uint8_t*)table->elements + (size_t)e * table->element_size;
+            build->column_text_offsets[e] = array_size(build->column_texts);
+            for (int i = 0, column_slot = 0; i < ARRAY_COUNT(table->columns) && column_slot < column_count; ++i)
+            {
+                const table_column_t& c = table->columns[i];
+                if (!c.used)
+                    continue;
+
+                column_slot++;
+                if ((c.flags & COLUMN_SEARCHABLE) == 0)
+                    continue;
+
+                const table_cell_t& cell = c.fetch_value(element, &c);
+                string_const_t cs = cell_value_to_string(cell, c);
+                const uint32_t offset = array_size(build->column_texts);
+                array_resize(build->column_texts, offset + (uint32_t)cs.length + 1);
+                if (cs.length)
+                    memcpy(build->column_texts + offset, cs.str, cs.length);
+                build->column_texts[offset + cs.length] = '\n';
+            }
+        }
+        build->column_text_offsets[table->element_count] = array_size(build->column_texts);
+    }
+
+    index->build = build;
+    index->build_job = job_execute(table_search_index_build_job, build);
+}
+
+/*! Publishes the index once its build job completes and starts a new build when the table data changes.
+ *  @return True if the published index matches the current table data.
+ */
+FOUNDATION_STATIC bool table_search_index_update(table_t* table)
+{
+    if (table->search_index == nullptr)
+        table->search_index = MEM_NEW(0, table_search_index_t);
+    table_search_index_t* index = table->search_index;
+
+    if (index->build_job)
+    {
+        if (!job_completed(index->build_job))
+        {
+            // Stop building an index of data that already changed.
+            if (table_search_index_data_is_stale(table, index->build->data))
+            {
+                index->build->cancelled = true;
+                job_cancel(index->build_job);
+            }
+            return !table_search_index_data_is_stale(table, index->data);
+        }
+
+        table_search_index_data_t* data = index->build->data;
+        if (index->build_job->status == 0 && !table_search_index_data_is_stale(table, data))
+        {
+            table_search_index_data_deallocate(index->data);
+            index->data = data;
+            index->build->data = nullptr;
+        }
+
+        table_search_index_free_build(index);
+    }
+
+    if (!table_search_index_data_is_stale(table, index->data))
+        return true;
+
+    table_search_index_start_build(table, index);
+    return false;
+}
+
+/*! Intersects two sorted element lists. */
+FOUNDATION_STATIC uint32_t* table_search_index_intersect(const uint32_t* a, uint32_t a_count, const uint32_t* b, uint32_t b_count, uint32_t* result)
+{
+    array_clear(result);
+    for (uint32_t i = 0, j = 0; i < a_count && j < b_count;)
+    {
+        if (a[i] < b[j])
+            ++i;
+        else if (a[i] > b[j])
+            ++j;
+        else
+        {
+            array_push(result, a[i]);
+            ++i, ++j;
+        }
+    }
+    return result;
+}
+
+/*! Filters the rows using the trigram index, only the elements containing all the filter trigrams get verified. 
+ *  @return False if the index of the current table data is still being built, in which case the rows are left as is.
+ */
+FOUNDATION_STATIC bool table_search_index_filter_rows(table_t* table, hash_t filter_hash)
+{
+    if (table->search_filter.length == 0)
+    {
+        table->rows_visible_count = table->element_count;
+        table->ordered_hash = filter_hash;
+        table->needs_sorting = true;
+        table_rows_reordered(table);
+        return true;
+    }
+
+    if (!table_search_index_update(table))
+        return false;
+
+    table_search_index_t* index = table->search_index;
+    const table_search_index_data_t* data = index->data;
+    table->ordered_hash = filter_hash;
+    table->needs_sorting = true;
+    table_rows_reordered(table);
+
+    const size_t filter_length = table->search_filter.length;
+    array_resize(index->filter, (uint32_t)filter_length);
+    char* filter_buffer = index->filter;
+    for (size_t i = 0; i < filter_length; ++i)
+        filter_buffer[i] = table_search_index_lower(table->search_filter.str[i]);
+
+    array_resize(index->matches, table->element_count);
+    memset(index->matches, 0, sizeof(bool) * table->element_count);
+    const auto verify = [index, data, filter_buffer, filter_length](uint32_t e)
+    {
+        const char* text = data->texts + data->text_offsets[e];
+        const size_t text_length = data->text_offsets[e + 1] - data->text_offsets[e];
+        index->matches[e] = string_find_string(text, text_length, filter_buffer, filter_length, 0) != STRING_NPOS;
+    };
+
+    if (filter_length < 3)
+    {
+        // Too short to use trigrams, scan the texts.
+        for (int e = 0; e < table->element_count; ++e)
+            verify((uint32_t)e);
+    }
+    else
+    {
+        // Intersect the postings of each filter trigram, starting with the current candidates.
+        const uint32_t* candidates = nullptr;
+        uint32_t candidate_count = 0;
+        uint32_t* intersection = nullptr;
+        uint32_t* buffer = nullptr;
+        for (size_t i = 0; i + 2 < filter_length; ++i)
+        {
+            const int t = array_binary_search(data->trigrams, table_search_index_trigram(filter_buffer + i));
+            if (t < 0)
+            {
+                candidate_count = 0;
+                break;
+            }
+
+            const uint32_t* postings = data->postings + data->trigram_offsets[t];
+            const uint32_t posting_count = data->trigram_offsets[t + 1] - data->trigram_offsets[t];
+            if (candidates == nullptr)
+            {
+                candidates = postings;
+                candidate_count = posting_count;
+            }
+            else
+            {
+                buffer = table_search_index_intersect(candidates, candidate_count, postings, posting_count, buffer);
+                std::swap(buffer, intersection);
+                candidates = intersection;
+                candidate_count = array_size(intersection);
+            }
+
+            if (candidate_count == 0)
+                break;
+        }
+
+        for (uint32_t i = 0; i < candidate_count; ++i)
+            verify(candidates[i]);
+
+        array_deallocate(intersection);
+        array_deallocate(buffer);
+    }
+
+    table_partition_rows(table, index->matches);
+    return true;
+}
+
+FOUNDATION_STATIC void table_export_string_value(string_builder_t* sb, const char* str, size_t length)
+{
+    char csv_column_name_buffer[1024];
+    string_t csv_column_name = string_copy(STRING_BUFFER(csv_column_name_buffer), str, length);
+
+    // Escape " into ""
+    csv_column_name = string_replace(STRING_ARGS(csv_column_name), sizeof(csv_column_name_buffer), STRING_CONST("\""), STRING_CONST("\"\""), true);
+
+    // Escape column name if it contains comma
+    if (string_find(csv_column_name.str, csv_column_name.length, ';', 0) != STRING_NPOS || string_find(csv_column_name.str, csv_column_name.length, '\"', 0) != STRING_NPOS)
+    {
+        string_builder_append(sb, '"');
+        string_builder_append(sb, csv_column_name.str, csv_column_name.length);
+        string_builder_append(sb, '"');
+    }
+    else
+        string_builder_append(sb, csv_column_name.str, csv_column_name.length);
+}
+
+/*! Cell value captured for exporting, so it can be formatted outside of the column callbacks. */
+struct table_export_value_t
+{
+    column_format_t format{ COLUMN_FORMAT_UNDEFINED };
+    union {
+        double number;
+        time_t time;
+        string_table_symbol_t symbol;
+        uint32_t text_offset;
+    };
+    uint32_t length{ 0 };
+};
+
+/*! Rows of a table captured for an export, see #table_export_t. */
+struct table_export_chunk_t
+{
+    uint32_t row_count{ 0 };
+
+    /*! Captured values, row major. Text values are copied to #texts since cell text can be transient. */
+    table_export_value_t* values{ nullptr };
+    char* texts{ nullptr };
+};
+
+/*! Table export in progress, see #table_export_csv and #table_export_binary.
+ *
+ *  The cell values of all the rows are captured on the main thread when the export starts, since column callbacks 
+ *  are not thread safe. The export then no longer depends on the table and a job formats and writes the captured chunks.
+ */
+struct table_export_t
+{
+    bool binary{ false };
+    bool failed{ false };
+    string_t path{};
+    string_t table_name{};
+    stream_t* stream{ nullptr };
+    table_export_completed_handler_t completed;
+
+    uint32_t row_count{ 0 };
+    column_format_t* column_formats{ nullptr };
+    table_export_chunk_t** chunks{ nullptr };
+};
+
+FOUNDATION_STATIC void table_export_write(table_export_t* e, const void* data, size_t size)
+{
+    if (size > 0 && stream_write(e->stream, data, size) != size)
+        e->failed = true;
+}
+
+FOUNDATION_STATIC void table_export_append(uint8_t*& data, const void* src, size_t size)
+{
+    const uint32_t offset = array_size(data);
+    array_resize(data, offset + (uint32_t)size);
+    if (size)
+        memcpy(data + offset, src, size);
+}
+
+FOUNDATION_STATIC table_export_value_t table_export_capture_value(const table_cell_t& cell, char*& texts)
+{
+    table_export_value_t value;
+    value.format = cell.format;
+    if (cell.format == COLUMN_FORMAT_TEXT)
+    {
+        // Cell text can be transient, keep a copy of it.
+        value.text_offset = array_size(texts);
+        value.length = (uint32_t)cell.length;
+        array_resize(texts, value.text_offset + value.length);
+        if (cell.length)
+            memcpy(texts + value.text_offset, cell.text, cell.length);
+    }
+    else if (cell.format == COLUMN_FORMAT_DATE)
+        value.time = cell.time;
+    else if (cell.format == COLUMN_FORMAT_SYMBOL)
+        value.symbol = cell.symbol;
+    else
+        value.number = cell.number;
+    return value;
+}
+
+FOUNDATION_STATIC string_const_t table_export_value_text(const table_export_value_t& value, const char* texts)
+{
+    if (value.format == COLUMN_FORMAT_TEXT)
+        return string_const(texts + value.text_offset, value.length);
+    if (value.format == COLUMN_FORMAT_SYMBOL)
+        return SYMBOL_CONST(value.symbol);
+    return string_null();
+}
+
+FOUNDATION_STATIC void table_export_csv_value(string_builder_t* sb, const table_export_value_t& value, column_format_t column_format, const char* texts)
+{
+    if (format_is_numeric(value.format))
+    {
+        double number = value.number;
+        if (column_format == COLUMN_FORMAT_PERCENTAGE)
+            number /= 100.0;
+        char number_buffer[64];
+        string_t nstr = string_from_real(STRING_BUFFER(number_buffer), number, 0, 0, 0);
+        nstr = string_replace(STRING_ARGS(nstr), sizeof(number_buffer), STRING_CONST("."), STRING_CONST(","), true);
+        string_builder_append(sb, STRING_ARGS(nstr));
+    }
+    else if (value.format == COLUMN_FORMAT_BOOLEAN)
+    {
+        string_const_t str = value.number ? CTEXT("1") : CTEXT("0");
+        table_export_string_value(sb, STRING_ARGS(str));
+    }
+    else if (value.format == COLUMN_FORMAT_SYMBOL || value.format == COLUMN_FORMAT_TEXT)
+    {
+        string_const_t str = table_export_value_text(value, texts);
+        table_export_string_value(sb, STRING_ARGS(str));
+    }
+    else if (value.format == COLUMN_FORMAT_DATE)
+    {
+        char date_buffer[64];
+        string_t dstr = string_from_date(STRING_BUFFER(date_buffer), value.time);
+        table_export_string_value(sb, STRING_ARGS(dstr));
+    }
+}
+
+FOUNDATION_STATIC void table_export_chunk_deallocate(table_export_chunk_t*& chunk)
+{
+    array_deallocate(chunk->values);
+    array_deallocate(chunk->texts);
+    MEM_DELETE(chunk);
+}
+
+FOUNDATION_STATIC void table_export_chunks_deallocate(table_export_chunk_t**& chunks)
+{
+    foreach(c, chunks)
+        table_export_chunk_deallocate(*c);
+    array_deallocate(chunks);
+}
+
+/*! Reports the export progress on the main thread. */
+FOUNDATION_STATIC void table_export_progress(uint32_t written_row_count, uint32_t row_count)
+{
+    dispatch([written_row_count, row_count]() { progress_set(written_row_count, row_count); });
+}
+
+/*! Formats a few chunks of rows in parallel and appends them to the csv file in order. */
+FOUNDATION_STATIC void table_export_write_csv_chunks(table_export_t* e)
+{
+    string_builder_t* sbs[TABLE_EXPORT_MAX_PENDING_CHUNKS];
+    const uint32_t column_count = array_size(e->column_formats);
+    const uint32_t chunk_count = array_size(e->chunks);
+    uint32_t written_row_count = 0;
+    for (uint32_t first = 0; first < chunk_count; first += TABLE_EXPORT_MAX_PENDING_CHUNKS)
+    {
+        const uint32_t batch_count = min(chunk_count - first, (uint32_t)TABLE_EXPORT_MAX_PENDING_CHUNKS);
+        job_parallel_for(batch_count, batch_count, [e, first, column_count, &sbs](size_t begin, size_t end, unsigned)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const table_export_chunk_t* chunk = e->chunks[first + i];
+                string_builder_t* sb = string_builder_allocate(chunk->row_count * column_count * 16);
+                for (uint32_t r = 0; r < chunk->row_count; ++r)
+                {
+                    const table_export_value_t* row_values = chunk->values + (size_t)r * column_count;
+                    for (uint32_t c = 0; c < column_count; ++c)
+                    {
+                        if (c > 0)
+                            string_builder_append(sb, ';');
+                        table_export_csv_value(sb, row_values[c], e->column_formats[c], chunk->texts);
+                    }
+
+                    string_builder_append_new_line(sb);
+                }
+                sbs[i] = sb;
+            }
+        });
+
+        for (uint32_t i = 0; i < batch_count; ++i)
+        {
+            string_const_t text = string_builder_text(sbs[i]);
+            table_export_write(e, text.str, text.length);
+            string_builder_deallocate(sbs[i]);
+            written_row_count += e->chunks[first + i]->row_count;
+        }
+
+        table_export_progress(written_row_count, e->row_count);
+    }
+}
+
+/*! Encodes the values of a column contiguously, see #table_export_binary. */
+FOUNDATION_STATIC void table_export_binary_column(const table_export_t* e, uint32_t column_index, uint8_t*& data)
 {
-    table_row_t* ra = (table_row_t*)va;
-    table_row_t* rb = (table_row_t*)vb;
-    table_element_ptr_t a = ra->element;
-    table_element_ptr_t b = rb->element;
+    const uint32_t column_count = array_size(e->column_formats);
+    const column_format_t format = e->column_formats[column_index];
+    const bool is_text = format == COLUMN_FORMAT_TEXT || format == COLUMN_FORMAT_SYMBOL || format == COLUMN_FORMAT_UNDEFINED;
 
-    table_sorting_context_t* context = (table_sorting_context_t*)pcontext;
-    const table_t* table = context->table;
-    const table_column_t* sorting_column = context->sorting_column;
-    const int pdiff = (int)pointer_diff(b, a);
-    const bool sort_acsending = context->sort_direction == 1;
-    if (sorting_column->flags & COLUMN_DYNAMIC_VALUE)
+    uint8_t* texts = nullptr;
+    foreach(chunk_it, e->chunks)
     {
-        if (!ra->fetched && table->update)
+        const table_export_chunk_t* chunk = *chunk_it;
+        for (uint32_t r = 0; r < chunk->row_count; ++r)
         {
-            if (!(ra->fetched = table->update(a)))
+            const table_export_value_t& value = chunk->values[(size_t)r * column_count + column_index];
+            if (is_text)
+            {
+                const uint32_t text_offset = array_size(texts);
+                table_export_append(data, &text_offset, sizeof(text_offset));
+                string_const_t str = table_export_value_text(value, chunk->texts);
+                table_export_append(texts, str.str, str.length);
+            }
+            else if (format == COLUMN_FORMAT_DATE)
             {
-                context->completly_sorted = false;
-                return 1;
+                const int64_t time = value.format == COLUMN_FORMAT_DATE ? (int64_t)value.time : 0;
+                table_export_append(data, &time, sizeof(time));
+            }
+            else
+            {
+                const double number = format_is_numeric(value.format) || value.format == COLUMN_FORMAT_BOOLEAN ? value.number : DNAN;
+                table_export_append(data, &number, sizeof(number));
             }
         }
+    }
+
+    if (is_text)
+    {
+        const uint32_t text_length = array_size(texts);
+        table_export_append(data, &text_length, sizeof(text_length));
+        table_export_append(data, texts, text_length);
+        array_deallocate(texts);
+    }
+}
+
+/*! Encodes the columns in parallel and writes them one after the other. */
+FOUNDATION_STATIC void table_export_write_binary_columns(table_export_t* e)
+{
+    const uint32_t column_count = array_size(e->column_formats);
+    uint8_t** columns_data = (uint8_t**)memory_allocate(0, sizeof(uint8_t*) * max(column_count, 1U), 0, MEMORY_TEMPORARY | MEMORY_ZERO_INITIALIZED);
+    job_parallel_for(column_count, column_count, [e, columns_data](size_t begin, size_t end, unsigned)
+    {
+        for (size_t c = begin; c < end; ++c)
+            table_export_binary_column(e, (uint32_t)c, columns_data[c]);
+    });
+
+    for (uint32_t c = 0; c < column_count; ++c)
+    {
+        table_export_write(e, columns_data[c], array_size(columns_data[c]));
+        array_deallocate(columns_data[c]);
+    }
+
+    memory_deallocate(columns_data);
+    table_export_progress(e->row_count, e->row_count);
+}
 
-        if (!rb->fetched && table->update)
+/*! Reports the completion of the export and releases it, invoked on the main thread once the file is closed. */
+FOUNDATION_STATIC void table_export_finish(table_export_t* e)
+{
+    progress_stop();
+
+    if (!e->failed)
+    {
+        log_infof(0, STRING_CONST("Exported %u rows of %.*s to %.*s"), e->row_count, STRING_FORMAT(e->table_name), STRING_FORMAT(e->path));
+    }
+    else
+    {
+        log_warnf(0, WARNING_INVALID_VALUE, STRING_CONST("Failed to write the export of %.*s to %.*s"), 
+            STRING_FORMAT(e->table_name), STRING_FORMAT(e->path));
+        fs_remove_file(STRING_ARGS(e->path));
+    }
+
+    if (e->completed)
+        e->completed(!e->failed);
+
+    table_export_chunks_deallocate(e->chunks);
+    array_deallocate(e->column_formats);
+    string_deallocate(e->path.str);
+    string_deallocate(e->table_name.str);
+    MEM_DELETE(e);
+}
+
+FOUNDATION_STATIC int table_export_write_job(payload_t* payload)
+{
+    table_export_t* e = (table_export_t*)payload;
+    if (e->binary)
+        table_export_write_binary_columns(e);
+    else
+        table_export_write_csv_chunks(e);
+
+    stream_deallocate(e->stream);
+    dispatch([e]() { table_export_finish(e); });
+    return 0;
+}
+
+/*! Returns the used columns of the table, in order. */
+FOUNDATION_STATIC table_column_t** table_export_columns(table_t* table)
+{
+    table_column_t** columns = nullptr;
+    for (int i = 0; i < ARRAY_COUNT(table->columns); ++i)
+    {
+        if (table->columns[i].used)
+            array_push(columns, table->columns + i);
+    }
+    return columns;
+}
+
+/*! Starts exporting the visible rows of the table, the file header and the cell values are captured right away. */
+FOUNDATION_STATIC bool table_export_start(table_t* table, const char* path, size_t length, bool binary, const table_export_completed_handler_t& completed)
+{
+    stream_t* stream = stream_open(path, length, STREAM_OUT | (binary ? STREAM_BINARY : 0) | STREAM_CREATE | STREAM_TRUNCATE);
+    if (stream == nullptr)
+    {
+        log_errorf(0, ERROR_ACCESS_DENIED, STRING_CONST("Failed to open %.*s to export table %.*s"), (int)length, path, STRING_FORMAT(table->name));
+        return false;
+    }
+
+    table_export_t* e = MEM_NEW(0, table_export_t);
+    e->binary = binary;
+    e->path = string_clone(path, length);
+    e->table_name = string_clone(STRING_ARGS(table->name));
+    e->stream = stream;
+    e->completed = completed;
+    e->row_count = (uint32_t)table->rows_visible_count;
+
+    table_column_t** columns = table_export_columns(table);
+    const uint32_t column_count = array_size(columns);
+    for (uint32_t c = 0; c < column_count; ++c)
+        array_push(e->column_formats, columns[c]->format);
+
+    if (binary)
+    {
+        const uint32_t header[] = { TABLE_EXPORT_BINARY_MAGIC, TABLE_EXPORT_BINARY_VERSION, column_count, e->row_count };
+        table_export_write(e, header, sizeof(header));
+        for (uint32_t c = 0; c < column_count; ++c)
         {
-            if (!(rb->fetched = table->update(b)))
-            {
-                context->completly_sorted = false;
-                return 1;
-            }
+            string_const_t name = SYMBOL_CONST(columns[c]->name);
+            const uint32_t column_header[] = { (uint32_t)columns[c]->format, (uint32_t)name.length };
+            table_export_write(e, column_header, sizeof(column_header));
+            table_export_write(e, name.str, name.length);
         }
     }
-
-    const column_format_t format = sorting_column->format;
-    const table_cell_t& ca = sorting_column->fetch_value(a, sorting_column);
-    const table_cell_t& cb = sorting_column->fetch_value(b, sorting_column);
-
-    if (format == COLUMN_FORMAT_BOOLEAN || format_is_numeric(format) || (format_is_numeric(ca.format) && format_is_numeric(cb.format)))
+    else
     {
-        double sa = ca.number;
-        double sb = cb.number;
-
-        if (math_real_eq(sa, sb, 3))
-            return 0;
-
-        if (math_real_is_nan(sa)) return 1;
-        if (math_real_is_nan(sb)) return -1;
+        string_builder_t* sb = string_builder_allocate();
+        for (uint32_t c = 0; c < column_count; ++c)
+        {
+            if (c > 0)
+                string_builder_append(sb, ';');
 
-        if (sa < sb)
-            return sort_acsending ? -1 : 1;
-        return sort_acsending ? 1 : -1;
+            string_const_t name = SYMBOL_CONST(columns[c]->name);
+            table_export_string_value(sb, STRING_ARGS(name));
+        }
+        string_builder_append_new_line(sb);
+        string_const_t header = string_builder_text(sb);
+        table_export_write(e, header.str, header.length);
+        string_builder_deallocate(sb);
     }
 
-    if (format == COLUMN_FORMAT_DATE || (ca.format == COLUMN_FORMAT_DATE && cb.format == COLUMN_FORMAT_DATE))
+    for (uint32_t first_row = 0; first_row < e->row_count; first_row += TABLE_EXPORT_CHUNK_ROW_COUNT)
     {
-        time_t sa = ca.time;
-        time_t sb = cb.time;
-
-        if (sort_acsending)
+        table_export_chunk_t* chunk = MEM_NEW(0, table_export_chunk_t);
+        chunk->row_count = min(e->row_count - first_row, (uint32_t)TABLE_EXPORT_CHUNK_ROW_COUNT);
+        array_reserve(chunk->values, chunk->row_count * column_count);
+        for (uint32_t r = 0; r < chunk->row_count; ++r)
         {
-            if (sa == 0) sa = INT64_MAX;
-            if (sb == 0) sb = INT64_MAX;
+            table_element_ptr_t element = table->rows[first_row + r].element;
+            for (uint32_t c = 0; c < column_count; ++c)
+            {
+                const table_cell_t& cell = columns[c]->fetch_value.invoke(element, columns[c]);
+                array_push(chunk->values, table_export_capture_value(cell, chunk->texts));
+            }
         }
-
-        return (int)(sa - sb) * (sort_acsending ? 1 : -1);
+        array_push(e->chunks, chunk);
     }
+    array_deallocate(columns);
 
-    if (ca.length == 0 && cb.length > 0)
-        return 1;
-    else if (ca.length > 0 && cb.length == 0)
-        return -1;
-
-    if (ca.text == cb.text || ca.format != COLUMN_FORMAT_TEXT || cb.format != COLUMN_FORMAT_TEXT)
-        return 0;
-
-    return strncmp(ca.text, cb.text, min(ca.length, cb.length)) * (sort_acsending ? 1 : -1);
+    job_execute(table_export_write_job, e, JOB_DEALLOCATE_AFTER_EXECUTION);
+    return true;
 }
 
-bool table_default_sorter(table_t* table, table_column_t* sorting_column, int sort_direction)
+bool table_export_csv(table_t* table, const char* path, size_t length, const table_export_completed_handler_t& completed /*= nullptr*/)
 {
-    if (table == nullptr || sorting_column == nullptr)
-        return true;
-
-    sorting_column->flags |= COLUMN_SORTING_ELEMENT;
-    table_sorting_context_t sorting_context{ table, sorting_column, sort_direction };
-    sorting_context.search_filter = table->search_filter;
-    array_qsort(table->rows, table->rows_visible_count, table_qsort_cells, &sorting_context);
-    sorting_column->flags &= ~COLUMN_SORTING_ELEMENT;
+    return table_export_start(table, path, length, false, completed);
+}
 
-    return sorting_context.completly_sorted;
+bool table_export_binary(table_t* table, const char* path, size_t length, const table_export_completed_handler_t& completed /*= nullptr*/)
+{
+    return table_export_start(table, path, length, true, completed);
 }
 
 table_t* table_allocate(const char* name, table_flags_t flags /*= TABLE_DEFAULT_OPTIONS*/)
@@ -367,12 +1641,25 @@ void table_deallocate(table_t* table)
     {
         memory_deallocate(table->new_row_data);
         string_deallocate(table->name.str);
+        table_async_deallocate(table);
+        table_search_index_deallocate(table);
+        foreach(r, table->rows)
+            array_deallocate(r->cells);
         array_deallocate(table->rows);
+        array_deallocate(table->summary.element_stamps);
+        array_deallocate(table->summary.values);
+        array_deallocate(table->summary.element_fetched);
         table->~table_t();
         memory_deallocate(table);
     }
 }
 
+void table_invalidate(table_t* table)
+{
+    if (table)
+        table->generation++;
+}
+
 size_t table_column_count(table_t* table)
 {
     size_t column_count = 0;
@@ -481,26 +1768,97 @@ FOUNDATION_STATIC void table_render_columns(table_t* table, int column_count)
     ImGui::TableHeadersRow();
 }
 
-FOUNDATION_STATIC bool table_search_row_element(table_t* table, table_element_ptr_t element, string_const_t search_text)
+/*! Returns the key of the element cached cells, see #table_row_t::cells_key. */
+FOUNDATION_STATIC hash_t table_cell_cache_key(const table_t* table, const table_row_t& row)
+{
+    if ((table->flags & TABLE_CACHE_CELLS) == 0)
+        return 0;
+    return hash(row.element, table->element_size);
+}
+
+FOUNDATION_STATIC bool table_cell_cache_find(const table_t* table, const table_row_t& row, hash_t key, int column_slot, tick_t now, table_cell_t& cell, string_const_t& str)
+{
+    if ((table->flags & TABLE_CACHE_CELLS) == 0 || row.cells_key != key || column_slot >= (int)array_size(row.cells))
+        return false;
+
+    const table_cell_cache_entry_t& entry = row.cells[column_slot];
+    if (entry.tick == 0 || entry.generation != table->generation || time_ticks_to_seconds(now - entry.tick) > TABLE_CELL_CACHE_MAX_AGE)
+        return false;
+
+    cell = entry.cell;
+    str = entry.null_string ? string_const_t{ nullptr, 0 } : string_const(entry.text, entry.length);
+    if (cell.format == COLUMN_FORMAT_TEXT && !entry.null_string)
+    {
+        cell.text = entry.text;
+        cell.length = entry.length;
+    }
+
+    return true;
+}
+
+FOUNDATION_STATIC void table_cell_cache_store(
+    const table_t* table, table_row_t& row, hash_t key, const table_column_t& column, 
+    int column_slot, int column_count, tick_t now, const table_cell_t& cell, string_const_t str)
+{
+    if ((table->flags & TABLE_CACHE_CELLS) == 0 || (column.flags & COLUMN_CUSTOM_DRAWING))
+        return;
+
+    // Long strings are not cached, they get fetched each time
+    if (str.length >= sizeof(table_cell_cache_entry_t::text))
+        return;
+
+    if (row.cells_key != key || array_size(row.cells) != (unsigned)column_count)
+    {
+        array_resize(row.cells, column_count);
+        memset((void*)row.cells, 0, sizeof(table_cell_cache_entry_t) * column_count);
+        row.cells_key = key;
+    }
+
+    table_cell_cache_entry_t& entry = row.cells[column_slot];
+    entry.tick = now;
+    entry.generation = table->generation;
+    entry.cell = cell;
+    entry.null_string = str.str == nullptr;
+    entry.length = (uint8_t)str.length;
+    if (str.length)
+        memcpy(entry.text, str.str, str.length);
+    entry.text[str.length] = 0;
+}
+
+FOUNDATION_STATIC bool table_search_row_element(table_t* table, table_row_t& row, string_const_t search_text)
 {
+    table_element_ptr_t element = row.element;
     if (table->search && table->search(element, STRING_ARGS(search_text)))
         return true;
 
     // Filter searchable columns
+    const tick_t now = time_current();
+    const hash_t cells_key = table_cell_cache_key(table, row);
     int column_count = (int)table_column_count(table);
-    for (size_t column_index = 0; column_index < ARRAY_COUNT(table->columns); ++column_index)
+    for (int i = 0, column_slot = 0; i < ARRAY_COUNT(table->columns); ++i)
     {
-        const table_column_t& c = table->columns[column_index];
-        if (column_index == column_count)
+        const table_column_t& c = table->columns[i];
+        if (column_slot == column_count)
             break;
         else if (!c.used)
             continue;
         
+        column_slot++;
         if ((c.flags & COLUMN_SEARCHABLE) == 0)
             continue;
 
-        const table_cell_t& cell = c.fetch_value(element, &c);
-        string_const_t cs = cell_value_to_string(cell, c);
+        table_cell_t cell;
+        string_const_t cs;
+        if (!table_cell_cache_find(table, row, cells_key, column_slot - 1, now, cell, cs))
+        {
+            if ((c.flags & COLUMN_DYNAMIC_VALUE) && !row.fetched && table->update)
+                row.fetched = table->update(element);
+
+            cell = c.fetch_value(element, &c);
+            cs = cell_value_to_string(cell, c);
+            table_cell_cache_store(table, row, cells_key, c, column_slot - 1, column_count, now, cell, cs);
+        }
+
         if (string_contains_nocase(STRING_ARGS(cs), STRING_ARGS(search_text)))
             return true;
     }
@@ -508,10 +1866,22 @@ FOUNDATION_STATIC bool table_search_row_element(table_t* table, table_element_pt
     return false;
 }
 
-FOUNDATION_STATIC void table_render_filter_rows(table_t* table)
+/*! Filters the rows when the search filter changes.
+ *  @return False while the current rows are kept until the search index of the table data is built.
+ */
+FOUNDATION_STATIC bool table_render_filter_rows(table_t* table)
 {
     const size_t search_filter_length = table->search_filter.length;
     hash_t new_ordered_hash = search_filter_length == 0 ? 0 : string_hash(STRING_ARGS(table->search_filter));
+
+    if (table->flags & TABLE_SEARCH_INDEX)
+    {
+        // Filter again when the indexed data changes, the current rows are kept until the new index is built.
+        if (table->ordered_hash != new_ordered_hash || (search_filter_length > 0 && table_search_index_is_stale(table)))
+            return table_search_index_filter_rows(table, new_ordered_hash);
+        return true;
+    }
+
     if (table->ordered_hash != new_ordered_hash)
     {
         table->rows_visible_count = table->element_count;
@@ -519,8 +1889,7 @@ FOUNDATION_STATIC void table_render_filter_rows(table_t* table)
         {
             for (int i = 0; i < table->rows_visible_count; ++i)
             {
-                table_element_ptr_t element = table->rows[i].element;
-                if (!table_search_row_element(table, element, table->search_filter))
+                if (!table_search_row_element(table, table->rows[i], table->search_filter))
                 {
                     const table_row_t b = table->rows[table->rows_visible_count - 1];
                     table->rows[table->rows_visible_count - 1] = table->rows[i];
@@ -531,11 +1900,18 @@ FOUNDATION_STATIC void table_render_filter_rows(table_t* table)
         }
         table->ordered_hash = new_ordered_hash;
         table->needs_sorting = true;
+        table_rows_reordered(table);
     }
+
+    return true;
 }
 
 FOUNDATION_STATIC void table_render_sort_rows(table_t* table)
 {
+    // Keep showing the current rows order until the background sorting completes.
+    if (table_async_poll_sort(table))
+        return;
+
     ImGuiTableSortSpecs* table_specs = ImGui::TableGetSortSpecs();
     if (table->sort && table_specs && (table->needs_sorting || table_specs->SpecsDirty) && table_specs->SpecsCount > 0)
     {
@@ -550,7 +1926,15 @@ FOUNDATION_STATIC void table_render_sort_rows(table_t* table)
         if (sorted_column != nullptr)
         {
             log_debugf(0, STRING_CONST("Sorting column %.*s [dir=%d]"), STRING_FORMAT(sorted_column->get_name()), column_sort_specs->SortDirection);
-            table_specs->SpecsDirty = !table->sort(table, sorted_column, column_sort_specs->SortDirection);
+            if (table_async_enabled(table))
+            {
+                table_specs->SpecsDirty = !table_async_sort_rows(table, sorted_column, column_sort_specs->SortDirection);
+            }
+            else
+            {
+                table_specs->SpecsDirty = !table->sort(table, sorted_column, column_sort_specs->SortDirection);
+                table_rows_reordered(table);
+            }
             table->needs_sorting = false;
             table->last_sort_time = time_current();
         }
@@ -562,6 +1946,8 @@ FOUNDATION_STATIC void table_render_update_ordered_elements(table_t* table, tabl
     if (table->elements != elements || table->element_size != element_size || table->element_count != element_count)
     {
         table_row_t* rows = table->rows;
+        for (unsigned i = element_count, end = array_size(rows); i < end; ++i)
+            array_deallocate(rows[i].cells);
         array_resize(rows, element_count);
         if (rows && element_count > table->element_count)
             memset(rows + table->element_count, 0, (element_count - table->element_count) * sizeof(table_row_t));
@@ -583,68 +1969,194 @@ FOUNDATION_STATIC void table_render_update_ordered_elements(table_t* table, tabl
         table->rows = rows;
         table->rows_visible_count = array_size(rows);
         table->needs_sorting = true;
+        table_rows_reordered(table);
     }
 }
 
-FOUNDATION_STATIC void table_render_summary_row(table_t* table, int column_count)
+FOUNDATION_FORCEINLINE bool table_summary_column_aggregates_values(const table_column_t& column)
 {
-    if ((table->flags & TABLE_SUMMARY) == 0 || table->rows_visible_count <= 1)
-        return;
-    table_cell_t summary_cells[ARRAY_COUNT(table->columns)];
-    memset(summary_cells, 0, sizeof(summary_cells));
+    return column.format == COLUMN_FORMAT_BOOLEAN || format_is_numeric(column.format) || column.format == COLUMN_FORMAT_DATE;
+}
 
-    for (int element_index = 0; element_index < table->rows_visible_count; ++element_index)
+FOUNDATION_STATIC uint64_t table_summary_columns_mask(table_t* table, int column_count)
+{
+    uint64_t mask = 0;
+    for (int i = 1, column_index = 0; i < ARRAY_COUNT(table->columns); ++i)
     {
-        table_row_t& row = table->rows[element_index];
-        table_element_ptr_t element = row.element;
+        const table_column_t& column = table->columns[i];
+        if (column_index == column_count)
+            break;
+        else if (!column.used)
+            continue;
 
-        for (int i = 1, column_index = 0; i < ARRAY_COUNT(table->columns); ++i)
-        {
-            table_column_t& column = table->columns[i];
-            if (column_index == column_count)
-                break;
-            else if (!column.used)
-                continue;
+        column_index++;
+        if (!column.fetch_value || (column.flags & COLUMN_NO_SUMMARY))
+            continue;
 
-            column_index++;
-            if (!column.fetch_value || (column.flags & COLUMN_NO_SUMMARY))
-                continue;
+        const ImGuiTableColumnFlags table_column_flags = ImGui::TableGetColumnFlags(i);
+        if ((table_column_flags & ImGuiTableColumnFlags_IsEnabled) == 0)
+            continue;
+        if ((table_column_flags & ImGuiTableColumnFlags_IsVisible) == 0)
+            continue;
 
-            const ImGuiTableColumnFlags table_column_flags = ImGui::TableGetColumnFlags(i);
-            if ((table_column_flags & ImGuiTableColumnFlags_IsEnabled) == 0)
-                continue;
-            if ((table_column_flags & ImGuiTableColumnFlags_IsVisible) == 0)
-                continue;
+        mask |= 1ULL << i;
+    }
 
-            if ((column.flags & COLUMN_DYNAMIC_VALUE) && !row.fetched && table->update)
-                row.fetched = table->update(element);
+    return mask;
+}
+
+FOUNDATION_STATIC void table_summary_reset(table_t* table, uint64_t columns_mask)
+{
+    table_summary_t& summary = table->summary;
+    summary.generation = table->generation;
+    summary.elements = table->elements;
+    summary.element_count = table->element_count;
+    summary.columns_mask = columns_mask;
+    summary.last_update = time_current();
+    summary.stamp = 1;
+
+    summary.slot_count = 0;
+    for (int i = 0; i < ARRAY_COUNT(table->columns); ++i)
+    {
+        if ((columns_mask & (1ULL << i)) && table_summary_column_aggregates_values(table->columns[i]))
+            summary.slot_count++;
+    }
+
+    array_resize(summary.element_stamps, summary.element_count);
+    array_resize(summary.element_fetched, summary.element_count);
+    array_resize(summary.values, summary.element_count * summary.slot_count);
+    if (summary.element_count > 0)
+    {
+        memset(summary.element_stamps, 0, sizeof(uint32_t) * summary.element_count);
+        memset(summary.element_fetched, 0, sizeof(bool) * summary.element_count);
+    }
+
+    memset(summary.sums, 0, sizeof(summary.sums));
+    memset(summary.counts, 0, sizeof(summary.counts));
+}
+
+FOUNDATION_STATIC void table_summary_fetch_row(table_t* table, table_row_t& row, double* values)
+{
+    const uint64_t columns_mask = table->summary.columns_mask;
+    for (int i = 1, slot = 0; i < ARRAY_COUNT(table->columns); ++i)
+    {
+        table_column_t& column = table->columns[i];
+        if ((columns_mask & (1ULL << i)) == 0 || !table_summary_column_aggregates_values(column))
+            continue;
+
+        if ((column.flags & COLUMN_DYNAMIC_VALUE) && !row.fetched && table->update)
+            row.fetched = table->update(row.element);
+
+        column.flags |= COLUMN_COMPUTE_SUMMARY;
+        const table_cell_t& cell = column.fetch_value(row.element, &column);
+        column.flags &= ~COLUMN_COMPUTE_SUMMARY;
+
+        values[slot++] = column.format == COLUMN_FORMAT_DATE ? (double)cell.time : cell.number;
+    }
+}
+
+FOUNDATION_STATIC void table_summary_accumulate(table_t* table, const double* values, double sign)
+{
+    table_summary_t& summary = table->summary;
+    for (int i = 1, slot = 0; i < ARRAY_COUNT(table->columns); ++i)
+    {
+        const table_column_t& column = table->columns[i];
+        if ((summary.columns_mask & (1ULL << i)) == 0 || !table_summary_column_aggregates_values(column))
+            continue;
+
+        const double value = values[slot++];
+        if (column.format == COLUMN_FORMAT_DATE)
+        {
+            summary.sums[i] += value * sign;
+        }
+        else if (!math_real_is_nan(value))
+        {
+            summary.sums[i] += value * sign;
+            summary.counts[i] += sign > 0 ? 1 : -1;
+        }
+    }
+}
+
+/*! Updates the cached summary aggregates. Element values are only fetched when the table data changed 
+ *  or periodically to catch up with live values, otherwise rows that got filtered in or out since the 
+ *  last frame are added to or removed from the aggregates using their cached values.
+ */
+FOUNDATION_STATIC void table_summary_update(table_t* table, int column_count)
+{
+    if (table->element_size == 0)
+        return;
+
+    table_summary_t& summary = table->summary;
+    const uint64_t columns_mask = table_summary_columns_mask(table, column_count);
+    if (summary.generation != table->generation || 
+        summary.elements != table->elements || summary.element_count != table->element_count ||
+        summary.columns_mask != columns_mask || time_elapsed(summary.last_update) > 1.0)
+    {
+        table_summary_reset(table, columns_mask);
+    }
 
-            column.flags |= COLUMN_COMPUTE_SUMMARY;
-            const table_cell_t& cell = column.fetch_value(element, &column);
-            column.flags &= ~COLUMN_COMPUTE_SUMMARY;
+    const uint32_t previous_stamp = summary.stamp;
+    const uint32_t current_stamp = previous_stamp + 1;
+    for (int r = 0; r < table->rows_visible_count; ++r)
+    {
+        table_row_t& row = table->rows[r];
+        const int element_index = (int)(pointer_diff(row.element, table->elements) / (ptrdiff_t)table->element_size);
+        if (element_index < 0 || element_index >= summary.element_count)
+            continue;
 
-            // Build summary cells
-            table_cell_t& sc = summary_cells[i];
-            sc.format = column.format;
-            switch (sc.format)
+        double* values = summary.values + (size_t)element_index * summary.slot_count;
+        if (summary.element_stamps[element_index] != previous_stamp)
+        {
+            if (!summary.element_fetched[element_index])
             {
-                case COLUMN_FORMAT_CURRENCY:
-                case COLUMN_FORMAT_PERCENTAGE:
-                case COLUMN_FORMAT_NUMBER:
-                case COLUMN_FORMAT_BOOLEAN:
-                    if (!math_real_is_nan(cell.number))
-                    {
-                        sc.number += cell.number;
-                        sc.length++;
-                    }
-                    break;
-                case COLUMN_FORMAT_DATE:
-                    sc.time += cell.time;
-                    break;
-                    
-                default:
-                    break;
+                table_summary_fetch_row(table, row, values);
+                summary.element_fetched[element_index] = true;
             }
+
+            table_summary_accumulate(table, values, 1.0);
+        }
+
+        summary.element_stamps[element_index] = current_stamp;
+    }
+
+    // Remove elements that are not visible anymore
+    for (int element_index = 0; element_index < summary.element_count; ++element_index)
+    {
+        if (summary.element_stamps[element_index] != previous_stamp)
+            continue;
+
+        table_summary_accumulate(table, summary.values + (size_t)element_index * summary.slot_count, -1.0);
+        summary.element_stamps[element_index] = 0;
+    }
+
+    summary.stamp = current_stamp;
+}
+
+FOUNDATION_STATIC void table_render_summary_row(table_t* table, int column_count)
+{
+    if ((table->flags & TABLE_SUMMARY) == 0 || table->rows_visible_count <= 1)
+        return;
+
+    table_summary_update(table, column_count);
+
+    table_cell_t summary_cells[ARRAY_COUNT(table->columns)];
+    memset(summary_cells, 0, sizeof(summary_cells));
+    for (int i = 1; i < ARRAY_COUNT(table->columns); ++i)
+    {
+        if ((table->summary.columns_mask & (1ULL << i)) == 0)
+            continue;
+
+        const table_column_t& column = table->columns[i];
+        table_cell_t& sc = summary_cells[i];
+        sc.format = column.format;
+        if (column.format == COLUMN_FORMAT_DATE)
+        {
+            sc.time = (time_t)table->summary.sums[i];
+        }
+        else if (table_summary_column_aggregates_values(column))
+        {
+            sc.number = table->summary.sums[i];
+            sc.length = table->summary.counts[i];
         }
     }
 
@@ -811,6 +2323,8 @@ FOUNDATION_STATIC void table_render_row_element(table_t* table, int element_inde
     #endif
 
     float max_cell_height = 0;
+    const tick_t now = time_current();
+    const hash_t cells_key = table_cell_cache_key(table, row);
     ImGuiTable* ct = ImGui::GetCurrentTable();
     const size_t max_column_count = sizeof(table->columns) / sizeof(table->columns[0]);
     for (int i = 0, column_index = 0; i < max_column_count; ++i)
@@ -825,16 +2339,23 @@ FOUNDATION_STATIC void table_render_row_element(table_t* table, int element_inde
         if (!ImGui::TableNextColumn())
             continue;
 
-        if ((column.flags & COLUMN_DYNAMIC_VALUE) && !row.fetched && table->update)
-            row.fetched = table->update(element);
-
         char cell_id_buf[64];
         string_t cell_id = string_format(STRING_BUFFER(cell_id_buf), STRING_CONST("cell_%d_%d"), element_index, column_index);
         ImGui::PushID(cell_id.str, cell_id.str + cell_id.length);
 
         ImGui::BeginGroup();
-        table_cell_t cell = column.fetch_value ? column.fetch_value(element, &column) : table_cell_t{};
-        string_const_t str_value = cell_value_to_string(cell, column);
+        table_cell_t cell;
+        string_const_t str_value;
+        if (!table_cell_cache_find(table, row, cells_key, column_index - 1, now, cell, str_value))
+        {
+            if ((column.flags & COLUMN_DYNAMIC_VALUE) && !row.fetched && table->update)
+                row.fetched = table->update(element);
+
+            cell = column.fetch_value ? column.fetch_value(element, &column) : table_cell_t{};
+            str_value = cell_value_to_string(cell, column);
+            if (column.fetch_value)
+                table_cell_cache_store(table, row, cells_key, column, column_index - 1, column_count, now, cell, str_value);
+        }
 
         if (column.format == COLUMN_FORMAT_UNDEFINED)
             column.format = cell.format;
@@ -1119,6 +2640,13 @@ void table_render(table_t* table, table_element_ptr_const_t elements, const int
     // Make top row always visible
     ImGui::TableSetupScrollFreeze(table->column_freeze, 1);
 
+    // Cells can display alternate values while a modifier key is pressed.
+    if ((table->flags & TABLE_CACHE_CELLS) && table->key_mods != (int)io.KeyMods)
+    {
+        table->key_mods = (int)io.KeyMods;
+        table_invalidate(table);
+    }
+
     table_render_update_ordered_elements(table, elements, element_count, element_size);
     table_render_columns(table, column_count);
 
@@ -1195,105 +2723,9 @@ void table_set_search_filter(table_t* table, const char* filter, size_t filter_l
     table->search_filter = { filter, filter_length };
 }
 
-FOUNDATION_STATIC void table_export_string_value(string_builder_t* sb, const char* str, size_t length)
+bool table_update_rows(table_t* table, table_element_ptr_const_t elements, const int element_count, size_t element_size)
 {
-    char csv_column_name_buffer[1024];
-    string_t csv_column_name = string_copy(STRING_BUFFER(csv_column_name_buffer), str, length);
-
-    // Escape " into ""
-    csv_column_name = string_replace(STRING_ARGS(csv_column_name), sizeof(csv_column_name_buffer), STRING_CONST("\""), STRING_CONST("\"\""), true);
-
-    // Escape column name if it contains comma
-    if (string_find(csv_column_name.str, csv_column_name.length, ';', 0) != STRING_NPOS || string_find(csv_column_name.str, csv_column_name.length, '\"', 0) != STRING_NPOS)
-    {
-        string_builder_append(sb, '"');
-        string_builder_append(sb, csv_column_name.str, csv_column_name.length);
-        string_builder_append(sb, '"');
-    }
-    else
-        string_builder_append(sb, csv_column_name.str, csv_column_name.length);
+    table_render_update_ordered_elements(table, elements, element_count, element_size);
+    return table_render_filter_rows(table);
 }
 
-bool table_export_csv(table_t* table, const char* path, size_t length)
-{
-    string_builder_t* sb = string_builder_allocate();
-    
-    // Write header
-    for (int i = 0; i < ARRAY_COUNT(table->columns); ++i)
-    {
-        if (!table->columns[i].used)
-            continue;
-
-        if (i > 0)
-            string_builder_append(sb, ';');
-
-        string_const_t name = SYMBOL_CONST(table->columns[i].name);
-        table_export_string_value(sb, STRING_ARGS(name));
-    }
-
-    string_builder_append_new_line(sb);
-
-    // Write rows
-    for (int i = 0, end = table->rows_visible_count; i < end; ++i)
-    {
-        const table_row_t* row = table->rows + i;
-
-        for (int j = 0; j < ARRAY_COUNT(table->columns); ++j)
-        {
-            if (!table->columns[j].used)
-                continue;
-
-            table_column_t* column = table->columns + j;
-            table_cell_t cell_value = column->fetch_value.invoke(row->element, column);
-
-            if (j > 0)
-                string_builder_append(sb, ';');
-
-            if (cell_format_is_numeric(cell_value))
-            {
-                double value = cell_value.number;
-                if (column->format == COLUMN_FORMAT_PERCENTAGE)
-                    value /= 100.0;
-                char number_buffer[64];
-                string_t nstr = string_from_real(STRING_BUFFER(number_buffer), value, 0, 0, 0);
-                nstr = string_replace(STRING_ARGS(nstr), sizeof(number_buffer), STRING_CONST("."), STRING_CONST(","), true);
-                string_builder_append(sb, STRING_ARGS(nstr));
-            }
-            else if (cell_value.format == COLUMN_FORMAT_BOOLEAN)
-            {
-                string_const_t str = cell_value.number ? CTEXT("1") : CTEXT("0");
-                table_export_string_value(sb, STRING_ARGS(str));
-            }
-            else if (cell_value.format == COLUMN_FORMAT_SYMBOL)
-            {
-                string_const_t str = SYMBOL_CONST(cell_value.symbol);
-                table_export_string_value(sb, STRING_ARGS(str));
-            }
-            else if (cell_value.format == COLUMN_FORMAT_TEXT)
-            {
-                table_export_string_value(sb, STRING_LENGTH(cell_value.text));
-            }
-            else if (cell_value.format == COLUMN_FORMAT_DATE)
-            {
-                char date_buffer[64];
-                string_t dstr = string_from_date(STRING_BUFFER(date_buffer), cell_value.time);
-                table_export_string_value(sb, STRING_ARGS(dstr));
-            }
-        }
-
-        string_builder_append_new_line(sb);
-    }
-
-    // Write to file
-    stream_t* stream = stream_open(path, length, STREAM_OUT | STREAM_CREATE | STREAM_TRUNCATE);
-    if (stream)
-    {
-        string_const_t text = string_builder_text(sb);
-        stream_write_string(stream, STRING_ARGS(text));
-        stream_deallocate(stream);
-    }
-
-    string_builder_deallocate(sb);
-
-    return true;
-}
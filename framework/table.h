@@ -16,6 +16,8 @@
 struct table_row_t;
 struct table_t;
 struct table_column_t;
+struct table_async_t;
+struct table_search_index_t;
 
 /*! Table flags that can define how table are displayed and what behavior they have. */
 typedef enum : size_t {
@@ -34,6 +36,24 @@ typedef enum : size_t {
      *
      *  The #fetch_value cell callback will be called with the column flag #COLUMN_ADD_NEW_ELEMENT */
     TABLE_ADD_NEW_ROW = 1ULL << 35,
+
+    /*! Cache the rendered cell values and their formatted strings per row.
+     *
+     *  Cached cells are fetched again when the element data changes, when #table_invalidate is called, when the keyboard 
+     *  modifiers change or after a short delay, so the table owner should invalidate the table when the data referenced by the elements change. */
+    TABLE_CACHE_CELLS = 1ULL << 36,
+
+    /*! Sort the rows of large tables in a background job, the previous rows order is displayed until it completes.
+     *
+     *  The rows are sorted on the column values, the #table_t::sort handler is not used for large tables. */
+    TABLE_BACKGROUND_SORT = 1ULL << 37,
+
+    /*! Filter rows using a trigram index of the searchable columns and #table_t::search_keywords text.
+     *
+     *  The index is built in a job once per table data generation, see #table_invalidate, and the current rows are displayed until it completes.
+     *  The #table_t::search_keywords handler is invoked from that job on a copy of the elements, so it must only read the element data.
+     *  Rows only match on the indexed text, the #table_t::search handler is not used. */
+    TABLE_SEARCH_INDEX = 1ULL << 38,
 } table_flag_t;
 typedef size_t table_flags_t;
 
@@ -343,6 +363,17 @@ typedef function<bool(table_element_ptr_t element)> table_update_cell_handler_t;
  */
 typedef function<bool(table_element_ptr_const_t element, const char*, size_t)> table_search_handler_t;
 
+/*! Callback invoked from a job to collect the text indexed to search an element, see #TABLE_SEARCH_INDEX.
+ *  @param element  The element being indexed
+ *  @param keywords Array to push the element keywords to, the strings must remain valid until the callback returns.
+ */
+typedef function<void(table_element_ptr_const_t element, string_const_t*& keywords)> table_search_keywords_handler_t;
+
+/*! Callback invoked on the main thread when a table export completes.
+ *  @param success True if all the rows were written, false if writing the file failed.
+ */
+typedef function<void(bool success)> table_export_completed_handler_t;
+
 /*! Callback invoked when the table is being sorted. 
  *  @param table          The table being sorted
  *  @param column         The column being sorted
@@ -446,6 +477,17 @@ struct table_column_t
     }
 };
 
+/*! Cached cell value and its formatted string, see #TABLE_CACHE_CELLS. */
+struct table_cell_cache_entry_t
+{
+    tick_t tick{ 0 };
+    uint32_t generation{ 0 };
+    table_cell_t cell;
+    bool null_string{ false };
+    uint8_t length{ 0 };
+    char text[54];
+};
+
 /*! Row data structure */
 struct table_row_t
 {
@@ -453,11 +495,47 @@ struct table_row_t
     float height { 0 };
     bool fetched{ false };
 
+    /*! Cached cells of the element, one per used column, see #TABLE_CACHE_CELLS. 
+     *  The cells are keyed by a hash of the element data, since the element slot can hold another element 
+     *  once the elements get sorted or replaced in place. */
+    table_cell_cache_entry_t* cells{ nullptr };
+    hash_t cells_key{ 0 };
+
     ImRect rect;
     ImU32 background_color{ 0 };
     bool hovered{ false };
 };
 
+/*! Cached summary row aggregates, maintained incrementally as rows get filtered in and out. */
+struct table_summary_t
+{
+    /*! Table data generation the aggregates were computed for. */
+    uint32_t generation{ 0 };
+
+    /*! Elements the aggregates were computed for. */
+    table_element_ptr_const_t elements{ nullptr };
+    int element_count{ 0 };
+
+    /*! Columns included in the summary, each one having a value slot per element. */
+    uint64_t columns_mask{ 0 };
+    uint32_t slot_count{ 0 };
+
+    /*! Last time the aggregates were fully recomputed. */
+    tick_t last_update{ 0 };
+
+    /*! Per element stamp, equal to #stamp if the element is included in the aggregates. */
+    uint32_t stamp{ 0 };
+    uint32_t* element_stamps{ nullptr };
+
+    /*! Per element cached column values (#slot_count values per element), valid if #element_fetched is set. */
+    double* values{ nullptr };
+    bool* element_fetched{ nullptr };
+
+    /*! Per column aggregates of the included elements. */
+    double sums[64];
+    uint32_t counts[64];
+};
+
 /*! Table data structure */
 struct table_t
 {
@@ -483,6 +561,7 @@ struct table_t
 
     table_search_handler_t search;
     table_search_handler_t filter;
+    table_search_keywords_handler_t search_keywords;
     table_update_cell_handler_t update;
     table_sort_handler_t sort;
     cell_callback_handler_t context_menu;
@@ -492,6 +571,19 @@ struct table_t
 
     void* user_data{ nullptr };
     void* new_row_data{ nullptr };
+
+    /*! Data generation, incremented by #table_invalidate when element values change. */
+    uint32_t generation{ 0 };
+    table_summary_t summary;
+
+    /*! Keyboard modifiers of the last render, cached cells are invalidated when they change. */
+    int key_mods{ 0 };
+
+    /*! Background sorting state, see #TABLE_BACKGROUND_SORT. */
+    table_async_t* async{ nullptr };
+
+    /*! Trigram index of the searchable text and its build job, see #TABLE_SEARCH_INDEX. */
+    table_search_index_t* search_index{ nullptr };
 };
 
 /*! Table sorting context */
@@ -516,6 +608,11 @@ table_t* table_allocate(const char* name, table_flags_t flags = TABLE_DEFAULT_OP
  */
 void table_deallocate(table_t* table);
 
+/*! Marks the table element values as changed, so cached data such as the summary row gets recomputed.
+ *  @param table The table to invalidate
+ */
+void table_invalidate(table_t* table);
+
 /*! Returns the number of columns in the table. 
  *  @param table The table
  *  @return The number of columns
@@ -661,13 +758,43 @@ float table_default_row_height();
  */
 void table_set_search_filter(table_t* table, const char* filter, size_t filter_length);
 
-/*! Export the table content into a csv file. 
+/*! Updates the table rows of the elements and filters them using the search filter, as done when rendering the table.
+ *  @param table            The table
+ *  @param elements         The table elements
+ *  @param element_count    The number of elements
+ *  @param element_size     The size of each element
+ *  @return True if the rows are filtered, false while the #TABLE_SEARCH_INDEX index of the elements is being built.
+ */
+bool table_update_rows(table_t* table, table_element_ptr_const_t elements, const int element_count, size_t element_size);
+
+/*! Export the table content into a csv file in the background.
+ *
+ *  @remark The cell values of the visible rows are fetched on the calling thread when the export starts, 
+ *          since column callbacks are not thread safe. A job then formats chunks of rows in parallel and writes them 
+ *          to the file, so the table can change or be deallocated while the export completes.
+ *
  *  @param table            The table
  *  @param path             The path to the csv file
  *  @param length           The path length
- *  @return true if the file was successfully exported
+ *  @param completed        Invoked on the main thread once the export completes
+ *  @return true if the export started
+ */
+bool table_export_csv(table_t* table, const char* path, size_t length, const table_export_completed_handler_t& completed = nullptr);
+
+/*! Export the table content into a binary columnar file in the background, see #table_export_csv.
+ *
+ *  The file starts with the uint32 values 'WTBL', version, column count and row count,
+ *  followed by each column uint32 format, uint32 name length and name characters.
+ *  Then the values of each column are stored contiguously, as doubles for numeric and boolean columns, 
+ *  as int64 times for date columns, or as row count + 1 uint32 offsets followed by the characters for text columns.
+ *
+ *  @param table            The table
+ *  @param path             The path to the binary file
+ *  @param length           The path length
+ *  @param completed        Invoked on the main thread once the export completes
+ *  @return true if the export started
  */
-bool table_export_csv(table_t* table, const char* path, size_t length);
+bool table_export_binary(table_t* table, const char* path, size_t length, const table_export_completed_handler_t& completed = nullptr);
 
 /*! Provide default table sorting function.
  *
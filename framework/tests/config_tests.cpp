@@ -10,6 +10,7 @@
 #include "test_utils.h"
 
 #include <framework/config.h>
+#include <framework/persistence.h>
 #include <framework/common.h>
 #include <framework/string.h>
 
@@ -199,6 +200,153 @@ TEST_SUITE("Configuration")
         config_deallocate(cv);
     }
 
+    TEST_CASE("Write binary file")
+    {
+        config_handle_t cv = config_allocate(CONFIG_VALUE_OBJECT, CONFIG_OPTION_PRESERVE_INSERTION_ORDER);
+        config_set(cv, "n", 42.0);
+        config_set(cv, "s", STRING_CONST("Hello World!"));
+        config_set(cv, "b", true);
+        config_set(cv, "p", (const void*)0xdeadbeefULL);
+        auto a = config_set_array(cv, STRING_CONST("a"));
+        for (unsigned i = 0; i < 10; ++i)
+            config_array_push(a, (double)i);
+        config_set(config_set_object(cv, STRING_CONST("o")), "name", STRING_CONST("nested"));
+
+        string_t temp_file_path = path_make_temporary(SHARED_BUFFER(BUILD_MAX_PATHLEN));
+        string_const_t temp_file_dir_path = path_directory_name(STRING_ARGS(temp_file_path));
+        CHECK(fs_make_directory(STRING_ARGS(temp_file_dir_path)));
+
+        char binary_file_path_buffer[BUILD_MAX_PATHLEN];
+        string_t binary_file_path = string_format(STRING_BUFFER(binary_file_path_buffer), 
+            STRING_CONST("%.*s." CONFIG_BINARY_FILE_EXTENSION), STRING_FORMAT(temp_file_path));
+        CHECK(config_write_file(STRING_ARGS(binary_file_path), cv));
+
+        config_handle_t loaded = config_parse_file(STRING_ARGS(binary_file_path), CONFIG_OPTION_PRESERVE_INSERTION_ORDER);
+        REQUIRE(config_is_valid(loaded));
+        CHECK_EQ(loaded["n"].as_number(), 42.0);
+        CHECK_EQ(loaded["s"].as_string(), CTEXT("Hello World!"));
+        CHECK_EQ(loaded["b"].as_boolean(), true);
+        CHECK_EQ(loaded["p"].type(), CONFIG_VALUE_NIL);
+        CHECK_EQ(config_size(loaded["a"]), 10);
+        CHECK_EQ(loaded["a"][9].as_number(), 9.0);
+        CHECK_EQ(loaded["o"]["name"].as_string(), CTEXT("nested"));
+
+        // Loaded configs can still be modified.
+        config_set(loaded, "added", STRING_CONST("after load"));
+        CHECK_EQ(loaded["added"].as_string(), CTEXT("after load"));
+
+        // Other extensions are still written as text.
+        config_set_null(cv, "p", 1);
+        CHECK(config_write_file(STRING_ARGS(temp_file_path), cv));
+        string_t text = fs_read_text(STRING_ARGS(temp_file_path));
+        CHECK_FALSE(config_is_binary(STRING_ARGS(text)));
+        CHECK_NE(string_find_string(STRING_ARGS(text), STRING_CONST("Hello World!"), 0), STRING_NPOS);
+
+        // Only the values of a sub-tree are written when serializing a child value.
+        uint8_t* binary = config_binary(cv["o"]);
+        uint32_t value_count = 0;
+        memcpy(&value_count, binary + 12, sizeof(value_count));
+        CHECK_EQ(value_count, 2);
+
+        config_handle_t subtree = config_parse_binary(binary, array_size(binary));
+        REQUIRE(config_is_valid(subtree));
+        CHECK_EQ(subtree["name"].as_string(), CTEXT("nested"));
+        CHECK_EQ(config_size(subtree), 1);
+        config_deallocate(subtree);
+
+        // Only the strings of the sub-tree are written: "", "o", "name" and "nested".
+        CHECK_EQ(array_size(binary), 24 + 2 * 24 + 1 + 2 + 5 + 7);
+
+        // The same content is always written the same way, whatever the config memory.
+        config_handle_t copy = config_allocate();
+        config_set(copy, "unused", STRING_CONST("not written"));
+        config_set(config_set_object(copy, STRING_CONST("o")), "name", STRING_CONST("nested"));
+        uint8_t* copy_binary = config_binary(copy["o"]);
+        REQUIRE_EQ(array_size(copy_binary), array_size(binary));
+        CHECK_EQ(memcmp(copy_binary, binary, array_size(binary)), 0);
+        array_deallocate(copy_binary);
+        config_deallocate(copy);
+
+        // Values referencing themselves or a previous value are rejected.
+        uint16_t value_size = 0;
+        memcpy(&value_size, binary + 6, sizeof(value_size));
+        const config_index_t back_reference = 1;
+        memcpy(binary + 24 + value_size + 12, &back_reference, sizeof(back_reference));
+        CHECK_FALSE(config_is_valid(config_parse_binary(binary, array_size(binary))));
+        array_deallocate(binary);
+
+        fs_remove_file(STRING_ARGS(binary_file_path));
+        fs_remove_file(STRING_ARGS(temp_file_path));
+        string_deallocate(text.str);
+        config_deallocate(loaded);
+        config_deallocate(cv);
+    }
+
+    TEST_CASE("Save files in the background")
+    {
+        config_handle_t cv = config_allocate(CONFIG_VALUE_OBJECT);
+        config_set(cv, "n", 1.0);
+
+        string_t temp_file_path = path_make_temporary(SHARED_BUFFER(BUILD_MAX_PATHLEN));
+        string_const_t temp_file_dir_path = path_directory_name(STRING_ARGS(temp_file_path));
+        CHECK(fs_make_directory(STRING_ARGS(temp_file_dir_path)));
+
+        // Saves are debounced, so only the latest content gets written.
+        const config_option_flags_t flags = CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS | CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL;
+        CHECK(persistence_save(string_to_const(temp_file_path), cv, flags, 60000));
+        config_set(cv, "n", 2.0);
+        CHECK(persistence_save(string_to_const(temp_file_path), cv, flags, 60000));
+
+        // The saved content is a snapshot, later changes are not written.
+        config_set(cv, "n", 3.0);
+        CHECK_EQ(persistence_flush(), 1);
+
+        config_handle_t loaded = config_parse_file(STRING_ARGS(temp_file_path));
+        CHECK_EQ(loaded["n"].as_number(), 2.0);
+        config_deallocate(loaded);
+
+        // Saving the same content again does not rewrite the file.
+        config_set(cv, "n", 2.0);
+        CHECK(persistence_save(string_to_const(temp_file_path), cv, flags, 60000));
+        CHECK_EQ(persistence_flush(), 0);
+
+        fs_remove_file(STRING_ARGS(temp_file_path));
+        config_deallocate(cv);
+    }
+
+    TEST_CASE("Cancel pending saves")
+    {
+        config_handle_t cv = config_allocate(CONFIG_VALUE_OBJECT);
+        config_set(cv, "n", 1.0);
+
+        string_t temp_file_path = path_make_temporary(SHARED_BUFFER(BUILD_MAX_PATHLEN));
+        string_const_t temp_file_dir_path = path_directory_name(STRING_ARGS(temp_file_path));
+        CHECK(fs_make_directory(STRING_ARGS(temp_file_dir_path)));
+
+        const config_option_flags_t flags = CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS | CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL;
+        CHECK(persistence_save(string_to_const(temp_file_path), cv, flags, 60000));
+        CHECK_EQ(persistence_flush(), 1);
+        CHECK(fs_is_file(STRING_ARGS(temp_file_path)));
+
+        // A save requested before the file gets deleted is never written.
+        config_set(cv, "n", 2.0);
+        CHECK(persistence_save(string_to_const(temp_file_path), cv, flags, 60000));
+        CHECK(persistence_cancel(string_to_const(temp_file_path)));
+        fs_remove_file(STRING_ARGS(temp_file_path));
+        CHECK_EQ(persistence_flush(), 0);
+        CHECK_FALSE(fs_is_file(STRING_ARGS(temp_file_path)));
+        CHECK_FALSE(persistence_cancel(string_to_const(temp_file_path)));
+
+        // Saving the content written before the file was deleted writes it again.
+        config_set(cv, "n", 1.0);
+        CHECK(persistence_save(string_to_const(temp_file_path), cv, flags, 60000));
+        CHECK_EQ(persistence_flush(), 1);
+        CHECK(fs_is_file(STRING_ARGS(temp_file_path)));
+
+        fs_remove_file(STRING_ARGS(temp_file_path));
+        config_deallocate(cv);
+    }
+
     TEST_CASE("Indexing")
     {
         // Create config
@@ -556,6 +704,42 @@ TEST_SUITE("Configuration")
         config_deallocate(cv);
     }
 
+    TEST_CASE("Find fields of large objects")
+    {
+        config_handle_t cv = config_allocate(CONFIG_VALUE_OBJECT);
+
+        char key[16];
+        for (int i = 0; i < 200; ++i)
+        {
+            string_t k = string_format(STRING_BUFFER(key), STRING_CONST("field%d"), i);
+            config_set(cv, STRING_ARGS(k), (double)i);
+        }
+
+        CHECK_EQ(config_size(cv), 200);
+        CHECK_EQ(cv["field0"].as_number(), 0);
+        CHECK_EQ(cv["field123"].as_number(), 123);
+        CHECK_EQ(cv["field199"].as_number(), 199);
+        CHECK(config_is_null(cv["field200"]));
+
+        // Fields added after the object got indexed are found.
+        config_set(cv, "field200", 200.0);
+        CHECK_EQ(cv["field200"].as_number(), 200);
+
+        // Removed fields are not found anymore.
+        CHECK(config_remove(cv, STRING_CONST("field123")));
+        CHECK(config_is_null(cv["field123"]));
+        CHECK_EQ(cv["field122"].as_number(), 122);
+
+        // Fields of a reset object are indexed again.
+        config_set(cv, nullptr, 0, 1.0);
+        config_set_object(cv, nullptr, 0);
+        config_set(cv, "field42", 42.0);
+        CHECK_EQ(cv["field42"].as_number(), 42);
+        CHECK(config_is_null(cv["field10"]));
+
+        config_deallocate(cv);
+    }
+
     TEST_CASE("Invalid object")
     {
         config_handle_t cv{};
@@ -990,6 +1174,27 @@ TEST_SUITE("Configuration")
         config_deallocate(cv);
     }
 
+    TEST_CASE("Parse long strings and indentation")
+    {
+        string_const_t sjson = CTEXT(R"({
+                                        // A comment after a long indentation
+                                        "plain key with spaces" = "A plain string longer than sixteen characters"
+                                        escaped = "A string with \"escaped quotes\" and a \\ backslash after many characters\n"
+                                        /* Block comment */ unquoted = "x"
+                                        empty = ""
+                                        literal = """A literal "string" without \ escapes"""
+                                    })");
+        config_handle_t cv = config_parse(STRING_ARGS(sjson));
+
+        CHECK_EQ(cv["plain key with spaces"].as_string(), CTEXT("A plain string longer than sixteen characters"));
+        CHECK_EQ(cv["escaped"].as_string(), CTEXT("A string with \"escaped quotes\" and a \\ backslash after many characters\n"));
+        CHECK_EQ(cv["unquoted"].as_string(), CTEXT("x"));
+        CHECK_EQ(cv["empty"].as_string().length, 0);
+        CHECK_EQ(cv["literal"].as_string(), CTEXT("A literal \"string\" without \\ escapes"));
+
+        config_deallocate(cv);
+    }
+
     TEST_CASE("Parse simple")
     {
         string_const_t sjson = CTEXT(R"({
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2022-2023 - All rights reserved.
+ * License: https://wiimag.com/LICENSE
+ */
+
+#include <foundation/platform.h>
+
+#if BUILD_TESTS
+
+#include "test_utils.h"
+
+#include <framework/console.h>
+#include <framework/session.h>
+#include <framework/common.h>
+
+#include <foundation/fs.h>
+#include <foundation/thread.h>
+
+#include <doctest/doctest.h>
+
+#include <stdio.h>
+
+constexpr unsigned CONSOLE_TEST_THREAD_COUNT = 4;
+constexpr unsigned CONSOLE_TEST_MESSAGE_COUNT = 2048;
+
+FOUNDATION_STATIC string_const_t console_test_log_file_path()
+{
+    return session_get_user_file_path(STRING_CONST("log.txt"));
+}
+
+TEST_SUITE("Console")
+{
+    TEST_CASE("Drain log messages of multiple threads")
+    {
+        console_log_flush();
+        string_const_t log_file_path = console_test_log_file_path();
+        const size_t log_file_offset = fs_size(STRING_ARGS(log_file_path));
+
+        thread_t threads[CONSOLE_TEST_THREAD_COUNT];
+        for (unsigned i = 0; i < ARRAY_COUNT(threads); ++i)
+        {
+            string_const_t thread_name = string_format_static(STRING_CONST("console_test_%u"), i);
+            thread_initialize(&threads[i], [](void* arg)->void*
+            {
+                char msg_buffer[64];
+                const unsigned thread_index = (unsigned)(uintptr_t)arg;
+                for (unsigned m = 0; m < CONSOLE_TEST_MESSAGE_COUNT; ++m)
+                {
+                    string_t msg = string_format(STRING_BUFFER(msg_buffer), STRING_CONST("console test %u %u"), thread_index, m);
+                    console_log(0, ERRORLEVEL_INFO, STRING_ARGS(msg));
+                }
+                return 0;
+            }, (void*)(uintptr_t)i, STRING_ARGS(thread_name), THREAD_PRIORITY_NORMAL, 0);
+        }
+
+        for (unsigned i = 0; i < ARRAY_COUNT(threads); ++i)
+            CHECK(thread_start(&threads[i]));
+
+        for (unsigned i = 0; i < ARRAY_COUNT(threads); ++i)
+        {
+            thread_join(&threads[i]);
+            thread_finalize(&threads[i]);
+        }
+
+        // Nothing drained the messages while the threads were logging, so the ring buffer filled up.
+        const unsigned drained_count = console_log_flush();
+        CHECK_GT(drained_count, 0U);
+        CHECK_LT(drained_count, CONSOLE_TEST_THREAD_COUNT * CONSOLE_TEST_MESSAGE_COUNT);
+
+        string_t text = fs_read_text(STRING_ARGS(log_file_path));
+        size_t offset = min(log_file_offset, text.length);
+
+        unsigned written_count = 0;
+        unsigned dropped_count = 0;
+        int last_message[CONSOLE_TEST_THREAD_COUNT] = { -1, -1, -1, -1 };
+        while (offset < text.length)
+        {
+            const size_t line_end = string_find(STRING_ARGS(text), '\n', offset);
+            const size_t line_length = (line_end == STRING_NPOS ? text.length : line_end) - offset;
+            string_const_t line = string_const(text.str + offset, line_length);
+
+            unsigned thread_index = 0, message_index = 0, dropped = 0;
+            if (sscanf(line.str, "console test %u %u", &thread_index, &message_index) == 2)
+            {
+                // Messages of each thread are written in the order they were logged.
+                REQUIRE_LT(thread_index, CONSOLE_TEST_THREAD_COUNT);
+                CHECK_GT((int)message_index, last_message[thread_index]);
+                last_message[thread_index] = (int)message_index;
+                written_count++;
+            }
+            else if (string_find_string(STRING_ARGS(line), STRING_CONST("log messages dropped"), 0) != STRING_NPOS &&
+                     sscanf(line.str, "%u", &dropped) == 1)
+            {
+                dropped_count += dropped;
+            }
+
+            offset += line_length + 1;
+        }
+
+        CHECK_EQ(written_count, drained_count);
+        CHECK_EQ(written_count + dropped_count, CONSOLE_TEST_THREAD_COUNT * CONSOLE_TEST_MESSAGE_COUNT);
+        string_deallocate(text.str);
+    }
+
+    TEST_CASE("Write errors right away")
+    {
+        console_log_flush();
+        string_const_t log_file_path = console_test_log_file_path();
+        const size_t log_file_offset = fs_size(STRING_ARGS(log_file_path));
+
+        console_log(0, ERRORLEVEL_INFO, STRING_CONST("console test info"));
+        console_log(0, ERRORLEVEL_ERROR, STRING_CONST("console test error"));
+
+        // The error and the messages logged before it are in the log file without draining them.
+        string_t text = fs_read_text(STRING_ARGS(log_file_path));
+        size_t offset = min(log_file_offset, text.length);
+        const size_t info_pos = string_find_string(STRING_ARGS(text), STRING_CONST("console test info"), offset);
+        const size_t error_pos = string_find_string(STRING_ARGS(text), STRING_CONST("console test error"), offset);
+        CHECK_NE(info_pos, STRING_NPOS);
+        CHECK_NE(error_pos, STRING_NPOS);
+        CHECK_LT(info_pos, error_pos);
+        string_deallocate(text.str);
+
+        CHECK_EQ(console_log_flush(), 0U);
+    }
+
+    TEST_CASE("Do not drop errors when the ring buffer is full")
+    {
+        console_log_flush();
+        string_const_t log_file_path = console_test_log_file_path();
+        const size_t log_file_offset = fs_size(STRING_ARGS(log_file_path));
+
+        // Fill the ring buffer with more messages than it can hold.
+        for (unsigned m = 0; m < CONSOLE_TEST_THREAD_COUNT * CONSOLE_TEST_MESSAGE_COUNT; ++m)
+            console_log(0, ERRORLEVEL_INFO, STRING_CONST("console test full"));
+        console_log(0, ERRORLEVEL_ERROR, STRING_CONST("console test error after full"));
+
+        string_t text = fs_read_text(STRING_ARGS(log_file_path));
+        size_t offset = min(log_file_offset, text.length);
+        CHECK_NE(string_find_string(STRING_ARGS(text), STRING_CONST("console test error after full"), offset), STRING_NPOS);
+        string_deallocate(text.str);
+
+        console_log_flush();
+    }
+}
+
+#endif // BUILD_TESTS
@@ -840,6 +840,68 @@ TEST_SUITE("Expressions")
         test_expr("count(ptr_i64(), [1,2,3])", 6);
     }
 
+    TEST_CASE("Arena temporaries")
+    {
+        expr_result_t* list = expr_eval_list_reserve(2);
+        REQUIRE_NE(list, nullptr);
+        CHECK(expr_arena_owns(list));
+        CHECK_EQ(array_size(list), 0);
+        for (int i = 0; i < 20; ++i)
+            expr_eval_list_push(list, expr_result_t((double)i));
+        CHECK_EQ(array_size(list), 20);
+        CHECK_EQ(list[19].as_number(), 19.0);
+
+        string_const_t clone = expr_arena_string_clone(STRING_CONST("arena"));
+        CHECK(expr_arena_owns(clone.str));
+        CHECK(string_equal(STRING_ARGS(clone), STRING_CONST("arena")));
+
+        // Temporaries must remain valid until the next top level evaluation.
+        expr_result_t result = eval("MAP(FILTER(REPEAT($i, 100), $1 > 49), MUL($1, 2))");
+        CHECK(result.is_set());
+        CHECK_EQ(result.element_count(), 50);
+        CHECK_EQ(result.element_at(0).as_number(), 100.0);
+        test_expr("CONCAT([1, 2], [3, 4], [5])", {1, 2, 3, 4, 5});
+        test_expr("LPAD('1', '0', 3)=='001'", true);
+
+        // Each top level evaluation gets a new identifier.
+        const uint64_t evaluation_id = expr_evaluation_id();
+        eval("1+1");
+        CHECK_NE(expr_evaluation_id(), evaluation_id);
+    }
+
+    TEST_CASE("Profiler")
+    {
+        const bool profiling_enabled = expr_profile_enabled();
+        expr_profile_reset();
+        expr_profile_enable(true);
+        test_expr("SUM(MAP([1, 2, 3], ADD($1, 1)))", 9);
+        expr_profile_enable(profiling_enabled);
+
+        expr_profile_entry_t* entries = expr_profile_entries();
+        REQUIRE_NE(entries, nullptr);
+
+        const expr_profile_entry_t* add_entry = nullptr;
+        const expr_profile_entry_t* map_entry = nullptr;
+        for (unsigned i = 0, end = array_size(entries); i < end; ++i)
+        {
+            const expr_profile_entry_t* e = &entries[i];
+            if (string_equal(e->name, string_length(e->name), STRING_CONST("ADD")))
+                add_entry = e;
+            else if (string_equal(e->name, string_length(e->name), STRING_CONST("MAP")))
+                map_entry = e;
+        }
+
+        REQUIRE_NE(add_entry, nullptr);
+        REQUIRE_NE(map_entry, nullptr);
+        CHECK_EQ(add_entry->calls, 3);
+        CHECK_EQ(map_entry->calls, 1);
+        CHECK_GE(map_entry->inclusive, map_entry->exclusive);
+        CHECK_GE(map_entry->inclusive, add_entry->inclusive);
+
+        array_deallocate(entries);
+        expr_profile_reset();
+    }
+
     TEST_CASE("Invalid syntax")
     {
         expr_unregister_function("nop");
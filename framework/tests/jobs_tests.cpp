@@ -0,0 +1,133 @@
+/*
+ * Copyright 2022-2023 - All rights reserved.
+ * License: https://wiimag.com/LICENSE
+ */
+
+#include <foundation/platform.h>
+
+#if BUILD_TESTS
+
+#include "test_utils.h"
+
+#include <framework/jobs.h>
+
+#include <foundation/atomic.h>
+#include <foundation/thread.h>
+
+#include <doctest/doctest.h>
+
+TEST_SUITE("Jobs")
+{
+    TEST_CASE("Parallel For")
+    {
+        const size_t count = 10000;
+        const unsigned chunk_count = job_parallel_thread_count();
+
+        double* sums = nullptr;
+        array_resize(sums, chunk_count);
+        for (unsigned i = 0; i < chunk_count; ++i)
+            sums[i] = 0;
+
+        job_parallel_for(count, chunk_count, [sums](size_t begin, size_t end, unsigned chunk)
+        {
+            for (size_t i = begin; i < end; ++i)
+                sums[chunk] += (double)i;
+        });
+
+        double total = 0;
+        for (unsigned i = 0; i < chunk_count; ++i)
+            total += sums[i];
+        CHECK_EQ(total, (double)(count * (count - 1) / 2));
+
+        array_deallocate(sums);
+    }
+
+    TEST_CASE("Parallel For More Chunks Than Items")
+    {
+        unsigned processed[4]{ 0 };
+        job_parallel_for(2, ARRAY_COUNT(processed), [&processed](size_t begin, size_t end, unsigned chunk)
+        {
+            processed[chunk] = (unsigned)(end - begin);
+        });
+
+        CHECK_EQ(processed[0] + processed[1] + processed[2] + processed[3], 2U);
+    }
+
+    TEST_CASE("Wait For Job")
+    {
+        int value = 0;
+        job_t* job = job_execute([](void* payload)
+        {
+            thread_sleep(10);
+            *(int*)payload = 42;
+            return 0;
+        }, &value);
+
+        job_wait(job);
+        CHECK(job_completed(job));
+        CHECK_EQ(job->status, 0);
+        CHECK_EQ(value, 42);
+
+        // Waiting for a completed job returns right away.
+        job_wait(job);
+        job_deallocate(job);
+    }
+
+    TEST_CASE("Wait And Deallocate Jobs")
+    {
+        // Jobs often complete while the caller starts waiting for them, the job must not be used once job_wait returns.
+        for (int i = 0; i < 2000; ++i)
+        {
+            int value = 0;
+            job_t* job = job_execute([](void* payload)
+            {
+                *(int*)payload = 1;
+                return 0;
+            }, &value);
+
+            if (i % 2)
+                thread_yield();
+
+            job_wait(job);
+            REQUIRE(job_completed(job));
+            REQUIRE_EQ(value, 1);
+            job_deallocate(job);
+            REQUIRE_EQ(job, nullptr);
+        }
+    }
+
+    TEST_CASE("Cancel Job")
+    {
+        atomic32_t calls;
+        atomic_store32(&calls, 0, memory_order_relaxed);
+
+        job_t* jobs[64];
+        for (auto& job : jobs)
+        {
+            job = job_execute([](void* payload)
+            {
+                thread_sleep(1);
+                atomic_incr32((atomic32_t*)payload, memory_order_relaxed);
+                return 0;
+            }, &calls);
+        }
+
+        for (auto& job : jobs)
+            job_cancel(job);
+
+        // Jobs that were not running yet when cancelled are never executed.
+        int cancelled_count = 0;
+        for (auto& job : jobs)
+        {
+            job_wait(job);
+            CHECK(job_completed(job));
+            if (job->status == -1)
+                cancelled_count++;
+            job_deallocate(job);
+        }
+
+        CHECK_EQ(cancelled_count + atomic_load32(&calls, memory_order_relaxed), (int)ARRAY_COUNT(jobs));
+    }
+}
+
+#endif // BUILD_TESTS
@@ -12,6 +12,10 @@
 #include "test_utils.h"
 
 #include <framework/localization.h>
+#include <framework/string.h>
+#include <framework/session.h>
+
+#include <foundation/fs.h>
 
 TEST_SUITE("Localization")
 {
@@ -19,6 +23,45 @@ TEST_SUITE("Localization")
     {
         // TODO: We need to add API to create a new localization DB on the fly.
     }
+
+    #if BUILD_ENABLE_LOCALIZATION
+    TEST_CASE("Compiled dictionary")
+    {
+        char lang_buffer[8];
+        string_const_t lang = localization_current_language();
+        string_t current_lang = string_copy(STRING_BUFFER(lang_buffer), STRING_ARGS(lang));
+
+        // Remove the cached dictionaries, so the first load compiles them and the next one loads them from the cache.
+        localization_set_current_language(STRING_CONST("en"));
+        const char* cached_langs[] = { "fr", "en" };
+        char cache_file_paths[ARRAY_COUNT(cached_langs)][BUILD_MAX_PATHLEN];
+        string_t cache_files[ARRAY_COUNT(cached_langs)];
+        for (int i = 0; i < ARRAY_COUNT(cached_langs); ++i)
+        {
+            string_const_t cache_file_name = string_format_static(STRING_CONST("locales_%s"), cached_langs[i]);
+            cache_files[i] = session_get_user_file_path(STRING_BUFFER(cache_file_paths[i]), 
+                STRING_ARGS(cache_file_name), STRING_CONST("cache"), STRING_CONST("dict"), false);
+            fs_remove_file(STRING_ARGS(cache_files[i]));
+            CHECK_FALSE(fs_is_file(STRING_ARGS(cache_files[i])));
+        }
+
+        for (int i = 0; i < 2; ++i)
+        {
+            localization_set_current_language(STRING_CONST("fr"));
+            CHECK_EQ(tr(STRING_CONST("Open")), CTEXT("Ouvrir"));
+            CHECK_EQ(tr(STRING_CONST("Not translated at all")), CTEXT("Not translated at all"));
+
+            localization_set_current_language(STRING_CONST("en"));
+            CHECK_EQ(tr(STRING_CONST("Open")), CTEXT("Open"));
+
+            // The compiled dictionaries are cached by the first load.
+            for (int c = 0; c < ARRAY_COUNT(cache_files); ++c)
+                CHECK(fs_is_file(STRING_ARGS(cache_files[c])));
+        }
+
+        localization_set_current_language(STRING_ARGS(current_lang));
+    }
+    #endif
 }
 
 #endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2022-2023 - All rights reserved.
+ * License: https://wiimag.com/LICENSE
+ */
+
+#include <foundation/platform.h>
+
+#if BUILD_TESTS && BUILD_ENABLE_PROFILE
+
+#include "test_utils.h"
+
+#include <framework/profiler.h>
+#include <framework/config.h>
+#include <framework/common.h>
+
+#include <foundation/fs.h>
+#include <foundation/path.h>
+
+#include <doctest/doctest.h>
+
+#if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+FOUNDATION_STATIC const profiler_memory_context_t* profiler_test_memory_context(const profiler_memory_context_t* entries, hash_t context)
+{
+    for (unsigned i = 0, end = array_size(entries); i < end; ++i)
+    {
+        if (entries[i].context == context)
+            return &entries[i];
+    }
+
+    return nullptr;
+}
+#endif
+
+TEST_SUITE("Profiler")
+{
+    TEST_CASE("Export trace as Chrome trace JSON")
+    {
+        char trace_file_path_buffer[BUILD_MAX_PATHLEN];
+        string_t trace_file_path = path_make_temporary(STRING_BUFFER(trace_file_path_buffer));
+        string_const_t trace_file_dir_path = path_directory_name(STRING_ARGS(trace_file_path));
+        CHECK(fs_make_directory(STRING_ARGS(trace_file_dir_path)));
+
+        REQUIRE(profiler_trace_start(STRING_ARGS(trace_file_path)));
+        CHECK(profiler_trace_enabled());
+        profiler_trace_begin(STRING_CONST("trace_test_block"));
+        profiler_trace_counter(STRING_CONST("trace_test_counter"), 42.0);
+        profiler_trace_end();
+
+        // Stopping the trace exports the JSON file next to the binary trace file.
+        profiler_trace_stop();
+        CHECK_FALSE(profiler_trace_enabled());
+
+        char json_file_path_buffer[BUILD_MAX_PATHLEN];
+        string_t json_file_path = string_format(STRING_BUFFER(json_file_path_buffer), STRING_CONST("%.*s.json"), STRING_FORMAT(trace_file_path));
+        REQUIRE(fs_is_file(STRING_ARGS(json_file_path)));
+
+        // The export can also be done again from the binary trace file.
+        fs_remove_file(STRING_ARGS(json_file_path));
+        REQUIRE(profiler_trace_export_chrome(STRING_ARGS(trace_file_path), STRING_ARGS(json_file_path)));
+
+        config_handle_t json = config_parse_file(STRING_ARGS(json_file_path));
+        REQUIRE(config_is_valid(json));
+        CHECK_EQ(json["displayTimeUnit"].as_string(), CTEXT("ms"));
+
+        config_handle_t events = json["traceEvents"];
+        REQUIRE_EQ(events.type(), CONFIG_VALUE_ARRAY);
+
+        double begin_ts = -1.0, counter_ts = -1.0, end_ts = -1.0;
+        double begin_tid = 0, end_tid = 0;
+        bool thread_named = false;
+        for (auto e : events)
+        {
+            string_const_t ph = e["ph"].as_string();
+            string_const_t name = e["name"].as_string();
+            if (string_equal(STRING_ARGS(ph), STRING_CONST("M")))
+            {
+                CHECK_EQ(name, CTEXT("thread_name"));
+                thread_named = true;
+            }
+            else if (string_equal(STRING_ARGS(ph), STRING_CONST("B")) && string_equal(STRING_ARGS(name), STRING_CONST("trace_test_block")))
+            {
+                begin_ts = e["ts"].as_number();
+                begin_tid = e["tid"].as_number();
+            }
+            else if (string_equal(STRING_ARGS(ph), STRING_CONST("C")) && string_equal(STRING_ARGS(name), STRING_CONST("trace_test_counter")))
+            {
+                counter_ts = e["ts"].as_number();
+                CHECK_EQ(e["args"]["value"].as_number(), 42.0);
+            }
+            else if (string_equal(STRING_ARGS(ph), STRING_CONST("E")) && begin_ts >= 0 && end_ts < 0 && e["tid"].as_number() == begin_tid)
+            {
+                end_ts = e["ts"].as_number();
+                end_tid = e["tid"].as_number();
+            }
+        }
+
+        // Events of the calling thread are exported in the order they were recorded.
+        CHECK(thread_named);
+        CHECK_GE(begin_ts, 0.0);
+        CHECK_GE(counter_ts, begin_ts);
+        CHECK_GE(end_ts, counter_ts);
+        CHECK_EQ(end_tid, begin_tid);
+
+        config_deallocate(json);
+        fs_remove_file(STRING_ARGS(json_file_path));
+        fs_remove_file(STRING_ARGS(trace_file_path));
+    }
+
+    #if BUILD_ENABLE_MEMORY_TRACKER && BUILD_ENABLE_MEMORY_CONTEXT
+    TEST_CASE("Count allocations per memory context")
+    {
+        // Both contexts start probing the counter slots at the same index.
+        const hash_t context_a = 0x7e57a11000000001ULL;
+        const hash_t context_b = context_a + (1ULL << 32);
+
+        void* a[3];
+        for (unsigned i = 0; i < ARRAY_COUNT(a); ++i)
+            a[i] = memory_allocate(context_a, 64 * (i + 1), 0, MEMORY_PERSISTENT);
+
+        void* b[2];
+        for (unsigned i = 0; i < ARRAY_COUNT(b); ++i)
+            b[i] = memory_allocate(context_b, 1024, 0, MEMORY_PERSISTENT);
+
+        const profiler_memory_context_t* entries = profiler_memory_sample();
+        const profiler_memory_context_t* ca = profiler_test_memory_context(entries, context_a);
+        const profiler_memory_context_t* cb = profiler_test_memory_context(entries, context_b);
+        REQUIRE(ca != nullptr);
+        REQUIRE(cb != nullptr);
+        CHECK_NE(ca, cb);
+
+        CHECK_EQ(ca->allocations, 3);
+        CHECK_EQ(ca->live_allocations, 3);
+        CHECK_EQ(ca->live_bytes, 64 + 128 + 192);
+        CHECK_EQ(ca->largest, 192);
+
+        CHECK_EQ(cb->allocations, 2);
+        CHECK_EQ(cb->live_allocations, 2);
+        CHECK_EQ(cb->live_bytes, 2048);
+        CHECK_EQ(cb->largest, 1024);
+
+        for (unsigned i = 0; i < ARRAY_COUNT(a); ++i)
+            memory_deallocate(a[i]);
+        for (unsigned i = 0; i < ARRAY_COUNT(b); ++i)
+            memory_deallocate(b[i]);
+
+        // Freed memory is no longer live, but it is still part of the sampled peak.
+        ca = profiler_test_memory_context(profiler_memory_sample(), context_a);
+        REQUIRE(ca != nullptr);
+        CHECK_EQ(ca->live_bytes, 0);
+        CHECK_EQ(ca->live_allocations, 0);
+        CHECK_EQ(ca->sampled_peak_bytes, 64 + 128 + 192);
+        CHECK_EQ(ca->allocations, 3);
+    }
+
+    TEST_CASE("Memory growth since snapshot")
+    {
+        const hash_t context = 0x7e57a11000000003ULL;
+        void* before = memory_allocate(context, 256, 0, MEMORY_PERSISTENT);
+        profiler_memory_snapshot();
+
+        void* after[2];
+        after[0] = memory_allocate(context, 1024, 0, MEMORY_PERSISTENT);
+        after[1] = memory_allocate(context, 512, 0, MEMORY_PERSISTENT);
+        memory_deallocate(before);
+
+        const profiler_memory_context_t* entries = profiler_memory_sample();
+        const profiler_memory_context_t* c = profiler_test_memory_context(entries, context);
+        REQUIRE(c != nullptr);
+        CHECK_EQ(c->live_bytes, 1536);
+        CHECK_EQ(c->live_allocations, 2);
+        CHECK_EQ(c->growth_bytes, 1536 - 256);
+        CHECK_EQ(c->growth_allocations, 1);
+
+        // Contexts are sorted by growth once a snapshot is taken.
+        for (unsigned i = 1, end = array_size(entries); i < end; ++i)
+            CHECK_GE(entries[i - 1].growth_bytes, entries[i].growth_bytes);
+
+        // Without a snapshot, growth is the live memory.
+        profiler_memory_clear_snapshot();
+        c = profiler_test_memory_context(profiler_memory_sample(), context);
+        REQUIRE(c != nullptr);
+        CHECK_EQ(c->growth_bytes, 1536);
+        CHECK_EQ(c->growth_allocations, 2);
+
+        memory_deallocate(after[0]);
+        memory_deallocate(after[1]);
+    }
+    #endif
+}
+
+#endif // BUILD_TESTS && BUILD_ENABLE_PROFILE
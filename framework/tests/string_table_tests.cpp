@@ -14,6 +14,8 @@
 #include <framework/config.h>
 #include <framework/common.h>
 #include <framework/string_table.h>
+#include <framework/jobs.h>
+#include <framework/array.h>
 
 TEST_SUITE("StringTable")
 {
@@ -109,6 +111,59 @@ TEST_SUITE("StringTable")
 
         string_table_deallocate(st);
     }
+
+    TEST_CASE("Encode global symbols from multiple threads")
+    {
+        const char* first = SYMBOL_CSTR(string_table_encode(STRING_CONST("Decoded before the table grows")));
+        REQUIRE_NE(first, nullptr);
+
+        const unsigned count = 20000;
+        string_table_symbol_t* symbols = nullptr;
+        array_resize(symbols, count);
+        job_parallel_for(count, job_parallel_thread_count(), [symbols](size_t begin, size_t end, unsigned chunk)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                char buffer[32];
+                string_t s = string_format(STRING_BUFFER(buffer), STRING_CONST("Global %u"), (unsigned)(i % 5000));
+                symbols[i] = string_table_encode(STRING_ARGS(s));
+            }
+        });
+
+        // Strings decoded before the table was grown must still be valid.
+        CHECK_EQ(string_const(first, string_length(first)), CTEXT("Decoded before the table grows"));
+
+        for (unsigned i = 0; i < count; ++i)
+        {
+            char buffer[32];
+            string_t s = string_format(STRING_BUFFER(buffer), STRING_CONST("Global %u"), i % 5000);
+            CHECK_EQ(symbols[i], string_table_encode(STRING_ARGS(s)));
+            CHECK_EQ(SYMBOL_CONST(symbols[i]), string_to_const(s));
+        }
+
+        array_deallocate(symbols);
+    }
+
+    TEST_CASE("Encode global strings larger than a storage chunk")
+    {
+        const size_t length = 150 * 1024;
+        char* large = (char*)memory_allocate(0, length + 1, 0, MEMORY_TEMPORARY);
+        for (size_t i = 0; i < length; ++i)
+            large[i] = 'a' + (i % 26);
+        large[length] = '\0';
+
+        const string_table_symbol_t symbol = string_table_encode(large, length);
+        CHECK_GT(symbol, STRING_TABLE_NULL_SYMBOL);
+        CHECK_EQ(string_table_encode(large, length), symbol);
+        CHECK_EQ(SYMBOL_CONST(symbol), string_const(large, length));
+
+        // Strings added after are still stored in regular chunks.
+        const string_table_symbol_t small = string_table_encode(STRING_CONST("After a large string"));
+        CHECK_EQ(SYMBOL_CONST(small), CTEXT("After a large string"));
+        CHECK_EQ(SYMBOL_CONST(symbol), string_const(large, length));
+
+        memory_deallocate(large);
+    }
 }
 
 #endif // BUILD_TESTS
@@ -0,0 +1,394 @@
+/*
+ * Copyright 2022-2023 - All rights reserved.
+ * License: https://wiimag.com/LICENSE
+ *
+ * Table tests
+ */
+
+#include <foundation/platform.h>
+
+#if BUILD_TESTS
+
+#include "test_utils.h"
+
+#include <framework/table.h>
+#include <framework/array.h>
+
+#include <foundation/fs.h>
+#include <foundation/path.h>
+#include <foundation/stream.h>
+#include <foundation/thread.h>
+
+struct table_test_element_t
+{
+    char name[32];
+    char country[16];
+    double score{ 0 };
+};
+
+FOUNDATION_STATIC table_t* table_test_allocate_indexed_table()
+{
+    table_t* table = table_allocate("Tests", TABLE_SEARCH_INDEX);
+    table->search_keywords = [](table_element_ptr_const_t element, string_const_t*& keywords)
+    {
+        const table_test_element_t* e = (const table_test_element_t*)element;
+        array_push(keywords, string_const(e->name, string_length(e->name)));
+    };
+
+    table_add_column(table, "Country", [](table_element_ptr_t element, const table_column_t* column)
+    {
+        const table_test_element_t* e = (const table_test_element_t*)element;
+        return table_cell_t(e->country);
+    }, COLUMN_FORMAT_TEXT, COLUMN_SEARCHABLE);
+
+    return table;
+}
+
+/*! Filters the table rows, waiting for the search index to be built if needed. */
+FOUNDATION_STATIC bool table_test_filter_rows(table_t* table, const table_test_element_t* elements, int element_count, const char* filter)
+{
+    table_set_search_filter(table, filter, string_length(filter));
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (table_update_rows(table, elements, element_count, sizeof(table_test_element_t)))
+            return true;
+        thread_sleep(1);
+    }
+
+    return false;
+}
+
+/*! Waits for an export to complete, the completion is reported by the dispatcher. */
+FOUNDATION_STATIC bool table_test_wait_export(const bool& completed)
+{
+    for (int i = 0; i < 5000 && !completed; ++i)
+    {
+        dispatcher_update();
+        thread_sleep(1);
+    }
+
+    return completed;
+}
+
+/*! Exports the table and waits for the export to complete. */
+template<typename ExportFunction>
+FOUNDATION_STATIC bool table_test_export(table_t* table, string_const_t path, ExportFunction export_function)
+{
+    bool completed = false, success = false;
+    if (!export_function(table, STRING_ARGS(path), [&completed, &success](bool export_success)
+    {
+        completed = true;
+        success = export_success;
+    }))
+    {
+        return false;
+    }
+
+    return table_test_wait_export(completed) && success;
+}
+
+FOUNDATION_STATIC bool table_test_visible_row(const table_t* table, const char* name)
+{
+    for (int i = 0; i < table->rows_visible_count; ++i)
+    {
+        const table_test_element_t* e = (const table_test_element_t*)table->rows[i].element;
+        if (string_equal(e->name, string_length(e->name), name, string_length(name)))
+            return true;
+    }
+
+    return false;
+}
+
+TEST_SUITE("Table")
+{
+    TEST_CASE("Search Index Hits And Misses")
+    {
+        table_test_element_t elements[] = {
+            { "Apple Inc", "US" },
+            { "Microsoft Corp", "US" },
+            { "Apple Hospitality", "US" },
+            { "Bank of Montreal", "CA" },
+        };
+
+        table_t* table = table_test_allocate_indexed_table();
+
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "APPLE"));
+        CHECK_EQ(table->rows_visible_count, 2);
+        CHECK(table_test_visible_row(table, "Apple Inc"));
+        CHECK(table_test_visible_row(table, "Apple Hospitality"));
+
+        // Filters spanning multiple trigrams must match the whole filter text.
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "apple inc"));
+        CHECK_EQ(table->rows_visible_count, 1);
+        CHECK(table_test_visible_row(table, "Apple Inc"));
+
+        // Searchable column values are indexed too.
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "CA"));
+        CHECK_EQ(table->rows_visible_count, 1);
+        CHECK(table_test_visible_row(table, "Bank of Montreal"));
+
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "xyz"));
+        CHECK_EQ(table->rows_visible_count, 0);
+
+        // Trigrams must not span over multiple values.
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "usapple"));
+        CHECK_EQ(table->rows_visible_count, 0);
+
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), ""));
+        CHECK_EQ(table->rows_visible_count, (int)ARRAY_COUNT(elements));
+
+        table_deallocate(table);
+    }
+
+    TEST_CASE("Search Index Short Filters")
+    {
+        table_test_element_t elements[] = {
+            { "Apple Inc", "US" },
+            { "Microsoft Corp", "US" },
+            { "Apple Hospitality", "US" },
+            { "Bank of Montreal", "CA" },
+        };
+
+        table_t* table = table_test_allocate_indexed_table();
+
+        // Filters shorter than a trigram scan the indexed texts.
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "ap"));
+        CHECK_EQ(table->rows_visible_count, 2);
+
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "o"));
+        CHECK_EQ(table->rows_visible_count, 3);
+        CHECK_FALSE(table_test_visible_row(table, "Apple Inc"));
+
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "z"));
+        CHECK_EQ(table->rows_visible_count, 0);
+
+        table_deallocate(table);
+    }
+
+    TEST_CASE("Search Index Long Filters")
+    {
+        table_test_element_t elements[] = {
+            { "Apple Inc", "US" },
+            { "Bank of Montreal", "CA" },
+        };
+
+        static char long_text[300];
+        memset(long_text, 'a', sizeof(long_text));
+
+        table_t* table = table_allocate("Tests", TABLE_SEARCH_INDEX);
+        table->search_keywords = [](table_element_ptr_const_t element, string_const_t*& keywords)
+        {
+            const table_test_element_t* e = (const table_test_element_t*)element;
+            array_push(keywords, string_const(long_text, sizeof(long_text)));
+            array_push(keywords, string_const(e->name, string_length(e->name)));
+        };
+
+        char filter[sizeof(long_text) + 2];
+        memcpy(filter, long_text, sizeof(long_text));
+        filter[sizeof(long_text)] = 0;
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), filter));
+        CHECK_EQ(table->rows_visible_count, (int)ARRAY_COUNT(elements));
+
+        // The whole filter must match, even past the first hundreds of characters.
+        filter[sizeof(long_text)] = 'b';
+        filter[sizeof(long_text) + 1] = 0;
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), filter));
+        CHECK_EQ(table->rows_visible_count, 0);
+
+        table_deallocate(table);
+    }
+
+    TEST_CASE("Search Index Staleness")
+    {
+        table_test_element_t elements[] = {
+            { "Apple Inc", "US" },
+            { "Microsoft Corp", "US" },
+            { "Bank of Montreal", "CA" },
+        };
+
+        table_t* table = table_test_allocate_indexed_table();
+
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "bank"));
+        CHECK_EQ(table->rows_visible_count, 1);
+
+        // Changed data is only searched once the table is invalidated and the index rebuilt.
+        string_copy(STRING_BUFFER(elements[1].name), STRING_CONST("Microsoft Bank"));
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "bank"));
+        CHECK_EQ(table->rows_visible_count, 1);
+
+        table_invalidate(table);
+
+        // The current rows are kept while the new index gets built.
+        CHECK_FALSE(table_update_rows(table, elements, ARRAY_COUNT(elements), sizeof(table_test_element_t)));
+        CHECK_EQ(table->rows_visible_count, 1);
+
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "bank"));
+        CHECK_EQ(table->rows_visible_count, 2);
+        CHECK(table_test_visible_row(table, "Microsoft Bank"));
+
+        // New elements also get indexed again.
+        table_test_element_t more_elements[] = {
+            { "Bank of Nova Scotia", "CA" },
+        };
+        REQUIRE(table_test_filter_rows(table, more_elements, ARRAY_COUNT(more_elements), "bank"));
+        CHECK_EQ(table->rows_visible_count, 1);
+        CHECK(table_test_visible_row(table, "Bank of Nova Scotia"));
+
+        table_deallocate(table);
+    }
+
+    TEST_CASE("Cached Cells Follow Their Element")
+    {
+        table_test_element_t elements[] = {
+            { "Apple Inc", "US" },
+            { "Bank of Montreal", "CA" },
+        };
+
+        static unsigned update_count = 0, fetch_count = 0;
+        update_count = fetch_count = 0;
+
+        table_t* table = table_allocate("Cache", TABLE_CACHE_CELLS);
+        table->update = [](table_element_ptr_t element)
+        {
+            update_count++;
+            return true;
+        };
+        table_add_column(table, "Name", [](table_element_ptr_t element, const table_column_t* column)
+        {
+            const table_test_element_t* e = (const table_test_element_t*)element;
+            fetch_count++;
+            return table_cell_t(e->name);
+        }, COLUMN_FORMAT_TEXT, COLUMN_SEARCHABLE | COLUMN_DYNAMIC_VALUE);
+
+        // Searching the rows caches their cells and updates the elements first.
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "apple"));
+        CHECK_EQ(table->rows_visible_count, 1);
+        CHECK(table_test_visible_row(table, "Apple Inc"));
+        CHECK_EQ(update_count, (unsigned)ARRAY_COUNT(elements));
+
+        // Elements swapped in place do not reuse the cells cached for the previous element of their slot.
+        const table_test_element_t first = elements[0];
+        elements[0] = elements[1];
+        elements[1] = first;
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "bank"));
+        CHECK_EQ(table->rows_visible_count, 1);
+        CHECK(table_test_visible_row(table, "Bank of Montreal"));
+
+        // Cells of the same elements are reused.
+        fetch_count = 0;
+        REQUIRE(table_test_filter_rows(table, elements, ARRAY_COUNT(elements), "inc"));
+        CHECK_EQ(table->rows_visible_count, 1);
+        CHECK(table_test_visible_row(table, "Apple Inc"));
+        CHECK_EQ(fetch_count, 0U);
+
+        table_deallocate(table);
+    }
+
+    TEST_CASE("Export")
+    {
+        table_test_element_t elements[] = {
+            { "Apple Inc", "US", 1.5 },
+            { "Bank of Montreal", "CA", -2.0 },
+            { "Shopify", "CA", 3.25 },
+        };
+
+        table_t* table = table_allocate("Export");
+        table_add_column(table, "Name", [](table_element_ptr_t element, const table_column_t* column)
+        {
+            const table_test_element_t* e = (const table_test_element_t*)element;
+            return table_cell_t(e->name);
+        }, COLUMN_FORMAT_TEXT);
+        table_add_column(table, "Score", [](table_element_ptr_t element, const table_column_t* column)
+        {
+            const table_test_element_t* e = (const table_test_element_t*)element;
+            return table_cell_t(e->score);
+        }, COLUMN_FORMAT_NUMBER);
+
+        table_set_search_filter(table, nullptr, 0);
+        REQUIRE(table_update_rows(table, elements, ARRAY_COUNT(elements), sizeof(table_test_element_t)));
+
+        char csv_path_buffer[BUILD_MAX_PATHLEN];
+        string_t csv_path = path_make_temporary(STRING_BUFFER(csv_path_buffer));
+        string_const_t temp_dir_path = path_directory_name(STRING_ARGS(csv_path));
+        CHECK(fs_make_directory(STRING_ARGS(temp_dir_path)));
+
+        REQUIRE(table_test_export(table, string_to_const(csv_path), table_export_csv));
+
+        string_t csv = fs_read_text(STRING_ARGS(csv_path));
+        CHECK_EQ(string_to_const(csv), CTEXT("Name;Score\nApple Inc;1,5\nBank of Montreal;-2\nShopify;3,25\n"));
+        string_deallocate(csv.str);
+        fs_remove_file(STRING_ARGS(csv_path));
+
+        char wtbl_path_buffer[BUILD_MAX_PATHLEN];
+        string_t wtbl_path = path_make_temporary(STRING_BUFFER(wtbl_path_buffer));
+        REQUIRE(table_test_export(table, string_to_const(wtbl_path), table_export_binary));
+
+        stream_t* stream = fs_open_file(STRING_ARGS(wtbl_path), STREAM_IN | STREAM_BINARY);
+        REQUIRE(stream);
+
+        uint32_t header[4];
+        REQUIRE_EQ(stream_read(stream, header, sizeof(header)), sizeof(header));
+        CHECK_EQ(header[0], 0x4C425457U);
+        CHECK_EQ(header[1], 1U);
+        CHECK_EQ(header[2], 2U);
+        CHECK_EQ(header[3], (uint32_t)ARRAY_COUNT(elements));
+
+        const char* column_names[] = { "Name", "Score" };
+        const column_format_t column_formats[] = { COLUMN_FORMAT_TEXT, COLUMN_FORMAT_NUMBER };
+        for (int c = 0; c < 2; ++c)
+        {
+            uint32_t column_header[2];
+            char name[16];
+            REQUIRE_EQ(stream_read(stream, column_header, sizeof(column_header)), sizeof(column_header));
+            CHECK_EQ(column_header[0], (uint32_t)column_formats[c]);
+            REQUIRE_EQ(column_header[1], (uint32_t)string_length(column_names[c]));
+            REQUIRE_EQ(stream_read(stream, name, column_header[1]), column_header[1]);
+            CHECK_EQ(string_const(name, column_header[1]), string_const(column_names[c], string_length(column_names[c])));
+        }
+
+        uint32_t text_offsets[ARRAY_COUNT(elements) + 1];
+        REQUIRE_EQ(stream_read(stream, text_offsets, sizeof(text_offsets)), sizeof(text_offsets));
+        char texts[64];
+        const uint32_t text_length = text_offsets[ARRAY_COUNT(elements)];
+        REQUIRE_LT(text_length, sizeof(texts));
+        REQUIRE_EQ(stream_read(stream, texts, text_length), text_length);
+        for (int r = 0; r < ARRAY_COUNT(elements); ++r)
+        {
+            string_const_t name = string_const(texts + text_offsets[r], text_offsets[r + 1] - text_offsets[r]);
+            CHECK_EQ(name, string_const(elements[r].name, string_length(elements[r].name)));
+        }
+
+        double scores[ARRAY_COUNT(elements)];
+        REQUIRE_EQ(stream_read(stream, scores, sizeof(scores)), sizeof(scores));
+        for (int r = 0; r < ARRAY_COUNT(elements); ++r)
+            CHECK_EQ(scores[r], elements[r].score);
+
+        CHECK_EQ(stream_tell(stream), stream_size(stream));
+        stream_deallocate(stream);
+        fs_remove_file(STRING_ARGS(wtbl_path));
+
+        // Cell values are captured when the export starts, so the export completes
+        // even if the table elements change and the table is deallocated right away.
+        table_test_element_t more_elements[] = {
+            { "Bank of Nova Scotia", "CA", 4.0 },
+        };
+        bool completed = false, success = false;
+        REQUIRE(table_export_csv(table, STRING_ARGS(csv_path), [&completed, &success](bool export_success)
+        {
+            completed = true;
+            success = export_success;
+        }));
+        CHECK_FALSE(completed);
+        table_update_rows(table, more_elements, ARRAY_COUNT(more_elements), sizeof(table_test_element_t));
+        table_deallocate(table);
+
+        REQUIRE(table_test_wait_export(completed));
+        CHECK(success);
+        csv = fs_read_text(STRING_ARGS(csv_path));
+        CHECK_EQ(string_to_const(csv), CTEXT("Name;Score\nApple Inc;1,5\nBank of Montreal;-2\nShopify;3,25\n"));
+        string_deallocate(csv.str);
+        fs_remove_file(STRING_ARGS(csv_path));
+    }
+}
+
+#endif // BUILD_TESTS
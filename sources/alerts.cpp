@@ -6,6 +6,7 @@
 #include "alerts.h"
 
 #include "logo.h"
+#include "events.h"
 #include "pattern.h"
 
 #include <framework/app.h>
@@ -13,6 +14,7 @@
 #include <framework/imgui.h>
 #include <framework/array.h>
 #include <framework/config.h>
+#include <framework/persistence.h>
 #include <framework/session.h>
 #include <framework/module.h>
 #include <framework/string_table.h>
@@ -22,6 +24,9 @@
 
 #define HASH_ALERTS static_hash_string("alerts", 5, 0x3a6761b0fb57262bULL)
 
+/*! Time spent evaluating pending alerts per frame, remaining alerts are evaluated over the next frames. */
+constexpr double ALERTS_EVALUATION_BUDGET_MS = 2.0;
+
 constexpr const char* SHOW_ALERTS_KEY = "show_alerts";
 
 /*! Expression evaluator. */
@@ -38,6 +43,13 @@ struct expr_evaluator_t
     bool discarded{ false };
 };
 
+/*! Links a stock symbol to an evaluator that references it. */
+struct alert_symbol_ref_t
+{
+    hash_t   symbol;
+    unsigned index;
+};
+
 static struct ALERTS_MODULE {
     expr_evaluator_t*   evaluators = nullptr;
 
@@ -47,9 +59,29 @@ static struct ALERTS_MODULE {
     tick_t              last_evaluation{ 0 };
     bool                evaluation_disabled{ false };
 
-    unsigned            async_index{ 0 };
+    /*! Evaluators grouped by the stock symbols they reference, sorted by symbol. 
+     *  Evaluators that do not reference any symbol are grouped under symbol 0. */
+    alert_symbol_ref_t* symbol_refs{ nullptr };
+
+    /*! Evaluator indexes sorted by expression hash, to find queued evaluators. */
+    alert_symbol_ref_t* expression_refs{ nullptr };
+    bool                compiled{ false };
+
+    /*! Expression hashes of the evaluators waiting to be evaluated, in the order they were queued.
+     *  Expressions are unique, so queued evaluators remain valid when alerts get added or removed. */
+    hash_t*             pending{ nullptr };
 } *_alerts_module;
 
+FOUNDATION_FORCEINLINE bool operator<(const alert_symbol_ref_t& r, const hash_t& symbol)
+{
+    return r.symbol < symbol;
+}
+
+FOUNDATION_FORCEINLINE bool operator>(const alert_symbol_ref_t& r, const hash_t& symbol)
+{
+    return r.symbol > symbol;
+}
+
 FOUNDATION_STATIC string_const_t alerts_config_file_path()
 {
     return session_get_user_file_path(STRING_CONST("alerts.json"));
@@ -79,29 +111,30 @@ FOUNDATION_STATIC expr_evaluator_t* alerts_load_evaluators(const config_handle_t
 
 FOUNDATION_STATIC void alerts_save_evaluators(const expr_evaluator_t* evaluators)
 {
-    config_write_file(alerts_config_file_path(), [evaluators](config_handle_t evaluators_data)
-    {
-        for (unsigned i = 0; i < array_size(evaluators); ++i)
-        {
-            const expr_evaluator_t& e = evaluators[i];
-
-            config_handle_t ecv = config_array_push(evaluators_data, CONFIG_VALUE_OBJECT);
-            config_set(ecv, "code", e.title, string_length(e.title));
-            config_set(ecv, "label", e.description, string_length(e.description));
-            config_set(ecv, "expression", e.expression, string_length(e.expression));
-            config_set(ecv, "frequency", e.frequency);
-            config_set(ecv, "created", (double)e.creation_date);
-            config_set(ecv, "last_run_time", (double)e.last_run_time);
-            config_set(ecv, "triggered_time", (double)e.triggered_time);
-            config_set(ecv, "discarded", e.discarded);
-        }
-
-        return true;
-    }, CONFIG_VALUE_ARRAY, 
+    const config_option_flags_t options = 
         CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS | 
         CONFIG_OPTION_PRESERVE_INSERTION_ORDER |
         CONFIG_OPTION_WRITE_OBJECT_SAME_LINE_PRIMITIVES | 
-        CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL);
+        CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL;
+
+    config_handle_t evaluators_data = config_allocate(CONFIG_VALUE_ARRAY, options);
+    for (unsigned i = 0; i < array_size(evaluators); ++i)
+    {
+        const expr_evaluator_t& e = evaluators[i];
+
+        config_handle_t ecv = config_array_push(evaluators_data, CONFIG_VALUE_OBJECT);
+        config_set(ecv, "code", e.title, string_length(e.title));
+        config_set(ecv, "label", e.description, string_length(e.description));
+        config_set(ecv, "expression", e.expression, string_length(e.expression));
+        config_set(ecv, "frequency", e.frequency);
+        config_set(ecv, "created", (double)e.creation_date);
+        config_set(ecv, "last_run_time", (double)e.last_run_time);
+        config_set(ecv, "triggered_time", (double)e.triggered_time);
+        config_set(ecv, "discarded", e.discarded);
+    }
+
+    persistence_save(alerts_config_file_path(), evaluators_data, options);
+    config_deallocate(evaluators_data);
 }
 
 FOUNDATION_STATIC bool alerts_check_expression_condition_result(const expr_result_t& result)
@@ -159,56 +192,254 @@ FOUNDATION_STATIC void alerts_push_notification(expr_evaluator_t& e)
         description.length--;
     }
 
-    system_notification_push(STRING_ARGS(title), STRING_ARGS(description));
+    if (main_is_interactive_mode())
+        system_notification_push(STRING_ARGS(title), STRING_ARGS(description));
 }
 
-FOUNDATION_STATIC void alerts_run_evaluators()
+FOUNDATION_STATIC void alerts_invalidate_evaluators()
 {
-    // Skip evaluation if last evaluation occurred less than 5 seconds ago
-    if (_alerts_module->evaluation_disabled || time_elapsed(_alerts_module->last_evaluation) < 5)
-        return;
+    _alerts_module->compiled = false;
+}
+
+FOUNDATION_STATIC void alerts_add_symbol_ref(hash_t symbol, unsigned index)
+{
+    alert_symbol_ref_t ref{ symbol, index };
+    array_push(_alerts_module->symbol_refs, ref);
+}
 
-    expr_evaluator_t* evaluators = _alerts_module->evaluators;
-    for (;_alerts_module->async_index < array_size(evaluators);)
+FOUNDATION_STATIC unsigned alerts_collect_expression_symbols(const expr_t* e, const expr_evaluator_t& ev, unsigned index)
+{
+    unsigned symbol_count = 0;
+
+    // Look for stock symbols accessed with S(<symbol>, <field>, ...)
+    if (e->type == OP_FUNC && e->args.len > 0 && string_equal_nocase(STRING_ARGS(e->param.func.f->name), STRING_CONST("S")))
     {
-        expr_evaluator_t& e = evaluators[_alerts_module->async_index++];
+        const expr_t& arg = e->args.buf[0];
+        string_const_t symbol{};
+        if (arg.type == OP_VAR)
+        {
+            symbol = arg.token;
+            if (string_equal_nocase(STRING_ARGS(symbol), STRING_CONST("$TITLE")))
+                symbol = string_const(ev.title, string_length(ev.title));
+        }
+        else if (arg.type == OP_CONST && arg.param.result.value.type == EXPR_RESULT_SYMBOL)
+        {
+            symbol = arg.param.result.value.as_string();
+        }
 
-        // Check if expression has already triggered
+        if (symbol.length)
+        {
+            alerts_add_symbol_ref(hash(STRING_ARGS(symbol)), index);
+            symbol_count++;
+        }
+    }
+
+    for (int i = 0; i < e->args.len; ++i)
+        symbol_count += alerts_collect_expression_symbols(&e->args.buf[i], ev, index);
+
+    return symbol_count;
+}
+
+/*! Parses all evaluator expressions once to group them by the stock symbols they reference. */
+FOUNDATION_STATIC void alerts_compile_evaluators()
+{
+    array_clear(_alerts_module->symbol_refs);
+    array_clear(_alerts_module->expression_refs);
+
+    for (unsigned i = 0, end = array_size(_alerts_module->evaluators); i < end; ++i)
+    {
+        const expr_evaluator_t& ev = _alerts_module->evaluators[i];
+
+        alert_symbol_ref_t expression_ref{ hash(ev.expression, string_length(ev.expression)), i };
+        array_push(_alerts_module->expression_refs, expression_ref);
+
+        unsigned symbol_count = 0;
+        const size_t title_length = string_length(ev.title);
+        if (title_length > 0)
+        {
+            alerts_add_symbol_ref(hash(ev.title, title_length), i);
+            symbol_count++;
+        }
+
+        expr_t* e = expr_parse(ev.expression, string_length(ev.expression));
+        if (e)
+        {
+            symbol_count += alerts_collect_expression_symbols(e, ev, i);
+            expr_destroy(e);
+        }
+
+        // Evaluators without any symbol are only evaluated based on their frequency.
+        if (symbol_count == 0)
+            alerts_add_symbol_ref(0, i);
+    }
+
+    array_sort(_alerts_module->symbol_refs, [](const alert_symbol_ref_t& a, const alert_symbol_ref_t& b)
+    {
+        if (a.symbol == b.symbol)
+            return (int)a.index - (int)b.index;
+        return a.symbol < b.symbol ? -1 : 1;
+    });
+
+    array_sort(_alerts_module->expression_refs, [](const alert_symbol_ref_t& a, const alert_symbol_ref_t& b)
+    {
+        if (a.symbol == b.symbol)
+            return (int)a.index - (int)b.index;
+        return a.symbol < b.symbol ? -1 : 1;
+    });
+
+    _alerts_module->compiled = true;
+}
+
+/*! Returns the index of the evaluator with the expression hash #key, or -1 if it was removed. */
+FOUNDATION_STATIC int alerts_evaluator_index(hash_t key)
+{
+    if (!_alerts_module->compiled)
+        alerts_compile_evaluators();
+
+    const alert_symbol_ref_t* refs = _alerts_module->expression_refs;
+    const int i = array_binary_search(refs, array_size(refs), key);
+    if (i < 0)
+        return -1;
+    return (int)refs[i].index;
+}
+
+FOUNDATION_STATIC void alerts_queue_evaluator(unsigned index)
+{
+    const expr_evaluator_t& e = _alerts_module->evaluators[index];
+    const hash_t key = hash(e.expression, string_length(e.expression));
+    if (array_contains(_alerts_module->pending, key))
+        return;
+    array_push(_alerts_module->pending, key);
+}
+
+FOUNDATION_STATIC void alerts_queue_symbol(hash_t symbol)
+{
+    if (!_alerts_module->compiled)
+        alerts_compile_evaluators();
+
+    const alert_symbol_ref_t* refs = _alerts_module->symbol_refs;
+    const unsigned ref_count = array_size(refs);
+    int i = array_binary_search(refs, ref_count, symbol);
+    if (i < 0)
+        return;
+
+    // Find the first reference to the symbol
+    while (i > 0 && refs[i - 1].symbol == symbol)
+        --i;
+
+    for (; i < (int)ref_count && refs[i].symbol == symbol; ++i)
+    {
+        const expr_evaluator_t& e = _alerts_module->evaluators[refs[i].index];
         if (e.triggered_time || e.discarded)
             continue;
+        alerts_queue_evaluator(refs[i].index);
+    }
+}
+
+FOUNDATION_STATIC bool alerts_realtime_prices_updated(const dispatcher_event_args_t& args)
+{
+    if (_alerts_module->evaluation_disabled)
+        return false;
+
+    const hash_t* keys = (const hash_t*)args.data;
+    const size_t key_count = args.size / sizeof(hash_t);
+    alerts_queue_symbols(keys, key_count);
+
+    return key_count > 0;
+}
+
+/*! Evaluates an alert expression on the main thread, since expressions can call functions
+ *  that are only safe to use on the main thread (i.e. TABLE, PLOT or report fields).
+ */
+FOUNDATION_STATIC bool alerts_evaluate(const expr_evaluator_t& e)
+{
+    // Set the alert variables (i.e. $TITLE, $DESCRIPTION, etc.)
+    expr_set_global_var(STRING_CONST("$TITLE"), e.title, string_length(e.title));
+    expr_set_global_var(STRING_CONST("$DESCRIPTION"), e.description, string_length(e.description));
 
-        // Check if the expression is due to be evaluated
-        if ((time_now() - e.last_run_time) < e.frequency)
+    log_debugf(HASH_ALERTS, STRING_CONST("Evaluating expression: %s"), e.expression);
+
+    string_const_t expression = string_const(e.expression, string_length(e.expression));
+    expr_result_t result = eval(expression);
+    return alerts_check_expression_condition_result(result);
+}
+
+FOUNDATION_STATIC unsigned alerts_evaluate_pending_evaluators(double time_budget_ms)
+{
+    if (!_alerts_module->compiled)
+        alerts_compile_evaluators();
+
+    unsigned evaluated_count = 0;
+    const tick_t start = time_current();
+    const time_t now = time_now();
+
+    // Evaluate at least one alert per call, so pending alerts always make progress.
+    unsigned i = 0;
+    const unsigned pending_count = array_size(_alerts_module->pending);
+    for (; i < pending_count; ++i)
+    {
+        if (evaluated_count > 0 && time_elapsed(start) * 1000.0 >= time_budget_ms)
+            break;
+
+        // Expressions can modify the alerts, so pending evaluators are looked up each time.
+        const hash_t key = _alerts_module->pending[i];
+        int index = alerts_evaluator_index(key);
+        if (index < 0)
             continue;
 
+        expr_evaluator_t& e = _alerts_module->evaluators[index];
+
         // Mark the expression has being evaluated
-        e.last_run_time = time_now();
-            
-        // Check if the expression is valid
-        const size_t expression_length = string_length(e.expression);
-        if (expression_length == 0)
+        e.last_run_time = now;
+
+        if (e.triggered_time || e.discarded || e.expression[0] == 0)
             continue;
 
-        // Set the alert variables (i.e. $TITLE, $DESCRIPTION, etc.)
-        expr_set_global_var(STRING_CONST("$TITLE"), e.title, string_length(e.title));
-        expr_set_global_var(STRING_CONST("$DESCRIPTION"), e.description, string_length(e.description));
+        evaluated_count++;
+        if (!alerts_evaluate(e))
+            continue;
 
-        log_debugf(HASH_ALERTS, STRING_CONST("Evaluating expression: %s"), e.expression);
+        index = alerts_evaluator_index(key);
+        if (index >= 0)
+            alerts_push_notification(_alerts_module->evaluators[index]);
+    }
+
+    array_erase_ordered_range_safe(_alerts_module->pending, 0, i);
+    return evaluated_count;
+}
 
-        // Evaluate the expression
-        string_const_t expression = string_const(e.expression, expression_length);
-        expr_result_t result = eval(expression);
+FOUNDATION_STATIC void alerts_run_evaluators()
+{
+    if (_alerts_module->evaluation_disabled)
+        return;
 
-        if (alerts_check_expression_condition_result(result))
-            alerts_push_notification(e);
+    if (!_alerts_module->compiled)
+        alerts_compile_evaluators();
+
+    // Queue evaluators that are due based on their frequency, checked once per second.
+    if (time_elapsed(_alerts_module->last_evaluation) >= 1.0)
+    {
+        const time_t now = time_now();
+        expr_evaluator_t* evaluators = _alerts_module->evaluators;
+        for (unsigned i = 0, end = array_size(evaluators); i < end; ++i)
+        {
+            const expr_evaluator_t& e = evaluators[i];
+            if (e.triggered_time || e.discarded)
+                continue;
+
+            if ((now - e.last_run_time) < e.frequency)
+                continue;
+
+            alerts_queue_evaluator(i);
+        }
 
-        // Evaluate one expression per frame
         _alerts_module->last_evaluation = time_current();
-        break;
     }
 
-    if (_alerts_module->async_index >= array_size(evaluators))
-        _alerts_module->async_index = 0;
+    if (array_size(_alerts_module->pending) == 0)
+        return;
+
+    alerts_evaluate_pending_evaluators(ALERTS_EVALUATION_BUDGET_MS);
 }
 
 FOUNDATION_STATIC void alerts_render_table(expr_evaluator_t*& evaluators)
@@ -275,6 +506,7 @@ FOUNDATION_STATIC void alerts_render_table(expr_evaluator_t*& evaluators)
                 {
                     new_entry.creation_date = time_now();
                     array_insert_memcpy_safe(evaluators, 0, &new_entry);
+                    alerts_invalidate_evaluators();
 
                     // Reset static entry
                     memset(&new_entry, 0, sizeof(expr_evaluator_t));
@@ -308,6 +540,8 @@ FOUNDATION_STATIC void alerts_render_table(expr_evaluator_t*& evaluators)
                 ImGui::ExpandNextItem(has_title ? open_button_width : 0.0f, has_title);
                 if (ImGui::InputTextWithHint("##Title", "AAPL.US", STRING_BUFFER(ev.title), ImGuiInputTextFlags_EnterReturnsTrue))
                     evaluate_expression = true;
+                else if (ImGui::IsItemDeactivatedAfterEdit())
+                    alerts_invalidate_evaluators();
 
                 if (has_title)
                 {
@@ -341,6 +575,8 @@ FOUNDATION_STATIC void alerts_render_table(expr_evaluator_t*& evaluators)
                 ImGui::ExpandNextItem();
                 if (ImGui::InputTextWithHint("##Expression", "S(AAPL.US, price)<S(APPL.US, open)", STRING_BUFFER(ev.expression), ImGuiInputTextFlags_EnterReturnsTrue))
                     evaluate_expression = true;
+                else if (ImGui::IsItemDeactivatedAfterEdit())
+                    alerts_invalidate_evaluators();
 
                 ImGui::BeginGroup();
                 if (ev.triggered_time)
@@ -416,6 +652,7 @@ FOUNDATION_STATIC void alerts_render_table(expr_evaluator_t*& evaluators)
                 if (ImGui::Button(ICON_MD_DELETE_FOREVER))
                 {
                     array_erase_ordered(evaluators, i);
+                    alerts_invalidate_evaluators();
                     i--;
                     evaluate_expression = false;
                 }
@@ -432,6 +669,7 @@ FOUNDATION_STATIC void alerts_render_table(expr_evaluator_t*& evaluators)
                 ev.last_run_time = 0;
                 ev.triggered_time = 0;
                 ev.discarded = false;
+                alerts_invalidate_evaluators();
             }
 
             ImGui::PopID();
@@ -482,6 +720,18 @@ FOUNDATION_STATIC int alerts_index_of_expression_starts_with(const char* express
     return -1;
 }
 
+FOUNDATION_STATIC int alerts_index_of_expression(const char* expression, size_t expression_length)
+{
+    for (unsigned i = 0, end = array_size(_alerts_module->evaluators); i < end; ++i)
+    {
+        const expr_evaluator_t* e = _alerts_module->evaluators + i;
+        if (string_equal(e->expression, string_length(e->expression), expression, expression_length))
+            return i;
+    }
+
+    return -1;
+}
+
 //
 // # PUBLIC API
 //
@@ -532,6 +782,7 @@ bool alerts_add_price_change(const char* title, size_t title_length, double pric
     new_alert.creation_date = time_now();
 
     array_insert_memcpy_safe(_alerts_module->evaluators, 0, &new_alert);
+    alerts_invalidate_evaluators();
 
     return true;
 }
@@ -546,6 +797,58 @@ bool alerts_add_price_decrease(const char* title, size_t title_length, double pr
     return alerts_add_price_change(title, title_length, price, ICON_MD_TRENDING_DOWN, "<=");
 }
 
+bool alerts_add(
+    const char* title, size_t title_length, 
+    const char* description, size_t description_length, 
+    const char* expression, size_t expression_length, double frequency)
+{
+    if (expression_length == 0 || alerts_index_of_expression(expression, expression_length) >= 0)
+        return false;
+
+    expr_evaluator_t new_alert{};
+    string_copy(STRING_BUFFER(new_alert.title), title, title_length);
+    string_copy(STRING_BUFFER(new_alert.description), description, description_length);
+    string_copy(STRING_BUFFER(new_alert.expression), expression, expression_length);
+    new_alert.frequency = frequency;
+    new_alert.last_run_time = time_now();
+    new_alert.creation_date = time_now();
+
+    array_push_memcpy(_alerts_module->evaluators, &new_alert);
+    alerts_invalidate_evaluators();
+    return true;
+}
+
+bool alerts_remove(const char* expression, size_t expression_length)
+{
+    const int index = alerts_index_of_expression(expression, expression_length);
+    if (index < 0)
+        return false;
+
+    array_erase_ordered(_alerts_module->evaluators, index);
+    alerts_invalidate_evaluators();
+    return true;
+}
+
+bool alerts_is_triggered(const char* expression, size_t expression_length)
+{
+    const int index = alerts_index_of_expression(expression, expression_length);
+    if (index < 0)
+        return false;
+
+    return _alerts_module->evaluators[index].triggered_time != 0;
+}
+
+void alerts_queue_symbols(const hash_t* symbols, size_t symbol_count)
+{
+    for (size_t i = 0; i < symbol_count; ++i)
+        alerts_queue_symbol(symbols[i]);
+}
+
+unsigned alerts_evaluate_pending(double time_budget_ms)
+{
+    return alerts_evaluate_pending_evaluators(time_budget_ms);
+}
+
 void alerts_notification_menu()
 {
     if (!alerts_has_any_notifications())
@@ -633,6 +936,7 @@ void alerts_notification_menu()
             if (ImGui::SmallButton(ICON_MD_DELETE))
             {
                 array_erase_ordered_safe(_alerts_module->evaluators, i);
+                alerts_invalidate_evaluators();
                 break;
             }
 
@@ -686,6 +990,8 @@ FOUNDATION_STATIC void alerts_initialize()
         config_deallocate(evaluators_data);
     }
 
+    dispatcher_register_event_listener(EVENT_REALTIME_PRICES_UPDATED, alerts_realtime_prices_updated);
+
     module_register_update(HASH_ALERTS, alerts_run_evaluators);
     module_register_window(HASH_ALERTS, alerts_render_evaluators);
 
@@ -701,6 +1007,9 @@ FOUNDATION_STATIC void alerts_shutdown()
         session_set_bool(SHOW_ALERTS_KEY, _alerts_module->show_window);
     }
 
+    array_deallocate(_alerts_module->pending);
+    array_deallocate(_alerts_module->symbol_refs);
+    array_deallocate(_alerts_module->expression_refs);
     array_deallocate(_alerts_module->evaluators);
     MEM_DELETE(_alerts_module);
 }
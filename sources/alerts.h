@@ -35,3 +35,56 @@ bool alerts_add_price_increase(const char* title, size_t title_length, double pr
  *  @return True if the alert was added successfully, false otherwise.
  */
 bool alerts_add_price_decrease(const char* title, size_t title_length, double price);
+
+/*! Add an alert evaluated when the stock symbols referenced by its expression are updated
+ *  or when its frequency elapsed.
+ *
+ *  @param title              Stock symbol bound to the $TITLE variable of the expression.
+ *  @param title_length       Length of the title string.
+ *  @param description        Description of the alert shown in the notification.
+ *  @param description_length Length of the description string.
+ *  @param expression         Expression to evaluate, the alert triggers when it evaluates to true.
+ *  @param expression_length  Length of the expression string.
+ *  @param frequency          Minimum number of seconds between evaluations based on time.
+ *
+ *  @return True if the alert was added, false if the expression is empty or already used by another alert.
+ */
+bool alerts_add(
+    const char* title, size_t title_length, 
+    const char* description, size_t description_length, 
+    const char* expression, size_t expression_length, double frequency = 60.0 * 5.0);
+
+/*! Remove the alert using the specified expression.
+ *
+ *  @param expression        Expression of the alert to remove.
+ *  @param expression_length Length of the expression string.
+ *
+ *  @return True if an alert was removed.
+ */
+bool alerts_remove(const char* expression, size_t expression_length);
+
+/*! Checks if the alert using the specified expression has triggered.
+ *
+ *  @param expression        Expression of the alert.
+ *  @param expression_length Length of the expression string.
+ *
+ *  @return True if the alert triggered and was not reset since.
+ */
+bool alerts_is_triggered(const char* expression, size_t expression_length);
+
+/*! Queue the alerts referencing any of the specified stock symbols to be evaluated.
+ *
+ *  @param symbols      Hashes of the stock symbols that were updated.
+ *  @param symbol_count Number of symbols.
+ */
+void alerts_queue_symbols(const hash_t* symbols, size_t symbol_count);
+
+/*! Evaluates the pending alerts on the main thread until the time budget is spent.
+ *
+ *  @remark At least one pending alert is evaluated per call, the others are left for the next call.
+ *
+ *  @param time_budget_ms Time budget in milliseconds.
+ *
+ *  @return Number of alerts evaluated.
+ */
+unsigned alerts_evaluate_pending(double time_budget_ms);
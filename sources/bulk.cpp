@@ -23,6 +23,8 @@
 #include <framework/jobs.h>
 #include <framework/string_builder.h>
 
+#include <foundation/path.h>
+
 #define HASH_BULK static_hash_string("bulk", 4, 0x9a6818bbbd28c09eULL)
 
 static struct BULK_MODULE
@@ -132,6 +134,8 @@ FOUNDATION_STATIC void bulk_load_symbols()
         array_clear(_bulk_module->symbols);
     }
 
+    table_invalidate(_bulk_module->table);
+
     for (int i = 0, end = array_size(_bulk_module->exchanges); i != end; ++i)
     {
         const string_t& code = _bulk_module->exchanges[i];
@@ -363,19 +367,11 @@ FOUNDATION_STATIC void bulk_set_beta_styling(table_element_ptr_const_t element,
     }
 }
 
-FOUNDATION_STATIC bool bulk_table_search(table_element_ptr_const_t element, const char* filter, size_t filter_length)
+FOUNDATION_STATIC void bulk_table_search_keywords(table_element_ptr_const_t element, string_const_t*& keywords)
 {
-    bulk_t* b = (bulk_t*)element;
-
-    string_const_t code = bulk_get_symbol_code(b);
-    if (string_contains_nocase(STRING_ARGS(code), filter, filter_length))
-        return true;
-
-    string_const_t name = string_table_decode_const(b->name);
-    if (string_contains_nocase(STRING_ARGS(name), filter, filter_length))
-        return true;
-
-    return false;
+    const bulk_t* b = (const bulk_t*)element;
+    array_push(keywords, bulk_get_symbol_code(b));
+    array_push(keywords, string_table_decode_const(b->name));
 }
 
 FOUNDATION_STATIC void bulk_create_symbols_table()
@@ -383,9 +379,9 @@ FOUNDATION_STATIC void bulk_create_symbols_table()
     if (_bulk_module->table)
         table_deallocate(_bulk_module->table);
 
-    _bulk_module->table = table_allocate("Bulk##_2", TABLE_HIGHLIGHT_HOVERED_ROW | TABLE_LOCALIZATION_CONTENT);
+    _bulk_module->table = table_allocate("Bulk##_2", TABLE_HIGHLIGHT_HOVERED_ROW | TABLE_LOCALIZATION_CONTENT | TABLE_CACHE_CELLS | TABLE_BACKGROUND_SORT | TABLE_SEARCH_INDEX);
     _bulk_module->table->context_menu = bulk_table_context_menu;
-    _bulk_module->table->search = bulk_table_search;
+    _bulk_module->table->search_keywords = bulk_table_search_keywords;
 
     table_add_column(_bulk_module->table, STRING_CONST("Title"), bulk_column_symbol_code, COLUMN_FORMAT_SYMBOL, COLUMN_SORTABLE | COLUMN_CUSTOM_DRAWING)
         .set_selected_callback(bulk_column_title_selected);
@@ -524,12 +520,16 @@ FOUNDATION_STATIC void bulk_render()
             {
                 system_save_file_dialog(
                     tr("Export table to CSV..."), 
-                    tr("Comma-Separated-Value (*.csv)|*.csv"), 
+                    tr("Comma-Separated-Value (*.csv)|*.csv|Binary Table (*.wtbl)|*.wtbl"), 
                     nullptr, [](string_const_t save_path)
                 {
                     string_t path = string_clone(STRING_ARGS(save_path));
                     SHARED_READ_LOCK(_bulk_module->lock);
-                    table_export_csv(_bulk_module->table, STRING_ARGS(path));
+                    string_const_t extension = path_file_extension(STRING_ARGS(path));
+                    if (string_equal_nocase(STRING_ARGS(extension), STRING_CONST("wtbl")))
+                        table_export_binary(_bulk_module->table, STRING_ARGS(path));
+                    else
+                        table_export_csv(_bulk_module->table, STRING_ARGS(path));
                     string_deallocate(path.str);
                     return true;
                 });
@@ -18,3 +18,6 @@ constexpr const char EVENT_SEARCH_DATABASE_LOADED[] = "SEARCH_DATABASE_LOADED";
 
 /*! Posted when the search query is updated. */
 constexpr const char EVENT_SEARCH_QUERY_UPDATED[] = "SEARCH_QUERY_UPDATED";
+
+/*! Posted when new realtime prices are streamed. The payload is the list of updated stock keys (hash_t). */
+constexpr const char EVENT_REALTIME_PRICES_UPDATED[] = "REALTIME_PRICES_UPDATED";
@@ -131,6 +131,7 @@ FOUNDATION_STATIC void realtime_fetch_query_data(const json_object_t& res)
     if (res.error_code > 0)
         return;
     
+    hash_t* updated_keys = nullptr;
     for (auto e : res)
     {
         stock_realtime_record_t r;
@@ -166,12 +167,22 @@ FOUNDATION_STATIC void realtime_fetch_query_data(const json_object_t& res)
                 stream_write(_realtime_module->stream, stock.code, sizeof(stock.code));
                 stream_write(_realtime_module->stream, &r.price, sizeof(r.price));
                 stream_write(_realtime_module->stream, &r.volume, sizeof(r.volume));
+
+                array_push(updated_keys, key);
             }
         }
     }
 
     if (_realtime_module->stream)
         stream_flush(_realtime_module->stream);
+
+    // Notify listeners (i.e. alerts) that new prices are available for these stocks
+    if (updated_keys)
+    {
+        dispatcher_post_event(EVENT_REALTIME_PRICES_UPDATED, 
+            updated_keys, array_size(updated_keys) * sizeof(hash_t), DISPATCHER_EVENT_OPTION_COPY_DATA);
+        array_deallocate(updated_keys);
+    }
 }
 
 FOUNDATION_STATIC stream_t* realtime_open_stream()
@@ -686,6 +697,12 @@ FOUNDATION_STATIC void realtime_render_window_tootlbar()
     ImGui::EndGroup();
 }
 
+FOUNDATION_STATIC bool realtime_prices_updated(const dispatcher_event_args_t& args)
+{
+    table_invalidate(_realtime_module->table);
+    return true;
+}
+
 FOUNDATION_STATIC void realtime_render_window()
 {
     if (_realtime_module->show_window == false)
@@ -696,7 +713,7 @@ FOUNDATION_STATIC void realtime_render_window()
     {
         if (_realtime_module->table == nullptr)
         {
-            _realtime_module->table = table_allocate("realtime", TABLE_LOCALIZATION_CONTENT);
+            _realtime_module->table = table_allocate("realtime", TABLE_LOCALIZATION_CONTENT | TABLE_CACHE_CELLS);
             _realtime_module->table->row_fixed_height = IM_SCALEF(200.0f);
             table_add_column(_realtime_module->table, "Title", realtime_table_draw_title, COLUMN_FORMAT_TEXT, 
                 COLUMN_SORTABLE | COLUMN_CUSTOM_DRAWING | COLUMN_NOCLIP_CONTENT | COLUMN_SEARCHABLE)
@@ -774,6 +791,7 @@ FOUNDATION_STATIC void realtime_initialize()
     }
 
     dispatcher_register_event_listener(EVENT_STOCK_REQUESTED, realtime_register_new_stock);
+    dispatcher_register_event_listener(EVENT_REALTIME_PRICES_UPDATED, realtime_prices_updated);
 
     #if BUILD_DEVELOPMENT
     module_register_menu(HASH_REALTIME, realtime_menu);
@@ -32,11 +32,13 @@
 #include <framework/expr.h>
 #include <framework/database.h>
 #include <framework/console.h>
+#include <framework/persistence.h>
 #include <framework/string.h>
 #include <framework/array.h>
 #include <framework/localization.h>
 #include <framework/system.h>
 #include <framework/window.h>
+#include <framework/jobs.h>
 
 #include <foundation/uuid.h>
 #include <foundation/path.h>
@@ -45,6 +47,9 @@
 
 #define E32(FN, P1, P2, P3) L2(FN(P1, P2, P3))
 
+/*! Minimum number of titles for reports to refresh titles and accumulate the summary in parallel. */
+#define REPORT_PARALLEL_MIN_TITLE_COUNT (32)
+
 constexpr string_const_t REPORTS_DIR_NAME = CTEXT("reports");
 static const ImU32 BACKGROUND_WATCH_COLOR = ImColor::HSV(120 / 360.0f, 0.30f, 0.61f);
 
@@ -243,6 +248,7 @@ FOUNDATION_STATIC void report_table_setup(report_handle_t report_handle, table_t
 {
     table->flags |= ImGuiTableFlags_ScrollX
         | TABLE_SUMMARY
+        | TABLE_CACHE_CELLS
         | TABLE_HIGHLIGHT_HOVERED_ROW
         | TABLE_LOCALIZATION_CONTENT;
 
@@ -1323,6 +1329,13 @@ FOUNDATION_STATIC report_handle_t report_create(const char* name, size_t name_le
     return report_handle;
 }
 
+FOUNDATION_STATIC string_t report_file_path_with_extension(char* buffer, size_t capacity, const char* file_path, size_t file_path_length, const char* extension, size_t extension_length)
+{
+    string_const_t current_extension = path_file_extension(file_path, file_path_length);
+    const size_t base_length = file_path_length - (current_extension.length > 0 ? current_extension.length + 1 : 0);
+    return string_format(buffer, capacity, STRING_CONST("%.*s.%.*s"), (int)base_length, file_path, (int)extension_length, extension);
+}
+
 FOUNDATION_STATIC string_const_t report_get_save_file_path(report_t* report)
 {
     string_const_t report_file_name = string_table_decode_const(report->name);
@@ -1333,7 +1346,7 @@ FOUNDATION_STATIC string_const_t report_get_save_file_path(report_t* report)
         config_set(report->data, STRING_CONST("id"), STRING_ARGS(report_file_name));
     }
     report_file_name = fs_clean_file_name(STRING_ARGS(report_file_name));
-    return session_get_user_file_path(STRING_ARGS(report_file_name), STRING_ARGS(REPORTS_DIR_NAME), STRING_CONST("json"));
+    return session_get_user_file_path(STRING_ARGS(report_file_name), STRING_ARGS(REPORTS_DIR_NAME), STRING_CONST(CONFIG_BINARY_FILE_EXTENSION));
 }
 
 FOUNDATION_STATIC void report_rename(report_t* report, string_const_t name)
@@ -1347,8 +1360,17 @@ FOUNDATION_STATIC void report_delete(report_t* report)
     report->save = false;
     report->opened = false;
     string_const_t report_save_file = report_get_save_file_path(report);
+
+    // Make sure a pending save does not write the report file back once removed.
+    persistence_cancel(report_save_file);
     if (fs_is_file(STRING_ARGS(report_save_file)))
         fs_remove_file(STRING_ARGS(report_save_file));
+
+    // Also remove the JSON file the report was saved to before binary report files.
+    char legacy_file_path_buffer[BUILD_MAX_PATHLEN];
+    string_t legacy_file_path = report_file_path_with_extension(STRING_BUFFER(legacy_file_path_buffer), STRING_ARGS(report_save_file), STRING_CONST("json"));
+    if (fs_is_file(STRING_ARGS(legacy_file_path)))
+        fs_remove_file(STRING_ARGS(legacy_file_path));
 }
 
 FOUNDATION_STATIC void report_toggle_show_summary(report_t* report)
@@ -1613,7 +1635,10 @@ FOUNDATION_STATIC bool report_initial_sync(report_t* report)
 
     log_debugf(HASH_REPORT, STRING_CONST("Fully resolved %s"), string_table_decode(report->name));
     if (report->table)
+    {
         report->table->needs_sorting = true;
+        table_invalidate(report->table);
+    }
 
     report->fully_resolved = 1;
     return fully_resolved;
@@ -2015,101 +2040,173 @@ double report_compute_total_sell_gain(report_t* report)
     return total_sell_gain;
 }
 
-void report_summary_update(report_t* report)
-{
-    // Update report average days
-    double total_days = 0;
-    double total_value = 0;
-    double total_investment = 0;
-    double total_sell_gain_if_kept = 0;
-    double total_sell_gain_if_kept_p = 0;
-    double total_title_sell_count = 0;
-    double total_sell_rated = 0;
-    double total_sell_gain_rated = 0;
-    double total_projected_sell_loses = 0;
-    double total_buy_rated = 0;
-    double average_nq = 0;
-    double average_nq_count = 0;
-    double total_day_gain = 0;
-    double total_daily_average_p = 0;
-    double title_resolved_count = 0;
-    double total_dividends = 0;
-    double total_active_titles = 0;
-    const size_t title_count = array_size(report->titles);
-    for (size_t i = 0; i < title_count; ++i)
+/*! Report summary totals, accumulated per title and merged to update the report summary. */
+struct report_summary_totals_t
+{
+    double total_days{ 0 };
+    double total_value{ 0 };
+    double total_investment{ 0 };
+    double total_sell_gain_if_kept{ 0 };
+    double total_sell_gain_if_kept_p{ 0 };
+    double total_title_sell_count{ 0 };
+    double total_sell_rated{ 0 };
+    double total_sell_gain_rated{ 0 };
+    double total_projected_sell_loses{ 0 };
+    double total_buy_rated{ 0 };
+    double average_nq{ 0 };
+    double average_nq_count{ 0 };
+    double total_day_gain{ 0 };
+    double total_daily_average_p{ 0 };
+    double title_resolved_count{ 0 };
+    double total_dividends{ 0 };
+    double total_active_titles{ 0 };
+};
+
+FOUNDATION_STATIC void report_summary_accumulate_title(const report_t* report, const title_t* t, report_summary_totals_t& totals)
+{
+    FOUNDATION_ASSERT(t);
+
+    if (title_is_index(t))
+        return;
+
+    if (t->average_quantity > 0)
     {
-        const title_t* t = report->titles[i];
-        FOUNDATION_ASSERT(t);
+        const double days_held = title_average_days_held(t);
+        
+        totals.total_days += days_held;
+        totals.total_active_titles++;
+    }
 
-        if (title_is_index(t))
-            continue;
+    const bool title_is_sold = title_sold(t);
+    if (!title_is_sold)
+        totals.total_investment += title_total_bought_price(t);
 
-        if (t->average_quantity > 0)
+    const stock_t* s = t->stock;
+    const bool stock_valid = s && !math_real_is_nan(s->current.change_p);
+    // Make sure the stock is still valid today, it might have been delisted.
+    if (stock_valid)
+    {
+        if (!title_is_sold)
         {
-            const double days_held = title_average_days_held(t);
-            
-            total_days += days_held;
-            total_active_titles++;
-        }
+            totals.total_value += title_get_total_value(t);
+            totals.average_nq += s->current.change_p / 100.0;
+            totals.average_nq_count++;
 
-        const bool title_is_sold = title_sold(t);
-        if (!title_is_sold)
-            total_investment += title_total_bought_price(t);
+            totals.average_nq += title_get_yesterday_change(t, s) / 100.0;
+            totals.average_nq_count++;
+        }
 
-        const stock_t* s = t->stock;
-        const bool stock_valid = s && !math_real_is_nan(s->current.change_p);
-        // Make sure the stock is still valid today, it might have been delisted.
-        if (stock_valid)
+        const day_result_t* ed = stock_get_EOD(s, -math_round(report->wallet->average_days), true);
+        if (ed)
         {
-            if (!title_is_sold)
-            {
-                total_value += title_get_total_value(t);
-                average_nq += s->current.change_p / 100.0;
-                average_nq_count++;
+            double eod_change_p = math_change_p(t->stock->current.price, ed->adjusted_close);
+            totals.average_nq += eod_change_p;
+            totals.average_nq_count++;
+        }
 
-                average_nq += title_get_yesterday_change(t, s) / 100.0;
-                average_nq_count++;
-            }
+        if (!math_real_is_nan(s->current.change))
+            totals.total_day_gain += math_ifnan(title_get_day_change(t, s), 0);
 
-            const day_result_t* ed = stock_get_EOD(s, -math_round(report->wallet->average_days), true);
-            if (ed)
-            {
-                double eod_change_p = math_change_p(t->stock->current.price, ed->adjusted_close);
-                average_nq += eod_change_p;
-                average_nq_count++;
-            }
+        totals.total_daily_average_p += s->current.change_p;
 
-            if (!math_real_is_nan(s->current.change))
-                total_day_gain += math_ifnan(title_get_day_change(t, s), 0);
+        totals.title_resolved_count++;
+    }
+    else if (!title_is_sold)
+    {
+        totals.total_value += t->average_quantity * t->average_price;
+    }
 
-            total_daily_average_p += s->current.change_p;
+    totals.total_buy_rated += t->buy_total_price_rated;
+    totals.total_sell_rated += t->sell_total_price_rated;
+    totals.total_dividends += t->total_dividends;
 
-            title_resolved_count++;
-        }
-        else if (!title_is_sold)
+    if (stock_valid && t->sell_total_quantity > 0)
+    {
+        const double sell_adjusted_price = t->sell_total_price_rated / t->sell_total_quantity;
+        const double sell_gain_if_kept = (s->current.adjusted_close - sell_adjusted_price) * t->sell_total_quantity;
+        const double sell_p = (s->current.price - sell_adjusted_price) / sell_adjusted_price;
+        if (!math_real_is_nan(sell_p))
         {
-            total_value += t->average_quantity * t->average_price;
+            totals.total_sell_gain_if_kept_p += sell_p;
+            totals.total_sell_gain_if_kept += sell_gain_if_kept;
+            totals.total_title_sell_count++;
+            totals.total_sell_gain_rated += title_get_sell_gain_rated(t, true);
+            totals.total_projected_sell_loses += title_get_sell_gain_rated(t, false);
         }
+    }
+}
 
-        total_buy_rated += t->buy_total_price_rated;
-        total_sell_rated += t->sell_total_price_rated;
-        total_dividends += t->total_dividends;
+FOUNDATION_STATIC void report_summary_merge_totals(report_summary_totals_t& totals, const report_summary_totals_t& other)
+{
+    totals.total_days += other.total_days;
+    totals.total_value += other.total_value;
+    totals.total_investment += other.total_investment;
+    totals.total_sell_gain_if_kept += other.total_sell_gain_if_kept;
+    totals.total_sell_gain_if_kept_p += other.total_sell_gain_if_kept_p;
+    totals.total_title_sell_count += other.total_title_sell_count;
+    totals.total_sell_rated += other.total_sell_rated;
+    totals.total_sell_gain_rated += other.total_sell_gain_rated;
+    totals.total_projected_sell_loses += other.total_projected_sell_loses;
+    totals.total_buy_rated += other.total_buy_rated;
+    totals.average_nq += other.average_nq;
+    totals.average_nq_count += other.average_nq_count;
+    totals.total_day_gain += other.total_day_gain;
+    totals.total_daily_average_p += other.total_daily_average_p;
+    totals.title_resolved_count += other.title_resolved_count;
+    totals.total_dividends += other.total_dividends;
+    totals.total_active_titles += other.total_active_titles;
+}
 
-        if (stock_valid && t->sell_total_quantity > 0)
+void report_summary_update(report_t* report)
+{
+    // Accumulate titles in chunks, each chunk having its own totals, so jobs never share any state.
+    report_summary_totals_t totals;
+    const size_t title_count = array_size(report->titles);
+    if (title_count >= REPORT_PARALLEL_MIN_TITLE_COUNT)
+    {
+        // Fetch today's exchange rates here since #stock_exchange_rate is not thread safe.
+        for (size_t i = 0; i < title_count; ++i)
+            report->titles[i]->today_exchange_rate.fetch();
+
+        report_summary_totals_t* chunk_totals = nullptr;
+        const unsigned chunk_count = job_parallel_thread_count();
+        array_resize(chunk_totals, chunk_count);
+        for (unsigned i = 0; i < chunk_count; ++i)
+            chunk_totals[i] = report_summary_totals_t{};
+
+        job_parallel_for(title_count, chunk_count, [report, chunk_totals](size_t begin, size_t end, unsigned chunk)
         {
-            const double sell_adjusted_price = t->sell_total_price_rated / t->sell_total_quantity;
-            const double sell_gain_if_kept = (s->current.adjusted_close - sell_adjusted_price) * t->sell_total_quantity;
-            const double sell_p = (s->current.price - sell_adjusted_price) / sell_adjusted_price;
-            if (!math_real_is_nan(sell_p))
-            {
-                total_sell_gain_if_kept_p += sell_p;
-                total_sell_gain_if_kept += sell_gain_if_kept;
-                total_title_sell_count++;
-                total_sell_gain_rated += title_get_sell_gain_rated(t, true);
-                total_projected_sell_loses += title_get_sell_gain_rated(t, false);
-            }
-        }
+            for (size_t i = begin; i < end; ++i)
+                report_summary_accumulate_title(report, report->titles[i], chunk_totals[chunk]);
+        });
+
+        // Merge in chunk order to always get the same sums.
+        for (unsigned i = 0; i < chunk_count; ++i)
+            report_summary_merge_totals(totals, chunk_totals[i]);
+        array_deallocate(chunk_totals);
     }
+    else
+    {
+        for (size_t i = 0; i < title_count; ++i)
+            report_summary_accumulate_title(report, report->titles[i], totals);
+    }
+
+    const double total_days = totals.total_days;
+    const double total_value = totals.total_value;
+    const double total_investment = totals.total_investment;
+    const double total_sell_gain_if_kept = totals.total_sell_gain_if_kept;
+    double total_sell_gain_if_kept_p = totals.total_sell_gain_if_kept_p;
+    const double total_title_sell_count = totals.total_title_sell_count;
+    const double total_sell_rated = totals.total_sell_rated;
+    const double total_sell_gain_rated = totals.total_sell_gain_rated;
+    const double total_projected_sell_loses = totals.total_projected_sell_loses;
+    double average_nq = totals.average_nq;
+    const double average_nq_count = totals.average_nq_count;
+    const double total_day_gain = totals.total_day_gain;
+    const double total_daily_average_p = totals.total_daily_average_p;
+    const double title_resolved_count = totals.title_resolved_count;
+    const double total_dividends = totals.total_dividends;
+    const double total_active_titles = totals.total_active_titles;
 
     if (total_active_titles > 0)
         report->wallet->average_days = total_days / total_active_titles;
@@ -2303,6 +2400,10 @@ report_handle_t report_load(string_const_t report_file_path)
         CONFIG_OPTION_WRITE_TRUNCATE_NUMBERS |
         CONFIG_OPTION_WRITE_SKIP_FIRST_BRACKETS;
 
+    // Keep the file path since it is usually a shared session path buffer.
+    char file_path_buffer[BUILD_MAX_PATHLEN];
+    report_file_path = string_to_const(string_copy(STRING_BUFFER(file_path_buffer), STRING_ARGS(report_file_path)));
+
     config_handle_t data{};
     if (fs_is_file(STRING_ARGS(report_file_path)))
     {
@@ -2320,18 +2421,40 @@ report_handle_t report_load(string_const_t report_file_path)
     report_handle_t report_handle = report_allocate(STRING_ARGS(report_name), data);
     report_t* report = report_get(report_handle);
     report->save = true;
+
+    // Migrate reports saved as JSON before binary report files, the JSON file is only removed once the binary file is written.
+    string_const_t extension = path_file_extension(STRING_ARGS(report_file_path));
+    if (data && string_equal_nocase(STRING_ARGS(extension), STRING_CONST("json")))
+    {
+        string_const_t save_file_path = report_get_save_file_path(report);
+        char binary_file_path_buffer[BUILD_MAX_PATHLEN];
+        string_t binary_file_path = string_copy(STRING_BUFFER(binary_file_path_buffer), STRING_ARGS(save_file_path));
+
+        // Only migrate files of the user reports directory.
+        string_const_t report_dir_path = path_directory_name(STRING_ARGS(report_file_path));
+        string_const_t binary_dir_path = path_directory_name(STRING_ARGS(binary_file_path));
+        if (string_equal(STRING_ARGS(report_dir_path), STRING_ARGS(binary_dir_path)) && report_save(report, STRING_ARGS(binary_file_path)))
+        {
+            log_infof(HASH_REPORT, STRING_CONST("Migrated report %.*s to %.*s"), STRING_FORMAT(report_file_path), STRING_FORMAT(binary_file_path));
+            fs_remove_file(STRING_ARGS(report_file_path));
+        }
+    }
+
     return report_handle;
 }
 
 report_handle_t report_load(const char* name, size_t name_length)
 {
-    string_const_t report_file_path = session_get_user_file_path(name, name_length, STRING_ARGS(REPORTS_DIR_NAME), STRING_CONST("json"));
+    // Reports saved before binary report files are loaded from their JSON file.
+    string_const_t report_file_path = session_get_user_file_path(name, name_length, STRING_ARGS(REPORTS_DIR_NAME), STRING_CONST(CONFIG_BINARY_FILE_EXTENSION));
+    if (!fs_is_file(STRING_ARGS(report_file_path)))
+        report_file_path = session_get_user_file_path(name, name_length, STRING_ARGS(REPORTS_DIR_NAME), STRING_CONST("json"));
     return report_load(report_file_path);
 }
 
-bool report_save(report_t* report, const char* file_path, size_t file_path_length)
+/*! Replicates the report memory fields in the report data before it gets written. */
+FOUNDATION_STATIC void report_save_data(report_t* report)
 {
-    // Replicate some memory fields
     config_set(report->data, "name", string_table_decode_const(report->name));
     config_set(report->data, "order", (double)report->save_index);
     config_set(report->data, "show_summary", report->show_summary);
@@ -2342,6 +2465,11 @@ bool report_save(report_t* report, const char* file_path, size_t file_path_lengt
     report_expression_columns_save(report);    
 
     wallet_save(report->wallet, config_set_object(report->data, STRING_CONST("wallet")));
+}
+
+bool report_save(report_t* report, const char* file_path, size_t file_path_length)
+{
+    report_save_data(report);
 
     string_const_t report_file_path = string_const(file_path, file_path_length);
     return config_write_file(report_file_path, report->data,
@@ -2350,9 +2478,15 @@ bool report_save(report_t* report, const char* file_path, size_t file_path_lengt
 
 void report_save(report_t* report)
 {
+    report_save_data(report);
+
+    // The report data is written in the background once no other save is requested.
     string_const_t report_file_path = report_get_save_file_path(report);
-    if (report_save(report, STRING_ARGS(report_file_path)))
+    if (persistence_save(report_file_path, report->data,
+        CONFIG_OPTION_WRITE_SKIP_NULL | CONFIG_OPTION_WRITE_SKIP_DOUBLE_COMMA_FIELDS | CONFIG_OPTION_WRITE_NO_SAVE_ON_DATA_EQUAL))
+    {
         report->dirty = false;
+    }
 }
 
 void report_render(report_t* report)
@@ -2540,11 +2674,29 @@ bool report_sync_titles(report_t* report, double timeout_seconds /*= 60.0*/)
 
     // Update report summary
     report_summary_update(report);
-    for (size_t i = 0; i < title_count; ++i)
-        title_refresh(report->titles[i]);
+    if (title_count >= REPORT_PARALLEL_MIN_TITLE_COUNT)
+    {
+        // Save missing split factors and exchange rates first, title jobs must not write the report data.
+        for (size_t i = 0; i < title_count; ++i)
+            title_resolve_transactions(report->titles[i]);
+
+        job_parallel_for(title_count, job_parallel_thread_count(), [report](size_t begin, size_t end, unsigned chunk)
+        {
+            for (size_t i = begin; i < end; ++i)
+                title_refresh(report->titles[i]);
+        });
+    }
+    else
+    {
+        for (size_t i = 0; i < title_count; ++i)
+            title_refresh(report->titles[i]);
+    }
     report_summary_update(report);
     if (report->table)
+    {
         report->table->needs_sorting = true;
+        table_invalidate(report->table);
+    }
 
     log_infof(HASH_REPORT, STRING_CONST("Report %s synced completed in %.3g seconds"), SYMBOL_CSTR(report->name), time_elapsed(timer));
     return true;
@@ -2582,7 +2734,7 @@ void report_title_sell(report_t* report, title_t* title, time_t date, double qty
     config_set(new_order, STRING_CONST("qty"), qty);
     config_set(new_order, STRING_CONST("price"), price);
 
-    title_refresh(title);
+    title_push_order(title, new_order);
 }
 
 void report_title_buy(report_t* report, title_t* title, time_t date, double qty, double price)
@@ -2599,7 +2751,7 @@ void report_title_buy(report_t* report, title_t* title, time_t date, double qty,
     config_set(new_order, STRING_CONST("qty"), qty);
     config_set(new_order, STRING_CONST("price"), price);
 
-    title_refresh(title);
+    title_push_order(title, new_order);
 }
 
 void report_deallocate(report_handle_t handle)
@@ -2685,7 +2837,7 @@ FOUNDATION_STATIC void report_initialize()
     {
         log_infof(HASH_REPORT, STRING_CONST("Loading reports from %.*s"), STRING_FORMAT(report_dir_path));
 
-        string_t* paths = fs_matching_files(STRING_ARGS(report_dir_path), STRING_CONST("^.*\\.json$"), false);
+        string_t* paths = fs_matching_files(STRING_ARGS(report_dir_path), STRING_CONST("^.*\\.(" CONFIG_BINARY_FILE_EXTENSION "|json)$"), false);
         foreach(e, paths)
         {
             char report_path_buffer[1024];
@@ -2697,6 +2849,18 @@ FOUNDATION_STATIC void report_initialize()
                     STRING_FORMAT(report_path));
                 continue;
             }
+
+            // JSON report files are only loaded until the report gets saved in a binary file.
+            string_const_t extension = path_file_extension(STRING_ARGS(report_path));
+            if (string_equal_nocase(STRING_ARGS(extension), STRING_CONST("json")))
+            {
+                char binary_path_buffer[1024];
+                string_t binary_path = report_file_path_with_extension(STRING_BUFFER(binary_path_buffer), 
+                    STRING_ARGS(report_path), STRING_CONST(CONFIG_BINARY_FILE_EXTENSION));
+                if (fs_is_file(STRING_ARGS(binary_path)))
+                    continue;
+            }
+
             report_load(string_to_const(report_path));
         }
         string_array_deallocate(paths);
@@ -127,6 +127,9 @@ report_handle_t report_load(const char* name, size_t name_length);
 void report_save(report_t* report);
 
 /*! Saves a report to a specific file path. 
+ * 
+ * The report is written as human readable SJSON text, unless the file path 
+ * has the #CONFIG_BINARY_FILE_EXTENSION extension.
  * 
  * @param report            The report to save.
  * @param file_path         The path to the file to save the report to.
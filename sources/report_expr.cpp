@@ -185,10 +185,185 @@ static struct {
     { CTEXT("cci"),            SC2(_2->cci), FetchLevel::REALTIME | FetchLevel::TECHNICAL_CCI }
 };
 
+/*! Maps a lowercase property name hash to its property evaluator index. */
+struct report_expr_property_ref_t
+{
+    hash_t   key;
+    uint32_t index;
+};
+
+/*! Identifies a field value resolved during an evaluation. */
+struct report_expr_memo_key_t
+{
+    const void* title;
+    hash_t      symbol;
+    uint32_t    property;
+    time_t      date;
+};
+
+/*! Memoized field value or stock handle. */
+struct report_expr_memo_entry_t
+{
+    hash_t         key;
+    expr_result_t  value;
+    stock_handle_t stock;
+};
+
+constexpr uint32_t REPORT_EXPR_MEMO_EOD_PROPERTY = 1U << 16;
+constexpr uint32_t REPORT_EXPR_MEMO_STOCK_HANDLE = UINT32_MAX;
+constexpr time_t REPORT_EXPR_MEMO_ALL_DATES = -1;
+
+static report_expr_property_ref_t* _report_field_property_index = nullptr;
+static report_expr_property_ref_t* _stock_end_of_day_property_index = nullptr;
+
+/*! Open addressing table of the fields resolved during the current top level evaluation of the thread.
+ *  The entries are allocated in the evaluation arena, so they get dropped along with the values they hold.
+ */
+static thread_local struct {
+    uint64_t                  evaluation{ 0 };
+    report_expr_memo_entry_t* entries{ nullptr };
+    uint32_t                  capacity{ 0 };
+    uint32_t                  count{ 0 };
+} _report_expr_memo;
+
 // 
 // # PRIVATE
 //
 
+FOUNDATION_STATIC report_expr_property_ref_t* report_expr_build_property_index(const char* const* names, uint32_t count)
+{
+    report_expr_property_ref_t* index = nullptr;
+    array_reserve(index, count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        char name_buffer[64];
+        string_t name = string_to_lower_ascii(STRING_BUFFER(name_buffer), names[i], string_length(names[i]));
+        report_expr_property_ref_t ref{ hash(STRING_ARGS(name)), i };
+        array_push(index, ref);
+    }
+
+    array_sort(index, [](const report_expr_property_ref_t& a, const report_expr_property_ref_t& b)
+    {
+        if (a.key == b.key)
+            return 0;
+        return a.key < b.key ? -1 : 1;
+    });
+
+    return index;
+}
+
+FOUNDATION_STATIC int report_expr_find_property(const report_expr_property_ref_t* index, string_const_t name)
+{
+    char name_buffer[64];
+    if (name.length >= sizeof(name_buffer))
+        return -1;
+
+    string_t lname = string_to_lower_ascii(STRING_BUFFER(name_buffer), STRING_ARGS(name));
+    const hash_t key = hash(STRING_ARGS(lname));
+    const int i = array_binary_search_compare(index, key, [](const report_expr_property_ref_t& ref, const hash_t& key)
+    {
+        if (ref.key == key)
+            return 0;
+        return ref.key < key ? -1 : 1;
+    });
+
+    return i >= 0 ? (int)index[i].index : -1;
+}
+
+FOUNDATION_STATIC hash_t report_expr_memo_key(const void* title, hash_t symbol, uint32_t property, time_t date = 0)
+{
+    report_expr_memo_key_t key;
+    memset(&key, 0, sizeof(key));
+    key.title = title;
+    key.symbol = symbol;
+    key.property = property;
+    key.date = date;
+
+    const hash_t h = hash(&key, sizeof(key));
+    return h != 0 ? h : 1;
+}
+
+FOUNDATION_STATIC report_expr_memo_entry_t* report_expr_memo_slot(hash_t key)
+{
+    // Drop the entries of the previous evaluation, their memory was reclaimed with the evaluation arena.
+    auto& memo = _report_expr_memo;
+    const uint64_t evaluation = expr_evaluation_id();
+    if (memo.evaluation != evaluation)
+    {
+        memo.evaluation = evaluation;
+        memo.entries = nullptr;
+        memo.capacity = 0;
+        memo.count = 0;
+    }
+
+    if (memo.capacity == 0)
+        return nullptr;
+
+    const uint32_t mask = memo.capacity - 1;
+    for (uint32_t i = (uint32_t)key & mask;; i = (i + 1) & mask)
+    {
+        report_expr_memo_entry_t* entry = &memo.entries[i];
+        if (entry->key == key || entry->key == 0)
+            return entry;
+    }
+}
+
+FOUNDATION_STATIC const report_expr_memo_entry_t* report_expr_memo_find(hash_t key)
+{
+    const report_expr_memo_entry_t* entry = report_expr_memo_slot(key);
+    return entry && entry->key == key ? entry : nullptr;
+}
+
+FOUNDATION_STATIC report_expr_memo_entry_t* report_expr_memo_insert(hash_t key)
+{
+    auto& memo = _report_expr_memo;
+    report_expr_memo_entry_t* entry = report_expr_memo_slot(key);
+    if (entry && entry->key == key)
+        return entry;
+
+    // Keep the table at most half full
+    if ((memo.count + 1) * 2 > memo.capacity)
+    {
+        const uint32_t capacity = max(64U, memo.capacity * 2);
+        const size_t size = sizeof(report_expr_memo_entry_t) * capacity;
+        report_expr_memo_entry_t* entries = (report_expr_memo_entry_t*)expr_arena_allocate(size, 16);
+        memset((void*)entries, 0, size);
+
+        for (uint32_t i = 0; i < memo.capacity; ++i)
+        {
+            const report_expr_memo_entry_t& e = memo.entries[i];
+            if (e.key == 0)
+                continue;
+
+            uint32_t k = (uint32_t)e.key & (capacity - 1);
+            while (entries[k].key != 0)
+                k = (k + 1) & (capacity - 1);
+            memcpy((void*)&entries[k], &e, sizeof(e));
+        }
+
+        memo.entries = entries;
+        memo.capacity = capacity;
+        entry = report_expr_memo_slot(key);
+    }
+
+    entry->key = key;
+    memo.count++;
+    return entry;
+}
+
+FOUNDATION_STATIC stock_handle_t report_expr_request_stock(string_const_t code)
+{
+    const hash_t memo_key = report_expr_memo_key(nullptr, hash(STRING_ARGS(code)), REPORT_EXPR_MEMO_STOCK_HANDLE);
+    const report_expr_memo_entry_t* memo = report_expr_memo_find(memo_key);
+    if (memo)
+        return memo->stock;
+
+    stock_handle_t stock_handle = stock_request(STRING_ARGS(code), FetchLevel::REALTIME);
+    if (stock_handle)
+        report_expr_memo_insert(memo_key)->stock = stock_handle;
+    return stock_handle;
+}
+
 FOUNDATION_STATIC bool report_eval_report_field_resolve_level(stock_handle_t& stock_handle, FetchLevel request_level, const double timeout_expired = 60.0)
 {
     const stock_t* s = stock_handle;
@@ -199,6 +374,7 @@ FOUNDATION_STATIC bool report_eval_report_field_resolve_level(stock_handle_t& st
     {
         if (stock_resolve(stock_handle, request_level) >= 0)
         {
+            ExprProfileWaitScope profile_wait;
             const tick_t timeout = time_current();
             while (!s->has_resolve(request_level) && time_elapsed(timeout) < timeout_expired)
             {
@@ -222,49 +398,57 @@ FOUNDATION_STATIC bool report_eval_report_field_resolve_level(title_t* t, FetchL
     return report_eval_report_field_resolve_level(t->stock, request_level);
 }
 
-FOUNDATION_STATIC bool report_eval_report_field_test(
-    const char* property_name, stock_handle_t& stock_handle, string_const_t field_name,
-    const function<expr_result_t(title_t* t, const stock_t* s)>& property_evalutor,
-    const function<bool(const expr_result_t& v)>& property_filter_out,
-    expr_result_t** results, FetchLevel required_level)
+FOUNDATION_STATIC bool report_eval_stock_field(stock_handle_t& stock_handle, uint32_t property_index, expr_result_t& value)
 {
-    if (!string_equal_nocase(STRING_LENGTH(property_name), STRING_ARGS(field_name)))
-        return false;
+    const hash_t memo_key = report_expr_memo_key(nullptr, stock_handle.id, property_index);
+    const report_expr_memo_entry_t* memo = report_expr_memo_find(memo_key);
+    if (memo)
+    {
+        value = memo->value;
+        return true;
+    }
 
+    const auto& pe = report_field_property_evalutors[property_index];
     const stock_t* s = stock_handle;
     if (s == nullptr)
     {
         log_warnf(HASH_REPORT_EXPRESSION, WARNING_SUSPICIOUS, 
-            STRING_CONST("Failed to resolve stock to evaluate %.*s"), STRING_FORMAT(field_name));
+            STRING_CONST("Failed to resolve stock to evaluate %s"), pe.property_name);
         return false;
     }
 
+    FetchLevel required_level = pe.required_level;
     if (s->code == STRING_TABLE_NULL_SYMBOL)
         required_level |= FetchLevel::FUNDAMENTALS;
 
     if (required_level != FetchLevel::NONE)
         report_eval_report_field_resolve_level(stock_handle, required_level);
 
-    expr_result_t value = property_evalutor(nullptr, stock_handle);
-    if (!property_filter_out || !property_filter_out(value))
-    {
-        const expr_result_t& kvp = expr_eval_pair(SYMBOL_CONST(s->code), value);
-        array_push(*results, kvp);
-    }
-
+    value = pe.handler(nullptr, stock_handle);
+    report_expr_memo_insert(memo_key)->value = value;
     return true;
 }
 
-FOUNDATION_STATIC bool report_eval_report_field_test(
-    const char* property_name, report_t* report,
-    string_const_t title_filter, string_const_t field_name,
-    const function<expr_result_t(title_t* t, const stock_t* s)>& property_evalutor,
-    const function<bool(const expr_result_t& v)>& property_filter_out,
-    expr_result_t** results, FetchLevel required_level)
+FOUNDATION_STATIC expr_result_t report_eval_title_field(title_t* t, uint32_t property_index)
 {
-    if (!string_equal_nocase(STRING_LENGTH(property_name), STRING_ARGS(field_name)))
-        return false;
-        
+    const hash_t memo_key = report_expr_memo_key(t, hash(t->code, t->code_length), property_index);
+    const report_expr_memo_entry_t* memo = report_expr_memo_find(memo_key);
+    if (memo)
+        return memo->value;
+
+    const auto& pe = report_field_property_evalutors[property_index];
+    if (pe.required_level != FetchLevel::NONE)
+        report_eval_report_field_resolve_level(t, pe.required_level);
+
+    expr_result_t value = pe.handler(t, t->stock);
+    report_expr_memo_insert(memo_key)->value = value;
+    return value;
+}
+
+FOUNDATION_STATIC void report_eval_report_field_titles(
+    report_t* report, string_const_t title_filter, uint32_t property_index, expr_result_t** results)
+{
+    const auto& pe = report_field_property_evalutors[property_index];
     foreach (pt, report->titles)
     {
         title_t* t = *pt;
@@ -272,22 +456,59 @@ FOUNDATION_STATIC bool report_eval_report_field_test(
         if (title_filter.length && !string_equal_nocase(STRING_ARGS(title_filter), t->code, t->code_length))
             continue;
 
-        if (required_level != FetchLevel::NONE)
-            report_eval_report_field_resolve_level(t, required_level);
-
-        expr_result_t value = property_evalutor(t, t->stock);
+        expr_result_t value = report_eval_title_field(t, property_index);
         expr_result_t symbol_code(string_const(t->code, t->code_length));
-        if (title_filter.length || !property_filter_out || !property_filter_out(value))
+        if (title_filter.length || !pe.filter_out || !pe.filter_out(value))
         {
             const expr_result_t& kvp = expr_eval_pair(symbol_code, value);
-            array_push(*results, kvp);
+            expr_eval_list_push(*results, kvp);
         }
 
-        if (title_filter.length && string_equal_nocase(STRING_ARGS(title_filter), t->code, t->code_length))
-            return true;
+        if (title_filter.length)
+            return;
     }
+}
 
-    return true;
+FOUNDATION_STATIC expr_result_t report_expr_eval_stock_history(stock_handle_t& stock_handle, uint32_t eod_index)
+{
+    // Return all end of day results for the requested field name.
+    const auto& se = stock_end_of_day_property_evalutors[eod_index];
+    const stock_t* s = stock_handle;
+
+    expr_result_t* results = nullptr;
+    expr_eval_list_push(results, expr_eval_pair((double)s->current.date, se.handler(s, &s->current)));
+
+    const day_result_t* history = s->history;
+    foreach(d, history)
+    {
+        expr_eval_list_push(results, expr_eval_pair((double)d->date, se.handler(s, d)));
+    }
+
+    return expr_eval_list(results);
+}
+
+FOUNDATION_STATIC expr_result_t report_expr_eval_stock_at(stock_handle_t& stock_handle, uint32_t eod_index, time_t time)
+{
+    const auto& se = stock_end_of_day_property_evalutors[eod_index];
+    const stock_t* s = stock_handle;
+
+    if (time >= s->current.date)
+        return se.handler(s, &s->current);
+
+    // Find the closest date in the stock history
+    const day_result_t* history = s->history;
+    foreach(d, history)
+    {
+        if (d->date <= time)
+            return se.handler(s, d);
+    }
+
+    // Use the last date in the history if we didn't find a match
+    const day_result_t* last = array_last(history);
+    if (last)
+        return se.handler(s, last);
+
+    throw ExprError(EXPR_ERROR_EVALUATION_TIMEOUT, "Failed to resolve date %ull for %s", time, SYMBOL_CSTR(stock_handle->code));
 }
 
 FOUNDATION_STATIC expr_result_t report_expr_eval_stock(const expr_func_t* f, vec_expr_t* args, void* c)
@@ -304,116 +525,65 @@ FOUNDATION_STATIC expr_result_t report_expr_eval_stock(const expr_func_t* f, vec
     string_const_t code = expr_eval(args->get(0)).as_string();
     string_const_t field_name = expr_eval(args->get(1)).as_string();
     
-    stock_handle_t stock_handle = stock_request(STRING_ARGS(code), FetchLevel::REALTIME);
+    stock_handle_t stock_handle = report_expr_request_stock(code);
     if (!stock_handle)
         throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "Failed to resolve stock %.*s", STRING_FORMAT(code));
 
-    expr_result_t* results = nullptr;
-
     if (args->len == 2)
     {   
-        FOUNDATION_ASSERT(string_equal(CTEXT("price"), string_to_const(report_field_property_evalutors[STOCK_ONLY_PROPERTY_EVALUATOR_START_INDEX].property_name)));
         // Handle default case getting latest information
-        for (int i = STOCK_ONLY_PROPERTY_EVALUATOR_START_INDEX; i < ARRAY_COUNT(report_field_property_evalutors); ++i)
-        {
-            const auto& pe = report_field_property_evalutors[i];
-            if (report_eval_report_field_test(pe.property_name, stock_handle, field_name, pe.handler, pe.filter_out, &results, pe.required_level))
-                break;
-        }
+        FOUNDATION_ASSERT(string_equal(CTEXT("price"), string_to_const(report_field_property_evalutors[STOCK_ONLY_PROPERTY_EVALUATOR_START_INDEX].property_name)));
+        const int property_index = report_expr_find_property(_report_field_property_index, field_name);
+        if (property_index < (int)STOCK_ONLY_PROPERTY_EVALUATOR_START_INDEX)
+            return NIL;
 
-        if (results == nullptr)
+        expr_result_t value;
+        if (!report_eval_stock_field(stock_handle, property_index, value))
             return NIL;
 
-        if (array_size(results) == 1)
-        {
-            expr_result_t single_value = results[0];
-            array_deallocate(results);
-            return single_value.list[1];
-        }
+        const auto& pe = report_field_property_evalutors[property_index];
+        if (pe.filter_out && pe.filter_out(value))
+            return NIL;
 
-        return expr_eval_list(results);
+        return value;
     }
-    else
-    {
-        string_const_t check_all = expr_eval(args->get(2)).as_string();
-        if (string_equal_nocase(STRING_ARGS(check_all), STRING_CONST("ALL")))
-        {
-            // Return all end of day results for the requested field name.
-            expr_result_t* results = nullptr;
-            const stock_t* s = stock_handle;
-            for (int i = 0; i < ARRAY_COUNT(stock_end_of_day_property_evalutors); ++i)
-            {
-                const auto& se = stock_end_of_day_property_evalutors[i];
-
-                if (!string_equal_nocase(STRING_ARGS(field_name), STRING_ARGS(se.property_name)))
-                    continue;
 
-                if (!report_eval_report_field_resolve_level(stock_handle, se.required_level))
-                    throw ExprError(EXPR_ERROR_EVALUATION_TIMEOUT, "Failed to resolve %s stock history data", SYMBOL_CSTR(stock_handle->code));
+    const int eod_index = report_expr_find_property(_stock_end_of_day_property_index, field_name);
+    if (eod_index < 0)
+        throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "Invalid field name %.*s", STRING_FORMAT(field_name));
 
-                array_push(results, expr_eval_pair((double)s->current.date, se.handler(s, &s->current)));
-                
-                // Find the closest date in the stock history
-                const day_result_t* history = s->history;
-                foreach(d, history)
-                {
-                    array_push(results, expr_eval_pair((double)d->date, se.handler(s, d)));
-                }
-
-                return expr_eval_list(results);
-            }
-        }
-        else
-        {
-            // Query the stock data at a given date.        
-            // First, get the date either as a string or a unix time stamp
-            time_t time = 0;
-            expr_result_t date_arg = expr_eval(args->get(2));
-            if (date_arg.type == EXPR_RESULT_SYMBOL)
-            {
-                string_const_t date_string = date_arg.as_string();
-                time = string_to_date(STRING_ARGS(date_string));
-            }
-            else
-            {
-                time = (time_t)date_arg.as_number(0);
-            }
-
-            if (time == 0)
-                throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "Failed to parse date argument `%.*s`", STRING_FORMAT(args->get(2)->token));
-
-            const stock_t* s = stock_handle;
-            for (int i = 0; i < ARRAY_COUNT(stock_end_of_day_property_evalutors); ++i)
-            {
-                const auto& se = stock_end_of_day_property_evalutors[i];
-
-                if (!string_equal_nocase(STRING_ARGS(field_name), STRING_ARGS(se.property_name)))
-                    continue;
-
-                if (!report_eval_report_field_resolve_level(stock_handle, se.required_level))
-                    throw ExprError(EXPR_ERROR_EVALUATION_TIMEOUT, "Failed to resolve %s stock history data", SYMBOL_CSTR(stock_handle->code));
+    // Query the stock data at a given date, or all dates if ALL is specified.
+    // First, get the date either as a string or a unix time stamp
+    time_t time = REPORT_EXPR_MEMO_ALL_DATES;
+    expr_result_t date_arg = expr_eval(args->get(2));
+    if (date_arg.type == EXPR_RESULT_SYMBOL)
+    {
+        string_const_t date_string = date_arg.as_string();
+        if (!string_equal_nocase(STRING_ARGS(date_string), STRING_CONST("ALL")))
+            time = string_to_date(STRING_ARGS(date_string));
+    }
+    else
+    {
+        time = (time_t)date_arg.as_number(0);
+    }
 
-                if (time >= s->current.date)
-                    return se.handler(s, &s->current);
+    if (time == 0)
+        throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "Failed to parse date argument `%.*s`", STRING_FORMAT(args->get(2)->token));
 
-                // Find the closest date in the stock history
-                const day_result_t* history = s->history;
-                foreach(d, history)
-                {
-                    if (d->date <= time)
-                        return se.handler(s, d);
-                }
+    const hash_t memo_key = report_expr_memo_key(nullptr, stock_handle.id, REPORT_EXPR_MEMO_EOD_PROPERTY | eod_index, time);
+    const report_expr_memo_entry_t* memo = report_expr_memo_find(memo_key);
+    if (memo)
+        return memo->value;
 
-                // Use the last date in the history if we didn't find a match
-                if (d)
-                    return se.handler(s, d);
+    const auto& se = stock_end_of_day_property_evalutors[eod_index];
+    if (!report_eval_report_field_resolve_level(stock_handle, se.required_level))
+        throw ExprError(EXPR_ERROR_EVALUATION_TIMEOUT, "Failed to resolve %s stock history data", SYMBOL_CSTR(stock_handle->code));
 
-                throw ExprError(EXPR_ERROR_EVALUATION_TIMEOUT, "Failed to resolve date %ull for %s", time, SYMBOL_CSTR(stock_handle->code));
-            }
-        }
-    }
-
-    throw ExprError(EXPR_ERROR_INVALID_ARGUMENT, "Invalid field name %.*s", STRING_FORMAT(field_name));
+    expr_result_t value = time == REPORT_EXPR_MEMO_ALL_DATES ? 
+        report_expr_eval_stock_history(stock_handle, eod_index) : 
+        report_expr_eval_stock_at(stock_handle, eod_index, time);
+    report_expr_memo_insert(memo_key)->value = value;
+    return value;
 }
 
 FOUNDATION_STATIC expr_result_t report_expr_eval_stock_fundamental(const json_object_t& json)
@@ -457,7 +627,7 @@ FOUNDATION_STATIC expr_result_t report_expr_eval_stock_fundamental(const json_ob
         for (auto e : json)
         {
             expr_result_t r = report_expr_eval_stock_fundamental(e);
-            array_push(results, r);
+            expr_eval_list_push(results, r);
         }
 
         return expr_eval_list(results);
@@ -472,9 +642,9 @@ FOUNDATION_STATIC expr_result_t report_expr_eval_stock_fundamental(const json_ob
 
             string_const_t id = e.id();
             expr_result_t r = report_expr_eval_stock_fundamental(e);
-            array_push(kvp, expr_result_t(id));
-            array_push(kvp, r);
-            array_push(results, expr_eval_list(kvp));
+            expr_eval_list_push(kvp, expr_result_t(id));
+            expr_eval_list_push(kvp, r);
+            expr_eval_list_push(results, expr_eval_list(kvp));
         }
         return expr_eval_list(results);
     }
@@ -579,10 +749,10 @@ FOUNDATION_STATIC expr_result_t report_eval_report_field(const expr_func_t* f, v
             const bool active = title_active(title);
             const double price = title_current_price(title);
             
-            array_push(kvp, expr_result_t(string_const(title->code, title->code_length)));
-            array_push(kvp, expr_result_t(price));
-            array_push(kvp, expr_result_t(active));
-            array_push(titles, expr_eval_list(kvp));
+            expr_eval_list_push(kvp, expr_result_t(string_const(title->code, title->code_length)));
+            expr_eval_list_push(kvp, expr_result_t(price));
+            expr_eval_list_push(kvp, expr_result_t(active));
+            expr_eval_list_push(titles, expr_eval_list(kvp));
         }
 
         return expr_eval_list(titles);
@@ -599,12 +769,15 @@ FOUNDATION_STATIC expr_result_t report_eval_report_field(const expr_func_t* f, v
         field_name_index = 2;
     }
 
-    tick_t s = time_current();
-    while (title_filter.length == 0 && !report_sync_titles(report))
     {
-        if (time_elapsed(s) > 30.0f)
-            throw ExprError(EXPR_ERROR_EVALUATION_TIMEOUT, "Sync timeout, retry later...", STRING_FORMAT(report_name));
-        dispatcher_wait_for_wakeup_main_thread(100);
+        ExprProfileWaitScope profile_wait;
+        tick_t s = time_current();
+        while (title_filter.length == 0 && !report_sync_titles(report))
+        {
+            if (time_elapsed(s) > 30.0f)
+                throw ExprError(EXPR_ERROR_EVALUATION_TIMEOUT, "Sync timeout, retry later...", STRING_FORMAT(report_name));
+            dispatcher_wait_for_wakeup_main_thread(100);
+        }
     }
 
     expr_result_t* results = nullptr;
@@ -624,7 +797,7 @@ FOUNDATION_STATIC expr_result_t report_eval_report_field(const expr_func_t* f, v
 
             expr_result_t* title_results = nullptr;    
             expr_result_t title_code_expr(string_const(t->code, t->code_length));
-            array_push(title_results, title_code_expr);
+            expr_eval_list_push(title_results, title_code_expr);
             for (int i = 0; i < field_expr->args.len; ++i)
             {
                 expr_t* fe = field_expr->args.get(i);
@@ -648,45 +821,29 @@ FOUNDATION_STATIC expr_result_t report_eval_report_field(const expr_func_t* f, v
                 if (fe_result.type == EXPR_RESULT_SYMBOL)
                 {
                     string_const_t field_name = fe_result.as_string();
-                    for (int i = 0; i < ARRAY_COUNT(report_field_property_evalutors); ++i)
+                    const int property_index = report_expr_find_property(_report_field_property_index, field_name);
+                    if (property_index >= 0)
                     {
-                        const auto& pe = report_field_property_evalutors[i];
-
-                        if (!string_equal_nocase(STRING_ARGS(field_name), STRING_LENGTH(pe.property_name)))
-                            continue;
-
-                        if (pe.required_level != FetchLevel::NONE)
-                            report_eval_report_field_resolve_level(t, pe.required_level);
-
                         const stock_t* s = t->stock;
                         if (s)
-                        {
-                            expr_result_t value = pe.handler(t, t->stock);
-                            array_push(title_results, value);
-                        }
+                            expr_eval_list_push(title_results, report_eval_title_field(t, property_index));
                         else
-                        {
-                            array_push(title_results, NIL);
-                        }
+                            expr_eval_list_push(title_results, NIL);
 
                         was_evaluated = true;
                     }
                 }
 
                 if (!was_evaluated)
-                    array_push(title_results, fe_result);
+                    expr_eval_list_push(title_results, fe_result);
             }
 
             expr_result_t title_result_list = expr_eval_list(title_results);
-            array_push(results, title_result_list);
+            expr_eval_list_push(results, title_result_list);
         }
 
         if (array_size(results) == 1)
-        {
-            expr_result_t single_value = results[0];
-            array_deallocate(results);
-            return single_value.list[1];
-        }
+            return results[0].list[1];
     }
     else
     {
@@ -715,35 +872,28 @@ FOUNDATION_STATIC expr_result_t report_eval_report_field(const expr_func_t* f, v
                     const double price = cv["price"].as_number();
 
                     expr_result_t* title_field_values = nullptr;
-                    array_push(title_field_values, expr_result_t(datestr));
-                    array_push(title_field_values, expr_result_t((double)date));
-                    array_push(title_field_values, expr_result_t(buy_or_sell));
-                    array_push(title_field_values, expr_result_t(qty));
-                    array_push(title_field_values, expr_result_t(price));
+                    expr_eval_list_push(title_field_values, expr_result_t(datestr));
+                    expr_eval_list_push(title_field_values, expr_result_t((double)date));
+                    expr_eval_list_push(title_field_values, expr_result_t(buy_or_sell));
+                    expr_eval_list_push(title_field_values, expr_result_t(qty));
+                    expr_eval_list_push(title_field_values, expr_result_t(price));
 
-                    array_push(results, expr_eval_list(title_field_values));
+                    expr_eval_list_push(results, expr_eval_list(title_field_values));
                 }
             }
         }
         else
         {
             // Evaluate the field for the given title
-            for (int i = 0; i < ARRAY_COUNT(report_field_property_evalutors); ++i)
-            {
-                const auto& pe = report_field_property_evalutors[i];
-                if (report_eval_report_field_test(pe.property_name, report, title_filter, field_name, pe.handler, pe.filter_out, &results, pe.required_level))
-                    break;
-            }
+            const int property_index = report_expr_find_property(_report_field_property_index, field_name);
+            if (property_index >= 0)
+                report_eval_report_field_titles(report, title_filter, property_index, &results);
 
             if (results == nullptr)
                 throw ExprError(EXPR_ERROR_EVALUATION_NOT_IMPLEMENTED, "Field %.*s not supported", STRING_FORMAT(field_name));
 
             if (array_size(results) == 1)
-            {
-                expr_result_t single_value = results[0];
-                array_deallocate(results);
-                return single_value.list[1];
-            }
+                return results[0].list[1];
         }
     }
 
@@ -811,6 +961,16 @@ FOUNDATION_STATIC expr_result_t report_eval_list_fields(const expr_func_t* f, ve
 
 FOUNDATION_STATIC void report_expr_initialize()
 {
+    const char* property_names[ARRAY_COUNT(report_field_property_evalutors)];
+    for (int i = 0; i < ARRAY_COUNT(report_field_property_evalutors); ++i)
+        property_names[i] = report_field_property_evalutors[i].property_name;
+    _report_field_property_index = report_expr_build_property_index(property_names, ARRAY_COUNT(property_names));
+
+    const char* eod_property_names[ARRAY_COUNT(stock_end_of_day_property_evalutors)];
+    for (int i = 0; i < ARRAY_COUNT(stock_end_of_day_property_evalutors); ++i)
+        eod_property_names[i] = stock_end_of_day_property_evalutors[i].property_name.str;
+    _stock_end_of_day_property_index = report_expr_build_property_index(eod_property_names, ARRAY_COUNT(eod_property_names));
+
     expr_register_function("S", report_expr_eval_stock);
     expr_register_function("STOCK", report_expr_eval_stock);
     expr_register_function("EOD", report_expr_eval_stock);
@@ -824,7 +984,8 @@ FOUNDATION_STATIC void report_expr_initialize()
 
 FOUNDATION_STATIC void report_expr_shutdown()
 {
-    
+    array_deallocate(_stock_end_of_day_property_index);
+    array_deallocate(_report_field_property_index);
 }
 
 DEFINE_MODULE(REPORT_EXPRESSION, report_expr_initialize, report_expr_shutdown, MODULE_PRIORITY_MODULE);
@@ -197,6 +197,7 @@ FOUNDATION_STATIC table_cell_t report_order_column_date(table_element_ptr_t elem
             odate = mktime(&tm_date);
             date_str = string_from_date(odate);
             config_set(order->data, STRING_CONST("date"), STRING_ARGS(date_str));
+            title_invalidate_orders(order->title);
             title_refresh(order->title);
         }
     }
@@ -216,6 +217,7 @@ FOUNDATION_STATIC table_cell_t report_order_column_quantity(table_element_ptr_t
         if (ImGui::InputDouble("##Quantity", &quantity, 10.0f, 100.0f, "%.0lf", ImGuiInputTextFlags_None))
         {
             config_set(order->data, STRING_CONST("qty"), quantity);
+            title_invalidate_orders(order->title);
             title_refresh(order->title);
             report_trigger_update(order->report);
         }
@@ -243,6 +245,7 @@ FOUNDATION_STATIC table_cell_t report_order_column_exchange_rate(table_element_p
         if (ImGui::InputDouble("##ExchangeRate", &order->exchange_rate, 0.01f, 0.1f, "%.2lf $", ImGuiInputTextFlags_None))
         {
             config_set(order->data, STRING_CONST("xcg"), order->exchange_rate);
+            title_invalidate_orders(order->title);
             title_refresh(order->title);
             report_trigger_update(order->report);
         }
@@ -294,6 +297,7 @@ FOUNDATION_STATIC table_cell_t report_order_column_split_price(table_element_ptr
         if (ImGui::InputDouble("##SplitFactor", &order->split_factor, 1.0f, 10.0f, "%.3lg", ImGuiInputTextFlags_None))
         {
             config_set(order->data, STRING_CONST("split"), order->split_factor);
+            title_invalidate_orders(order->title);
             title_refresh(order->title);
             report_trigger_update(order->report);
         }
@@ -350,6 +354,7 @@ FOUNDATION_STATIC table_cell_t report_order_column_price(table_element_ptr_t ele
             math_real_is_nan(price) ? "-" : (price < 0.5 ? "%.4lg $" : "%.2lf $"), ImGuiInputTextFlags_None))
         {
             config_set(order->data, STRING_CONST("price"), price);
+            title_invalidate_orders(order->title);
             title_refresh(order->title);
             report_trigger_update(order->report);
         }
@@ -372,6 +377,7 @@ FOUNDATION_STATIC table_cell_t report_order_column_ask_price(table_element_ptr_t
             math_real_is_nan(price) ? "-" : (price < 0.5 ? "%.3lf $" : "%.2lf $"), ImGuiInputTextFlags_None))
         {
             config_set(order->data, STRING_CONST("ask"), price);
+            title_invalidate_orders(order->title);
             title_refresh(order->title);
         }
     }
@@ -401,6 +407,7 @@ FOUNDATION_STATIC table_cell_t report_order_column_actions(table_element_ptr_t e
             if (config_remove(corders, order->data))
             {
                 order->deleted = true;
+                title_invalidate_orders(order->title);
                 title_refresh(order->title);
                 report_trigger_update(order->report);
             }
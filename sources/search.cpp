@@ -969,6 +969,8 @@ FOUNDATION_STATIC void search_window_clear_results(search_window_t* sw)
         }
         array_clear(sw->results);
     }
+
+    table_invalidate(sw->table);
 }
 
 FOUNDATION_STATIC void search_window_execute_query(search_window_t* sw, const char* search_text, size_t search_text_length)
@@ -1565,7 +1567,7 @@ FOUNDATION_STATIC void search_table_contextual_menu(table_element_ptr_const_t el
 
 FOUNDATION_STATIC table_t* search_create_table()
 {
-    table_t* table = table_allocate("QuickSearch##15", TABLE_HIGHLIGHT_HOVERED_ROW | TABLE_LOCALIZATION_CONTENT);
+    table_t* table = table_allocate("QuickSearch##15", TABLE_HIGHLIGHT_HOVERED_ROW | TABLE_LOCALIZATION_CONTENT | TABLE_CACHE_CELLS);
     table->context_menu = search_table_contextual_menu;
 
     table_add_column(table, search_table_column_symbol, "Symbol", COLUMN_FORMAT_TEXT, COLUMN_SORTABLE | COLUMN_CUSTOM_DRAWING)
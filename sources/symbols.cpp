@@ -396,7 +396,7 @@ FOUNDATION_STATIC void symbol_code_selected(table_element_ptr_const_t element, c
 
 FOUNDATION_STATIC table_t* symbols_table_init(const char* name, function<void(string_const_t)> selector = nullptr)
 {
-    table_t* table = table_allocate(name, TABLE_HIGHLIGHT_HOVERED_ROW | TABLE_LOCALIZATION_CONTENT);
+    table_t* table = table_allocate(name, TABLE_HIGHLIGHT_HOVERED_ROW | TABLE_LOCALIZATION_CONTENT | TABLE_BACKGROUND_SORT | TABLE_SEARCH_INDEX);
 
     table->update = [](table_element_ptr_t element)->bool
     {
@@ -406,29 +406,13 @@ FOUNDATION_STATIC table_t* symbols_table_init(const char* name, function<void(st
         return stock_update(STRING_ARGS(code), symbol->stock, REQUIRED_FETCH_LEVEL);
     };
 
-    table->search = [](table_element_ptr_const_t element, const char* search_filter, size_t search_filter_length)->bool
+    table->search_keywords = [](table_element_ptr_const_t element, string_const_t*& keywords)
     {
-        if (search_filter_length == 0)
-            return true;
-
         const symbol_t* symbol = (const symbol_t*)element;
-        string_const_t code = string_table_decode_const(symbol->code);
-        if (string_contains_nocase(STRING_ARGS(code), search_filter, search_filter_length))
-            return true;
-
-        string_const_t name = string_table_decode_const(symbol->name);
-        if (string_contains_nocase(STRING_ARGS(name), search_filter, search_filter_length))
-            return true;
-
-        string_const_t country = string_table_decode_const(symbol->country);
-        if (string_contains_nocase(STRING_ARGS(country), search_filter, search_filter_length))
-            return true;
-
-        string_const_t type = string_table_decode_const(symbol->type);
-        if (string_contains_nocase(STRING_ARGS(type), search_filter, search_filter_length))
-            return true;
-
-        return false;
+        array_push(keywords, string_table_decode_const(symbol->code));
+        array_push(keywords, string_table_decode_const(symbol->name));
+        array_push(keywords, string_table_decode_const(symbol->country));
+        array_push(keywords, string_table_decode_const(symbol->type));
     };
 
     table->context_menu = [selector](table_element_ptr_const_t element, const table_column_t* column, const table_cell_t* cell)
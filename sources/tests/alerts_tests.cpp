@@ -0,0 +1,101 @@
+/*
+ * License: https://wiimag.com/LICENSE
+ * Copyright 2023 Wiimag Inc. All rights reserved.
+ */
+
+#include <framework/tests/test_utils.h>
+
+#if BUILD_TESTS
+
+#include <alerts.h>
+
+#include <foundation/hash.h>
+
+TEST_SUITE("Alerts")
+{
+    TEST_CASE("Evaluate alerts of updated symbols")
+    {
+        const hash_t symbol = hash(STRING_CONST("ALERTS.TEST"));
+        const hash_t other_symbol = hash(STRING_CONST("OTHER.TEST"));
+
+        REQUIRE(alerts_add(STRING_CONST("ALERTS.TEST"), STRING_CONST("True"), STRING_CONST("1 + 1 == 2")));
+        REQUIRE(alerts_add(STRING_CONST("ALERTS.TEST"), STRING_CONST("False"), STRING_CONST("1 + 1 == 3")));
+        CHECK_FALSE(alerts_add(STRING_CONST("ALERTS.TEST"), STRING_CONST("Duplicate"), STRING_CONST("1 + 1 == 2")));
+
+        // Alerts of other symbols are not evaluated
+        alerts_queue_symbols(&other_symbol, 1);
+        CHECK_EQ(alerts_evaluate_pending(100.0), 0);
+
+        // Alerts queued more than once are only evaluated once
+        alerts_queue_symbols(&symbol, 1);
+        alerts_queue_symbols(&symbol, 1);
+        CHECK_EQ(alerts_evaluate_pending(100.0), 2);
+        CHECK_EQ(alerts_evaluate_pending(100.0), 0);
+
+        CHECK(alerts_is_triggered(STRING_CONST("1 + 1 == 2")));
+        CHECK_FALSE(alerts_is_triggered(STRING_CONST("1 + 1 == 3")));
+
+        // Triggered alerts are not evaluated again
+        alerts_queue_symbols(&symbol, 1);
+        CHECK_EQ(alerts_evaluate_pending(100.0), 1);
+
+        CHECK(alerts_remove(STRING_CONST("1 + 1 == 2")));
+        CHECK(alerts_remove(STRING_CONST("1 + 1 == 3")));
+        CHECK_FALSE(alerts_remove(STRING_CONST("1 + 1 == 3")));
+    }
+
+    TEST_CASE("Spread evaluation over multiple calls")
+    {
+        const hash_t symbol = hash(STRING_CONST("SPREAD.TEST"));
+
+        REQUIRE(alerts_add(STRING_CONST("SPREAD.TEST"), STRING_CONST("A"), STRING_CONST("2 > 1")));
+        REQUIRE(alerts_add(STRING_CONST("SPREAD.TEST"), STRING_CONST("B"), STRING_CONST("3 > 1")));
+        REQUIRE(alerts_add(STRING_CONST("SPREAD.TEST"), STRING_CONST("C"), STRING_CONST("0 > 1")));
+
+        // Without any time budget, a single alert gets evaluated per call.
+        alerts_queue_symbols(&symbol, 1);
+        CHECK_EQ(alerts_evaluate_pending(0), 1);
+        CHECK_EQ(alerts_evaluate_pending(0), 1);
+        CHECK_EQ(alerts_evaluate_pending(0), 1);
+        CHECK_EQ(alerts_evaluate_pending(0), 0);
+
+        CHECK(alerts_is_triggered(STRING_CONST("2 > 1")));
+        CHECK(alerts_is_triggered(STRING_CONST("3 > 1")));
+        CHECK_FALSE(alerts_is_triggered(STRING_CONST("0 > 1")));
+
+        // Alerts that were removed while pending are not evaluated.
+        alerts_queue_symbols(&symbol, 1);
+        CHECK(alerts_remove(STRING_CONST("0 > 1")));
+        CHECK_EQ(alerts_evaluate_pending(100.0), 0);
+
+        CHECK(alerts_remove(STRING_CONST("2 > 1")));
+        CHECK(alerts_remove(STRING_CONST("3 > 1")));
+    }
+
+    TEST_CASE("Keep pending alerts when alerts change")
+    {
+        const hash_t symbol = hash(STRING_CONST("KEEP.TEST"));
+
+        REQUIRE(alerts_add(STRING_CONST("KEEP.TEST"), STRING_CONST("A"), STRING_CONST("4 > 1")));
+        REQUIRE(alerts_add(STRING_CONST("KEEP.TEST"), STRING_CONST("B"), STRING_CONST("5 > 1")));
+        REQUIRE(alerts_add(STRING_CONST("KEEP.TEST"), STRING_CONST("C"), STRING_CONST("6 > 1")));
+
+        alerts_queue_symbols(&symbol, 1);
+        CHECK_EQ(alerts_evaluate_pending(0), 1);
+
+        // Adding or removing alerts shifts the evaluators, but the remaining pending alerts still get evaluated.
+        REQUIRE(alerts_add(STRING_CONST("OTHER.TEST"), STRING_CONST("D"), STRING_CONST("7 > 1")));
+        CHECK(alerts_remove(STRING_CONST("4 > 1")));
+        CHECK_EQ(alerts_evaluate_pending(100.0), 2);
+
+        CHECK(alerts_is_triggered(STRING_CONST("5 > 1")));
+        CHECK(alerts_is_triggered(STRING_CONST("6 > 1")));
+        CHECK_FALSE(alerts_is_triggered(STRING_CONST("7 > 1")));
+
+        CHECK(alerts_remove(STRING_CONST("5 > 1")));
+        CHECK(alerts_remove(STRING_CONST("6 > 1")));
+        CHECK(alerts_remove(STRING_CONST("7 > 1")));
+    }
+}
+
+#endif // BUILD_TESTS
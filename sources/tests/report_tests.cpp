@@ -11,6 +11,12 @@
 #include <report.h>
 #include <wallet.h>
 
+#include <framework/expr.h>
+#include <framework/session.h>
+#include <framework/persistence.h>
+
+#include <foundation/fs.h>
+
 TEST_SUITE("Report")
 {
     TEST_CASE("Create")
@@ -27,6 +33,28 @@ TEST_SUITE("Report")
         report_deallocate(handle);
     }
 
+    TEST_CASE("Save & Delete")
+    {
+        string_t name = string_random(SHARED_BUFFER(16));
+        report_handle_t handle = report_allocate(STRING_ARGS(name));
+        report_t* report = report_get(handle);
+        REQUIRE(report != 0);
+
+        // The save is still pending when the report gets deleted.
+        report_save(report);
+
+        string_const_t report_id = string_from_uuid_static(report->id);
+        char report_file_path_buffer[BUILD_MAX_PATHLEN];
+        string_t report_file_path = session_get_user_file_path(STRING_BUFFER(report_file_path_buffer), 
+            STRING_ARGS(report_id), STRING_CONST("reports"), STRING_CONST(CONFIG_BINARY_FILE_EXTENSION), false);
+
+        report_deallocate(handle);
+
+        // The pending save must not write back the deleted report.
+        CHECK_EQ(persistence_flush(), 0);
+        CHECK_FALSE(fs_is_file(STRING_ARGS(report_file_path)));
+    }
+
     TEST_CASE("Buy & Sell Some")
     {
         string_t name = string_random(SHARED_BUFFER(16));
@@ -92,6 +120,32 @@ TEST_SUITE("Report")
         report_deallocate(handle);
     }
 
+    TEST_CASE("Fields Are Not Memoized Across Evaluations")
+    {
+        string_t name = string_random(SHARED_BUFFER(16));
+        report_handle_t handle = report_allocate(STRING_ARGS(name));
+        report_t* report = report_get(handle);
+        REQUIRE(report != 0);
+
+        title_t* title = report_add_title(report, STRING_CONST("SXP.TO"));
+        REQUIRE(title != 0);
+        report_title_buy(report, title, string_to_date(STRING_CONST("2023-06-14")), 5.0, 2.0);
+        CHECK(report_sync_titles(report));
+
+        // Compiled expressions can be evaluated many times without a top level eval.
+        string_const_t expression = string_format_static(STRING_CONST("R('%.*s', SXP.TO, qty)"), STRING_FORMAT(name));
+        expr_t* e = expr_parse(STRING_ARGS(expression));
+        REQUIRE(e != nullptr);
+        CHECK_EQ(expr_eval(e).as_number(), 5.0);
+
+        report_title_buy(report, title, string_to_date(STRING_CONST("2023-06-15")), 10.0, 1.0);
+        CHECK(report_sync_titles(report));
+        CHECK_EQ(expr_eval(e).as_number(), 15.0);
+
+        expr_destroy(e);
+        report_deallocate(handle);
+    }
+
     TEST_CASE("Buy, Split and Sell")
     {
         string_t name = string_random(SHARED_BUFFER(16));
@@ -161,6 +215,36 @@ TEST_SUITE("Report")
 
         report_deallocate(handle);
      }
+
+    TEST_CASE("Decoded Orders")
+    {
+        string_t name = string_random(SHARED_BUFFER(16));
+        report_handle_t handle = report_allocate(STRING_ARGS(name));
+        report_t* report = report_get(handle);
+
+        title_t* title = report_add_title(report, STRING_CONST("U.US"));
+        report_title_buy(report, title, string_to_date(STRING_CONST("2023-05-03")), 5.0, 2.0);
+        report_title_sell(report, title, string_to_date(STRING_CONST("2023-06-21")), 2.0, 3.0);
+
+        // New orders are decoded as they get added
+        CHECK_EQ(array_size(title->orders), 2);
+        CHECK_NE(title->orders[0].flags & TITLE_ORDER_BUY, 0);
+        CHECK_NE(title->orders[1].flags & TITLE_ORDER_SELL, 0);
+        CHECK_EQ(title->average_quantity, 3.0);
+        CHECK_EQ(title_first_transaction_date(title), string_to_date(STRING_CONST("2023-05-03")));
+        CHECK_EQ(title_last_transaction_date(title), string_to_date(STRING_CONST("2023-06-21")));
+
+        // Edited orders are only decoded again once invalidated
+        config_set(title->data["orders"][0U], STRING_CONST("qty"), 10.0);
+        title_init(title, title->wallet, title->data);
+        CHECK_EQ(title->average_quantity, 3.0);
+
+        title_invalidate_orders(title);
+        title_init(title, title->wallet, title->data);
+        CHECK_EQ(title->average_quantity, 8.0);
+
+        report_deallocate(handle);
+    }
 }
 
 #endif // BUILD_TESTS
@@ -0,0 +1,70 @@
+/*
+ * License: https://wiimag.com/LICENSE
+ * Copyright 2023 Wiimag Inc. All rights reserved.
+ */
+
+#include <framework/tests/test_utils.h>
+
+#if BUILD_TESTS
+
+#include <title.h>
+#include <report.h>
+#include <wallet.h>
+#include <timeline.h>
+
+#include <framework/array.h>
+
+FOUNDATION_STATIC void timeline_test_check_days(const timeline_day_totals_t* days, const timeline_day_totals_t* expected)
+{
+    REQUIRE_EQ(array_size(days), array_size(expected));
+    for (unsigned i = 0, end = array_size(days); i < end; ++i)
+    {
+        CHECK_EQ(days[i].date, expected[i].date);
+        CHECK_EQ(days[i].total_gain, doctest::Approx(expected[i].total_gain));
+        CHECK_EQ(days[i].total_dividends, doctest::Approx(expected[i].total_dividends));
+        CHECK_EQ(days[i].total_value, doctest::Approx(expected[i].total_value));
+        CHECK_EQ(days[i].total_fund, doctest::Approx(expected[i].total_fund));
+        CHECK_EQ(days[i].total_investment, doctest::Approx(expected[i].total_investment));
+    }
+}
+
+TEST_SUITE("Timeline")
+{
+    TEST_CASE("Incremental updates match a full rebuild")
+    {
+        string_t name = string_random(SHARED_BUFFER(16));
+        report_handle_t handle = report_allocate(STRING_ARGS(name));
+        report_t* report = report_get(handle);
+        REQUIRE(report != 0);
+
+        string_deallocate(report->wallet->preferred_currency.str);
+        report->wallet->preferred_currency = string_clone(STRING_CONST("CAD"));
+
+        title_t* title = report_add_title(report, STRING_CONST("SXP.TO"));
+        REQUIRE(title != 0);
+
+        report_title_buy(report, title, string_to_date(STRING_CONST("2023-01-16")), 10.0, 2.0);
+        timeline_day_totals_t* days = timeline_report_days(report, true);
+        REQUIRE_GT(array_size(days), 0);
+        array_deallocate(days);
+
+        // The first update appends days after the last transaction.
+        report_title_buy(report, title, string_to_date(STRING_CONST("2023-06-14")), 5.0, 2.5);
+        days = timeline_report_days(report);
+        CHECK_EQ(array_last(days)->total_investment, doctest::Approx(32.5));
+        array_deallocate(days);
+
+        // The second update restores the holdings of a checkpoint made by the previous updates.
+        report_title_sell(report, title, string_to_date(STRING_CONST("2023-03-15")), 4.0, 2.2);
+        days = timeline_report_days(report);
+
+        timeline_day_totals_t* rebuilt_days = timeline_report_days(report, true);
+        timeline_test_check_days(days, rebuilt_days);
+
+        array_deallocate(rebuilt_days);
+        array_deallocate(days);
+        report_deallocate(handle);
+    }
+}
+
+#endif // BUILD_TESTS
@@ -0,0 +1,82 @@
+/*
+ * License: https://wiimag.com/LICENSE
+ * Copyright 2023 Wiimag Inc. All rights reserved.
+ */
+
+#include <framework/tests/test_utils.h>
+
+#if BUILD_TESTS
+
+#include <watches.h>
+
+#include <framework/array.h>
+
+FOUNDATION_STATIC bool watches_test_has_dependency(const watch_point_t* point, watch_dependency_type_t type, const char* name, size_t length)
+{
+    const hash_t key = string_hash(name, length);
+    for (unsigned i = 0, end = array_size(point->dependencies); i < end; ++i)
+    {
+        if (point->dependencies[i].type == type && point->dependencies[i].key == key)
+            return true;
+    }
+
+    return false;
+}
+
+TEST_SUITE("Watches")
+{
+    TEST_CASE("Collect dependencies of expressions")
+    {
+        watch_context_t* context = watch_create(STRING_CONST("Dependencies"));
+        watch_point_add(context, STRING_CONST("a"), STRING_CONST("S(AAPL.US, close) + R('FLEX', MSFT.US, ps) + b * $X + S($TITLE, open)"), false, false);
+        REQUIRE_EQ(array_size(context->points), 1);
+
+        const watch_point_t* point = context->points;
+        CHECK(watches_test_has_dependency(point, WATCH_DEPENDENCY_STOCK, STRING_CONST("AAPL.US")));
+        CHECK(watches_test_has_dependency(point, WATCH_DEPENDENCY_STOCK, STRING_CONST("MSFT.US")));
+        CHECK(watches_test_has_dependency(point, WATCH_DEPENDENCY_STOCK, STRING_CONST("$TITLE")));
+        CHECK(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("$TITLE")));
+        CHECK(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("b")));
+        CHECK(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("$X")));
+
+        // Stock symbols, report names and field names are not variables or watch points.
+        CHECK_FALSE(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("AAPL.US")));
+        CHECK_FALSE(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("MSFT.US")));
+        CHECK_FALSE(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("close")));
+        CHECK_FALSE(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("ps")));
+        CHECK_FALSE(watches_test_has_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_CONST("open")));
+        CHECK_FALSE(watches_test_has_dependency(point, WATCH_DEPENDENCY_STOCK, STRING_CONST("b")));
+
+        watch_destroy(context);
+    }
+
+    TEST_CASE("Only evaluate invalidated watch points")
+    {
+        watch_context_t* context = watch_create(STRING_CONST("Updates"));
+        watch_set_variable(context, STRING_CONST("$X"), 2.0);
+        watch_point_add(context, STRING_CONST("x2"), STRING_CONST("$X * 2"), true, false);
+        watch_point_add(context, STRING_CONST("y"), STRING_CONST("x2 + 1"), true, false);
+        watch_point_add(context, STRING_CONST("z"), STRING_CONST("10"), true, false);
+        REQUIRE_EQ(array_size(context->points), 3);
+        CHECK_EQ(context->points[1].record.number, 5.0);
+
+        // Nothing changed since the watch points were added.
+        CHECK_EQ(watch_update(context), 0);
+
+        // Setting the same value does not invalidate anything.
+        watch_set_variable(context, STRING_CONST("$X"), 2.0);
+        CHECK_EQ(watch_update(context), 0);
+
+        // Only x2 and y depend on $X.
+        watch_set_variable(context, STRING_CONST("$X"), 3.0);
+        CHECK_EQ(watch_update(context), 2);
+        CHECK_EQ(context->points[0].record.number, 6.0);
+        CHECK_EQ(context->points[1].record.number, 7.0);
+        CHECK_EQ(context->points[2].record.number, 10.0);
+        CHECK_EQ(watch_update(context), 0);
+
+        watch_destroy(context);
+    }
+}
+
+#endif // BUILD_TESTS
@@ -15,9 +15,18 @@
 #include <framework/string.h>
 #include <framework/window.h>
 #include <framework/array.h>
+#include <framework/module.h>
+
+#include <foundation/uuid.h>
 
 #define HASH_TIMELINE static_hash_string("timeline", 8, 0x8982c42357327efeULL)
 
+/*! Number of days between holdings checkpoints, days in between only store the holdings they changed. */
+#define TIMELINE_CHECKPOINT_INTERVAL (32)
+
+/*! Number of seconds the exchange rates used to value holdings are kept before rebuilding the timeline. */
+#define TIMELINE_EXCHANGE_RATES_MAX_AGE (60 * 60)
+
 typedef enum class TimelineTransactionType
 {
     UNDEFINED = 0,
@@ -51,6 +60,8 @@ struct timeline_transaction_t
 
     double split_factor{ 1.0 };
     double adjusted_factor{ 1.0 };
+
+    int same_day_count{ 0 };
 };
 
 struct timeline_stock_t
@@ -65,7 +76,9 @@ struct timeline_stock_t
 struct timeline_t
 {
     time_t date{ 0 };
-    timeline_stock_t* stocks{ nullptr };
+
+    /*! Holdings changed by the day transactions, null for days without any transaction. */
+    timeline_stock_t* deltas{ nullptr };
     
     double total_gain{ 0 };
     double total_dividends{ 0 };
@@ -75,13 +88,38 @@ struct timeline_t
     double total_investment{ 0 };
 };
 
-struct timeline_report_t
+/*! Holdings at the start of a timeline day. */
+struct timeline_checkpoint_t
 {
-    timeline_t* days{ nullptr };
+    unsigned day{ 0 };
+    timeline_stock_t* stocks{ nullptr };
+};
+
+struct timeline_exchange_rate_t
+{
+    hash_t key{ 0 };
+    double rate{ 1.0 };
+};
+
+/*! Persistent report timeline, updated from the first day affected by transaction changes. */
+struct timeline_history_t
+{
+    uuid_t report_id{};
+    string_t preferred_currency{};
+
     timeline_transaction_t* transactions{ nullptr };
+    timeline_t* days{ nullptr };
+    timeline_checkpoint_t* checkpoints{ nullptr };
+
+    timeline_exchange_rate_t* exchange_rates{ nullptr };
+    time_t exchange_rates_time{ 0 };
+};
+
+struct timeline_report_t
+{
+    timeline_history_t* history{ nullptr };
     
     string_t title{};
-    string_const_t preferred_currency{};
 
     bool first_render{ true };
 };
@@ -92,6 +130,8 @@ struct timeline_plot_day_t
     const function<double(const timeline_t* day)>& fn;
 };
 
+static timeline_history_t** _timeline_histories = nullptr;
+
 //
 // # PRIVATE
 //
@@ -99,25 +139,81 @@ struct timeline_plot_day_t
 FOUNDATION_FORCEINLINE bool operator<(const timeline_stock_t& s, const hash_t& key) { return s.key < key; }
 FOUNDATION_FORCEINLINE bool operator>(const timeline_stock_t& s, const hash_t& key) { return s.key > key; }
 
+FOUNDATION_FORCEINLINE bool operator<(const timeline_exchange_rate_t& s, const hash_t& key) { return s.key < key; }
+FOUNDATION_FORCEINLINE bool operator>(const timeline_exchange_rate_t& s, const hash_t& key) { return s.key > key; }
+
 FOUNDATION_FORCEINLINE bool operator<(const timeline_t& s, const time_t& date) { return s.date < date; }
 FOUNDATION_FORCEINLINE bool operator>(const timeline_t& s, const time_t& date) { return s.date > date; }
 
 FOUNDATION_FORCEINLINE bool operator<(const timeline_transaction_t& s, const time_t& date) { return s.date < date; }
 FOUNDATION_FORCEINLINE bool operator>(const timeline_transaction_t& s, const time_t& date) { return s.date > date; }
 
-FOUNDATION_FORCEINLINE int timeline_transaction_same_day_count(timeline_transaction_t* transactions, hash_t code, time_t date)
+/*! Returns the index of the first element dated on or after the given date. */
+template<typename T>
+FOUNDATION_FORCEINLINE unsigned timeline_lower_bound(const T* elements, time_t date)
+{
+    unsigned first = 0;
+    for (unsigned count = array_size(elements); count > 0;)
+    {
+        const unsigned step = count / 2;
+        if (elements[first + step].date < date)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+    return first;
+}
+
+FOUNDATION_FORCEINLINE bool timeline_transaction_equal(const timeline_transaction_t& a, const timeline_transaction_t& b)
+{
+    return a.date == b.date && a.code_key == b.code_key && a.type == b.type && 
+        a.qty == b.qty && a.price == b.price && 
+        a.exchange_rate == b.exchange_rate && a.split_factor == b.split_factor;
+}
+
+/*! Looks for the same order in the previous transactions to reuse its end of day prices. */
+FOUNDATION_STATIC const timeline_transaction_t* timeline_find_previous_transaction(const timeline_transaction_t* previous, const timeline_transaction_t& t)
 {
-    int counter = 0;
-    foreach(t, transactions)
+    for (unsigned i = timeline_lower_bound(previous, t.date), end = array_size(previous); i < end && previous[i].date == t.date; ++i)
     {
-        if (t->code_key == code && t->date == date)
-            counter++;
+        const timeline_transaction_t& p = previous[i];
+        if (p.code_key == t.code_key && p.type == t.type && p.qty == t.qty && p.price == t.price)
+            return &p;
     }
 
-    return counter;
+    return nullptr;
+}
+
+/*! Counts transactions of the same title on the same day, used to order transactions of the same day. */
+FOUNDATION_STATIC void timeline_transactions_count_same_day(timeline_transaction_t* transactions)
+{
+    array_sort(transactions, [](const timeline_transaction_t& a, const timeline_transaction_t& b)
+    {
+        if (a.date != b.date)
+            return a.date < b.date ? -1 : 1;
+        if (a.code_key != b.code_key)
+            return a.code_key < b.code_key ? -1 : 1;
+        return 0;
+    });
+
+    for (unsigned i = 0, count = array_size(transactions); i < count;)
+    {
+        unsigned end = i + 1;
+        while (end < count && transactions[end].date == transactions[i].date && transactions[end].code_key == transactions[i].code_key)
+            ++end;
+
+        for (unsigned k = i; k < end; ++k)
+            transactions[k].same_day_count = (int)(end - i);
+        i = end;
+    }
 }
 
-FOUNDATION_STATIC timeline_transaction_t* timeline_report_compute_transactions(const report_t* report, string_const_t preferred_currency)
+FOUNDATION_STATIC timeline_transaction_t* timeline_report_compute_transactions(const report_t* report, string_const_t preferred_currency, const timeline_transaction_t* previous)
 {
     timeline_transaction_t* transactions = nullptr;
 
@@ -128,25 +224,20 @@ FOUNDATION_STATIC timeline_transaction_t* timeline_report_compute_transactions(c
 
         while (!title_is_resolved(t) && title_update(t, 10.0))
             dispatcher_wait_for_wakeup_main_thread(10000);
-                    
-        for (auto order : t->data["orders"])
+
+        // Use the title decoded orders rather than walking the title config orders again.
+        foreach(order, t->orders)
         {
-            string_const_t date_string = order["date"].as_string();
-            if (date_string.length == 0)
+            const time_t date = order->date;
+            if (date <= 0)
             {
                 log_warnf(HASH_TIMELINE, WARNING_INVALID_VALUE, STRING_CONST("Invalid %.*s date for order"), STRING_FORMAT(code));
                 continue;
             }
 
-            const time_t date = string_to_date(STRING_ARGS(date_string));
-            if (date <= 0)
-            {
-                log_warnf(HASH_TIMELINE, WARNING_INVALID_VALUE, STRING_CONST("Invalid %.*s date for order on %.*s"), STRING_FORMAT(code), STRING_FORMAT(date_string));
-                continue;
-            }
-            
-            const bool buy = order["buy"].as_boolean();
-            const bool sell = order["sell"].as_boolean();
+            string_const_t date_string = string_from_date(date);
+            const bool buy = (order->flags & TITLE_ORDER_BUY) != 0;
+            const bool sell = (order->flags & TITLE_ORDER_SELL) != 0;
             
             if (buy == sell)
             {
@@ -154,14 +245,14 @@ FOUNDATION_STATIC timeline_transaction_t* timeline_report_compute_transactions(c
                 continue;
             }
             
-            const double qty = order["qty"].as_number(0);
-            if (qty <= 0)
+            const double qty = order->qty;
+            if (!math_real_is_finite(qty) || qty <= 0)
             {
                 log_warnf(HASH_TIMELINE, WARNING_INVALID_VALUE, STRING_CONST("Invalid %.*s quantity for order on %.*s"), STRING_FORMAT(code), STRING_FORMAT(date_string));
                 continue;
             }
                 
-            const double price = order["price"].as_number();
+            const double price = order->price;
             if (!math_real_is_finite(price))
             {
                 log_warnf(HASH_TIMELINE, WARNING_INVALID_VALUE, STRING_CONST("Invalid %.*s price for order on %.*s"), STRING_FORMAT(code), STRING_FORMAT(date_string));
@@ -177,28 +268,38 @@ FOUNDATION_STATIC timeline_transaction_t* timeline_report_compute_transactions(c
             transaction.price = price;
             transaction.type = buy ? TimelineTransactionType::BUY : TimelineTransactionType::SELL;
 
-            day_result_t ed = stock_get_eod(STRING_ARGS(code), date);
-            transaction.close = ed.close;
-            transaction.adjusted_close = ed.adjusted_close;
+            const timeline_transaction_t* previous_transaction = timeline_find_previous_transaction(previous, transaction);
+            if (previous_transaction)
+            {
+                transaction.close = previous_transaction->close;
+                transaction.adjusted_close = previous_transaction->adjusted_close;
+            }
+            else
+            {
+                day_result_t ed = stock_get_eod(STRING_ARGS(code), date);
+                transaction.close = ed.close;
+                transaction.adjusted_close = ed.adjusted_close;
+            }
             
-            transaction.exchange_rate = order["xcg"].as_number();
-            if (math_real_is_nan(transaction.exchange_rate))
+            transaction.exchange_rate = order->exchange_rate;
+            if (order->flags & TITLE_ORDER_EXCHANGE_RATE_UNRESOLVED)
             {
                 string_const_t title_currency = SYMBOL_CONST(t->stock->currency);
                 transaction.exchange_rate = stock_exchange_rate(STRING_ARGS(title_currency), STRING_ARGS(preferred_currency), date);
             }
 
-            transaction.split_factor = order["split"].as_number();
-            if (math_real_is_nan(transaction.split_factor))
+            transaction.split_factor = order->split_factor;
+            if (order->flags & TITLE_ORDER_SPLIT_UNRESOLVED)
                 transaction.split_factor = stock_get_split_factor(STRING_ARGS(code), date);
-            transaction.split_close = ed.close * transaction.split_factor;
+            transaction.split_close = transaction.close * transaction.split_factor;
             transaction.adjusted_factor = transaction.adjusted_close / transaction.split_close;
 
             array_push(transactions, transaction);
         }
     }
 
-    transactions = array_sort(transactions, [transactions](const timeline_transaction_t& a, const timeline_transaction_t& b)
+    timeline_transactions_count_same_day(transactions);
+    transactions = array_sort(transactions, [](const timeline_transaction_t& a, const timeline_transaction_t& b)
     {
         if (a.date < b.date)
             return -1;
@@ -206,8 +307,8 @@ FOUNDATION_STATIC timeline_transaction_t* timeline_report_compute_transactions(c
         if (a.date > b.date)
             return 1;
 
-        int ca = timeline_transaction_same_day_count(transactions, a.code_key, a.date);
-        int cb = timeline_transaction_same_day_count(transactions, b.code_key, a.date);
+        const int ca = a.same_day_count;
+        const int cb = b.same_day_count;
 
         if (ca < cb)
             return -1;
@@ -248,54 +349,164 @@ FOUNDATION_STATIC int timeline_add_new_stock(const timeline_transaction_t* t, ti
     s.qty = 0;
     s.total_value = 0;
     s.average_price = 0;
-    s.code = string_const(t->code, string_length(t->code));
+    s.code = SYMBOL_CONST(string_table_encode(t->code, string_length(t->code)));
 
     array_insert(stocks, insert_at, s);
     return insert_at;
 }
 
-FOUNDATION_STATIC double timeline_compute_day_total_value(const timeline_stock_t* stocks, time_t at, string_const_t preferred_currency)
+/*! Sets the holding of a stock, keeping the holdings sorted by stock key. */
+FOUNDATION_STATIC void timeline_set_stock(timeline_stock_t*& stocks, const timeline_stock_t& stock)
 {
-    double total_value = 0;
-    foreach(s, stocks)
-    {
-        const day_result_t ed = stock_get_eod(STRING_ARGS(s->code), at);
-        
-        string_const_t stock_currency = stock_get_currency(STRING_ARGS(s->code));
-        const double that_day_exchange_rate = stock_exchange_rate(STRING_ARGS(stock_currency), STRING_ARGS(preferred_currency));
-
-        const double investment_value = s->qty * s->average_price;
-        const double current_value = s->qty * ed.close * that_day_exchange_rate;
+    int sidx = array_binary_search(stocks, array_size(stocks), stock.key);
+    if (sidx >= 0)
+        stocks[sidx] = stock;
+    else
+        array_insert(stocks, ~sidx, stock);
+}
 
-        #if BUILD_DEBUG
-        const double idiff = math_abs(investment_value - s->total_value);
-        if (idiff > 0.001)
+/*! Removes the stocks that are not held anymore at the start of a new day. */
+FOUNDATION_STATIC void timeline_prune_stocks(timeline_stock_t*& stocks, time_t date)
+{
+    for (unsigned i = 0; i < array_size(stocks);)
+    {
+        if (stocks[i].qty > 0)
         {
-            log_warnf(HASH_TIMELINE, WARNING_SUSPICIOUS,
-                STRING_CONST("Compare investment and stock total value: %.2lf <> %.2lf"),
-                investment_value, s->total_value);
+            ++i;
+            continue;
         }
+
+        #if BUILD_DEBUG
+        string_const_t date_string = string_from_date(date);
+        log_debugf(HASH_TIMELINE, STRING_CONST("\t\t\t\t  Disposing of %.*s on %.*s"), STRING_FORMAT(stocks[i].code), STRING_FORMAT(date_string));
         #endif
+        array_erase_ordered_safe(stocks, i);
+    }
+}
 
-        total_value += current_value;
-        FOUNDATION_ASSERT(math_real_is_finite(total_value));
+/*! Returns the current exchange rate of a stock currency, fetched once per timeline history. */
+FOUNDATION_STATIC double timeline_stock_exchange_rate(timeline_history_t* history, const timeline_stock_t& s)
+{
+    int ridx = array_binary_search(history->exchange_rates, array_size(history->exchange_rates), s.key);
+    if (ridx >= 0)
+        return history->exchange_rates[ridx].rate;
+
+    string_const_t stock_currency = stock_get_currency(STRING_ARGS(s.code));
+    timeline_exchange_rate_t rate;
+    rate.key = s.key;
+    rate.rate = stock_exchange_rate(STRING_ARGS(stock_currency), STRING_ARGS(history->preferred_currency));
+    array_insert(history->exchange_rates, ~ridx, rate);
+    return rate.rate;
+}
+
+/*! Fills the end of day close prices of a stock for each timeline day, walking the stock history once. */
+FOUNDATION_STATIC void timeline_stock_price_series(const timeline_stock_t& s, const timeline_t* days, unsigned day_count, double* prices)
+{
+    const stock_t* stock = stock_request(STRING_ARGS(s.code), FetchLevel::EOD);
+    if (stock)
+    {
+        while (!stock->has_resolve(FetchLevel::EOD))
+            dispatcher_wait_for_wakeup_main_thread();
     }
 
-    return total_value;
+    const day_result_t* history = stock ? stock->history : nullptr;
+    const size_t history_count = stock ? stock->history_count : 0;
+    if (history == nullptr || history_count == 0)
+    {
+        for (unsigned d = 0; d < day_count; ++d)
+            prices[d] = DNAN;
+        return;
+    }
+
+    // Stock history is sorted from the most recent day, so we move toward the recent days 
+    // as the timeline days advance, the same way #stock_get_EOD would pick them.
+    constexpr const time_t ONE_DAY = time_one_day();
+    size_t hidx = history_count;
+    for (unsigned d = 0; d < day_count; ++d)
+    {
+        const time_t day_trunc = days[d].date / ONE_DAY;
+        while (hidx > 0 && history[hidx - 1].date / ONE_DAY <= day_trunc)
+            --hidx;
+
+        prices[d] = hidx < history_count ? history[hidx].close : history[history_count - 1].close;
+    }
 }
 
-FOUNDATION_STATIC void timeline_day_update_total_value(timeline_t& day, string_const_t preferred_currency)
+/*! Values the holdings of each day starting at the given day.
+ *
+ *  Every stock held over these days is resolved once to a quantity and a price series aligned 
+ *  on the timeline days and the day values are accumulated as quantity x price x rate.
+ */
+FOUNDATION_STATIC void timeline_history_value_days(timeline_history_t* history, unsigned first_day, const timeline_stock_t* holdings)
 {
-    day.total_value = timeline_compute_day_total_value(day.stocks, day.date, preferred_currency);
+    const unsigned total_day_count = array_size(history->days);
+    if (first_day >= total_day_count)
+        return;
+
+    timeline_t* days = history->days + first_day;
+    const unsigned day_count = total_day_count - first_day;
+
+    timeline_stock_t* columns = nullptr;
+    array_copy(columns, holdings);
+    for (unsigned d = 0; d < day_count; ++d)
+    {
+        foreach(s, days[d].deltas)
+        {
+            int sidx = array_binary_search(columns, array_size(columns), s->key);
+            if (sidx < 0)
+                array_insert(columns, ~sidx, *s);
+        }
+    }
+
+    const unsigned column_count = array_size(columns);
+    double* quantities = nullptr;
+    double* prices = nullptr;
+    double* values = nullptr;
+    array_resize(quantities, day_count);
+    array_resize(prices, day_count);
+    array_resize(values, day_count);
+    memset(values, 0, sizeof(double) * day_count);
+
+    for (unsigned c = 0; c < column_count; ++c)
+    {
+        const timeline_stock_t& column = columns[c];
+
+        int hidx = array_binary_search(holdings, array_size(holdings), column.key);
+        double qty = hidx >= 0 ? holdings[hidx].qty : 0;
+        for (unsigned d = 0; d < day_count; ++d)
+        {
+            int didx = array_binary_search(days[d].deltas, array_size(days[d].deltas), column.key);
+            if (didx >= 0)
+                qty = days[d].deltas[didx].qty;
+            quantities[d] = qty;
+        }
+
+        timeline_stock_price_series(column, days, day_count, prices);
+
+        const double rate = timeline_stock_exchange_rate(history, column);
+        for (unsigned d = 0; d < day_count; ++d)
+            values[d] += quantities[d] > 0 ? quantities[d] * prices[d] * rate : 0;
+    }
+
+    for (unsigned d = 0; d < day_count; ++d)
+    {
+        days[d].total_value = values[d];
+        FOUNDATION_ASSERT(math_real_is_finite(days[d].total_value));
+    }
+
+    array_deallocate(values);
+    array_deallocate(prices);
+    array_deallocate(quantities);
+    array_deallocate(columns);
 }
 
-FOUNDATION_STATIC void timeline_update_day(timeline_t& day, const timeline_transaction_t* t, string_const_t preferred_currency)
+FOUNDATION_STATIC void timeline_update_day(timeline_t& day, timeline_stock_t*& stocks, const timeline_transaction_t* t)
 {
-    int sidx = array_binary_search(day.stocks, array_size(day.stocks), t->code_key);
+    int sidx = array_binary_search(stocks, array_size(stocks), t->code_key);
     if (sidx < 0)
-        sidx = timeline_add_new_stock(t, day.stocks, ~sidx);
+        sidx = timeline_add_new_stock(t, stocks, ~sidx);
 
-    timeline_stock_t& s = day.stocks[sidx];
+    timeline_stock_t& s = stocks[sidx];
 
     if (t->type == TimelineTransactionType::BUY)
     {
@@ -353,125 +564,250 @@ FOUNDATION_STATIC void timeline_update_day(timeline_t& day, const timeline_trans
         FOUNDATION_ASSERT_FAIL("Transaction type not supported");
     }
 
-    timeline_day_update_total_value(day, preferred_currency);
+    // Only keep the holdings changed by the day transactions.
+    timeline_set_stock(day.deltas, s);
 }
 
-FOUNDATION_STATIC int timeline_add_new_day(const timeline_transaction_t* t, timeline_t*& days, int insert_at)
+/*! Releases the days starting at the given day and the checkpoints that are no longer valid. */
+FOUNDATION_STATIC void timeline_history_truncate(timeline_history_t* history, unsigned day_count)
 {
-    FOUNDATION_ASSERT(t);
-    FOUNDATION_ASSERT(insert_at >= 0);
+    for (unsigned i = day_count, end = array_size(history->days); i < end; ++i)
+        array_deallocate(history->days[i].deltas);
+    if (day_count < array_size(history->days))
+        array_resize(history->days, day_count);
 
-    timeline_t* previous_day = array_last(days);
+    while (array_size(history->checkpoints) > 0 && array_last(history->checkpoints)->day >= day_count)
+    {
+        array_deallocate(array_last(history->checkpoints)->stocks);
+        array_pop(history->checkpoints);
+    }
+}
 
-    timeline_t day;
-    day.date = t->date;
-    day.stocks = nullptr;
+/*! Restores the holdings at the end of the history days, from the last checkpoint and the following day deltas. */
+FOUNDATION_STATIC timeline_stock_t* timeline_history_restore_stocks(const timeline_history_t* history)
+{
+    timeline_stock_t* stocks = nullptr;
+    unsigned day = 0;
 
-    if (previous_day == nullptr)
+    const timeline_checkpoint_t* checkpoint = array_last(history->checkpoints);
+    if (checkpoint)
     {
-        day.total_gain = 0;
-        day.total_dividends = 0;
-        day.total_value = 0;
-        day.total_fund = 0;
-        day.total_investment = 0;
+        day = checkpoint->day;
+        array_copy(stocks, checkpoint->stocks);
     }
-    else
+
+    for (const unsigned end = array_size(history->days); day < end; ++day)
+    {
+        const timeline_t& d = history->days[day];
+        timeline_prune_stocks(stocks, d.date);
+        foreach(s, d.deltas)
+            timeline_set_stock(stocks, *s);
+    }
+
+    return stocks;
+}
+
+/*! Appends the days of the transactions starting at the given transaction, and then a day for each day until today. */
+FOUNDATION_STATIC void timeline_history_replay(timeline_history_t* history, unsigned first_transaction, timeline_stock_t*& stocks)
+{
+    const time_t one_day = time_one_day();
+    const time_t end_date = time_now() + one_day / 2;
+    const timeline_transaction_t* transactions = history->transactions;
+    const unsigned transaction_count = array_size(transactions);
+
+    // Days without transactions are added every day since the first transaction day.
+    time_t next_fill_date = 0;
+    if (array_size(history->days) > 0)
+    {
+        const time_t first_date = history->days[0].date;
+        const time_t last_date = array_last(history->days)->date;
+        next_fill_date = first_date + ((last_date - first_date) / one_day + 1) * one_day;
+    }
+    else if (transaction_count > 0)
+    {
+        next_fill_date = transactions[0].date;
+    }
+
+    unsigned tidx = first_transaction;
+    while (tidx < transaction_count || (array_size(history->days) > 0 && next_fill_date <= end_date))
     {
-        day.total_gain = previous_day->total_gain;
-        day.total_dividends = previous_day->total_dividends;
-        day.total_value = previous_day->total_value;
-        day.total_fund = previous_day->total_fund;
-        day.total_investment = previous_day->total_investment;
+        const bool transaction_day = tidx < transaction_count && transactions[tidx].date <= next_fill_date;
+        const time_t date = transaction_day ? transactions[tidx].date : next_fill_date;
+        while (next_fill_date <= date)
+            next_fill_date += one_day;
 
-        // Copy stocks which still have some qty
-        foreach(s, previous_day->stocks)
+        timeline_t day;
+        const timeline_t* previous_day = array_last(history->days);
+        if (previous_day)
         {
-            if (s->qty > 0)
-            {
-                array_push(day.stocks, *s);
-            }
-            #if BUILD_DEBUG
-            else
-            {
-                string_const_t date_string = string_from_date(t->date);
-                log_debugf(HASH_TIMELINE, STRING_CONST("\t\t\t\t  Disposing of %.*s on %.*s"), STRING_FORMAT(s->code), STRING_FORMAT(date_string));
-            }
+            day.total_gain = previous_day->total_gain;
+            day.total_dividends = previous_day->total_dividends;
+            day.total_fund = previous_day->total_fund;
+            day.total_investment = previous_day->total_investment;
+        }
+        day.date = date;
+        day.deltas = nullptr;
+
+        timeline_prune_stocks(stocks, date);
+
+        const unsigned day_index = array_size(history->days);
+        if (day_index % TIMELINE_CHECKPOINT_INTERVAL == 0)
+        {
+            timeline_checkpoint_t checkpoint;
+            checkpoint.day = day_index;
+            checkpoint.stocks = nullptr;
+            array_copy(checkpoint.stocks, stocks);
+            array_push(history->checkpoints, checkpoint);
+        }
+
+        for (; transaction_day && tidx < transaction_count && transactions[tidx].date == date; ++tidx)
+        {
+            const timeline_transaction_t* t = transactions + tidx;
+
+            #if BUILD_DEVELOPMENT
+            // Print transactions
+            string_const_t date_string = string_from_date(t->date);
+            log_infof(HASH_TIMELINE, STRING_CONST("[%3u] Transaction: %s%-15s %.*s %7.0lf x %7.2lf $ x %5.4lg = %8.2lf $ (%.2lf, %.4lf)"),
+                tidx, t->type == TimelineTransactionType::BUY ? "+" : "-",
+                t->code, STRING_FORMAT(date_string),
+                t->qty, t->price, t->exchange_rate, t->qty * t->price * t->exchange_rate,
+                t->split_factor, t->adjusted_factor);
             #endif
-        }       
+
+            timeline_update_day(day, stocks, t);
+        }
+
+        array_push(history->days, day);
+
+        #if BUILD_DEBUG
+        if (transaction_day)
+        {
+            log_debugf(HASH_TIMELINE, STRING_CONST(
+                "\t\t\t\t\tFund:       %9.2lf $\n"
+                "\t\t\t\t\tGain:       %9.2lf $\n"
+                "\t\t\t\t\tDividends:  %9.2lf $\n"
+                "\t\t\t\t\tInvestment: %9.2lf $\n"
+                "\t\t\t\t\tHoldings:   %9u"),
+                day.total_fund, day.total_gain, day.total_dividends, day.total_investment, 
+                array_size(stocks));
+        }
+        #endif
     }
+}
 
-    array_insert(days, insert_at, day);
-    return insert_at;
+FOUNDATION_STATIC void timeline_history_clear(timeline_history_t* history)
+{
+    timeline_history_truncate(history, 0);
+    array_deallocate(history->days);
+    array_deallocate(history->checkpoints);
+    array_deallocate(history->transactions);
+    array_deallocate(history->exchange_rates);
+    history->exchange_rates_time = 0;
+}
+
+FOUNDATION_STATIC void timeline_history_deallocate(timeline_history_t*& history)
+{
+    timeline_history_clear(history);
+    string_deallocate(history->preferred_currency.str);
+    MEM_DELETE(history);
+}
+
+FOUNDATION_STATIC timeline_history_t* timeline_history_get(const report_t* report)
+{
+    foreach(h, _timeline_histories)
+    {
+        if (uuid_equal((*h)->report_id, report->id))
+            return *h;
+    }
+
+    timeline_history_t* history = MEM_NEW(HASH_TIMELINE, timeline_history_t);
+    history->report_id = report->id;
+    array_push(_timeline_histories, history);
+    return history;
 }
 
-FOUNDATION_STATIC timeline_t* timeline_build(const timeline_transaction_t* transactions, string_const_t preferred_currency)
+/*! Updates the report timeline, only the days starting at the first changed transaction get computed again. */
+FOUNDATION_STATIC void timeline_history_update(timeline_history_t* history, const report_t* report)
 {
     LOG_PREFIX(false);
 
-    timeline_t* days = nullptr;
-    foreach(t, transactions)
-    {
-        #if BUILD_DEVELOPMENT
-        // Print transactions
-        string_const_t date_string = string_from_date(t->date);
-        log_infof(HASH_TIMELINE, STRING_CONST("[%3u] Transaction: %s%-15s %.*s %7.0lf x %7.2lf $ x %5.4lg = %8.2lf $ (%.2lf, %.4lf)"),
-            i, t->type == TimelineTransactionType::BUY ? "+" : "-",
-            t->code, STRING_FORMAT(date_string),
-            t->qty, t->price, t->exchange_rate, t->qty * t->price * t->exchange_rate,
-            t->split_factor, t->adjusted_factor);
-        #endif
+    const tick_t timer = time_current();
 
-        int fidx = array_binary_search(days, array_size(days), t->date);
-        if (fidx < 0)
-            fidx = timeline_add_new_day(t, days, ~fidx);
-        
-        timeline_t& day = days[fidx];
-        timeline_update_day(day, t, preferred_currency);
+    // Holdings are valued with the current exchange rates, so everything is computed again when they change.
+    string_const_t preferred_currency = string_to_const(report->wallet->preferred_currency);
+    if (!string_equal(STRING_ARGS(preferred_currency), STRING_ARGS(history->preferred_currency)) ||
+        time_now() - history->exchange_rates_time > TIMELINE_EXCHANGE_RATES_MAX_AGE)
+    {
+        timeline_history_clear(history);
+        string_deallocate(history->preferred_currency.str);
+        history->preferred_currency = string_clone(STRING_ARGS(preferred_currency));
+        history->exchange_rates_time = time_now();
+    }
 
-        #if BUILD_DEBUG
-        log_debugf(HASH_TIMELINE, STRING_CONST(
-            "\t\t\t\t\tFund:       %9.2lf $\n"
-            "\t\t\t\t\tGain:       %9.2lf $\n"
-            "\t\t\t\t\tDividends:  %9.2lf $\n"
-            "\t\t\t\t\tInvestment: %9.2lf $\n"
-            "\t\t\t\t\tTotal [%2u]: %9.2lf $ (%.2lf $)"),
-            day.total_fund, day.total_gain, day.total_dividends, day.total_investment, 
-            array_size(day.stocks), day.total_value,
-            day.total_value + day.total_gain + day.total_dividends + day.total_fund);
-        #endif
+    timeline_transaction_t* transactions = timeline_report_compute_transactions(report, preferred_currency, history->transactions);
+
+    // Find the first day affected by the transaction changes.
+    const unsigned previous_count = array_size(history->transactions);
+    const unsigned transaction_count = array_size(transactions);
+    unsigned first_changed = 0;
+    while (first_changed < previous_count && first_changed < transaction_count &&
+        timeline_transaction_equal(history->transactions[first_changed], transactions[first_changed]))
+    {
+        first_changed++;
+    }
+
+    time_t affected_date = INT64_MAX;
+    if (first_changed < previous_count)
+        affected_date = history->transactions[first_changed].date;
+    if (first_changed < transaction_count)
+        affected_date = min(affected_date, transactions[first_changed].date);
+    if (affected_date == INT64_MAX && array_size(history->days) > 0)
+    {
+        // Only the last day value and the days since then need to be updated.
+        affected_date = array_last(history->days)->date;
     }
 
+    array_deallocate(history->transactions);
+    history->transactions = transactions;
+
+    const unsigned previous_day_count = array_size(history->days);
+    const unsigned kept_day_count = timeline_lower_bound(history->days, affected_date);
+    timeline_history_truncate(history, kept_day_count);
+
+    timeline_stock_t* stocks = timeline_history_restore_stocks(history);
+    timeline_stock_t* holdings = nullptr;
+    array_copy(holdings, stocks);
+
+    const unsigned first_transaction = kept_day_count > 0 ? timeline_lower_bound(transactions, affected_date) : 0;
+    timeline_history_replay(history, first_transaction, stocks);
+    timeline_history_value_days(history, kept_day_count, holdings);
+    array_deallocate(holdings);
+    array_deallocate(stocks);
+
+    log_debugf(HASH_TIMELINE, STRING_CONST("Timeline updated in %.3lf ms (%u/%u days reused, %u days, %u checkpoints)"),
+        time_elapsed(timer) * 1000.0, kept_day_count, previous_day_count, array_size(history->days), array_size(history->checkpoints));
+
     #if BUILD_DEVELOPMENT
-    foreach(d, days)
+    foreach(d, history->days)
     {
+        if (d->deltas == nullptr)
+            continue;
         string_const_t date_string = string_from_date(d->date);
         log_infof(HASH_TIMELINE, STRING_CONST("Timeline: [%2u] %.*s -> Funds: %8.2lf $ -> Investment: %9.2lf $ -> Gain: %8.2lf $ (%8.2lf $) -> Total: %8.2lf $ (%8.2lf $)"),
-            array_size(d->stocks), STRING_FORMAT(date_string),
+            array_size(d->deltas), STRING_FORMAT(date_string),
             d->total_fund, d->total_investment, d->total_gain, d->total_dividends, d->total_value, d->total_value + d->total_dividends + d->total_fund);
     }
     #endif
-
-    return days;
-}
-
-FOUNDATION_STATIC void timeline_deallocate(timeline_t*& timeline)
-{
-    foreach(d, timeline)
-        array_deallocate(d->stocks);
-    array_deallocate(timeline);
-    timeline = nullptr;
 }
 
-FOUNDATION_STATIC timeline_report_t* timeline_report_allocate(const report_t* report)
+FOUNDATION_STATIC timeline_report_t* timeline_report_allocate(const report_t* report, timeline_history_t* history)
 {
-    timeline_report_t* timeline_report = (timeline_report_t*)memory_allocate(HASH_TIMELINE, sizeof(timeline_report_t), 0, MEMORY_PERSISTENT);
-    timeline_report->days = nullptr;
-    timeline_report->transactions = nullptr;
+    timeline_report_t* timeline_report = MEM_NEW(HASH_TIMELINE, timeline_report_t);
+    timeline_report->history = history;
     
     string_const_t report_name = SYMBOL_CONST(report->name);
     string_const_t fmttr = RTEXT("Timeline %.*s");
     timeline_report->title = string_allocate_format(STRING_ARGS(fmttr), STRING_FORMAT(report_name));
-    timeline_report->preferred_currency = string_to_const(report->wallet->preferred_currency);
 
     return timeline_report;
 }
@@ -479,10 +815,7 @@ FOUNDATION_STATIC timeline_report_t* timeline_report_allocate(const report_t* re
 FOUNDATION_STATIC void timeline_report_deallocate(timeline_report_t*& timeline_report)
 {
     string_deallocate(timeline_report->title.str);
-    timeline_deallocate(timeline_report->days);
-    array_deallocate(timeline_report->transactions);
-    memory_deallocate(timeline_report);
-    timeline_report = nullptr;
+    MEM_DELETE(timeline_report);
 }
 
 FOUNDATION_STATIC void timeline_report_plot_day_value(const char* title, size_t title_length, const timeline_t* timeline, function<double(const timeline_t* day)>&& fn, float line_weight = 2.0f, bool default_hide = false)
@@ -519,7 +852,7 @@ FOUNDATION_STATIC void timeline_report_plot_day_bar_value(const char* title, siz
         timeline_plot_day_t* plot = (timeline_plot_day_t*)user_data;
         const timeline_t* t = plot->timeline + idx;
         const double x = (double)t->date;
-        const double y = t->stocks ? plot->fn(t) : NAN;
+        const double y = t->deltas ? plot->fn(t) : NAN;
         return ImPlotPoint(x, y);
     }, &plot, array_size(timeline), bar_size, ImPlotBarsFlags_None);
 }
@@ -591,11 +924,11 @@ FOUNDATION_STATIC bool timeline_report_graph(timeline_report_t* report)
     if (ImGui::IsWindowAppearing())
         dispatch(L0(ImPlot::SetNextAxesToFit()));
 
-    auto summary = array_last(report->days);
+    auto summary = array_last(report->history->days);
 
     plot_axis_format_t axis_format{};
-    const double min_d = (double)report->days[0].date;
-    const double max_d = (double)array_last(report->days)->date;
+    const double min_d = (double)report->history->days[0].date;
+    const double max_d = (double)array_last(report->history->days)->date;
 
     ImPlot::SetupLegend(ImPlotLocation_NorthWest, ImPlotLegendFlags_Horizontal | ImPlotLegendFlags_None);
 
@@ -618,38 +951,38 @@ FOUNDATION_STATIC bool timeline_report_graph(timeline_report_t* report)
 
     ImPlot::SetAxis(ImAxis_Y2);
     ImPlot::HideNextItem(false, ImPlotCond_Once);
-    timeline_report_plot_day_bar_value(STRING_CONST("Gain"), report->days, L1(_1->total_gain + _1->total_dividends));
+    timeline_report_plot_day_bar_value(STRING_CONST("Gain"), report->history->days, L1(_1->total_gain + _1->total_dividends));
 
     ImPlot::SetAxis(ImAxis_Y1);
     ImPlot::HideNextItem(true, ImPlotCond_Once);
     timeline_report_graph_limit(STRING_CONST("Stock Value"), min_d, max_d, summary->total_value);
-    timeline_report_plot_day_value(STRING_CONST("Stock Value"), report->days, L1(_1->total_value), 2.0f, true);
+    timeline_report_plot_day_value(STRING_CONST("Stock Value"), report->history->days, L1(_1->total_value), 2.0f, true);
 
     ImPlot::SetAxis(ImAxis_Y2);
     ImPlot::HideNextItem(false, ImPlotCond_Once);
-    timeline_report_plot_day_bar_value(STRING_CONST("+Funds"), report->days, L1(_1->total_fund), 0, true);
+    timeline_report_plot_day_bar_value(STRING_CONST("+Funds"), report->history->days, L1(_1->total_fund), 0, true);
 
     ImPlot::SetAxis(ImAxis_Y2);
     ImPlot::HideNextItem(true, ImPlotCond_Once);
     timeline_report_graph_limit(STRING_CONST("+Dividends"), min_d, max_d, summary->total_dividends);
-    timeline_report_plot_day_bar_value(STRING_CONST("+Dividends"), report->days, L1(_1->total_dividends), 0, true);
+    timeline_report_plot_day_bar_value(STRING_CONST("+Dividends"), report->history->days, L1(_1->total_dividends), 0, true);
 
-    timeline_report_plot_day_value(STRING_CONST("+Funds"), report->days, L1(_1->total_value + _1->total_fund), 1.0f, true);
+    timeline_report_plot_day_value(STRING_CONST("+Funds"), report->history->days, L1(_1->total_value + _1->total_fund), 1.0f, true);
 
     ImPlot::SetAxis(ImAxis_Y1);
     timeline_report_graph_limit(STRING_CONST("Investments"), min_d, max_d, summary->total_investment - summary->total_dividends - summary->total_gain);
-    timeline_report_plot_day_value(STRING_CONST("Investments"), report->days, L1(_1->total_investment - _1->total_dividends - _1->total_gain), 2.0f);
+    timeline_report_plot_day_value(STRING_CONST("Investments"), report->history->days, L1(_1->total_investment - _1->total_dividends - _1->total_gain), 2.0f);
 
     ImPlot::SetAxis(ImAxis_Y1);
     timeline_report_graph_limit(STRING_CONST("Total Value##5"), min_d, max_d, summary->total_value + summary->total_fund + summary->total_dividends);
 
     //ImPlot::SetNextMarkerStyle(ImPlotMarker_Circle, 4.0f, ImVec4(1, 0, 0, 1), 2);
-    timeline_report_plot_day_value(STRING_CONST("Total Value##5"), report->days, L1(_1->total_value + _1->total_fund + _1->total_dividends), 4.0f);
+    timeline_report_plot_day_value(STRING_CONST("Total Value##5"), report->history->days, L1(_1->total_value + _1->total_fund + _1->total_dividends), 4.0f);
 
     ImPlot::SetAxis(ImAxis_Y1);
     ImPlot::HideNextItem(true, ImPlotCond_Once);
     timeline_report_graph_limit(STRING_CONST("Total Wealth"), min_d, max_d, summary->total_investment);
-    timeline_report_plot_day_value(STRING_CONST("Total Wealth"), report->days, L1(_1->total_investment), 2.0f, true);
+    timeline_report_plot_day_value(STRING_CONST("Total Wealth"), report->history->days, L1(_1->total_investment), 2.0f, true);
 
     const time_t min_time = (time_t)limits.X.Min + time_one_day() * 5;
     const int year_range = math_ceil(time_elapsed_days((time_t)min_time, (time_t)max_d) / 365.0);
@@ -671,15 +1004,15 @@ FOUNDATION_STATIC bool timeline_report_graph(timeline_report_t* report)
         ImPlotPoint ppos = ImPlot::GetPlotMousePos(ImAxis_X1, ImAxis_Y1);
         time_t ppos_date = (time_t)ppos.x;
 
-        const unsigned transaction_count = array_size(report->transactions);
-        int tidx = array_binary_search(report->transactions, transaction_count, ppos_date);
+        const unsigned transaction_count = array_size(report->history->transactions);
+        int tidx = array_binary_search(report->history->transactions, transaction_count, ppos_date);
         if (tidx < 0)
             tidx = ~tidx;
 
         const int max_transactions = 10;
         for (int i = max(0, tidx - max_transactions/2), end = min(tidx + max_transactions/2, to_int(transaction_count)); i < end; ++i)
         {
-            timeline_transaction_t* t = &report->transactions[i];
+            timeline_transaction_t* t = &report->history->transactions[i];
 
             // Compute point position around #ppos that make a circle for each transaction
             const float angle = i * (2 * FLT_PI / max_transactions) + ((t->code_key % 120) / 120.0f + 0.3f);
@@ -708,7 +1041,7 @@ FOUNDATION_STATIC bool timeline_report_graph(timeline_report_t* report)
 
 FOUNDATION_STATIC void timeline_report_toolbar(timeline_report_t* report)
 {
-    const unsigned transaction_count = array_size(report->transactions);
+    const unsigned transaction_count = array_size(report->history->transactions);
     if (report == nullptr || transaction_count == 0)
         return;
 
@@ -716,13 +1049,13 @@ FOUNDATION_STATIC void timeline_report_toolbar(timeline_report_t* report)
     
     ImGui::BeginGroup();
 
-    auto last_day = array_last(report->days);
+    auto last_day = array_last(report->history->days);
     string_const_t last_date_string = string_from_date(last_day->date);
 
     ImGui::Text(ICON_MD_STACKED_LINE_CHART " [%u] %.*s", transaction_count, STRING_FORMAT(last_date_string));
     if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayNormal))
     {
-        auto first_day = &report->days[0];
+        auto first_day = &report->history->days[0];
         string_const_t first_date_string = string_from_date(first_day->date);
         ImGui::SetTooltip(tr("You've made %u transactions since %.*s"), transaction_count, STRING_FORMAT(first_date_string));
     }
@@ -774,7 +1107,7 @@ FOUNDATION_STATIC bool timeline_report_graph_dialog(void* user_data)
 {
     timeline_report_t* report = (timeline_report_t*)user_data;
 
-    if (array_size(report->days) <= 2)
+    if (array_size(report->history->days) <= 2)
     {
         ImGui::TrTextUnformatted("No transactions to display");
         return true;
@@ -795,7 +1128,7 @@ FOUNDATION_STATIC void timeline_window_render_report(window_handle_t window_hand
     timeline_report_t* report = (timeline_report_t*)window_get_user_data(window_handle);
     FOUNDATION_ASSERT(report);
 
-    if (array_size(report->days) <= 2)
+    if (array_size(report->history->days) <= 2)
         return ImGui::TrTextUnformatted("No transactions to display");
 
     timeline_report_toolbar(report);
@@ -822,47 +1155,51 @@ FOUNDATION_STATIC void timeline_window_report_close(window_handle_t window_handl
 
 void timeline_render_graph(const report_t* report)
 {
-    timeline_report_t* timeline_report = timeline_report_allocate(report);
-    timeline_report->transactions = timeline_report_compute_transactions(report, timeline_report->preferred_currency);
-    timeline_report->days = timeline_build(timeline_report->transactions, timeline_report->preferred_currency);
-
-    // Insert new days with updated total current value
-    auto days = timeline_report->days;
-    for (time_t d = days[0].date, end = time_now() + time_one_day() / 2; d <= end; d += time_one_day())
-    {
-        int didx = array_binary_search(days, array_size(days), d);
-        if (didx >= 0)
-            continue;
-
-        didx = ~didx;        
-        int idx = didx;
-        timeline_t* previous_day = nullptr;
-        while (idx >= 0)
-        {
-            if (to_uint(idx) < array_size(days) && days[idx].stocks)
-            {
-                previous_day = &days[idx];
-                break;
-            }
-            idx--;
-        }
-
-        if (previous_day == nullptr)
-            continue;
-
-        timeline_t day;
-        day.date = d;
-        day.stocks = nullptr;
-        day.total_gain = previous_day->total_gain;
-        day.total_dividends = previous_day->total_dividends;
-        day.total_value = day.total_value = timeline_compute_day_total_value(previous_day->stocks, day.date, timeline_report->preferred_currency);
-        day.total_fund = previous_day->total_fund;
-        day.total_investment = previous_day->total_investment;
-        timeline_report->days = array_insert(days, didx, day);
-    }
+    timeline_history_t* history = timeline_history_get(report);
+    timeline_history_update(history, report);
+    if (array_size(history->days) == 0)
+        return;
 
+    timeline_report_t* timeline_report = timeline_report_allocate(report, history);
     window_open(
         "timeline_window", STRING_ARGS(timeline_report->title), 
         timeline_window_render_report, timeline_window_report_close, 
         timeline_report, WindowFlags::Transient | WindowFlags::Maximized);
 }
+
+timeline_day_totals_t* timeline_report_days(const report_t* report, bool rebuild /*= false*/)
+{
+    timeline_history_t* history = timeline_history_get(report);
+    if (rebuild)
+        timeline_history_clear(history);
+    timeline_history_update(history, report);
+
+    timeline_day_totals_t* totals = nullptr;
+    array_reserve(totals, array_size(history->days));
+    foreach(d, history->days)
+    {
+        timeline_day_totals_t t;
+        t.date = d->date;
+        t.total_gain = d->total_gain;
+        t.total_dividends = d->total_dividends;
+        t.total_value = d->total_value;
+        t.total_fund = d->total_fund;
+        t.total_investment = d->total_investment;
+        array_push(totals, t);
+    }
+
+    return totals;
+}
+
+//
+// # SYSTEM
+//
+
+FOUNDATION_STATIC void timeline_shutdown()
+{
+    foreach(h, _timeline_histories)
+        timeline_history_deallocate(*h);
+    array_deallocate(_timeline_histories);
+}
+
+DEFINE_MODULE(TIMELINE, [](){}, timeline_shutdown, MODULE_PRIORITY_UI);
@@ -7,4 +7,26 @@
 
 struct report_t;
 
+/*! Totals of a report timeline day. */
+struct timeline_day_totals_t
+{
+    time_t date{ 0 };
+
+    double total_gain{ 0 };
+    double total_dividends{ 0 };
+    double total_value{ 0 };
+    double total_fund{ 0 };
+    double total_investment{ 0 };
+};
+
 void timeline_render_graph(const report_t* report);
+
+/*! Updates the report timeline and returns the totals of each day.
+ *
+ *  @param report  The report to compute the timeline for.
+ *  @param rebuild Discard the report timeline kept for the session and compute every day again,
+ *                 otherwise only the days affected by the transaction changes are computed again.
+ *
+ *  @return The timeline day totals, the caller must deallocate the array.
+ */
+timeline_day_totals_t* timeline_report_days(const report_t* report, bool rebuild = false);
@@ -295,16 +295,114 @@ config_handle_t title_get_fundamental_config_value(title_t* title, const char* f
     return config_null();
 }
 
+/*! Decodes a title order configuration data. */
+FOUNDATION_STATIC title_order_t title_decode_order(const config_handle_t& order)
+{
+    title_order_t o;
+    o.data = order;
+
+    string_const_t date = order["date"].as_string();
+    o.date = string_to_date(STRING_ARGS(date));
+    o.qty = order["qty"].as_number();
+    o.price = order["price"].as_number();
+    o.ask_price = order["ask"].as_number();
+
+    if (order["buy"].as_boolean())
+        o.flags |= TITLE_ORDER_BUY;
+    else if (order["sell"].as_boolean())
+        o.flags |= TITLE_ORDER_SELL;
+
+    o.split_factor = order["split"].as_number();
+    if (math_real_is_nan(o.split_factor))
+    {
+        o.split_factor = 1.0;
+        o.flags |= TITLE_ORDER_SPLIT_UNRESOLVED;
+    }
+
+    o.exchange_rate = order["xcg"].as_number();
+    if (math_real_is_nan(o.exchange_rate))
+    {
+        o.exchange_rate = 1.0;
+        o.flags |= TITLE_ORDER_EXCHANGE_RATE_UNRESOLVED;
+    }
+
+    return o;
+}
+
+FOUNDATION_STATIC void title_decode_orders(title_t* t, const config_handle_t& data)
+{
+    array_clear(t->orders);
+    for (auto order : data["orders"])
+    {
+        title_order_t o = title_decode_order(order);
+        array_push_memcpy(t->orders, &o);
+    }
+    t->orders_decoded = true;
+}
+
+/*! Resolves the order split factor and exchange rate once the title stock is available and saves them in the order data. */
+FOUNDATION_STATIC void title_resolve_order(title_t* t, title_order_t& o, string_const_t stock_currency, string_const_t preferred_currency)
+{
+    if (o.flags & TITLE_ORDER_SPLIT_UNRESOLVED)
+    {
+        o.split_factor = stock_get_split_factor(t->code, t->code_length, o.date);
+        config_set(o.data, "split", o.split_factor);
+        o.flags &= ~TITLE_ORDER_SPLIT_UNRESOLVED;
+    }
+
+    if (o.flags & TITLE_ORDER_EXCHANGE_RATE_UNRESOLVED)
+    {
+        o.exchange_rate = stock_exchange_rate(STRING_ARGS(stock_currency), STRING_ARGS(preferred_currency), o.date);
+        o.exchange_rate = math_ifzero(o.exchange_rate, 1.0);
+        config_set(o.data, "xcg", o.exchange_rate);
+        o.flags &= ~TITLE_ORDER_EXCHANGE_RATE_UNRESOLVED;
+    }
+}
+
+/*! Resolves and saves any missing order split factor or exchange rate and any missing dividend exchange rate. */
+FOUNDATION_STATIC void title_resolve_transactions(title_t* t, const stock_t* s)
+{
+    string_const_t stock_currency = string_table_decode_const(s->currency);
+    string_const_t preferred_currency = string_to_const(t->wallet->preferred_currency);
+    foreach(order, t->orders)
+        title_resolve_order(t, *order, stock_currency, preferred_currency);
+
+    if (stock_currency.length == 0)
+        return;
+
+    for (auto dividends : t->data["dividends"])
+    {
+        if (!math_real_is_nan(dividends["xcg"].as_number()))
+            continue;
+
+        time_t date = dividends["date"].as_time();
+        const double xgrate = stock_exchange_rate(STRING_ARGS(stock_currency), STRING_ARGS(preferred_currency), date);
+        config_set(dividends, "xcg", xgrate);
+    }
+}
+
+bool title_resolve_transactions(title_t* t)
+{
+    FOUNDATION_ASSERT(t);
+
+    if (!title_is_resolved(t))
+        return false;
+
+    const stock_t* s = t->stock;
+    if (!t->orders_decoded)
+        title_decode_orders(t, t->data);
+    title_resolve_transactions(t, s);
+
+    // Fetch the lazy stock values used by #title_init so it only reads them afterward.
+    s->dividends_yield.fetch();
+    return true;
+}
+
 void title_init(title_t* t, wallet_t* wallet, const config_handle_t& data)
 {
-    const config_tag_t TITLE_DATE = config_tag(data, STRING_CONST("date"));
-    const config_tag_t TITLE_BUY = config_tag(data, STRING_CONST("buy"));
-    const config_tag_t TITLE_SELL = config_tag(data, STRING_CONST("sell"));
-    const config_tag_t TITLE_QTY = config_tag(data, STRING_CONST("qty"));
-    const config_tag_t TITLE_PRICE = config_tag(data, STRING_CONST("price"));
-    const config_tag_t TITLE_ASK_PRICE = config_tag(data, STRING_CONST("ask"));
-    const config_tag_t TITLE_EXCHANGE_RATE = config_tag(data, STRING_CONST("xcg"));
-    const config_tag_t TITLE_SPLIT_FACTOR = config_tag(data, STRING_CONST("split"));
+    // Decode orders only when the title data changes, see #title_invalidate_orders.
+    if (!t->orders_decoded || t->data.config != data.config || t->data.index != data.index)
+        title_decode_orders(t, data);
 
     t->data = data;
     t->wallet = wallet;
@@ -356,63 +454,31 @@ void title_init(title_t* t, wallet_t* wallet, const config_handle_t& data)
     double total_exchange_rate_count = 0;
     
     const stock_t* s = title_is_resolved(t) ? t->stock : nullptr;
-    string_t preferred_currency = t->wallet->preferred_currency;
-    string_const_t stock_currency = s ? string_table_decode_const(s->currency) : string_null();
     const double dividends_yield = s ? math_ifnan(s->dividends_yield.fetch(), 0) : 0.0;
 
     // Check if the title has been fully sold
     double total_current_quantity = 0;
-    for (auto order : data["orders"])
+    foreach(o, t->orders)
     {
-        const double qty = order[TITLE_QTY].as_number();
-        const bool buy = order[TITLE_BUY].as_boolean();
-        const bool sell = order[TITLE_SELL].as_boolean();
-
-        if (buy)
+        if (o->flags & TITLE_ORDER_BUY)
         {
-            total_current_quantity += qty;
+            total_current_quantity += o->qty;
         }
-        else if (sell)
+        else if (o->flags & TITLE_ORDER_SELL)
         {
-            total_current_quantity -= qty;
+            total_current_quantity -= o->qty;
         }
     }
 
-    for (auto order : data["orders"])
-    {
-        string_const_t date = order[TITLE_DATE].as_string();
-        const bool buy = order[TITLE_BUY].as_boolean();
-        const bool sell = order[TITLE_SELL].as_boolean();
-        const double qty = order[TITLE_QTY].as_number();
-        const double price = order[TITLE_PRICE].as_number();
-        const double ask_price = order[TITLE_ASK_PRICE].as_number();
-        const time_t order_date = string_to_date(STRING_ARGS(date));
-
-        double order_split_factor = order[TITLE_SPLIT_FACTOR].as_number();
-        double order_exchange_rate = order[TITLE_EXCHANGE_RATE].as_number();
-        if (s)
-        {
-            if (math_real_is_nan(order_split_factor))
-            {
-                order_split_factor = stock_get_split_factor(STRING_ARGS(title_code), order_date);
-                config_set(order, "split", order_split_factor);
-            }
-
-            if (math_real_is_nan(order_exchange_rate))
-            {
-                order_exchange_rate = stock_exchange_rate(STRING_ARGS(stock_currency), STRING_ARGS(preferred_currency), order_date);
-                order_exchange_rate = math_ifzero(order_exchange_rate, 1.0);
-                config_set(order, "xcg", order_exchange_rate);
-            }
-        }
-        else
-        {
-            if (math_real_is_nan(order_split_factor))
-                order_split_factor = 1.0;
+    if (s)
+        title_resolve_transactions(t, s);
 
-            if (math_real_is_nan(order_exchange_rate))
-                order_exchange_rate = 1.0;
-        }
+    foreach(order, t->orders)
+    {
+        const double qty = order->qty;
+        const double price = order->price;
+        const time_t order_date = order->date;
+        const double order_exchange_rate = order->exchange_rate;
 
         total_exchange_rate_count += qty;
         total_exchange_rate += order_exchange_rate * qty;
@@ -430,16 +496,16 @@ void title_init(title_t* t, wallet_t* wallet, const config_handle_t& data)
             t->date_average += order_date;
         }
         
-        if (ask_price > 0)
+        if (order->ask_price > 0)
         {
             total_ask_count++;
-            total_ask_price += ask_price;
+            total_ask_price += order->ask_price;
             total_buy_limit_price += price;
         }
 
-        const double split_quantity = qty / order_split_factor;
+        const double split_quantity = qty / order->split_factor;
 
-        if (buy)
+        if (order->flags & TITLE_ORDER_BUY)
         {
             t->buy_total_count++;
             t->buy_total_quantity += split_quantity;
@@ -447,7 +513,7 @@ void title_init(title_t* t, wallet_t* wallet, const config_handle_t& data)
             t->buy_total_price_rated += qty * price * order_exchange_rate;
             t->average_quantity += split_quantity;
         }
-        else if (sell)
+        else if (order->flags & TITLE_ORDER_SELL)
         {
             t->sell_total_count++;
             t->sell_total_quantity += split_quantity;
@@ -482,13 +548,7 @@ void title_init(title_t* t, wallet_t* wallet, const config_handle_t& data)
     t->total_dividends = 0;
     for (auto dividends : data["dividends"])
     {
-        double xgrate = dividends["xcg"].as_number();
-        if (stock_currency.length && math_real_is_nan(xgrate))
-        {
-            time_t date = dividends["date"].as_time();
-            xgrate = stock_exchange_rate(STRING_ARGS(stock_currency), STRING_ARGS(preferred_currency), date);
-            config_set(dividends, "xcg", xgrate);
-        }
+        const double xgrate = dividends["xcg"].as_number();
         t->total_dividends += dividends["amount"].as_number(0) * math_ifnan(xgrate, 1.0);
     }
 
@@ -531,6 +591,25 @@ void title_init(title_t* t, wallet_t* wallet, const config_handle_t& data)
     t->today_exchange_rate.reset([t](double& value){ return title_fetch_today_exchange_rate(t, value); });
 }
 
+void title_invalidate_orders(title_t* t)
+{
+    FOUNDATION_ASSERT(t);
+    t->orders_decoded = false;
+}
+
+void title_push_order(title_t* t, const config_handle_t& order)
+{
+    FOUNDATION_ASSERT(t);
+
+    if (t->orders_decoded)
+    {
+        title_order_t o = title_decode_order(order);
+        array_push_memcpy(t->orders, &o);
+    }
+
+    title_refresh(t);
+}
+
 bool title_refresh(title_t* title)
 {
     const stock_t* s = title->stock;
@@ -619,20 +698,18 @@ title_t* title_allocate(wallet_t* wallet /*= nullptr*/, const config_handle_t& d
 
 void title_deallocate(title_t*& title)
 {
+    if (title)
+        array_deallocate(title->orders);
     MEM_DELETE(title);
 }
 
 time_t title_last_transaction_date(const title_t* t)
 {
     time_t last_date = 0;
-    for (auto corder : t->data["orders"])
+    foreach(o, t->orders)
     {
-        string_const_t date_str = corder["date"].as_string();
-        if (date_str.length == 0)
-            continue;
-        const time_t odate = string_to_date(STRING_ARGS(date_str));
-        if (odate > last_date)
-            last_date = odate;
+        if (o->date > last_date)
+            last_date = o->date;
     }
 
     return last_date;
@@ -641,14 +718,10 @@ time_t title_last_transaction_date(const title_t* t)
 time_t title_first_transaction_date(const title_t* t)
 {
     time_t first_date = INT64_MAX;
-    for (auto corder : t->data["orders"])
+    foreach(o, t->orders)
     {
-        string_const_t date_str = corder["date"].as_string();
-        if (date_str.length == 0)
-            continue;
-        const time_t odate = string_to_date(STRING_ARGS(date_str));
-        if (odate < first_date)
-            first_date = odate;
+        if (o->date != 0 && o->date < first_date)
+            first_date = o->date;
     }
 
     return first_date;
@@ -715,22 +788,21 @@ double title_average_days_held(const title_t* title)
     if (title->average_days_held.try_get(average_days_held))
         return average_days_held;
 
-    auto orders = title->data["orders"];
     double buy_total_price = title->buy_total_price;
 
     // Compute in average how many days the title is help.
     // We weight each transaction total price by the title total transaction price.
     double current_quantity = 0;
-    for (auto e : orders)
+    foreach(e, title->orders)
     {
-        const bool buy = e["buy"].as_boolean();
-        const bool sell = e["sell"].as_boolean();
-        const double qty = e["qty"].as_number();
+        const bool buy = (e->flags & TITLE_ORDER_BUY) != 0;
+        const bool sell = (e->flags & TITLE_ORDER_SELL) != 0;
+        const double qty = e->qty;
 
         if (buy)
         {
-            const time_t order_date = e["date"].as_time();
-            const double price = e["price"].as_number();
+            const time_t order_date = e->date;
+            const double price = e->price;
             const double total_price = qty * price;
 
             const double ratio = total_price / buy_total_price;
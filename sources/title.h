@@ -27,6 +27,31 @@ const fetch_level_t INDEX_MINIMUM_FETCH_LEVEL =
     FetchLevel::EOD | 
     FetchLevel::TECHNICAL_SAR;
 
+/*! Title order flags. */
+typedef enum title_order_flag_t : unsigned int {
+    TITLE_ORDER_NONE = 0,
+    TITLE_ORDER_BUY = 1 << 0,
+    TITLE_ORDER_SELL = 1 << 1,
+
+    /*! The order split factor or exchange rate was not yet resolved from the title stock. */
+    TITLE_ORDER_SPLIT_UNRESOLVED = 1 << 2,
+    TITLE_ORDER_EXCHANGE_RATE_UNRESOLVED = 1 << 3,
+} title_order_flag_t;
+typedef unsigned int title_order_flags_t;
+
+/*! Title order decoded from the title configuration data, see #title_t::orders. */
+struct title_order_t
+{
+    config_handle_t data{ nullptr };
+    time_t date{ 0 };
+    double qty{ 0 };
+    double price{ 0 };
+    double ask_price{ DNAN };
+    double split_factor{ 1.0 };
+    double exchange_rate{ 1.0 };
+    title_order_flags_t flags{ TITLE_ORDER_NONE };
+};
+
 /*! The title structure is used to store information about a given title. 
  *  A title is owned by a report and tracks all the transaction made for a given title.
  *
@@ -77,6 +102,10 @@ FOUNDATION_ALIGNED_STRUCT(title_t, 8)
     double_option_t ask_price{ DNAN };
     double_option_t today_exchange_rate{ 1.0 };
     mutable double_option_t average_days_held{ DNAN };
+
+    // Orders decoded once from #data, so the title statistics can be refreshed without walking the config tree.
+    title_order_t* orders{ nullptr };
+    bool orders_decoded{ false };
 };
 
 /*! Allocates a new title to be assigned to a report wallet.
@@ -193,6 +222,32 @@ config_handle_t title_get_fundamental_config_value(title_t* title, const char* f
  */
 void title_init(title_t* t, wallet_t* wallet, const config_handle_t& data);
 
+/*! Marks the title orders to be decoded again from the title data on the next refresh.
+ *
+ *  @remark This needs to be called when existing orders are edited or removed from the title data.
+ *
+ *  @param t The title to invalidate the orders for.
+ */
+void title_invalidate_orders(title_t* t);
+
+/*! Adds a new order to the title decoded orders and updates the title statistics if the title stock is available.
+ *
+ *  @param t     The title the order was added to.
+ *  @param order The order configuration data that was appended to the title orders.
+ */
+void title_push_order(title_t* t, const config_handle_t& order);
+
+/*! Resolves and saves the missing order split factors and exchange rates of a resolved title.
+ *
+ *  Call this on the main thread before refreshing titles from jobs, so #title_init
+ *  only reads the title data and never writes the report configuration.
+ *
+ *  @param t The title to resolve.
+ *
+ *  @return True if the title stock is resolved, false otherwise.
+ */
+bool title_resolve_transactions(title_t* t);
+
 /*! Refresh the title data.
  *
  *  We fetch the stock data and then refresh the title. You need to recall this function
@@ -5,6 +5,8 @@
 
 #include "watches.h"
 
+#include "stock.h"
+
 #include <framework/app.h>
 #include <framework/array.h>
 #include <framework/memory.h>
@@ -50,20 +52,263 @@ FOUNDATION_STATIC watch_point_t* watch_point_find(watch_context_t* context, cons
     return nullptr;
 }
 
+FOUNDATION_STATIC watch_variable_t* watch_find_variable(watch_context_t* context, hash_t key)
+{
+    for (unsigned i = 0, end = array_size(context->variables); i < end; ++i)
+    {
+        watch_variable_t* var = context->variables + i;
+        if (string_hash(STRING_ARGS(var->name)) == key)
+            return var;
+    }
+
+    return nullptr;
+}
+
+FOUNDATION_STATIC watch_point_t* watch_point_find(watch_context_t* context, hash_t key)
+{
+    for (unsigned i = 0, end = array_size(context->points); i < end; ++i)
+    {
+        watch_point_t* p = context->points + i;
+        if (string_hash(STRING_ARGS(p->name)) == key)
+            return p;
+    }
+
+    return nullptr;
+}
+
+FOUNDATION_STATIC expr_result_t watch_value_to_expr_result(const watch_value_t& value)
+{
+    if (value.type == WATCH_VALUE_TEXT)
+        return expr_result_t(string_to_const(value.text));
+
+    if (value.type == WATCH_VALUE_NUMBER || value.type == WATCH_VALUE_BOOLEAN || value.type == WATCH_VALUE_DATE)
+        return expr_result_t(value.number);
+
+    return NIL;
+}
+
+FOUNDATION_STATIC bool watch_value_equal(const watch_value_t& a, const watch_value_t& b)
+{
+    if (a.type != b.type)
+        return false;
+
+    if (a.type == WATCH_VALUE_TEXT)
+        return string_equal(STRING_ARGS(a.text), STRING_ARGS(b.text));
+
+    return a.number == b.number || (math_real_is_nan(a.number) && math_real_is_nan(b.number));
+}
+
+FOUNDATION_STATIC bool watch_point_depends_on(const watch_point_t* point, watch_dependency_type_t type, hash_t key)
+{
+    for (unsigned i = 0, end = array_size(point->dependencies); i < end; ++i)
+    {
+        const watch_dependency_t* d = point->dependencies + i;
+        if (d->type == type && d->key == key)
+            return true;
+    }
+
+    return false;
+}
+
+FOUNDATION_STATIC void watch_point_add_dependency(watch_point_t* point, watch_dependency_type_t type, const char* name, size_t length)
+{
+    const hash_t key = string_hash(name, length);
+    if (watch_point_depends_on(point, type, key))
+        return;
+
+    watch_dependency_t d{ type, key, 0, 0 };
+    array_push(point->dependencies, d);
+}
+
+/*! Returns the name given to a stock or report function argument, i.e. AAPL.US, 'AAPL.US' or $TITLE. */
+FOUNDATION_STATIC string_const_t watch_expression_name_argument(const expr_t& arg)
+{
+    if (arg.type == OP_VAR)
+        return arg.token;
+
+    if (arg.type == OP_CONST && arg.param.result.value.type == EXPR_RESULT_SYMBOL)
+        return arg.param.result.value.as_string();
+
+    return string_null();
+}
+
+/*! Adds the stock symbol of a S() or R() argument, symbols given by variables (i.e. $TITLE) are resolved when evaluated. */
+FOUNDATION_STATIC void watch_point_add_stock_dependency(watch_point_t* point, const expr_t& arg)
+{
+    string_const_t symbol = watch_expression_name_argument(arg);
+    if (symbol.length == 0)
+        return;
+
+    watch_point_add_dependency(point, WATCH_DEPENDENCY_STOCK, STRING_ARGS(symbol));
+    if (symbol.str[0] == '$')
+        watch_point_add_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_ARGS(symbol));
+}
+
+/*! Collects the dependencies of a watch point expression node and its arguments. */
+FOUNDATION_STATIC void watch_point_collect_dependencies(watch_point_t* point, const expr_t* e)
+{
+    if (e->type == OP_VAR)
+    {
+        if (e->token.length > 0)
+            watch_point_add_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_ARGS(e->token));
+        return;
+    }
+
+    // Stock symbols and field names given to S(<symbol>, <field>, ...) and
+    // R(<report>, <symbol>, <field>) are not variables or watch points.
+    unsigned first_arg = 0;
+    if (e->type == OP_FUNC && e->param.func.f)
+    {
+        string_const_t fn = e->param.func.f->name;
+        if (e->args.len >= 2 && string_equal_nocase(STRING_ARGS(fn), STRING_CONST("S")))
+        {
+            watch_point_add_stock_dependency(point, e->args.buf[0]);
+            first_arg = e->args.buf[1].type == OP_VAR ? 2 : 1;
+        }
+        else if (e->args.len >= 2 && (string_equal_nocase(STRING_ARGS(fn), STRING_CONST("R")) || string_equal_nocase(STRING_ARGS(fn), STRING_CONST("REPORT"))))
+        {
+            string_const_t report_name = watch_expression_name_argument(e->args.buf[0]);
+            if (report_name.length > 0 && report_name.str[0] == '$')
+                watch_point_add_dependency(point, WATCH_DEPENDENCY_SYMBOL, STRING_ARGS(report_name));
+
+            if (e->args.len >= 3)
+                watch_point_add_stock_dependency(point, e->args.buf[1]);
+            first_arg = e->args.len >= 3 ? 2 : 1;
+            if (e->args.buf[first_arg].type == OP_VAR)
+                first_arg++;
+        }
+    }
+
+    for (unsigned i = first_arg; i < (unsigned)e->args.len; ++i)
+        watch_point_collect_dependencies(point, &e->args.buf[i]);
+}
+
+/*! Parses the watch point expression to build the list of names (variables and other watch points)
+ *  and stocks (i.e. S(<symbol>, ...)) it depends on.
+ */
+FOUNDATION_STATIC void watch_point_build_dependencies(watch_point_t* point)
+{
+    array_clear(point->dependencies);
+    if (point->expression.length == 0)
+        return;
+
+    expr_t* e = expr_parse(STRING_ARGS(point->expression));
+    if (e == nullptr)
+        return;
+
+    watch_point_collect_dependencies(point, e);
+    expr_destroy(e);
+}
+
+FOUNDATION_STATIC tick_t watch_stock_last_update(hash_t stock_id)
+{
+    if (stock_id == 0)
+        return 0;
+
+    stock_handle_t handle;
+    handle.id = stock_id;
+    
+    const stock_t* s = nullptr;
+    if (!stock_request(handle, &s) || s == nullptr)
+        return 0;
+
+    return s->last_update_time;
+}
+
+FOUNDATION_STATIC hash_t watch_point_resolve_stock_id(watch_context_t* context, const watch_dependency_t* d)
+{
+    // The stock symbol can be given by a context variable, i.e. S($TITLE, price)
+    const watch_variable_t* var = watch_find_variable(context, d->key);
+    if (var == nullptr)
+        return d->key;
+
+    if (var->value.type != WATCH_VALUE_TEXT)
+        return 0;
+
+    return string_hash(STRING_ARGS(var->value.text));
+}
+
+FOUNDATION_STATIC void watch_point_invalidate(watch_point_t* point)
+{
+    if (point->record.type == WATCH_VALUE_TEXT)
+        string_deallocate(point->record.text.str);
+    point->record.type = WATCH_VALUE_UNDEFINED;
+}
+
+/*! Invalidates all the watch points referencing the name #key and their own dependents. */
+FOUNDATION_STATIC void watch_invalidate_dependents(watch_context_t* context, hash_t key)
+{
+    for (unsigned i = 0, end = array_size(context->points); i < end; ++i)
+    {
+        watch_point_t* p = context->points + i;
+        if (p->record.type == WATCH_VALUE_UNDEFINED)
+            continue;
+
+        if (!watch_point_depends_on(p, WATCH_DEPENDENCY_SYMBOL, key))
+            continue;
+
+        watch_point_invalidate(p);
+        watch_invalidate_dependents(context, string_hash(STRING_ARGS(p->name)));
+    }
+}
+
+/*! Invalidates watch points for which the underlying stock data changed since they were last evaluated. */
+FOUNDATION_STATIC void watch_context_update_dependencies(watch_context_t* context)
+{
+    for (unsigned i = 0, end = array_size(context->points); i < end; ++i)
+    {
+        watch_point_t* p = context->points + i;
+        if (p->record.type == WATCH_VALUE_UNDEFINED)
+            continue;
+
+        foreach(d, p->dependencies)
+        {
+            if (d->type != WATCH_DEPENDENCY_STOCK || d->stock_id == 0)
+                continue;
+
+            if (watch_stock_last_update(d->stock_id) == d->last_update)
+                continue;
+
+            watch_point_invalidate(p);
+            watch_invalidate_dependents(context, string_hash(STRING_ARGS(p->name)));
+            break;
+        }
+    }
+}
+
 FOUNDATION_STATIC bool watch_point_evaluate(watch_context_t* context, watch_point_t* point, bool share = false)
 {
     if (point->expression.length == 0)
         return false;
 
-    for (unsigned i = 0, end = array_size(context->variables); i < end; ++i)
+    if (point->evaluating)
     {
-        watch_variable_t* var = context->variables + i;
-        expr_result_t var_value = NIL;
-        if (var->value.type == WATCH_VALUE_TEXT)
-            var_value = expr_result_t(string_to_const(var->value.text));
-        else
-            var_value = expr_result_t(var->value.number);
-        expr_set_or_create_global_var(STRING_ARGS(var->name), var_value);
+        log_warnf(HASH_WATCHES, WARNING_INVALID_VALUE, STRING_CONST("Circular watch point reference to %.*s"), STRING_FORMAT(point->name));
+        return false;
+    }
+
+    point->evaluating = true;
+
+    // Only publish the variables and watch points this point depends on.
+    foreach(d, point->dependencies)
+    {
+        if (d->type != WATCH_DEPENDENCY_SYMBOL)
+            continue;
+
+        const watch_variable_t* var = watch_find_variable(context, d->key);
+        if (var)
+        {
+            expr_set_or_create_global_var(STRING_ARGS(var->name), watch_value_to_expr_result(var->value));
+            continue;
+        }
+
+        watch_point_t* ref = watch_point_find(context, d->key);
+        if (ref == nullptr || ref == point)
+            continue;
+
+        if (ref->record.type == WATCH_VALUE_UNDEFINED)
+            watch_point_evaluate(context, ref);
+        expr_set_or_create_global_var(STRING_ARGS(ref->name), watch_value_to_expr_result(ref->record));
     }
 
     expr_result_t result = eval(point->expression.str, point->expression.length);
@@ -90,6 +335,18 @@ FOUNDATION_STATIC bool watch_point_evaluate(watch_context_t* context, watch_poin
         point->record.text = string_clone(str.str, str.length);
     }
 
+    // Remember the state of the stock data used to compute the value
+    foreach(sd, point->dependencies)
+    {
+        if (sd->type != WATCH_DEPENDENCY_STOCK)
+            continue;
+
+        sd->stock_id = watch_point_resolve_stock_id(context, sd);
+        sd->last_update = watch_stock_last_update(sd->stock_id);
+    }
+
+    point->evaluating = false;
+
     // Update shared context with this watch point
     if (share && _shared_context)
     { 
@@ -100,6 +357,8 @@ FOUNDATION_STATIC bool watch_point_evaluate(watch_context_t* context, watch_poin
             
             string_deallocate(wsp->expression.str);
             wsp->expression = string_clone(STRING_ARGS(point->expression));
+            watch_point_build_dependencies(wsp);
+            watch_point_invalidate(wsp);
         }
         else
         {
@@ -158,6 +417,8 @@ FOUNDATION_STATIC bool watch_point_edit_expression_render_dialog(void* user_data
     {
         string_deallocate(point->expression.str);
         point->expression = string_clone(point->expression_edit_buffer, string_length(point->expression_edit_buffer));
+        watch_point_build_dependencies(point);
+        watch_invalidate_dependents(point->context, string_hash(STRING_ARGS(point->name)));
         watch_point_evaluate(point->context, point, true);
     }
 
@@ -344,6 +605,7 @@ FOUNDATION_STATIC void watch_point_deallocate(watch_point_t* w)
         string_deallocate(w->record.text.str);
             
     memory_deallocate(w->expression_edit_buffer);
+    array_deallocate(w->dependencies);
     string_deallocate(w->expression.str);
     string_deallocate(w->name.str);
 }
@@ -402,9 +664,12 @@ FOUNDATION_STATIC void watch_table_contextual_menu(table_element_ptr_const_t ele
 
         if (ImGui::TrMenuItem(ICON_MD_DELETE " Delete"))
         {
-            unsigned pos = point - point->context->points;
+            watch_context_t* context = point->context;
+            const hash_t name_key = string_hash(STRING_ARGS(point->name));
+            unsigned pos = point - context->points;
             watch_point_deallocate(point);
-            array_erase_safe(point->context->points, pos);
+            array_erase_safe(context->points, pos);
+            watch_invalidate_dependents(context, name_key);
         }
     }
 }
@@ -557,6 +822,33 @@ FOUNDATION_STATIC bool watch_render_new_point(watch_context_t* context)
 // PUBLIC API
 //
 
+unsigned watch_update(watch_context_t* context)
+{
+    FOUNDATION_ASSERT(context != nullptr);
+
+    watch_context_update_dependencies(context);
+
+    unsigned evaluation_count = 0;
+    for (unsigned i = 0, end = array_size(context->points); i < end; ++i)
+    {
+        watch_point_t* p = context->points + i;
+        if (p->expression.length == 0)
+            continue;
+
+        if (p->type != WATCH_POINT_VALUE && p->type != WATCH_POINT_DATE && p->type != WATCH_POINT_INTEGER)
+            continue;
+
+        // Watch points already evaluated by one of their dependents are skipped.
+        if (p->record.type != WATCH_VALUE_UNDEFINED)
+            continue;
+
+        evaluation_count++;
+        watch_point_evaluate(context, p);
+    }
+
+    return evaluation_count;
+}
+
 void watches_render(watch_context_t* context)
 {
     FOUNDATION_ASSERT(context != nullptr);
@@ -566,6 +858,8 @@ void watches_render(watch_context_t* context)
 
     watch_render_new_point(context);
 
+    watch_update(context);
+
     _active_context = context;
     table_render(
         context->table, 
@@ -585,11 +879,16 @@ void watch_set_variable(watch_context_t* context, const char* name, size_t name_
     watch_variable_t* var = watch_find_variable(context, name, name_length);
     if (var)
     {
+        watch_value_t value{ WATCH_VALUE_NUMBER };
+        value.number = number;
+        if (watch_value_equal(var->value, value))
+            return;
+
         if (var->value.type == WATCH_VALUE_TEXT)
             string_deallocate(var->value.text.str);
 
-        var->value.type = WATCH_VALUE_NUMBER;
-        var->value.number = (double)number;
+        var->value = value;
+        watch_invalidate_dependents(context, string_hash(name, name_length));
     }
     else
     {
@@ -598,6 +897,7 @@ void watch_set_variable(watch_context_t* context, const char* name, size_t name_
         new_var.value.type = WATCH_VALUE_NUMBER;
         new_var.value.number = (double)number;
         array_push_memcpy(context->variables, &new_var);
+        watch_invalidate_dependents(context, string_hash(name, name_length));
     }
 }
 
@@ -617,6 +917,9 @@ void watch_point_add(watch_context_t* context,
     new_point.context = context;
     new_point.expression_edit_buffer = nullptr;
     new_point.expression_edit_buffer_size = 0;
+    new_point.dependencies = nullptr;
+    new_point.evaluating = false;
+    watch_point_build_dependencies(&new_point);
 
     if (new_point.expression.length > 0)
     {
@@ -637,11 +940,16 @@ void watch_set_variable(watch_context_t* context, const char* name, size_t name_
     watch_variable_t* var = watch_find_variable(context, name, name_length);
     if (var)
     {
+        watch_value_t value{ WATCH_VALUE_DATE };
+        value.number = (double)date;
+        if (watch_value_equal(var->value, value))
+            return;
+
         if (var->value.type == WATCH_VALUE_TEXT)
             string_deallocate(var->value.text.str);
 
-        var->value.type = WATCH_VALUE_DATE;
-        var->value.number = (double)date;
+        var->value = value;
+        watch_invalidate_dependents(context, string_hash(name, name_length));
     }
     else
     {
@@ -650,6 +958,7 @@ void watch_set_variable(watch_context_t* context, const char* name, size_t name_
         new_var.value.type = WATCH_VALUE_DATE;
         new_var.value.number = (double)date;
         array_push_memcpy(context->variables, &new_var);
+        watch_invalidate_dependents(context, string_hash(name, name_length));
     }
 }
 
@@ -660,11 +969,15 @@ void watch_set_variable(watch_context_t* context, const char* name, size_t name_
     watch_variable_t* var = watch_find_variable(context, name, name_length);
     if (var)
     {
+        if (var->value.type == WATCH_VALUE_TEXT && string_equal(STRING_ARGS(var->value.text), value, value_length))
+            return;
+
         if (var->value.type == WATCH_VALUE_TEXT)
             string_deallocate(var->value.text.str);
 
         var->value.type = WATCH_VALUE_TEXT;
         var->value.text = string_clone(value, value_length);
+        watch_invalidate_dependents(context, string_hash(name, name_length));
     }
     else
     {
@@ -673,6 +986,7 @@ void watch_set_variable(watch_context_t* context, const char* name, size_t name_
         new_var.value.type = WATCH_VALUE_TEXT;
         new_var.value.text = string_clone(value, value_length);
         array_push_memcpy(context->variables, &new_var);
+        watch_invalidate_dependents(context, string_hash(name, name_length));
     }
 }
 
@@ -692,6 +1006,9 @@ void watch_load(watch_context_t* context, config_handle_t data)
         p.context = context;
         p.expression_edit_buffer = nullptr;
         p.expression_edit_buffer_size = 0;
+        p.dependencies = nullptr;
+        p.evaluating = false;
+        watch_point_build_dependencies(&p);
 
         array_push_memcpy(context->points, &p);
     }
@@ -45,6 +45,21 @@ struct watch_value_t
     };
 };
 
+typedef enum {
+
+    WATCH_DEPENDENCY_SYMBOL,    // Variable or watch point referenced by name
+    WATCH_DEPENDENCY_STOCK,     // Stock data accessed with S() or R()
+
+} watch_dependency_type_t;
+
+struct watch_dependency_t
+{
+    watch_dependency_type_t type;
+    hash_t                  key;            // Hash of the referenced name or S()/R() symbol argument
+    hash_t                  stock_id;       // Stock resolved when the watch point was last evaluated
+    tick_t                  last_update;    // Stock data update time when the watch point was last evaluated
+};
+
 struct watch_context_t;
 struct watch_point_t
 {
@@ -57,6 +72,9 @@ struct watch_point_t
     char*                expression_edit_buffer;
     size_t               expression_edit_buffer_size;
 
+    watch_dependency_t*  dependencies;
+    bool                 evaluating;
+
     char                 name_buffer[64];
 };
 
@@ -87,6 +105,14 @@ void watch_save(watch_context_t* context, config_handle_t data);
 
 void watch_destroy(watch_context_t*& context);
 
+/*! Invalidates watch points for which the stock data changed and re-evaluates all the invalidated watch points.
+ * 
+ *  @param context Watch context to update.
+ * 
+ *  @return Number of watch points that were evaluated.
+ */
+unsigned watch_update(watch_context_t* context);
+
 void watches_render(watch_context_t* context);
 
 void watch_open_dialog(watch_context_t* context);